@@ -107,6 +107,11 @@ void xToolsBroadcastAssistant::initUiBroadcastAddress()
 void xToolsBroadcastAssistant::initUiBroadcastInterval()
 {
     ui->comboBoxBroadcastInterval->clear();
+    const int fastIntervals[] = {1, 2, 5, 10};
+    for (int i : fastIntervals) {
+        ui->comboBoxBroadcastInterval->addItem(QString::number(i), i);
+    }
+
     for (int i = 20; i <= 100; i += 20) {
         ui->comboBoxBroadcastInterval->addItem(QString::number(i), i);
     }
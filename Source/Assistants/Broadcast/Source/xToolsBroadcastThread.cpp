@@ -8,9 +8,10 @@
  **************************************************************************************************/
 #include "xToolsBroadcastThread.h"
 
-#include <QTimer>
 #include <QUdpSocket>
 
+#include "xToolsDeadlineScheduler.h"
+
 xToolsBroadcastThread::xToolsBroadcastThread(QObject* parent)
     : QThread{parent}
 {}
@@ -48,27 +49,26 @@ void xToolsBroadcastThread::run()
     auto parameters = m_parameters;
     m_parametersMutext.unlock();
 
-    QTimer* txTimer = new QTimer();
-    txTimer->setSingleShot(true);
-    txTimer->setInterval(parameters.interval < 20 ? 20 : parameters.interval);
-    connect(txTimer, &QTimer::timeout, txTimer, [=]() {
-        QHostAddress hostAddress(parameters.address);
+    // The datagrams are sent at absolute deadlines, so the interval does not drift.
+    const qint64 interval = qMax(parameters.interval, 1) * 1000000ll;
+    const QHostAddress hostAddress(parameters.address);
+    xToolsDeadlineScheduler* scheduler = new xToolsDeadlineScheduler();
+    scheduler->setSpinThreshold(parameters.interval < 10 ? 1000000 : 0);
+    connect(scheduler, &xToolsDeadlineScheduler::timeout, scheduler, [=]() {
         qint64 ret = udpSocket->writeDatagram(parameters.data, hostAddress, parameters.port);
         if (ret < 0) {
             qWarning() << udpSocket->error();
         } else {
             emit bytesWritten(parameters.data);
         }
-
-        txTimer->start();
     });
-    txTimer->start();
+    scheduler->schedule(0, interval);
 
     exec();
 
-    txTimer->stop();
-    txTimer->deleteLater();
-    txTimer = Q_NULLPTR;
+    scheduler->clear();
+    scheduler->deleteLater();
+    scheduler = Q_NULLPTR;
 
     udpSocket->close();
     udpSocket->deleteLater();
@@ -0,0 +1,94 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "xToolsBenchmark.h"
+#ifdef X_TOOLS_ENABLE_MODULE_CANBUS
+#include "xToolsCanBusBenchmarks.h"
+#endif
+#include "xToolsEchoBenchmarks.h"
+#include "xToolsMicroBenchmarks.h"
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+#include "xToolsModbusBenchmarks.h"
+#endif
+
+static QtMessageHandler defaultMessageHandler = nullptr;
+
+// The tools log every frame, the logs are dropped or the terminal is measured too.
+static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+
+    if (defaultMessageHandler) {
+        defaultMessageHandler(type, context, msg);
+    } else {
+        QTextStream(stderr) << qFormatLogMessage(type, context, msg) << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("xtools-benchmarks");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks of the xTools data paths.");
+    parser.addHelpOption();
+    QCommandLineOption filterOption({"f", "filter"},
+                                    "Run the benchmarks whose names match the regular expression.",
+                                    "regexp");
+    QCommandLineOption outputOption({"o", "output"}, "Write the results to a JSON file.", "file");
+    QCommandLineOption repetitionsOption({"r", "repetitions"},
+                                         "The runs of every benchmark.",
+                                         "count",
+                                         "5");
+    QCommandLineOption minTimeOption({"t", "min-time"},
+                                     "The minimum time of a run, the iterations are calibrated.",
+                                     "ms",
+                                     "200");
+    QCommandLineOption listOption({"l", "list"}, "List the benchmarks.");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Output the logs of the tools.");
+    parser.addOption(filterOption);
+    parser.addOption(outputOption);
+    parser.addOption(repetitionsOption);
+    parser.addOption(minTimeOption);
+    parser.addOption(listOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        defaultMessageHandler = qInstallMessageHandler(messageHandler);
+    }
+
+    xToolsBenchmark runner;
+    xToolsMicroBenchmarks::addBenchmarks(runner);
+    xToolsEchoBenchmarks::addBenchmarks(runner);
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    xToolsModbusBenchmarks::addBenchmarks(runner);
+#endif
+#ifdef X_TOOLS_ENABLE_MODULE_CANBUS
+    xToolsCanBusBenchmarks::addBenchmarks(runner);
+#endif
+
+    if (parser.isSet(listOption)) {
+        QTextStream(stdout) << runner.names().join("\n") << "\n";
+        return 0;
+    }
+
+    xToolsBenchmark::Parameters parameters;
+    parameters.filter = parser.value(filterOption);
+    parameters.outputFileName = parser.value(outputOption);
+    parameters.repetitions = qMax(1, parser.value(repetitionsOption).toInt());
+    parameters.minTime = qMax(1, parser.value(minTimeOption).toInt());
+    return runner.run(parameters) == 0 ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+
+#include "xToolsRateMeter.h"
+
+void xToolsBenchmark::add(const Benchmark &benchmark)
+{
+    m_benchmarks.append(benchmark);
+}
+
+QStringList xToolsBenchmark::names() const
+{
+    QStringList names;
+    for (const Benchmark &benchmark : m_benchmarks) {
+        names.append(benchmark.name);
+    }
+
+    return names;
+}
+
+int xToolsBenchmark::run(const Parameters &parameters)
+{
+    QRegularExpression filter(parameters.filter);
+    if (!filter.isValid()) {
+        QTextStream(stderr) << "Invalid filter: " << filter.errorString() << "\n";
+        return 1;
+    }
+
+    QTextStream(stdout) << QString("%1 %2 %3 %4 %5\n")
+                               .arg(QString("Benchmark"), -48)
+                               .arg(QString("Iterations"), 12)
+                               .arg(QString("Median(ns)"), 14)
+                               .arg(QString("CV(%)"), 8)
+                               .arg(QString("Throughput"), 14);
+
+    int failed = 0;
+    m_results.clear();
+    for (const Benchmark &benchmark : m_benchmarks) {
+        if (!parameters.filter.isEmpty() && !filter.match(benchmark.name).hasMatch()) {
+            continue;
+        }
+
+        Result result = runBenchmark(benchmark, parameters);
+        if (!result.errorString.isEmpty()) {
+            failed++;
+        }
+
+        printResult(result);
+        m_results.append(result);
+    }
+
+    if (parameters.outputFileName.isEmpty()) {
+        return failed;
+    }
+
+    QJsonArray benchmarks;
+    for (const Result &result : m_results) {
+        benchmarks.append(toJson(result));
+    }
+
+    QJsonObject obj;
+    obj.insert("context", context());
+    obj.insert("benchmarks", benchmarks);
+    obj.insert("repetitions", parameters.repetitions);
+    obj.insert("min_time_ms", parameters.minTime);
+
+    QFile file(parameters.outputFileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        QTextStream(stderr) << "Failed to open " << parameters.outputFileName << ": "
+                            << file.errorString() << "\n";
+        return failed + 1;
+    }
+
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Indented));
+    file.close();
+    return failed;
+}
+
+QByteArray xToolsBenchmark::payload(int size, quint32 seed)
+{
+    // xorshift32, the seed must not be 0.
+    quint32 state = seed ? seed : 0x5eed;
+    QByteArray bytes(size, '\0');
+    for (int i = 0; i < size; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        bytes[i] = static_cast<char>(state & 0xff);
+    }
+
+    return bytes;
+}
+
+bool xToolsBenchmark::waitFor(const std::function<bool()> &condition, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > timeout) {
+            return false;
+        }
+
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+        QThread::usleep(50);
+    }
+
+    return true;
+}
+
+xToolsBenchmark::Result xToolsBenchmark::runBenchmark(const Benchmark &benchmark,
+                                                      const Parameters &parameters)
+{
+    Result result;
+    result.name = benchmark.name;
+    result.bytesPerIteration = benchmark.bytesPerIteration;
+
+    if (benchmark.setup && !benchmark.setup()) {
+        result.errorString = QString("setup failed");
+        return result;
+    }
+
+    // The first runs warm up the caches and the threads, they are not recorded.
+    const qint64 minTime = qMax(1, parameters.minTime) * 1000000ll;
+    const qint64 maxIterations = 1ll << 32;
+    qint64 iterations = 1;
+    QElapsedTimer timer;
+    while (true) {
+        timer.start();
+        if (!benchmark.run(iterations)) {
+            result.errorString = QString("run failed");
+            break;
+        }
+
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (elapsed >= minTime || iterations >= maxIterations) {
+            break;
+        }
+
+        // Grow 2-10 times, aim 20% over the minimum time to avoid another calibration run.
+        qint64 estimated = iterations * 10;
+        if (elapsed > 0) {
+            estimated = static_cast<qint64>(iterations * 1.2 * minTime / elapsed);
+        }
+        iterations = qBound(iterations * 2, estimated, iterations * 10);
+    }
+
+    result.iterations = iterations;
+    for (int i = 0; i < parameters.repetitions && result.errorString.isEmpty(); i++) {
+        timer.start();
+        if (!benchmark.run(iterations)) {
+            result.errorString = QString("run failed");
+            break;
+        }
+
+        result.samples.append(static_cast<double>(timer.nsecsElapsed()) / iterations);
+    }
+
+    if (benchmark.teardown) {
+        benchmark.teardown();
+    }
+
+    return result;
+}
+
+QJsonObject xToolsBenchmark::context() const
+{
+#if defined(__clang__)
+    const QString compiler = QString("clang %1").arg(__clang_version__);
+#elif defined(__GNUC__)
+    const QString compiler = QString("gcc %1").arg(__VERSION__);
+#elif defined(_MSC_VER)
+    const QString compiler = QString("msvc %1").arg(_MSC_VER);
+#else
+    const QString compiler = QString("unknown");
+#endif
+
+#if defined(QT_NO_DEBUG)
+    const QString build = QString("release");
+#else
+    const QString build = QString("debug");
+#endif
+
+    QJsonObject obj;
+    obj.insert("date", QDateTime::currentDateTime().toString(Qt::ISODate));
+    obj.insert("host", QSysInfo::machineHostName());
+    obj.insert("os", QSysInfo::prettyProductName());
+    obj.insert("kernel", QSysInfo::kernelType() + " " + QSysInfo::kernelVersion());
+    obj.insert("cpu_architecture", QSysInfo::currentCpuArchitecture());
+    obj.insert("cpus", QThread::idealThreadCount());
+    obj.insert("qt_version", QString(qVersion()));
+    obj.insert("compiler", compiler);
+    obj.insert("build", build);
+    return obj;
+}
+
+QJsonObject xToolsBenchmark::toJson(const Result &result) const
+{
+    QJsonObject obj;
+    obj.insert("name", result.name);
+    obj.insert("iterations", result.iterations);
+    obj.insert("bytes_per_iteration", result.bytesPerIteration);
+    if (!result.errorString.isEmpty()) {
+        obj.insert("error", result.errorString);
+        return obj;
+    }
+
+    QList<double> samples = result.samples;
+    std::sort(samples.begin(), samples.end());
+    const int count = samples.count();
+    double median = samples.at(count / 2);
+    if (count % 2 == 0) {
+        median = (samples.at(count / 2 - 1) + samples.at(count / 2)) / 2;
+    }
+
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    const double mean = sum / count;
+
+    double variance = 0;
+    for (double sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+    const double stddev = count > 1 ? std::sqrt(variance / (count - 1)) : 0;
+
+    QJsonArray samplesArray;
+    for (double sample : result.samples) {
+        samplesArray.append(sample);
+    }
+
+    QJsonObject time;
+    time.insert("min", samples.first());
+    time.insert("max", samples.last());
+    time.insert("median", median);
+    time.insert("mean", mean);
+    time.insert("stddev", stddev);
+    obj.insert("ns_per_iteration", time);
+    obj.insert("samples", samplesArray);
+    obj.insert("iterations_per_second", median > 0 ? 1e9 / median : 0);
+    if (result.bytesPerIteration > 0) {
+        obj.insert("bytes_per_second", median > 0 ? result.bytesPerIteration * 1e9 / median : 0);
+    }
+
+    return obj;
+}
+
+void xToolsBenchmark::printResult(const Result &result) const
+{
+    QTextStream out(stdout);
+    if (!result.errorString.isEmpty()) {
+        out << QString("%1 %2\n").arg(result.name, -48).arg(result.errorString);
+        return;
+    }
+
+    QJsonObject obj = toJson(result);
+    QJsonObject time = obj.value("ns_per_iteration").toObject();
+    const double median = time.value("median").toDouble();
+    const double mean = time.value("mean").toDouble();
+    const double cv = mean > 0 ? time.value("stddev").toDouble() * 100 / mean : 0;
+
+    QString throughput;
+    if (obj.contains("bytes_per_second")) {
+        throughput = xToolsRateMeter::speedString(obj.value("bytes_per_second").toDouble());
+    } else {
+        throughput = QString("%1/s").arg(obj.value("iterations_per_second").toDouble(), 0, 'f', 0);
+    }
+
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg(result.name, -48)
+               .arg(result.iterations, 12)
+               .arg(median, 14, 'f', 1)
+               .arg(cv, 8, 'f', 2)
+               .arg(throughput, 14);
+}
@@ -0,0 +1,72 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <functional>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// A small benchmark runner. The iterations of a benchmark are calibrated until a run takes at
+/// least the minimum time, then the benchmark is run several times with the calibrated iterations.
+/// The results are printed as a table and can be written to a JSON file, so runs of different
+/// builds can be compared.
+class xToolsBenchmark
+{
+public:
+    struct Benchmark
+    {
+        QString name;                 // "group/name/argument", it is matched by the filter.
+        qint64 bytesPerIteration{0};  // 0 = no throughput.
+        std::function<bool()> setup;  // Optional, called once before the first run.
+        std::function<bool(qint64 iterations)> run;
+        std::function<void()> teardown; // Optional, called once after the last run.
+    };
+
+    struct Parameters
+    {
+        QString filter;         // A regular expression, empty = all benchmarks.
+        QString outputFileName; // The JSON file, empty = no file.
+        int repetitions{5};
+        int minTime{200}; // ms, the minimum time of a calibrated run.
+    };
+
+    struct Result
+    {
+        QString name;
+        qint64 iterations{0};
+        qint64 bytesPerIteration{0};
+        QList<double> samples; // ns per iteration, one sample per repetition.
+        QString errorString;
+    };
+
+public:
+    void add(const Benchmark &benchmark);
+    QStringList names() const;
+    /// Returns the number of failed benchmarks.
+    int run(const Parameters &parameters);
+
+    /// The same payload is returned for the same size and seed, the results of two runs are
+    /// comparable.
+    static QByteArray payload(int size, quint32 seed = 0x5eed);
+    /// Process the events of the current thread until the condition is true or the timeout(ms).
+    static bool waitFor(const std::function<bool()> &condition, int timeout = 5000);
+
+private:
+    QList<Benchmark> m_benchmarks;
+    QList<Result> m_results;
+
+private:
+    Result runBenchmark(const Benchmark &benchmark, const Parameters &parameters);
+    QJsonObject context() const;
+    QJsonObject toJson(const Result &result) const;
+    void printResult(const Result &result) const;
+};
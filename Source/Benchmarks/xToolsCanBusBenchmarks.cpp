@@ -0,0 +1,75 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusBenchmarks.h"
+
+#include <memory>
+#include <QCanBusFrame>
+#include <QVector>
+
+#include "xToolsCanBusStatistics.h"
+
+static volatile qint64 sink = 0;
+
+void xToolsCanBusBenchmarks::addBenchmarks(xToolsBenchmark &runner)
+{
+    addStatisticsBenchmarks(runner, 16);
+    addStatisticsBenchmarks(runner, 2048);
+    addFrameBitsBenchmarks(runner);
+}
+
+void xToolsCanBusBenchmarks::addStatisticsBenchmarks(xToolsBenchmark &runner, int ids)
+{
+    // Half of the ids are extended, so the standard and the extended keys of an id differ.
+    QVector<QCanBusFrame> frames;
+    for (int i = 0; i < ids; i++) {
+        QCanBusFrame frame(quint32(i * 7919) & 0x7ff, xToolsBenchmark::payload(8, quint32(i)));
+        frame.setExtendedFrameFormat(i % 2);
+        frames.append(frame);
+    }
+
+    auto statistics = std::make_shared<xToolsCanBusStatistics>();
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("canbus/statistics/add/%1").arg(ids);
+    benchmark.run = [statistics, frames](qint64 iterations) {
+        const int count = frames.count();
+        for (qint64 i = 0; i < iterations; i++) {
+            statistics->add(frames.at(int(i % count)), false, i * 100);
+        }
+        sink = sink + statistics->frames();
+        return statistics->idCount() <= count;
+    };
+    runner.add(benchmark);
+}
+
+void xToolsCanBusBenchmarks::addFrameBitsBenchmarks(xToolsBenchmark &runner)
+{
+    QCanBusFrame classicFrame(0x123, xToolsBenchmark::payload(8));
+    QCanBusFrame fdFrame(0x123, xToolsBenchmark::payload(64));
+    fdFrame.setFlexibleDataRateFormat(true);
+    fdFrame.setBitrateSwitch(true);
+
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("canbus/frame_bits/classic_8");
+    benchmark.run = [classicFrame](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            sink = sink + xToolsCanBusStatistics::frameBits(classicFrame).nominalBits;
+        }
+        return true;
+    };
+    runner.add(benchmark);
+
+    benchmark.name = QString("canbus/frame_bits/fd_64");
+    benchmark.run = [fdFrame](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            sink = sink + xToolsCanBusStatistics::frameBits(fdFrame).dataBits;
+        }
+        return true;
+    };
+    runner.add(benchmark);
+}
@@ -0,0 +1,24 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "xToolsBenchmark.h"
+
+/// The CAN bus statistics without a device, an iteration adds a frame of a rotating set of ids.
+/// The cost of a frame should not depend on the number of ids. The frame bits benchmarks compute
+/// the length of a classic frame and of a 64 bytes CAN FD frame.
+class xToolsCanBusBenchmarks
+{
+public:
+    static void addBenchmarks(xToolsBenchmark &runner);
+
+private:
+    static void addStatisticsBenchmarks(xToolsBenchmark &runner, int ids);
+    static void addFrameBitsBenchmarks(xToolsBenchmark &runner);
+};
@@ -0,0 +1,366 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsEchoBenchmarks.h"
+
+#include <atomic>
+#include <memory>
+#include <QEventLoop>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QWebSocket>
+
+#include "IO/IO/Communication/TcpServer.h"
+#include "IO/IO/Communication/UdpServer.h"
+#include "IO/IO/Communication/WebSocketServer.h"
+#include "IO/xIO.h"
+
+#if defined(X_TOOLS_ENABLE_MODULE_SERIALPORT) && defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "IO/IO/Communication/SerialPort.h"
+#endif
+
+void xToolsEchoBenchmarks::addBenchmarks(xToolsBenchmark &runner)
+{
+    addTcpBenchmarks(runner, 64);
+    addTcpBenchmarks(runner, 4096);
+    addUdpBenchmarks(runner, 64);
+    addUdpBenchmarks(runner, 1024);
+    addWebSocketBenchmarks(runner, 64);
+    addWebSocketBenchmarks(runner, 4096);
+#if defined(X_TOOLS_ENABLE_MODULE_SERIALPORT) && defined(Q_OS_LINUX)
+    addSerialPortBenchmarks(runner, 64);
+    addSerialPortBenchmarks(runner, 1024);
+#endif
+}
+
+void xToolsEchoBenchmarks::addTcpBenchmarks(xToolsBenchmark &runner, int size)
+{
+    struct Context
+    {
+        TcpServer *server{nullptr};
+        QTcpSocket *socket{nullptr};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("echo/tcp/%1").arg(size);
+    benchmark.bytesPerIteration = size;
+    benchmark.setup = [ctx]() {
+        const quint16 port = unusedTcpPort();
+        ctx->server = new TcpServer();
+        QVariantMap parameters;
+        parameters.insert("serverAddress", "127.0.0.1");
+        parameters.insert("serverPort", port);
+        if (!openEchoDevice(ctx->server, parameters)) {
+            return false;
+        }
+
+        ctx->socket = new QTcpSocket();
+        ctx->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        ctx->socket->connectToHost(QHostAddress::LocalHost, port);
+        return ctx->socket->waitForConnected(3000);
+    };
+    benchmark.run = [ctx, bytes](qint64 iterations) {
+        QTcpSocket *socket = ctx->socket;
+        for (qint64 i = 0; i < iterations; i++) {
+            socket->write(bytes);
+            socket->flush();
+
+            qint64 received = 0;
+            while (received < bytes.size()) {
+                if (socket->bytesAvailable() == 0 && !socket->waitForReadyRead(5000)) {
+                    return false;
+                }
+                received += socket->readAll().size();
+            }
+        }
+
+        return true;
+    };
+    benchmark.teardown = [ctx]() {
+        if (ctx->socket) {
+            ctx->socket->abort();
+            delete ctx->socket;
+            ctx->socket = nullptr;
+        }
+
+        closeEchoDevice(ctx->server);
+        ctx->server = nullptr;
+    };
+    runner.add(benchmark);
+}
+
+void xToolsEchoBenchmarks::addUdpBenchmarks(xToolsBenchmark &runner, int size)
+{
+    struct Context
+    {
+        UdpServer *server{nullptr};
+        QUdpSocket *socket{nullptr};
+        quint16 port{0};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("echo/udp/%1").arg(size);
+    benchmark.bytesPerIteration = size;
+    benchmark.setup = [ctx]() {
+        ctx->port = unusedUdpPort();
+        ctx->server = new UdpServer();
+        QVariantMap parameters;
+        parameters.insert("serverAddress", "127.0.0.1");
+        parameters.insert("serverPort", ctx->port);
+        if (!openEchoDevice(ctx->server, parameters)) {
+            return false;
+        }
+
+        ctx->socket = new QUdpSocket();
+        return ctx->socket->bind(QHostAddress::LocalHost, 0);
+    };
+    benchmark.run = [ctx, bytes](qint64 iterations) {
+        QUdpSocket *socket = ctx->socket;
+        QByteArray datagram;
+        for (qint64 i = 0; i < iterations; i++) {
+            socket->writeDatagram(bytes, QHostAddress::LocalHost, ctx->port);
+            if (!socket->hasPendingDatagrams() && !socket->waitForReadyRead(5000)) {
+                return false;
+            }
+
+            datagram.resize(socket->pendingDatagramSize());
+            socket->readDatagram(datagram.data(), datagram.size());
+        }
+
+        return true;
+    };
+    benchmark.teardown = [ctx]() {
+        delete ctx->socket;
+        ctx->socket = nullptr;
+        closeEchoDevice(ctx->server);
+        ctx->server = nullptr;
+    };
+    runner.add(benchmark);
+}
+
+void xToolsEchoBenchmarks::addWebSocketBenchmarks(xToolsBenchmark &runner, int size)
+{
+    struct Context
+    {
+        WebSocketServer *server{nullptr};
+        QWebSocket *socket{nullptr};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("echo/websocket/%1").arg(size);
+    benchmark.bytesPerIteration = size;
+    benchmark.setup = [ctx]() {
+        const quint16 port = unusedTcpPort();
+        ctx->server = new WebSocketServer();
+        QVariantMap parameters;
+        parameters.insert("serverAddress", "127.0.0.1");
+        parameters.insert("serverPort", port);
+        parameters.insert("channel", static_cast<int>(xIO::WebSocketDataChannel::Binary));
+        if (!openEchoDevice(ctx->server, parameters)) {
+            return false;
+        }
+
+        ctx->socket = new QWebSocket();
+        ctx->socket->open(QUrl(QString("ws://127.0.0.1:%1").arg(port)));
+        return xToolsBenchmark::waitFor([ctx]() {
+            return ctx->socket->state() == QAbstractSocket::ConnectedState;
+        });
+    };
+    benchmark.run = [ctx, bytes](qint64 iterations) {
+        // QWebSocket has no blocking api, the messages are sent from the event loop.
+        QEventLoop loop;
+        qint64 count = 0;
+        bool timeout = false;
+        QTimer timer;
+        timer.setSingleShot(true);
+        QObject::connect(&timer, &QTimer::timeout, &loop, [&]() {
+            timeout = true;
+            loop.quit();
+        });
+        QObject::connect(ctx->socket,
+                         &QWebSocket::binaryMessageReceived,
+                         &loop,
+                         [&](const QByteArray &) {
+                             if (++count < iterations) {
+                                 ctx->socket->sendBinaryMessage(bytes);
+                             } else {
+                                 loop.quit();
+                             }
+                         });
+
+        timer.start(60 * 1000);
+        ctx->socket->sendBinaryMessage(bytes);
+        loop.exec();
+        return !timeout;
+    };
+    benchmark.teardown = [ctx]() {
+        if (ctx->socket) {
+            ctx->socket->abort();
+            delete ctx->socket;
+            ctx->socket = nullptr;
+        }
+
+        closeEchoDevice(ctx->server);
+        ctx->server = nullptr;
+    };
+    runner.add(benchmark);
+}
+
+#if defined(X_TOOLS_ENABLE_MODULE_SERIALPORT) && defined(Q_OS_LINUX)
+void xToolsEchoBenchmarks::addSerialPortBenchmarks(xToolsBenchmark &runner, int size)
+{
+    struct Context
+    {
+        SerialPort *serialPort{nullptr};
+        int master{-1};
+        int slave{-1};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("echo/serialport/%1").arg(size);
+    benchmark.bytesPerIteration = size;
+    benchmark.setup = [ctx]() {
+        // The slave end is kept open, or reading the master end fails when the port is closed.
+        if (openpty(&ctx->master, &ctx->slave, nullptr, nullptr, nullptr) != 0) {
+            return false;
+        }
+
+        struct termios options;
+        tcgetattr(ctx->slave, &options);
+        cfmakeraw(&options);
+        tcsetattr(ctx->slave, TCSANOW, &options);
+
+        ctx->serialPort = new SerialPort();
+        QVariantMap parameters;
+        parameters.insert("portName", QString::fromLocal8Bit(ttyname(ctx->slave)));
+        parameters.insert("baudRate", 115200);
+        parameters.insert("dataBits", 8);
+        parameters.insert("parity", 0);
+        parameters.insert("stopBits", 1);
+        parameters.insert("flowControl", 0);
+        return openEchoDevice(ctx->serialPort, parameters);
+    };
+    benchmark.run = [ctx, bytes](qint64 iterations) {
+        char buffer[4096];
+        for (qint64 i = 0; i < iterations; i++) {
+            qint64 written = 0;
+            while (written < bytes.size()) {
+                ssize_t ret = ::write(ctx->master,
+                                      bytes.constData() + written,
+                                      bytes.size() - written);
+                if (ret <= 0) {
+                    return false;
+                }
+                written += ret;
+            }
+
+            qint64 received = 0;
+            while (received < bytes.size()) {
+                struct pollfd fd = {ctx->master, POLLIN, 0};
+                if (poll(&fd, 1, 5000) <= 0) {
+                    return false;
+                }
+
+                ssize_t ret = ::read(ctx->master, buffer, sizeof(buffer));
+                if (ret <= 0) {
+                    return false;
+                }
+                received += ret;
+            }
+        }
+
+        return true;
+    };
+    benchmark.teardown = [ctx]() {
+        closeEchoDevice(ctx->serialPort);
+        ctx->serialPort = nullptr;
+        if (ctx->master >= 0) {
+            ::close(ctx->master);
+            ::close(ctx->slave);
+            ctx->master = -1;
+            ctx->slave = -1;
+        }
+    };
+    runner.add(benchmark);
+}
+#endif
+
+bool xToolsEchoBenchmarks::openEchoDevice(Communication *device, const QVariantMap &parameters)
+{
+    QObject::connect(
+        device,
+        &Communication::bytesRead,
+        device,
+        [device](const QByteArray &bytes, const QString &) { device->inputBytes(bytes); },
+        Qt::DirectConnection);
+
+    // The signals are emitted in the thread of the device.
+    auto opened = std::make_shared<std::atomic_bool>(false);
+    auto closed = std::make_shared<std::atomic_bool>(false);
+    QObject::connect(
+        device,
+        &Communication::opened,
+        device,
+        [opened]() { *opened = true; },
+        Qt::DirectConnection);
+    QObject::connect(
+        device,
+        &Communication::closed,
+        device,
+        [closed]() { *closed = true; },
+        Qt::DirectConnection);
+
+    device->setParameters(parameters);
+    device->openDevice();
+    xToolsBenchmark::waitFor([opened, closed]() { return *opened || *closed; });
+    return *opened;
+}
+
+void xToolsEchoBenchmarks::closeEchoDevice(Communication *device)
+{
+    if (device) {
+        device->closeDevice();
+        delete device;
+    }
+}
+
+quint16 xToolsEchoBenchmarks::unusedTcpPort()
+{
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+
+    return server.serverPort();
+}
+
+quint16 xToolsEchoBenchmarks::unusedUdpPort()
+{
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+
+    return socket.localPort();
+}
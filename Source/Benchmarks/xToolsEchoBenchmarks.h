@@ -0,0 +1,37 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QVariantMap>
+
+#include "xToolsBenchmark.h"
+
+class Communication;
+
+/// Round trips through the communication devices. The device echoes the bytes that it reads, the
+/// client in the main thread writes a message and waits for the echo, an iteration is a round trip.
+/// The sockets are bound to 127.0.0.1, the serial port is one end of a pseudo terminal pair.
+class xToolsEchoBenchmarks
+{
+public:
+    static void addBenchmarks(xToolsBenchmark &runner);
+    static quint16 unusedTcpPort();
+
+private:
+    static void addTcpBenchmarks(xToolsBenchmark &runner, int size);
+    static void addUdpBenchmarks(xToolsBenchmark &runner, int size);
+    static void addWebSocketBenchmarks(xToolsBenchmark &runner, int size);
+#if defined(X_TOOLS_ENABLE_MODULE_SERIALPORT) && defined(Q_OS_LINUX)
+    static void addSerialPortBenchmarks(xToolsBenchmark &runner, int size);
+#endif
+
+    static bool openEchoDevice(Communication *device, const QVariantMap &parameters);
+    static void closeEchoDevice(Communication *device);
+    static quint16 unusedUdpPort();
+};
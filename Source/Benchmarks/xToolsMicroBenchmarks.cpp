@@ -0,0 +1,356 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsMicroBenchmarks.h"
+
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPair>
+#include <QVector>
+
+#include "IO/IO/Processor/ModbusDecoder.h"
+#include "IO/IO/Processor/Statistician.h"
+#include "IO/xIO.h"
+#include "xToolsAnalyzerTool.h"
+#include "xToolsCaptureFile.h"
+#include "xToolsDataStructure.h"
+#include "xToolsHdrHistogram.h"
+#include "xToolsRateMeter.h"
+#include "xToolsResponserTool.h"
+#include "xToolsRuleProgram.h"
+
+// Written by the benchmarks, so the compiler can not drop the measured calls.
+static volatile qint64 sink = 0;
+
+void xToolsMicroBenchmarks::addBenchmarks(xToolsBenchmark &runner)
+{
+    addCodecBenchmarks(runner);
+    addCrcBenchmarks(runner);
+    addMeterBenchmarks(runner);
+    addRuleBenchmarks(runner);
+    addToolBenchmarks(runner);
+    addDecoderBenchmarks(runner, ModbusDecoder::FramingRtu);
+    addDecoderBenchmarks(runner, ModbusDecoder::FramingTcp);
+}
+
+void xToolsMicroBenchmarks::addCodecBenchmarks(xToolsBenchmark &runner)
+{
+    const QList<QPair<xIO::TextFormat, QString>> formats{
+        qMakePair(xIO::TextFormat::Bin, QString("bin")),
+        qMakePair(xIO::TextFormat::Oct, QString("oct")),
+        qMakePair(xIO::TextFormat::Dec, QString("dec")),
+        qMakePair(xIO::TextFormat::Hex, QString("hex")),
+        qMakePair(xIO::TextFormat::Ascii, QString("ascii")),
+        qMakePair(xIO::TextFormat::Utf8, QString("utf8")),
+    };
+
+    const int size = 1024;
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    for (const auto &format : formats) {
+        const xIO::TextFormat textFormat = format.first;
+
+        xToolsBenchmark::Benchmark encode;
+        encode.name = QString("codec/bytes2string/%1/%2").arg(format.second).arg(size);
+        encode.bytesPerIteration = size;
+        encode.run = [bytes, textFormat](qint64 iterations) {
+            for (qint64 i = 0; i < iterations; i++) {
+                sink = sink + xIO::bytes2string(bytes, textFormat).length();
+            }
+            return true;
+        };
+        runner.add(encode);
+
+        const QString text = xIO::bytes2string(bytes, textFormat);
+        xToolsBenchmark::Benchmark decode;
+        decode.name = QString("codec/string2bytes/%1/%2").arg(format.second).arg(size);
+        decode.bytesPerIteration = size;
+        decode.run = [text, textFormat](qint64 iterations) {
+            for (qint64 i = 0; i < iterations; i++) {
+                sink = sink + xIO::string2bytes(text, textFormat).length();
+            }
+            return true;
+        };
+        runner.add(decode);
+    }
+}
+
+void xToolsMicroBenchmarks::addCrcBenchmarks(xToolsBenchmark &runner)
+{
+    const int size = 4096;
+    const QByteArray bytes = xToolsBenchmark::payload(size);
+    const QList<int> algorithms = xIO::supportedCrcAlgorithms();
+    for (int algorithm : algorithms) {
+        auto crcAlgorithm = static_cast<xIO::CrcAlgorithm>(algorithm);
+        QString name = xIO::crcAlgorithmName(crcAlgorithm).toLower().replace('/', '-');
+
+        xToolsBenchmark::Benchmark benchmark;
+        benchmark.name = QString("crc/%1/%2").arg(name).arg(size);
+        benchmark.bytesPerIteration = size;
+        benchmark.run = [bytes, crcAlgorithm](qint64 iterations) {
+            for (qint64 i = 0; i < iterations; i++) {
+                sink = sink + xIO::calculateCrc(bytes, crcAlgorithm, true).length();
+            }
+            return true;
+        };
+        runner.add(benchmark);
+    }
+}
+
+void xToolsMicroBenchmarks::addMeterBenchmarks(xToolsBenchmark &runner)
+{
+    auto rateMeter = std::make_shared<xToolsRateMeter>();
+    xToolsBenchmark::Benchmark rate;
+    rate.name = QString("meter/rate_meter_add");
+    rate.run = [rateMeter](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            rateMeter->add(64);
+        }
+        sink = sink + rateMeter->totalFrames();
+        return true;
+    };
+    runner.add(rate);
+
+    // Latencies from 1us to 1s in ns, spread over the buckets.
+    QVector<qint64> values(1024);
+    for (int i = 0; i < values.size(); i++) {
+        values[i] = 1000 + (static_cast<qint64>(i) * 7919 * 12289) % (1000 * 1000 * 1000);
+    }
+
+    auto histogram = std::make_shared<xToolsHdrHistogram>();
+    xToolsBenchmark::Benchmark hdr;
+    hdr.name = QString("meter/hdr_histogram_record");
+    hdr.run = [histogram, values](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            histogram->record(values.at(i & 1023));
+        }
+        sink = sink + histogram->count();
+        return true;
+    };
+    runner.add(hdr);
+}
+
+void xToolsMicroBenchmarks::addRuleBenchmarks(xToolsBenchmark &runner)
+{
+    // A modbus read holding registers request.
+    const QByteArray frame = QByteArray::fromHex("010300100002c5ce");
+    auto program = std::make_shared<xToolsRuleProgram>();
+    program->compile("match(0, \"01 03\"); len == 8; address = u16[2]; count = u16[4]; "
+                     "address + count <= 100",
+                     "01 03 {count * 2} {slice(2, 4)} {address:u16} {crc:CRC_16_MODBUS:le}");
+    auto context = std::make_shared<xToolsRuleProgram::Context>();
+
+    xToolsBenchmark::Benchmark match;
+    match.name = QString("rule/match/modbus");
+    match.bytesPerIteration = frame.size();
+    match.run = [program, context, frame](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            sink = sink + program->match(frame, *context);
+        }
+        return program->isValid();
+    };
+    runner.add(match);
+
+    xToolsBenchmark::Benchmark response;
+    response.name = QString("rule/response/modbus");
+    response.bytesPerIteration = frame.size();
+    response.run = [program, context, frame](qint64 iterations) {
+        QByteArray bytes;
+        for (qint64 i = 0; i < iterations; i++) {
+            bytes.clear();
+            if (program->match(frame, *context)) {
+                program->response(frame, *context, bytes);
+            }
+            sink = sink + bytes.size();
+        }
+        return program->isValid();
+    };
+    runner.add(response);
+}
+
+void xToolsMicroBenchmarks::addToolBenchmarks(xToolsBenchmark &runner)
+{
+    // The statistician counts the bytes only when its thread is running.
+    auto statistician = std::make_shared<Statistician *>(nullptr);
+    const QByteArray frame = xToolsBenchmark::payload(64);
+    xToolsBenchmark::Benchmark statisticianBenchmark;
+    statisticianBenchmark.name = QString("tools/statistician/%1").arg(frame.size());
+    statisticianBenchmark.bytesPerIteration = frame.size();
+    statisticianBenchmark.setup = [statistician]() {
+        *statistician = new Statistician();
+        (*statistician)->start();
+        return xToolsBenchmark::waitFor([statistician]() { return (*statistician)->isWorking(); });
+    };
+    statisticianBenchmark.run = [statistician, frame](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            (*statistician)->inputBytes(frame);
+        }
+        return true;
+    };
+    statisticianBenchmark.teardown = [statistician]() {
+        (*statistician)->exit();
+        (*statistician)->wait();
+        delete *statistician;
+        *statistician = nullptr;
+    };
+    runner.add(statisticianBenchmark);
+
+    // The analyzer and the responser handle the bytes in their own threads, an iteration is a
+    // frame that has gone through the tool.
+    struct ToolContext
+    {
+        xToolsBaseTool *tool{nullptr};
+        std::atomic<qint64> outputFrames{0};
+    };
+
+    auto setupTool = [](std::shared_ptr<ToolContext> ctx, xToolsBaseTool *tool) {
+        ctx->tool = tool;
+        QObject::connect(
+            tool,
+            &xToolsBaseTool::outputBytes,
+            tool,
+            [ctx](const QByteArray &) { ctx->outputFrames++; },
+            Qt::DirectConnection);
+        tool->start();
+        return xToolsBenchmark::waitFor([tool]() { return tool->isWorking(); });
+    };
+    auto runTool = [](std::shared_ptr<ToolContext> ctx, const QByteArray &bytes, qint64 count) {
+        ctx->outputFrames = 0;
+        for (qint64 i = 0; i < count; i++) {
+            ctx->tool->inputBytes(bytes);
+        }
+
+        return xToolsBenchmark::waitFor([ctx, count]() { return ctx->outputFrames >= count; },
+                                        60 * 1000);
+    };
+    auto teardownTool = [](std::shared_ptr<ToolContext> ctx) {
+        ctx->tool->exit();
+        ctx->tool->wait();
+        delete ctx->tool;
+        ctx->tool = nullptr;
+    };
+
+    auto fixed = std::make_shared<ToolContext>();
+    const QByteArray fixedFrame = xToolsBenchmark::payload(16);
+    xToolsBenchmark::Benchmark fixedBenchmark;
+    fixedBenchmark.name = QString("tools/analyzer/fixed/%1").arg(fixedFrame.size());
+    fixedBenchmark.bytesPerIteration = fixedFrame.size();
+    fixedBenchmark.setup = [fixed, setupTool]() {
+        auto analyzer = new xToolsAnalyzerTool();
+        analyzer->setFixed(true);
+        analyzer->setFrameBytes(16);
+        analyzer->setMaxTempBytes(INT_MAX);
+        analyzer->setIsEnable(true);
+        return setupTool(fixed, analyzer);
+    };
+    fixedBenchmark.run = [fixed, fixedFrame, runTool](qint64 iterations) {
+        return runTool(fixed, fixedFrame, iterations);
+    };
+    fixedBenchmark.teardown = [fixed, teardownTool]() { teardownTool(fixed); };
+    runner.add(fixedBenchmark);
+
+    auto separation = std::make_shared<ToolContext>();
+    const QByteArray separationFrame = xToolsBenchmark::payload(14).toHex().left(14) + "\r\n";
+    xToolsBenchmark::Benchmark separationBenchmark;
+    separationBenchmark.name = QString("tools/analyzer/separation/%1").arg(separationFrame.size());
+    separationBenchmark.bytesPerIteration = separationFrame.size();
+    separationBenchmark.setup = [separation, setupTool]() {
+        auto analyzer = new xToolsAnalyzerTool();
+        analyzer->setFixed(false);
+        analyzer->setSeparationMark(QByteArray("\r\n"));
+        analyzer->setMaxTempBytes(INT_MAX);
+        analyzer->setIsEnable(true);
+        return setupTool(separation, analyzer);
+    };
+    separationBenchmark.run = [separation, separationFrame, runTool](qint64 iterations) {
+        return runTool(separation, separationFrame, iterations);
+    };
+    separationBenchmark.teardown = [separation, teardownTool]() { teardownTool(separation); };
+    runner.add(separationBenchmark);
+
+    // Every frame is compared with all rules, only the last rule matches.
+    const int rules = 16;
+    auto responser = std::make_shared<ToolContext>();
+    const QByteArray reference = QString("reference-%1").arg(rules - 1).toLatin1();
+    xToolsBenchmark::Benchmark responserBenchmark;
+    responserBenchmark.name = QString("tools/responser/equal/%1").arg(rules);
+    responserBenchmark.bytesPerIteration = reference.size();
+    responserBenchmark.setup = [responser, setupTool, rules]() {
+        auto tool = new xToolsResponserTool();
+        xToolsResponserTool::ResponserItemKeys keys;
+        for (int i = 0; i < rules; i++) {
+            QJsonObject item = tool->itemContext(-1).toJsonObject();
+            item.insert(keys.itemOption, xToolsDataStructure::ResponseOptionInputEqualReference);
+            item.insert(keys.itemReferenceText, QString("reference-%1").arg(i));
+            item.insert(keys.itemResponseText, QString("response-%1").arg(i));
+            tool->addItem(QString::fromUtf8(QJsonDocument(item).toJson()));
+        }
+
+        return setupTool(responser, tool);
+    };
+    responserBenchmark.run = [responser, reference, runTool](qint64 iterations) {
+        return runTool(responser, reference, iterations);
+    };
+    responserBenchmark.teardown = [responser, teardownTool]() { teardownTool(responser); };
+    runner.add(responserBenchmark);
+}
+
+void xToolsMicroBenchmarks::addDecoderBenchmarks(xToolsBenchmark &runner, int framing)
+{
+    // An iteration is a transaction, reading 10 holding registers of unit 1. The timestamps of
+    // the bytes are the same, the rtu frames are split by the crc only.
+    QByteArray request = QByteArray::fromHex("01030000000a");
+    QByteArray response = QByteArray::fromHex("010314");
+    response.append(xToolsBenchmark::payload(20));
+    const bool isTcp = framing == ModbusDecoder::FramingTcp;
+    if (isTcp) {
+        const QByteArray header = QByteArray::fromHex("0001000000");
+        request.prepend(header + char(request.size()));
+        response.prepend(header + char(response.size()));
+    } else {
+        request.append(xIO::calculateCrc(request, xIO::CrcAlgorithm::CRC_16_MODBUS, false));
+        response.append(xIO::calculateCrc(response, xIO::CrcAlgorithm::CRC_16_MODBUS, false));
+    }
+
+    auto decoder = std::make_shared<ModbusDecoder *>(nullptr);
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("tools/modbus_decoder/%1").arg(isTcp ? "tcp" : "rtu");
+    benchmark.bytesPerIteration = request.size() + response.size();
+    benchmark.setup = [decoder, framing]() {
+        *decoder = new ModbusDecoder();
+        ModbusDecoder::Parameters parameters;
+        parameters.framing = framing;
+        (*decoder)->setParameters(parameters);
+        (*decoder)->start();
+        return xToolsBenchmark::waitFor([decoder]() { return (*decoder)->isWorking(); });
+    };
+    benchmark.run = [decoder, request, response](qint64 iterations) {
+        const qint64 timestamp = xToolsCaptureFile::currentTimestamp();
+        const QString peer("benchmark");
+        for (qint64 i = 0; i < iterations; i++) {
+            (*decoder)->inputTx(request, peer, timestamp);
+            (*decoder)->inputRx(response, peer, timestamp);
+            if ((i & 0xfff) == 0xfff) {
+                sink = sink + (*decoder)->takeRows().size();
+            }
+        }
+
+        sink = sink + (*decoder)->takeRows().size();
+        ModbusDecoder::Statistics statistics = (*decoder)->statistics();
+        return statistics.crcErrors == 0 && statistics.invalidFrames == 0;
+    };
+    benchmark.teardown = [decoder]() {
+        (*decoder)->exit();
+        (*decoder)->wait();
+        delete *decoder;
+        *decoder = nullptr;
+    };
+    runner.add(benchmark);
+}
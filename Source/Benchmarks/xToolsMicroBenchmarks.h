@@ -0,0 +1,28 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "xToolsBenchmark.h"
+
+/// The benchmarks of the data path without any device: the text codecs, the crc algorithms, the
+/// meters, the rule programs, the statistician, the framing of the analyzer, the rule matching of
+/// the responser and the modbus decoder.
+class xToolsMicroBenchmarks
+{
+public:
+    static void addBenchmarks(xToolsBenchmark &runner);
+
+private:
+    static void addCodecBenchmarks(xToolsBenchmark &runner);
+    static void addCrcBenchmarks(xToolsBenchmark &runner);
+    static void addMeterBenchmarks(xToolsBenchmark &runner);
+    static void addRuleBenchmarks(xToolsBenchmark &runner);
+    static void addToolBenchmarks(xToolsBenchmark &runner);
+    static void addDecoderBenchmarks(xToolsBenchmark &runner, int framing);
+};
@@ -0,0 +1,236 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusBenchmarks.h"
+
+#include <memory>
+#include <QEventLoop>
+#include <QModbusTcpServer>
+#include <QTimer>
+
+#include "xToolsEchoBenchmarks.h"
+#include "xToolsModbusRegisterStore.h"
+#include "xToolsModbusSimulator.h"
+#include "xToolsModbusTcpPipeline.h"
+
+void xToolsModbusBenchmarks::addBenchmarks(xToolsBenchmark &runner)
+{
+    addPipelineBenchmarks(runner, 1, 1);
+    addPipelineBenchmarks(runner, 1, 4);
+    addPipelineBenchmarks(runner, 1, 16);
+    addPipelineBenchmarks(runner, 1, 64);
+    addPipelineBenchmarks(runner, 4, 16);
+    addRegisterStoreBenchmarks(runner);
+    addSimulatorBenchmarks(runner, 1);
+    addSimulatorBenchmarks(runner, 200);
+}
+
+void xToolsModbusBenchmarks::addPipelineBenchmarks(xToolsBenchmark &runner,
+                                                   int connections,
+                                                   int window)
+{
+    struct Context
+    {
+        QModbusTcpServer *server{nullptr};
+        xToolsModbusTcpPipeline *pipeline{nullptr};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("modbus/tcp_pipeline/%1x%2").arg(connections).arg(window);
+    benchmark.setup = [ctx, connections, window]() {
+        const quint16 port = xToolsEchoBenchmarks::unusedTcpPort();
+        ctx->server = new QModbusTcpServer();
+        QModbusDataUnitMap map;
+        map.insert(QModbusDataUnit::HoldingRegisters,
+                   QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 0, 100));
+        ctx->server->setMap(map);
+        ctx->server->setServerAddress(1);
+        ctx->server->setConnectionParameter(QModbusDevice::NetworkAddressParameter, "127.0.0.1");
+        ctx->server->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+        if (!ctx->server->connectDevice()) {
+            return false;
+        }
+
+        xToolsModbusTcpPipeline::Parameters parameters;
+        parameters.port = port;
+        parameters.connections = connections;
+        parameters.window = window;
+        parameters.timeout = 5000;
+        ctx->pipeline = new xToolsModbusTcpPipeline();
+        ctx->pipeline->setParameters(parameters);
+
+        QEventLoop loop;
+        QTimer::singleShot(3000, &loop, &QEventLoop::quit);
+        QObject::connect(ctx->pipeline,
+                         &xToolsModbusTcpPipeline::connected,
+                         &loop,
+                         &QEventLoop::quit);
+        ctx->pipeline->connectDevice();
+        loop.exec();
+        return ctx->pipeline->isConnected();
+    };
+    benchmark.run = [ctx, connections, window](qint64 iterations) {
+        const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 10);
+        qint64 sent = 0;
+        qint64 finished = 0;
+        bool isOk = true;
+
+        QEventLoop loop;
+        auto onFinished = [&](quint64, int error, const QModbusResponse &) {
+            isOk &= error == xToolsModbusTcpPipeline::NoError;
+            if (sent < iterations) {
+                ctx->pipeline->sendReadRequest(unit, 1);
+                sent++;
+            }
+
+            if (++finished == iterations) {
+                loop.quit();
+            }
+        };
+        auto connection = QObject::connect(ctx->pipeline,
+                                           &xToolsModbusTcpPipeline::finished,
+                                           &loop,
+                                           onFinished);
+
+        // Fill the windows, every finished request sends the next one.
+        const qint64 inFlight = qMin(iterations, qint64(connections) * window);
+        for (; sent < inFlight; sent++) {
+            ctx->pipeline->sendReadRequest(unit, 1);
+        }
+
+        loop.exec();
+        QObject::disconnect(connection);
+        return isOk;
+    };
+    benchmark.teardown = [ctx]() {
+        delete ctx->pipeline;
+        ctx->pipeline = nullptr;
+        if (ctx->server) {
+            ctx->server->disconnectDevice();
+            delete ctx->server;
+            ctx->server = nullptr;
+        }
+    };
+    runner.add(benchmark);
+}
+
+void xToolsModbusBenchmarks::addRegisterStoreBenchmarks(xToolsBenchmark &runner)
+{
+    auto store = std::make_shared<xToolsModbusRegisterStore>();
+    const QVector<quint16> values(125, 0x1234);
+
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = "modbus/register_store/set_range";
+    benchmark.run = [store, values](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            int address = int((i * 125) % (xToolsModbusRegisterStore::tableSize - 125));
+            store->setRange(QModbusDataUnit::HoldingRegisters, address, values);
+        }
+        return true;
+    };
+    runner.add(benchmark);
+
+    // A snapshot is alive while the values are written, every write copies the table once.
+    benchmark.name = "modbus/register_store/set_range_with_snapshot";
+    benchmark.run = [store, values](qint64 iterations) {
+        for (qint64 i = 0; i < iterations; i++) {
+            QVector<quint16> snapshot = store->snapshot(QModbusDataUnit::HoldingRegisters);
+            store->setRange(QModbusDataUnit::HoldingRegisters, 0, values);
+            if (snapshot.isEmpty()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    runner.add(benchmark);
+}
+
+void xToolsModbusBenchmarks::addSimulatorBenchmarks(xToolsBenchmark &runner, int units)
+{
+    struct Context
+    {
+        xToolsModbusSimulator *simulator{nullptr};
+        xToolsModbusTcpPipeline *pipeline{nullptr};
+    };
+
+    auto ctx = std::make_shared<Context>();
+    xToolsBenchmark::Benchmark benchmark;
+    benchmark.name = QString("modbus/simulator/%1_units").arg(units);
+    benchmark.setup = [ctx, units]() {
+        xToolsModbusSimulator::Parameters simulatorParameters;
+        simulatorParameters.address = "127.0.0.1";
+        simulatorParameters.port = xToolsEchoBenchmarks::unusedTcpPort();
+        ctx->simulator = new xToolsModbusSimulator();
+        ctx->simulator->setParameters(simulatorParameters);
+        for (int unitId = 1; unitId <= units; unitId++) {
+            ctx->simulator->addUnit(unitId);
+            ctx->simulator->addRange(unitId, QModbusDataUnit::HoldingRegisters, 0, 100);
+        }
+        if (!ctx->simulator->start()) {
+            return false;
+        }
+
+        xToolsModbusTcpPipeline::Parameters parameters;
+        parameters.port = simulatorParameters.port;
+        parameters.connections = 4;
+        parameters.window = 16;
+        parameters.timeout = 5000;
+        ctx->pipeline = new xToolsModbusTcpPipeline();
+        ctx->pipeline->setParameters(parameters);
+
+        QEventLoop loop;
+        QTimer::singleShot(3000, &loop, &QEventLoop::quit);
+        QObject::connect(ctx->pipeline,
+                         &xToolsModbusTcpPipeline::connected,
+                         &loop,
+                         &QEventLoop::quit);
+        ctx->pipeline->connectDevice();
+        loop.exec();
+        return ctx->pipeline->isConnected();
+    };
+    benchmark.run = [ctx, units](qint64 iterations) {
+        const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 10);
+        qint64 sent = 0;
+        qint64 finished = 0;
+        bool isOk = true;
+
+        QEventLoop loop;
+        auto onFinished = [&](quint64, int error, const QModbusResponse &) {
+            isOk &= error == xToolsModbusTcpPipeline::NoError;
+            if (sent < iterations) {
+                ctx->pipeline->sendReadRequest(unit, int(sent % units) + 1);
+                sent++;
+            }
+
+            if (++finished == iterations) {
+                loop.quit();
+            }
+        };
+        auto connection = QObject::connect(ctx->pipeline,
+                                           &xToolsModbusTcpPipeline::finished,
+                                           &loop,
+                                           onFinished);
+
+        const qint64 inFlight = qMin(iterations, qint64(4 * 16));
+        for (; sent < inFlight; sent++) {
+            ctx->pipeline->sendReadRequest(unit, int(sent % units) + 1);
+        }
+
+        loop.exec();
+        QObject::disconnect(connection);
+        return isOk;
+    };
+    benchmark.teardown = [ctx]() {
+        delete ctx->pipeline;
+        ctx->pipeline = nullptr;
+        delete ctx->simulator;
+        ctx->simulator = nullptr;
+    };
+    runner.add(benchmark);
+}
@@ -0,0 +1,27 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "xToolsBenchmark.h"
+
+/// Polls of a local QModbusTcpServer through the pipelined modbus tcp client, an iteration is a
+/// read of 10 holding registers. The polls per second scale with the window of the pipeline until
+/// the server is saturated. The register store benchmarks write 125 holding registers, the
+/// maximum of a request, per iteration. The simulator benchmarks poll the units of a simulator
+/// round robin with a 4x16 pipeline.
+class xToolsModbusBenchmarks
+{
+public:
+    static void addBenchmarks(xToolsBenchmark &runner);
+
+private:
+    static void addPipelineBenchmarks(xToolsBenchmark &runner, int connections, int window);
+    static void addRegisterStoreBenchmarks(xToolsBenchmark &runner);
+    static void addSimulatorBenchmarks(xToolsBenchmark &runner, int units);
+};
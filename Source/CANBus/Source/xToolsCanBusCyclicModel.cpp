@@ -0,0 +1,234 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusCyclicModel.h"
+
+xToolsCanBusCyclicModel::xToolsCanBusCyclicModel(xToolsCanBusCyclicTransmitter *transmitter,
+                                                 QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_transmitter(transmitter)
+{}
+
+void xToolsCanBusCyclicModel::addMessage(const xToolsCanBusCyclicTransmitter::Message &message)
+{
+    const int row = m_transmitter->messageCount();
+    beginInsertRows(QModelIndex(), row, row);
+    m_transmitter->addMessage(message);
+    endInsertRows();
+    emit messagesChanged();
+}
+
+void xToolsCanBusCyclicModel::removeMessage(int row)
+{
+    if (row < 0 || row >= m_transmitter->messageCount()) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_transmitter->removeMessage(row);
+    endRemoveRows();
+    emit messagesChanged();
+}
+
+void xToolsCanBusCyclicModel::refresh()
+{
+    const int count = m_transmitter->messageCount();
+    if (count > 0) {
+        emit dataChanged(index(0, ColumnFrames), index(count - 1, ColumnJitter));
+    }
+}
+
+int xToolsCanBusCyclicModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_transmitter->messageCount();
+}
+
+int xToolsCanBusCyclicModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnJitter + 1;
+}
+
+QVariant xToolsCanBusCyclicModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const xToolsCanBusCyclicTransmitter::Message &message = m_transmitter->message(index.row());
+    if (role == Qt::CheckStateRole) {
+        if (index.column() == ColumnId) {
+            return message.enabled ? Qt::Checked : Qt::Unchecked;
+        }
+
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        return index.column() == ColumnPayload ? QVariant() : QVariant(int(Qt::AlignCenter));
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        return QVariant();
+    }
+
+    const xToolsCanBusCyclicTransmitter::Statistics statistics = m_transmitter->statistics(
+        index.row());
+    switch (index.column()) {
+    case ColumnId: {
+        const int width = message.isExtended ? 8 : 3;
+        return QString("%1").arg(message.frameId, width, 16, QChar('0')).toUpper();
+    }
+    case ColumnCycle:
+        return message.cycle;
+    case ColumnPayload:
+        return QString::fromLatin1(message.payload.toHex(' ')).toUpper();
+    case ColumnCounter:
+        if (message.counterStart < 0) {
+            return QString();
+        }
+
+        return QString("%1|%2").arg(message.counterStart).arg(message.counterLength);
+    case ColumnCrc:
+        return message.crcByte < 0 ? QString() : QString::number(message.crcByte);
+    case ColumnFrames:
+        return statistics.frames;
+    case ColumnErrors:
+        return statistics.errors;
+    case ColumnMeasuredCycle:
+        if (statistics.frames < 2) {
+            return QString();
+        }
+
+        return QString("%1/%2/%3")
+            .arg(statistics.minCycle / 1000.0, 0, 'f', 3)
+            .arg(statistics.meanCycle / 1000.0, 0, 'f', 3)
+            .arg(statistics.maxCycle / 1000.0, 0, 'f', 3);
+    case ColumnJitter:
+        return QString::number(statistics.jitter / 1000.0, 'f', 3);
+    default:
+        return QVariant();
+    }
+}
+
+bool xToolsCanBusCyclicModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid()) {
+        return false;
+    }
+
+    xToolsCanBusCyclicTransmitter::Message message = m_transmitter->message(index.row());
+    if (role == Qt::CheckStateRole && index.column() == ColumnId) {
+        message.enabled = value.toInt() == Qt::Checked;
+    } else if (role == Qt::EditRole) {
+        const QString text = value.toString().trimmed();
+        bool ok = true;
+        switch (index.column()) {
+        case ColumnId: {
+            const quint32 frameId = text.toUInt(&ok, 16);
+            ok = ok && frameId <= (message.isExtended ? 0x1fffffffu : 0x7ffu);
+            message.frameId = ok ? frameId : message.frameId;
+            break;
+        }
+        case ColumnCycle: {
+            const int cycle = text.toInt(&ok);
+            ok = ok && cycle > 0;
+            message.cycle = ok ? cycle : message.cycle;
+            break;
+        }
+        case ColumnPayload: {
+            const QByteArray payload = QByteArray::fromHex(text.toLatin1());
+            ok = payload.length() <= (message.isFlexibleDataRate ? 64 : 8);
+            message.payload = ok ? payload : message.payload;
+            break;
+        }
+        case ColumnCounter: {
+            // An empty text removes the counter.
+            const QStringList fields = text.split('|');
+            if (text.isEmpty()) {
+                message.counterStart = -1;
+            } else if (fields.size() == 2) {
+                bool isLengthOk = false;
+                const int start = fields.at(0).toInt(&ok);
+                const int length = fields.at(1).toInt(&isLengthOk);
+                ok = ok && isLengthOk && start >= 0 && length >= 1 && length <= 32;
+                message.counterStart = ok ? start : message.counterStart;
+                message.counterLength = ok ? length : message.counterLength;
+            } else {
+                ok = false;
+            }
+            break;
+        }
+        case ColumnCrc: {
+            const int crcByte = text.isEmpty() ? -1 : text.toInt(&ok);
+            ok = ok && crcByte < 64;
+            message.crcByte = ok ? crcByte : message.crcByte;
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+
+        if (!ok) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    m_transmitter->setMessage(index.row(), message);
+    emit dataChanged(this->index(index.row(), 0), this->index(index.row(), ColumnCrc));
+    emit messagesChanged();
+    return true;
+}
+
+Qt::ItemFlags xToolsCanBusCyclicModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+    if (index.column() == ColumnId) {
+        flags |= Qt::ItemIsUserCheckable;
+    }
+
+    if (index.column() <= ColumnCrc) {
+        flags |= Qt::ItemIsEditable;
+    }
+
+    return flags;
+}
+
+QVariant xToolsCanBusCyclicModel::headerData(int section,
+                                             Qt::Orientation orientation,
+                                             int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case ColumnId:
+        return tr("ID");
+    case ColumnCycle:
+        return tr("Cycle(ms)");
+    case ColumnPayload:
+        return tr("Data");
+    case ColumnCounter:
+        return tr("Counter");
+    case ColumnCrc:
+        return tr("CRC Byte");
+    case ColumnFrames:
+        return tr("Frames");
+    case ColumnErrors:
+        return tr("Errors");
+    case ColumnMeasuredCycle:
+        return tr("Measured(ms)");
+    case ColumnJitter:
+        return tr("Jitter(ms)");
+    default:
+        return QVariant();
+    }
+}
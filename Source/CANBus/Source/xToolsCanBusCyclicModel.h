@@ -0,0 +1,56 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QAbstractTableModel>
+
+#include "xToolsCanBusCyclicTransmitter.h"
+
+/// The editable table of the messages of a cyclic transmitter. The id column is checkable to
+/// enable the message, the counter is edited as "start|length" like a signal of a DBC file. The
+/// statistics columns follow the transmitter only when refresh() is called.
+class xToolsCanBusCyclicModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        ColumnId,
+        ColumnCycle,
+        ColumnPayload,
+        ColumnCounter,
+        ColumnCrc,
+        ColumnFrames,
+        ColumnErrors,
+        ColumnMeasuredCycle,
+        ColumnJitter
+    };
+
+public:
+    xToolsCanBusCyclicModel(xToolsCanBusCyclicTransmitter *transmitter, QObject *parent = nullptr);
+
+    void addMessage(const xToolsCanBusCyclicTransmitter::Message &message);
+    void removeMessage(int row);
+    void refresh();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+signals:
+    /// The messages are added, removed or edited.
+    void messagesChanged();
+
+private:
+    xToolsCanBusCyclicTransmitter *m_transmitter;
+};
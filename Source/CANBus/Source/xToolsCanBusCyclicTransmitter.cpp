@@ -0,0 +1,335 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusCyclicTransmitter.h"
+
+#include <QCanBusDevice>
+
+#include "xToolsCanBusStatistics.h"
+#include "xToolsDeadlineScheduler.h"
+#include "xToolsProfiler.h"
+
+xToolsCanBusCyclicTransmitter::xToolsCanBusCyclicTransmitter(QObject *parent)
+    : QObject{parent}
+    , m_scheduler{new xToolsDeadlineScheduler(this)}
+{
+    connect(m_scheduler,
+            &xToolsDeadlineScheduler::timeout,
+            this,
+            &xToolsCanBusCyclicTransmitter::onSchedulerTimeout);
+    connect(m_scheduler,
+            &xToolsDeadlineScheduler::timeoutsFinished,
+            this,
+            &xToolsCanBusCyclicTransmitter::onSchedulerTimeoutsFinished);
+}
+
+xToolsCanBusCyclicTransmitter::~xToolsCanBusCyclicTransmitter() {}
+
+void xToolsCanBusCyclicTransmitter::setDevice(QCanBusDevice *device)
+{
+    if (m_device != device) {
+        stop();
+        m_device = device;
+    }
+}
+
+int xToolsCanBusCyclicTransmitter::messageCount() const
+{
+    return m_entries.count();
+}
+
+const xToolsCanBusCyclicTransmitter::Message &xToolsCanBusCyclicTransmitter::message(
+    int index) const
+{
+    return m_entries.at(index).message;
+}
+
+void xToolsCanBusCyclicTransmitter::addMessage(const Message &message)
+{
+    Entry entry;
+    entry.message = message;
+    entry.counter = 0;
+    entry.lastSent = 0;
+    entry.cycleSum = 0;
+    prepareFrame(entry);
+    m_entries.append(entry);
+
+    updateSchedule();
+    updateBusLoad();
+}
+
+void xToolsCanBusCyclicTransmitter::setMessage(int index, const Message &message)
+{
+    Entry &entry = m_entries[index];
+    entry.message = message;
+    prepareFrame(entry);
+
+    updateSchedule();
+    updateBusLoad();
+}
+
+void xToolsCanBusCyclicTransmitter::removeMessage(int index)
+{
+    // The ids of the scheduler are the indexes of the entries, the entries behind the removed one
+    // take the deadlines of their predecessors.
+    m_entries.remove(index);
+    m_scheduler->cancel(m_entries.count());
+    m_dueEntries.clear();
+
+    updateSchedule();
+    updateBusLoad();
+}
+
+xToolsCanBusCyclicTransmitter::Statistics xToolsCanBusCyclicTransmitter::statistics(int index) const
+{
+    const Entry &entry = m_entries.at(index);
+    Statistics statistics = entry.statistics;
+    const qint64 cycles = statistics.frames - 1;
+    statistics.meanCycle = cycles > 0 ? entry.cycleSum / cycles : 0;
+    return statistics;
+}
+
+void xToolsCanBusCyclicTransmitter::resetStatistics()
+{
+    for (Entry &entry : m_entries) {
+        entry.statistics = Statistics();
+        entry.lastSent = 0;
+        entry.cycleSum = 0;
+    }
+}
+
+bool xToolsCanBusCyclicTransmitter::start()
+{
+    if (!m_device) {
+        return false;
+    }
+
+    resetStatistics();
+    m_isRunning = true;
+    updateSchedule();
+    return true;
+}
+
+void xToolsCanBusCyclicTransmitter::stop()
+{
+    m_isRunning = false;
+    m_scheduler->clear();
+    m_dueEntries.clear();
+}
+
+bool xToolsCanBusCyclicTransmitter::isRunning() const
+{
+    return m_isRunning;
+}
+
+void xToolsCanBusCyclicTransmitter::setBitrates(int bitrate, int dataBitrate)
+{
+    m_bitrate = bitrate;
+    m_dataBitrate = dataBitrate;
+    updateBusLoad();
+}
+
+double xToolsCanBusCyclicTransmitter::busLoad() const
+{
+    return m_busLoad;
+}
+
+void xToolsCanBusCyclicTransmitter::setBusLoadThreshold(double threshold)
+{
+    m_busLoadThreshold = threshold;
+}
+
+double xToolsCanBusCyclicTransmitter::busLoadThreshold() const
+{
+    return m_busLoadThreshold;
+}
+
+bool xToolsCanBusCyclicTransmitter::isBusLoadExceeded() const
+{
+    return m_busLoad > m_busLoadThreshold;
+}
+
+QVariantMap xToolsCanBusCyclicTransmitter::saveMessage(const Message &message)
+{
+    QVariantMap data;
+    data["enabled"] = message.enabled;
+    data["frameId"] = message.frameId;
+    data["isExtended"] = message.isExtended;
+    data["isFlexibleDataRate"] = message.isFlexibleDataRate;
+    data["bitrateSwitch"] = message.bitrateSwitch;
+    data["payload"] = QString::fromLatin1(message.payload.toHex());
+    data["cycle"] = message.cycle;
+    data["counterStart"] = message.counterStart;
+    data["counterLength"] = message.counterLength;
+    data["crcByte"] = message.crcByte;
+    return data;
+}
+
+xToolsCanBusCyclicTransmitter::Message xToolsCanBusCyclicTransmitter::loadMessage(
+    const QVariantMap &data)
+{
+    Message message;
+    message.enabled = data.value("enabled", message.enabled).toBool();
+    message.frameId = data.value("frameId", message.frameId).toUInt();
+    message.isExtended = data.value("isExtended", message.isExtended).toBool();
+    message.isFlexibleDataRate = data.value("isFlexibleDataRate").toBool();
+    message.bitrateSwitch = data.value("bitrateSwitch", message.bitrateSwitch).toBool();
+    message.payload = QByteArray::fromHex(data.value("payload").toString().toLatin1());
+    message.cycle = qMax(1, data.value("cycle", message.cycle).toInt());
+    message.counterStart = data.value("counterStart", message.counterStart).toInt();
+    message.counterLength = data.value("counterLength", message.counterLength).toInt();
+    message.crcByte = data.value("crcByte", message.crcByte).toInt();
+    return message;
+}
+
+quint8 xToolsCanBusCyclicTransmitter::crc8SaeJ1850(const uchar *data, int length, quint8 crc)
+{
+    // The polynomial 0x1d, the initial value and the final xor value are 0xff.
+    static const struct Table
+    {
+        quint8 values[256];
+        Table()
+        {
+            for (int i = 0; i < 256; i++) {
+                quint8 value = quint8(i);
+                for (int bit = 0; bit < 8; bit++) {
+                    value = (value & 0x80) ? quint8((value << 1) ^ 0x1d) : quint8(value << 1);
+                }
+                values[i] = value;
+            }
+        }
+    } table;
+
+    crc ^= 0xff;
+    for (int i = 0; i < length; i++) {
+        crc = table.values[crc ^ data[i]];
+    }
+
+    return crc ^ 0xff;
+}
+
+void xToolsCanBusCyclicTransmitter::onSchedulerTimeout(int id)
+{
+    if (id < m_entries.count()) {
+        m_dueEntries.append(id);
+    }
+}
+
+void xToolsCanBusCyclicTransmitter::onSchedulerTimeoutsFinished()
+{
+    if (!m_device || m_device->state() != QCanBusDevice::ConnectedState) {
+        m_dueEntries.clear();
+        return;
+    }
+
+    const qint64 now = xToolsProfiler::now();
+    m_frames.clear();
+    for (int index : qAsConst(m_dueEntries)) {
+        sendFrame(m_entries[index], now);
+    }
+
+    m_dueEntries.clear();
+    if (!m_frames.isEmpty()) {
+        emit framesSent(m_frames);
+    }
+}
+
+void xToolsCanBusCyclicTransmitter::updateSchedule()
+{
+    for (int i = 0; i < m_entries.count(); i++) {
+        const Message &message = m_entries.at(i).message;
+        if (m_isRunning && message.enabled) {
+            m_scheduler->schedule(i, qMax(1, message.cycle) * qint64(1000000));
+        } else {
+            m_scheduler->cancel(i);
+        }
+    }
+}
+
+void xToolsCanBusCyclicTransmitter::updateBusLoad()
+{
+    // The frames are measured with the payloads of the messages, the counters and the crcs may
+    // change a few stuff bits.
+    double load = 0;
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.message.enabled) {
+            const qint64 time = xToolsCanBusStatistics::frameTime(entry.frame,
+                                                                  m_bitrate,
+                                                                  m_dataBitrate);
+            load += double(time) / (qMax(1, entry.message.cycle) * 1000000.0);
+        }
+    }
+
+    load *= 100;
+    if (!qFuzzyCompare(load + 1, m_busLoad + 1)) {
+        m_busLoad = load;
+        emit busLoadChanged(m_busLoad);
+    }
+}
+
+void xToolsCanBusCyclicTransmitter::prepareFrame(Entry &entry)
+{
+    const Message &message = entry.message;
+    entry.frame = QCanBusFrame(message.frameId, message.payload);
+    entry.frame.setExtendedFrameFormat(message.isExtended);
+    entry.frame.setFlexibleDataRateFormat(message.isFlexibleDataRate);
+    entry.frame.setBitrateSwitch(message.isFlexibleDataRate && message.bitrateSwitch);
+}
+
+void xToolsCanBusCyclicTransmitter::sendFrame(Entry &entry, qint64 now)
+{
+    const Message &message = entry.message;
+    const int length = message.payload.length();
+    const bool hasCounter = message.counterStart >= 0
+                            && message.counterStart + message.counterLength <= length * 8;
+    const bool hasCrc = message.crcByte >= 0 && message.crcByte < length;
+    if (hasCounter || hasCrc) {
+        QByteArray payload = message.payload;
+        uchar *bytes = reinterpret_cast<uchar *>(payload.data());
+        if (hasCounter) {
+            for (int i = 0; i < message.counterLength; i++) {
+                const int bit = message.counterStart + i;
+                const uchar mask = uchar(1 << (bit % 8));
+                bytes[bit / 8] = (entry.counter >> i) & 1 ? bytes[bit / 8] | mask
+                                                          : bytes[bit / 8] & ~mask;
+            }
+
+            const quint32 mask = message.counterLength >= 32 ? 0xffffffff
+                                                             : (1u << message.counterLength) - 1;
+            entry.counter = (entry.counter + 1) & mask;
+        }
+
+        // The crc covers the bytes before and behind it, with the updated counter.
+        if (hasCrc) {
+            const int crcByte = message.crcByte;
+            const quint8 crc = crc8SaeJ1850(bytes, crcByte);
+            bytes[crcByte] = crc8SaeJ1850(bytes + crcByte + 1, length - crcByte - 1, crc);
+        }
+
+        entry.frame.setPayload(payload);
+    }
+
+    if (!m_device->writeFrame(entry.frame)) {
+        entry.statistics.errors++;
+        return;
+    }
+
+    Statistics &statistics = entry.statistics;
+    if (entry.lastSent > 0) {
+        const qint64 cycle = (now - entry.lastSent) / 1000;
+        const qint64 deviation = qAbs(cycle - message.cycle * 1000);
+        statistics.minCycle = statistics.frames > 1 ? qMin(statistics.minCycle, cycle) : cycle;
+        statistics.maxCycle = qMax(statistics.maxCycle, cycle);
+        statistics.jitter = qMax(statistics.jitter, deviation);
+        entry.cycleSum += cycle;
+    }
+
+    entry.lastSent = now;
+    statistics.frames++;
+    m_frames.append(entry.frame);
+}
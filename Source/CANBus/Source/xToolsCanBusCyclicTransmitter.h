@@ -0,0 +1,124 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QCanBusFrame>
+#include <QObject>
+#include <QPointer>
+#include <QVariantMap>
+#include <QVector>
+
+class QCanBusDevice;
+class xToolsDeadlineScheduler;
+
+/// Sends a table of periodic CAN messages, every message has its own cycle time. The deadlines of
+/// the messages are kept by a deadline scheduler, the messages that are due in the same wake-up are
+/// written to the device in one batch. An alive counter and a CRC byte can be updated in every
+/// frame, like the E2E protected messages of an ECU.
+///
+/// The cycle time of every message is measured from the frames actually written, and the bus load
+/// of the table is estimated from the worst case length of the frames.
+class xToolsCanBusCyclicTransmitter : public QObject
+{
+    Q_OBJECT
+public:
+    struct Message
+    {
+        bool enabled{true};
+        quint32 frameId{0};
+        bool isExtended{false};
+        bool isFlexibleDataRate{false};
+        bool bitrateSwitch{false};
+        QByteArray payload;
+        int cycle{100};       // ms
+        int counterStart{-1}; // The start bit of the alive counter(Intel order), -1 = no counter.
+        int counterLength{4}; // bits, 1-32
+        int crcByte{-1};      // CRC-8 SAE J1850 of the other payload bytes, -1 = no crc.
+    };
+
+    struct Statistics
+    {
+        qint64 frames{0};
+        qint64 errors{0};   // Frames that writeFrame() failed to queue.
+        qint64 minCycle{0}; // us, the measured time between two frames of the message.
+        qint64 maxCycle{0};
+        double meanCycle{0};
+        qint64 jitter{0}; // us, the largest deviation of the measured cycle time.
+    };
+
+public:
+    explicit xToolsCanBusCyclicTransmitter(QObject *parent = nullptr);
+    ~xToolsCanBusCyclicTransmitter() override;
+
+    /// The transmission is stopped if the device is changed.
+    void setDevice(QCanBusDevice *device);
+
+    int messageCount() const;
+    const Message &message(int index) const;
+    void addMessage(const Message &message);
+    /// The counter and the statistics of the message are kept.
+    void setMessage(int index, const Message &message);
+    void removeMessage(int index);
+    Statistics statistics(int index) const;
+    void resetStatistics();
+
+    /// Returns false if there is no device.
+    bool start();
+    void stop();
+    bool isRunning() const;
+
+    /// The bitrates(bit/s) of the estimation of the bus load.
+    void setBitrates(int bitrate, int dataBitrate);
+    /// The estimated bus load(%) of the enabled messages.
+    double busLoad() const;
+    void setBusLoadThreshold(double threshold);
+    double busLoadThreshold() const;
+    bool isBusLoadExceeded() const;
+
+    static QVariantMap saveMessage(const Message &message);
+    static Message loadMessage(const QVariantMap &data);
+    /// The crc is the crc of the previous bytes to continue with, 0x00 is the crc of no bytes.
+    static quint8 crc8SaeJ1850(const uchar *data, int length, quint8 crc = 0x00);
+
+signals:
+    /// The frames written to the device in one batch.
+    void framesSent(const QVector<QCanBusFrame> &frames);
+    void busLoadChanged(double load);
+
+private:
+    struct Entry
+    {
+        Message message;
+        Statistics statistics;
+        QCanBusFrame frame;
+        quint32 counter;
+        qint64 lastSent; // ns, the monotonic time of the previous frame.
+        double cycleSum; // us
+    };
+
+    QVector<Entry> m_entries;
+    QPointer<QCanBusDevice> m_device;
+    xToolsDeadlineScheduler *m_scheduler;
+    QVector<int> m_dueEntries;
+    QVector<QCanBusFrame> m_frames;
+    bool m_isRunning{false};
+    int m_bitrate{500000};
+    int m_dataBitrate{2000000};
+    double m_busLoad{0};
+    double m_busLoadThreshold{70};
+
+private:
+    void onSchedulerTimeout(int id);
+    void onSchedulerTimeoutsFinished();
+    void updateSchedule();
+    void updateBusLoad();
+    void prepareFrame(Entry &entry);
+    void sendFrame(Entry &entry, qint64 now);
+};
@@ -0,0 +1,388 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusDbc.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+
+enum Kernel { KernelLittleEndian, KernelBigEndian, KernelBits };
+
+xToolsCanBusDbc::xToolsCanBusDbc() {}
+
+bool xToolsCanBusDbc::load(const QString &fileName, QString &errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        errorString = QString("Can not open %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    // DBC files are written in latin1 by the most tools.
+    const QString text = QString::fromLatin1(file.readAll());
+    file.close();
+    if (!parse(text, errorString)) {
+        return false;
+    }
+
+    m_fileName = fileName;
+    return true;
+}
+
+bool xToolsCanBusDbc::parse(const QString &text, QString &errorString)
+{
+    static const QRegularExpression messageRe(R"(^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+))");
+    static const QRegularExpression signalRe(
+        R"(^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*)"
+        R"(\(\s*([^,\s]+)\s*,\s*([^)\s]+)\s*\)\s*)"
+        R"(\[\s*([^|\s]*)\s*\|\s*([^\]\s]*)\s*\]\s*"([^"]*)")");
+    static const QRegularExpression valueTypeRe(R"(^SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:\s*([012]))");
+
+    QVector<Message> messages;
+    QVector<Signal> signalTable;
+    // The signals are read per message, they are moved to the flat table in the order of the
+    // messages at the end.
+    QVector<QVector<Signal>> messageSignals;
+    QHash<quint32, int> indexes;
+
+    const QStringList lines = text.split('\n');
+    int currentMessage = -1;
+    for (int i = 0; i < lines.size(); i++) {
+        const QString line = lines.at(i).trimmed();
+        if (line.startsWith("BO_ ")) {
+            QRegularExpressionMatch match = messageRe.match(line);
+            if (!match.hasMatch()) {
+                errorString = QString("Invalid message at line %1.").arg(i + 1);
+                return false;
+            }
+
+            const quint32 id = match.captured(1).toUInt();
+            Message message;
+            message.isExtended = (id & 0x80000000) != 0;
+            message.frameId = id & 0x1fffffff;
+            message.name = match.captured(2);
+            message.length = qBound(0, match.captured(3).toInt(), 64);
+            message.firstSignal = 0;
+            message.signalCount = 0;
+            message.multiplexor = -1;
+
+            currentMessage = messages.size();
+            indexes.insert(key(message.frameId, message.isExtended), currentMessage);
+            messages.append(message);
+            messageSignals.append(QVector<Signal>());
+        } else if (line.startsWith("SG_ ")) {
+            QRegularExpressionMatch match = signalRe.match(line);
+            if (!match.hasMatch() || currentMessage == -1) {
+                errorString = QString("Invalid signal at line %1.").arg(i + 1);
+                return false;
+            }
+
+            Signal signal;
+            signal.name = match.captured(1);
+            signal.isMultiplexor = match.captured(2) == "M";
+            signal.multiplexValue = match.captured(2).startsWith('m')
+                                        ? match.captured(2).mid(1).toInt()
+                                        : -1;
+            signal.startBit = match.captured(3).toInt();
+            signal.length = match.captured(4).toInt();
+            signal.isBigEndian = match.captured(5) == "0";
+            signal.isSigned = match.captured(6) == "-";
+            signal.valueType = ValueTypeInteger;
+            signal.factor = match.captured(7).toDouble();
+            signal.offset = match.captured(8).toDouble();
+            signal.minimum = match.captured(9).toDouble();
+            signal.maximum = match.captured(10).toDouble();
+            signal.unit = match.captured(11);
+            if (signal.length < 1 || signal.length > 64 || signal.startBit > 511) {
+                errorString = QString("Invalid signal %1 at line %2.").arg(signal.name).arg(i + 1);
+                return false;
+            }
+
+            messageSignals[currentMessage].append(signal);
+        } else if (line.startsWith("SIG_VALTYPE_ ")) {
+            QRegularExpressionMatch match = valueTypeRe.match(line);
+            if (!match.hasMatch()) {
+                continue;
+            }
+
+            const quint32 id = match.captured(1).toUInt();
+            const bool isExtended = (id & 0x80000000) != 0;
+            const int message = indexes.value(key(id & 0x1fffffff, isExtended), -1);
+            if (message == -1) {
+                continue;
+            }
+
+            for (Signal &signal : messageSignals[message]) {
+                if (signal.name == match.captured(2)) {
+                    signal.valueType = match.captured(3).toInt();
+                }
+            }
+        } else if (!line.isEmpty()) {
+            currentMessage = -1;
+        }
+    }
+
+    for (int i = 0; i < messages.size(); i++) {
+        Message &message = messages[i];
+        message.firstSignal = signalTable.size();
+        message.signalCount = messageSignals.at(i).size();
+        for (Signal signal : messageSignals.at(i)) {
+            // A float signal is 32 bits and a double signal is 64 bits always.
+            if (signal.valueType == ValueTypeFloat) {
+                signal.length = 32;
+            } else if (signal.valueType == ValueTypeDouble) {
+                signal.length = 64;
+            }
+
+            signal.message = i;
+            compile(signal);
+            if (signal.isMultiplexor) {
+                message.multiplexor = signalTable.size();
+            }
+            signalTable.append(signal);
+        }
+    }
+
+    // The database is replaced only now, the views keep the indexes of it if the text is invalid.
+    clear();
+    m_messages = messages;
+    m_signals = signalTable;
+    m_messageIndexes = indexes;
+    return true;
+}
+
+void xToolsCanBusDbc::clear()
+{
+    m_fileName.clear();
+    m_messages.clear();
+    m_signals.clear();
+    m_messageIndexes.clear();
+}
+
+bool xToolsCanBusDbc::isEmpty() const
+{
+    return m_messages.isEmpty();
+}
+
+QString xToolsCanBusDbc::fileName() const
+{
+    return m_fileName;
+}
+
+int xToolsCanBusDbc::messageCount() const
+{
+    return m_messages.size();
+}
+
+const xToolsCanBusDbc::Message &xToolsCanBusDbc::message(int index) const
+{
+    return m_messages.at(index);
+}
+
+int xToolsCanBusDbc::signalCount() const
+{
+    return m_signals.size();
+}
+
+const xToolsCanBusDbc::Signal &xToolsCanBusDbc::signal(int index) const
+{
+    return m_signals.at(index);
+}
+
+int xToolsCanBusDbc::findMessage(quint32 frameId, bool isExtended) const
+{
+    return m_messageIndexes.value(key(frameId, isExtended), -1);
+}
+
+int xToolsCanBusDbc::findSignal(int message, const QString &name) const
+{
+    const Message &m = m_messages.at(message);
+    for (int i = m.firstSignal; i < m.firstSignal + m.signalCount; i++) {
+        if (m_signals.at(i).name == name) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+double xToolsCanBusDbc::decodeSignal(int signal, const uchar *payload, int length) const
+{
+    const Signal &s = m_signals.at(signal);
+    if (length < s.requiredBytes) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    if (s.multiplexValue != -1) {
+        const int multiplexor = m_messages.at(s.message).multiplexor;
+        if (multiplexor == -1) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        const Signal &m = m_signals.at(multiplexor);
+        if (length < m.requiredBytes || extract(m, payload) != quint64(s.multiplexValue)) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    return physical(s, extract(s, payload));
+}
+
+void xToolsCanBusDbc::decode(int message, const uchar *payload, int length, double *values) const
+{
+    const Message &m = m_messages.at(message);
+    qint64 multiplexValue = -1;
+    if (m.multiplexor != -1 && length >= m_signals.at(m.multiplexor).requiredBytes) {
+        multiplexValue = qint64(extract(m_signals.at(m.multiplexor), payload));
+    }
+
+    for (int i = 0; i < m.signalCount; i++) {
+        const Signal &s = m_signals.at(m.firstSignal + i);
+        if (length < s.requiredBytes
+            || (s.multiplexValue != -1 && s.multiplexValue != multiplexValue)) {
+            values[i] = std::numeric_limits<double>::quiet_NaN();
+        } else {
+            values[i] = physical(s, extract(s, payload));
+        }
+    }
+}
+
+void xToolsCanBusDbc::encode(int message, const double *values, uchar *payload) const
+{
+    const Message &m = m_messages.at(message);
+    for (int i = 0; i < m.signalCount; i++) {
+        const Signal &s = m_signals.at(m.firstSignal + i);
+        const double value = values[i];
+        if (std::isnan(value) || s.requiredBytes > m.length) {
+            continue;
+        }
+
+        quint64 raw = 0;
+        if (s.valueType == ValueTypeFloat) {
+            float f = static_cast<float>(value);
+            quint32 bits;
+            memcpy(&bits, &f, sizeof(bits));
+            raw = bits;
+        } else if (s.valueType == ValueTypeDouble) {
+            memcpy(&raw, &value, sizeof(raw));
+        } else {
+            const double scaled = s.factor != 0 ? std::round((value - s.offset) / s.factor) : 0;
+            const double lowest = s.isSigned ? -std::ldexp(1.0, s.length - 1) : 0;
+            // The highest raw value + 1, the doubles of 64 bits values may be rounded up to it.
+            const double end = std::ldexp(1.0, s.isSigned ? s.length - 1 : s.length);
+            const double clamped = qBound(lowest, scaled, end);
+            if (clamped >= end) {
+                raw = s.isSigned ? (s.mask >> 1) : s.mask;
+            } else {
+                raw = s.isSigned ? quint64(qint64(clamped)) & s.mask : quint64(clamped);
+            }
+        }
+
+        insert(s, raw, payload);
+    }
+}
+
+void xToolsCanBusDbc::compile(Signal &signal)
+{
+    signal.mask = signal.length == 64 ? ~quint64(0) : (quint64(1) << signal.length) - 1;
+    if (signal.isBigEndian) {
+        // The start bit is the most significant bit, numbered in the sawtooth order(bit 7 of byte
+        // 0 is 7, bit 0 of byte 1 is 8). In the bit stream of the big endian order, bit 7 of byte
+        // 0 is 0, so the signal is a contiguous range of it.
+        signal.bitPosition = (signal.startBit / 8) * 8 + (7 - signal.startBit % 8);
+        const int last = signal.bitPosition + signal.length - 1;
+        signal.firstByte = signal.bitPosition / 8;
+        signal.byteCount = last / 8 - signal.firstByte + 1;
+        signal.shift = 7 - last % 8;
+        signal.kernel = KernelBigEndian;
+    } else {
+        signal.bitPosition = signal.startBit;
+        signal.firstByte = signal.startBit / 8;
+        signal.shift = signal.startBit % 8;
+        signal.byteCount = (signal.shift + signal.length + 7) / 8;
+        signal.kernel = KernelLittleEndian;
+    }
+
+    // A signal of 58 bits or more may span 9 bytes, it does not fit in 64 bits.
+    if (signal.byteCount > 8) {
+        signal.kernel = KernelBits;
+    }
+
+    signal.requiredBytes = signal.firstByte + signal.byteCount;
+}
+
+quint64 xToolsCanBusDbc::extract(const Signal &signal, const uchar *payload)
+{
+    const uchar *bytes = payload + signal.firstByte;
+    quint64 value = 0;
+    switch (signal.kernel) {
+    case KernelLittleEndian:
+        for (int i = 0; i < signal.byteCount; i++) {
+            value |= quint64(bytes[i]) << (8 * i);
+        }
+        return (value >> signal.shift) & signal.mask;
+    case KernelBigEndian:
+        for (int i = 0; i < signal.byteCount; i++) {
+            value = (value << 8) | bytes[i];
+        }
+        return (value >> signal.shift) & signal.mask;
+    default:
+        for (int i = 0; i < signal.length; i++) {
+            const int bit = signal.bitPosition + i;
+            if (signal.isBigEndian) {
+                value = (value << 1) | ((payload[bit / 8] >> (7 - bit % 8)) & 1);
+            } else {
+                value |= quint64((payload[bit / 8] >> (bit % 8)) & 1) << i;
+            }
+        }
+        return value;
+    }
+}
+
+void xToolsCanBusDbc::insert(const Signal &signal, quint64 raw, uchar *payload)
+{
+    // Encoding is not on the hot path, the bits are written one by one.
+    for (int i = 0; i < signal.length; i++) {
+        const int bit = signal.bitPosition + i;
+        const int shift = signal.isBigEndian ? 7 - bit % 8 : bit % 8;
+        const int value = (raw >> (signal.isBigEndian ? signal.length - 1 - i : i)) & 1;
+        uchar &byte = payload[bit / 8];
+        byte = static_cast<uchar>((byte & ~(1 << shift)) | (value << shift));
+    }
+}
+
+double xToolsCanBusDbc::physical(const Signal &signal, quint64 raw)
+{
+    if (signal.valueType == ValueTypeFloat) {
+        const quint32 bits = quint32(raw);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value * signal.factor + signal.offset;
+    } else if (signal.valueType == ValueTypeDouble) {
+        double value;
+        memcpy(&value, &raw, sizeof(value));
+        return value * signal.factor + signal.offset;
+    }
+
+    if (signal.isSigned && signal.length < 64 && (raw >> (signal.length - 1)) & 1) {
+        raw |= ~signal.mask;
+    }
+
+    const double value = signal.isSigned ? double(qint64(raw)) : double(raw);
+    return value * signal.factor + signal.offset;
+}
+
+quint32 xToolsCanBusDbc::key(quint32 frameId, bool isExtended)
+{
+    return (frameId & 0x1fffffff) | (isExtended ? 0x80000000 : 0);
+}
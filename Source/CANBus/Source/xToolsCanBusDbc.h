@@ -0,0 +1,103 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/// The messages and the signals of a DBC file, compiled for decoding. The signals of all messages
+/// are kept in one flat table, the signals of a message are a range of it, and the messages are
+/// found by the CAN id with a hash lookup. The byte range, the shift and the mask of every signal
+/// are computed when the file is loaded, decoding a signal reads a few bytes and allocates nothing.
+///
+/// BO_, SG_(with simple multiplexing) and SIG_VALTYPE_ are read, the other sections are skipped.
+class xToolsCanBusDbc
+{
+public:
+    enum ValueType { ValueTypeInteger, ValueTypeFloat, ValueTypeDouble };
+
+    struct Signal
+    {
+        QString name;
+        QString unit;
+        int startBit;
+        int length;
+        bool isBigEndian; // Motorola, "@0" of the DBC file.
+        bool isSigned;
+        int valueType;
+        double factor;
+        double offset;
+        double minimum;
+        double maximum;
+        bool isMultiplexor;
+        int multiplexValue; // The signal is present if the multiplexor has the value, -1 = always.
+        int message;        // The index of the message of the signal.
+
+        // The compiled extraction, see compile().
+        int kernel;
+        int firstByte;
+        int byteCount;
+        int shift;
+        int bitPosition;   // The first bit of the bit stream of the byte order.
+        int requiredBytes; // The payload must be this long at least.
+        quint64 mask;
+    };
+
+    struct Message
+    {
+        quint32 frameId;
+        bool isExtended;
+        QString name;
+        int length;      // Bytes
+        int firstSignal; // The index of the first signal in the signal table.
+        int signalCount;
+        int multiplexor; // The index of the multiplexor signal, -1 = none.
+    };
+
+public:
+    xToolsCanBusDbc();
+
+    bool load(const QString &fileName, QString &errorString);
+    bool parse(const QString &text, QString &errorString);
+    void clear();
+    bool isEmpty() const;
+    QString fileName() const;
+
+    int messageCount() const;
+    const Message &message(int index) const;
+    int signalCount() const;
+    const Signal &signal(int index) const;
+    /// Returns the index of the message, -1 if the id is not defined.
+    int findMessage(quint32 frameId, bool isExtended) const;
+    /// Returns the index of the signal, -1 if the message has no such signal.
+    int findSignal(int message, const QString &name) const;
+
+    /// The physical value of the signal, NaN if the payload is too short, or the signal is
+    /// multiplexed and the multiplexor has another value.
+    double decodeSignal(int signal, const uchar *payload, int length) const;
+    /// The values of the signals of the message, in the order of the signals.
+    void decode(int message, const uchar *payload, int length, double *values) const;
+    /// Write the values of the signals(NaN = leave the bits) into the payload, which is the length
+    /// of the message. The values are clamped to the range of the raw values.
+    void encode(int message, const double *values, uchar *payload) const;
+
+private:
+    QString m_fileName;
+    QVector<Message> m_messages;
+    QVector<Signal> m_signals;
+    QHash<quint32, int> m_messageIndexes; // The key is the id, bit 31 is set for extended ids.
+
+private:
+    static void compile(Signal &signal);
+    static quint64 extract(const Signal &signal, const uchar *payload);
+    static void insert(const Signal &signal, quint64 raw, uchar *payload);
+    static double physical(const Signal &signal, quint64 raw);
+    static quint32 key(quint32 frameId, bool isExtended);
+};
@@ -0,0 +1,184 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusFrameBuffer.h"
+
+#include <cstring>
+
+xToolsCanBusFrameBuffer::xToolsCanBusFrameBuffer(int capacity)
+{
+    setCapacity(capacity);
+}
+
+void xToolsCanBusFrameBuffer::setCapacity(int capacity)
+{
+    m_frames = QVector<Frame>(qMax(1, capacity));
+    clear();
+}
+
+int xToolsCanBusFrameBuffer::capacity() const
+{
+    return m_frames.size();
+}
+
+void xToolsCanBusFrameBuffer::clear()
+{
+    m_endSequence = 0;
+    m_idRows.clear();
+    m_idIndexes.clear();
+    m_errorTexts.clear();
+}
+
+void xToolsCanBusFrameBuffer::append(const QCanBusFrame &frame,
+                                     bool isTx,
+                                     qint64 timestamp,
+                                     const QString &errorText)
+{
+    quint8 flags = isTx ? FlagTx : 0;
+    flags |= frame.hasExtendedFrameFormat() ? FlagExtended : 0;
+    flags |= frame.hasFlexibleDataRateFormat() ? FlagFlexibleDataRate : 0;
+    flags |= frame.hasBitrateSwitch() ? FlagBitrateSwitch : 0;
+    flags |= frame.frameType() == QCanBusFrame::RemoteRequestFrame ? FlagRemote : 0;
+    flags |= frame.frameType() == QCanBusFrame::ErrorFrame ? FlagError : 0;
+
+    const QCanBusFrame::TimeStamp deviceTimestamp = frame.timeStamp();
+    if (deviceTimestamp.seconds() != 0 || deviceTimestamp.microSeconds() != 0) {
+        timestamp = deviceTimestamp.seconds() * 1000000 + deviceTimestamp.microSeconds();
+    }
+
+    // The payload of the frame is shared, it is not copied by payload().
+    const QByteArray payload = frame.payload();
+    Frame &f = m_frames[m_endSequence % m_frames.size()];
+    if ((f.flags & FlagError) && m_endSequence >= quint64(m_frames.size())) {
+        m_errorTexts.remove(m_endSequence - m_frames.size());
+    }
+    if ((flags & FlagError) && !errorText.isEmpty()) {
+        m_errorTexts.insert(m_endSequence, errorText);
+    }
+
+    f.timestamp = timestamp;
+    f.delta = 0;
+    f.frameId = frame.frameId();
+    f.flags = flags;
+    f.length = static_cast<quint8>(qMin(payload.size(), 64));
+    memcpy(f.payload, payload.constData(), f.length);
+    m_endSequence++;
+
+    const quint32 k = key(f.frameId, flags);
+    auto it = m_idIndexes.constFind(k);
+    if (it == m_idIndexes.constEnd()) {
+        m_idIndexes.insert(k, m_idRows.size());
+        m_idRows.append(IdRow{f, 1, errorText});
+        return;
+    }
+
+    IdRow &row = m_idRows[it.value()];
+    f.delta = timestamp - row.frame.timestamp;
+    row.frame = f;
+    row.count++;
+    if (flags & FlagError) {
+        row.errorText = errorText;
+    }
+}
+
+quint64 xToolsCanBusFrameBuffer::firstSequence() const
+{
+    const quint64 capacity = m_frames.size();
+    return m_endSequence > capacity ? m_endSequence - capacity : 0;
+}
+
+quint64 xToolsCanBusFrameBuffer::endSequence() const
+{
+    return m_endSequence;
+}
+
+const xToolsCanBusFrameBuffer::Frame *xToolsCanBusFrameBuffer::frame(quint64 sequence) const
+{
+    if (sequence < firstSequence() || sequence >= m_endSequence) {
+        return nullptr;
+    }
+
+    return &m_frames.at(sequence % m_frames.size());
+}
+
+QString xToolsCanBusFrameBuffer::errorText(quint64 sequence) const
+{
+    return m_errorTexts.value(sequence);
+}
+
+int xToolsCanBusFrameBuffer::idCount() const
+{
+    return m_idRows.size();
+}
+
+const xToolsCanBusFrameBuffer::IdRow &xToolsCanBusFrameBuffer::idRow(int index) const
+{
+    return m_idRows.at(index);
+}
+
+int xToolsCanBusFrameBuffer::dlc(int length)
+{
+    // The payload of a CAN FD frame longer than 8 bytes is padded to the length of its DLC.
+    static const int lengths[] = {12, 16, 20, 24, 32, 48, 64};
+    if (length <= 8) {
+        return length;
+    }
+
+    for (int i = 0; i < 7; i++) {
+        if (length <= lengths[i]) {
+            return 9 + i;
+        }
+    }
+
+    return 15;
+}
+
+QString xToolsCanBusFrameBuffer::idText(const Frame &frame)
+{
+    const int width = (frame.flags & FlagExtended) ? 8 : 3;
+    return QString("%1").arg(frame.frameId, width, 16, QChar('0')).toUpper();
+}
+
+QString xToolsCanBusFrameBuffer::typeText(const Frame &frame)
+{
+    if (frame.flags & FlagError) {
+        return QString("Error");
+    } else if (frame.flags & FlagRemote) {
+        return QString("Remote");
+    }
+
+    QString text = (frame.flags & FlagExtended) ? QString("Ext") : QString("Std");
+    if (frame.flags & FlagFlexibleDataRate) {
+        text += (frame.flags & FlagBitrateSwitch) ? QString(" FD BRS") : QString(" FD");
+    }
+
+    return text;
+}
+
+QString xToolsCanBusFrameBuffer::payloadText(const Frame &frame)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    QString text(frame.length * 3 - (frame.length ? 1 : 0), QChar(' '));
+    for (int i = 0; i < frame.length; i++) {
+        text[i * 3] = QChar(digits[frame.payload[i] >> 4]);
+        text[i * 3 + 1] = QChar(digits[frame.payload[i] & 0x0f]);
+    }
+
+    return text;
+}
+
+quint32 xToolsCanBusFrameBuffer::key(quint32 frameId, quint8 flags)
+{
+    // An id is 29 bits at most, the same id of the standard and the extended format are two ids,
+    // the transmitted and the received frames of an id are two rows with their own cycle times.
+    quint32 k = frameId & 0x1fffffff;
+    k |= (flags & FlagExtended) ? 0x80000000 : 0;
+    k |= (flags & FlagError) ? 0x40000000 : 0;
+    k |= (flags & FlagTx) ? 0x20000000 : 0;
+    return k;
+}
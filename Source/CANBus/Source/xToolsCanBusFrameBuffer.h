@@ -0,0 +1,96 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QCanBusFrame>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/// A ring buffer of the latest CAN frames with a fixed capacity. The frames are copied into
+/// preallocated slots, appending a frame allocates no memory, the oldest frame is overwritten when
+/// the buffer is full. Every frame gets a sequence number, so a view can tell the frames it has
+/// shown from the new ones and from the overwritten ones.
+///
+/// The latest frame of every CAN id and direction is kept too, with the count and the cycle time of
+/// the id, it is the table of the fixed mode of the trace view. The buffer must be used in one
+/// thread.
+class xToolsCanBusFrameBuffer
+{
+public:
+    enum Flag {
+        FlagTx = 0x01,
+        FlagExtended = 0x02,
+        FlagFlexibleDataRate = 0x04,
+        FlagBitrateSwitch = 0x08,
+        FlagRemote = 0x10,
+        FlagError = 0x20
+    };
+
+    struct Frame
+    {
+        qint64 timestamp; // us since epoch
+        qint64 delta;     // us, since the previous frame of the same id, 0 = the first one.
+        quint32 frameId;
+        quint8 flags;
+        quint8 length;
+        uchar payload[64];
+    };
+
+    struct IdRow
+    {
+        Frame frame; // The latest frame.
+        qint64 count;
+        QString errorText; // The error text of the latest frame of an error row.
+    };
+
+public:
+    explicit xToolsCanBusFrameBuffer(int capacity = 100000);
+
+    /// The buffer is cleared.
+    void setCapacity(int capacity);
+    int capacity() const;
+    void clear();
+
+    /// The timestamp(us since epoch) is used if the frame has no timestamp of the device. The error
+    /// text is the text of an error frame interpreted by the device.
+    void append(const QCanBusFrame &frame,
+                bool isTx,
+                qint64 timestamp,
+                const QString &errorText = QString());
+
+    /// The sequence of the oldest frame in the buffer, it is the number of the overwritten frames.
+    quint64 firstSequence() const;
+    /// The sequence of the next frame, it is the number of the appended frames.
+    quint64 endSequence() const;
+    /// Returns nullptr if the frame is overwritten or not appended yet.
+    const Frame *frame(quint64 sequence) const;
+    /// The error text of an error frame, it is empty if the frame has no error text.
+    QString errorText(quint64 sequence) const;
+
+    /// The ids in the order of their first frames.
+    int idCount() const;
+    const IdRow &idRow(int index) const;
+
+    static int dlc(int length);
+    static QString idText(const Frame &frame);
+    static QString typeText(const Frame &frame);
+    static QString payloadText(const Frame &frame);
+
+private:
+    QVector<Frame> m_frames;
+    quint64 m_endSequence{0};
+    QVector<IdRow> m_idRows;
+    QHash<quint32, int> m_idIndexes; // The key of the id, see key().
+    // The error frames are rare, their texts are kept aside, so the slots stay plain.
+    QHash<quint64, QString> m_errorTexts;
+
+private:
+    static quint32 key(quint32 frameId, quint8 flags);
+};
@@ -0,0 +1,241 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusSignalPlot.h"
+
+#include <cmath>
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include "xToolsCanBusDbc.h"
+
+xToolsCanBusSignalPlot::xToolsCanBusSignalPlot(QWidget *parent)
+    : QWidget{parent}
+{
+    setMinimumHeight(120);
+    setAutoFillBackground(true);
+}
+
+void xToolsCanBusSignalPlot::setDbc(const xToolsCanBusDbc *dbc)
+{
+    m_dbc = dbc;
+    m_series.clear();
+    updateMessageSeries();
+    update();
+}
+
+bool xToolsCanBusSignalPlot::addSignal(int signal)
+{
+    if (!m_dbc || m_series.size() >= maxSignals) {
+        return false;
+    }
+
+    for (const Series &series : m_series) {
+        if (series.signal == signal) {
+            return true;
+        }
+    }
+
+    static const QColor colors[maxSignals] = {QColor(31, 119, 180),
+                                             QColor(255, 127, 14),
+                                             QColor(44, 160, 44),
+                                             QColor(214, 39, 40),
+                                             QColor(148, 103, 189),
+                                             QColor(140, 86, 75),
+                                             QColor(227, 119, 194),
+                                             QColor(127, 127, 127)};
+
+    // The first color that is not used.
+    QColor color = colors[0];
+    for (int i = 0; i < maxSignals; i++) {
+        bool isUsed = false;
+        for (const Series &series : m_series) {
+            isUsed = isUsed || series.color == colors[i];
+        }
+        if (!isUsed) {
+            color = colors[i];
+            break;
+        }
+    }
+
+    Series series;
+    series.signal = signal;
+    series.color = color;
+    series.timestamps = QVector<qint64>(samplesPerSignal);
+    series.values = QVector<double>(samplesPerSignal);
+    series.head = 0;
+    series.count = 0;
+    m_series.append(series);
+    updateMessageSeries();
+    update();
+    return true;
+}
+
+void xToolsCanBusSignalPlot::removeSignal(int signal)
+{
+    for (int i = 0; i < m_series.size(); i++) {
+        if (m_series.at(i).signal == signal) {
+            m_series.removeAt(i);
+            break;
+        }
+    }
+
+    updateMessageSeries();
+    update();
+}
+
+void xToolsCanBusSignalPlot::clearSamples()
+{
+    for (Series &series : m_series) {
+        series.head = 0;
+        series.count = 0;
+    }
+
+    m_latestTimestamp = 0;
+    update();
+}
+
+void xToolsCanBusSignalPlot::setTimeWindow(int seconds)
+{
+    m_timeWindow = qMax(1, seconds) * 1000000ll;
+    update();
+}
+
+void xToolsCanBusSignalPlot::addFrame(int message,
+                                      const uchar *payload,
+                                      int length,
+                                      qint64 timestamp)
+{
+    auto it = m_messageSeries.constFind(message);
+    if (it == m_messageSeries.constEnd()) {
+        return;
+    }
+
+    for (int index : it.value()) {
+        Series &series = m_series[index];
+        const double value = m_dbc->decodeSignal(series.signal, payload, length);
+        if (std::isnan(value)) {
+            continue;
+        }
+
+        series.timestamps[series.head] = timestamp;
+        series.values[series.head] = value;
+        series.head = (series.head + 1) % samplesPerSignal;
+        series.count = qMin(series.count + 1, int(samplesPerSignal));
+    }
+
+    m_latestTimestamp = qMax(m_latestTimestamp, timestamp);
+    m_isDirty = true;
+}
+
+void xToolsCanBusSignalPlot::refresh()
+{
+    if (m_isDirty) {
+        m_isDirty = false;
+        update();
+    }
+}
+
+void xToolsCanBusSignalPlot::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const QFontMetrics metrics = fontMetrics();
+    const int margin = metrics.height() / 2;
+    const int axisWidth = metrics.boundingRect(QString("-0000.00")).width() + margin;
+    const int legendHeight = metrics.height() + margin;
+    const QRect plot = rect().adjusted(axisWidth, margin, -margin, -legendHeight - margin);
+    if (plot.width() < 10 || plot.height() < 10) {
+        return;
+    }
+
+    // The range of the values in the time window.
+    const qint64 begin = m_latestTimestamp - m_timeWindow;
+    double minimum = 0;
+    double maximum = 0;
+    bool hasValue = false;
+    for (const Series &series : m_series) {
+        for (int i = 0; i < series.count; i++) {
+            const int index = (series.head - 1 - i + samplesPerSignal) % samplesPerSignal;
+            if (series.timestamps.at(index) < begin) {
+                break;
+            }
+
+            const double value = series.values.at(index);
+            minimum = hasValue ? qMin(minimum, value) : value;
+            maximum = hasValue ? qMax(maximum, value) : value;
+            hasValue = true;
+        }
+    }
+
+    if (maximum - minimum < 1e-9) {
+        minimum -= 1;
+        maximum += 1;
+    }
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawRect(plot);
+    for (int i = 0; i <= 4; i++) {
+        const int y = plot.bottom() - plot.height() * i / 4;
+        const double value = minimum + (maximum - minimum) * i / 4;
+        painter.drawLine(plot.left() - margin / 2, y, plot.left(), y);
+        QRect text(0, y - metrics.height() / 2, axisWidth - margin, metrics.height());
+        painter.drawText(text, Qt::AlignRight | Qt::AlignVCenter, QString::number(value, 'g', 5));
+    }
+
+    int legendX = plot.left();
+    const int legendY = plot.bottom() + margin;
+    for (const Series &series : m_series) {
+        QPainterPath path;
+        for (int i = 0; i < series.count; i++) {
+            const int index = (series.head - series.count + i + samplesPerSignal)
+                              % samplesPerSignal;
+            const qint64 timestamp = series.timestamps.at(index);
+            if (timestamp < begin) {
+                continue;
+            }
+
+            const double x = plot.left() + double(timestamp - begin) / m_timeWindow * plot.width();
+            const double y = plot.bottom()
+                             - (series.values.at(index) - minimum) / (maximum - minimum)
+                                   * plot.height();
+            if (path.elementCount() == 0) {
+                path.moveTo(x, y);
+            } else {
+                path.lineTo(x, y);
+            }
+        }
+
+        painter.setPen(QPen(series.color, 1.5));
+        painter.drawPath(path);
+
+        const xToolsCanBusDbc::Signal &signal = m_dbc->signal(series.signal);
+        QString legend = signal.name;
+        if (series.count > 0) {
+            const int last = (series.head - 1 + samplesPerSignal) % samplesPerSignal;
+            legend += QString(" = %1 %2").arg(series.values.at(last), 0, 'g', 6).arg(signal.unit);
+        }
+
+        painter.fillRect(legendX, legendY + metrics.height() / 2 - 2, 12, 4, series.color);
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawText(legendX + 16, legendY + metrics.ascent(), legend);
+        legendX += 16 + metrics.boundingRect(legend).width() + margin * 2;
+    }
+}
+
+void xToolsCanBusSignalPlot::updateMessageSeries()
+{
+    m_messageSeries.clear();
+    for (int i = 0; i < m_series.size(); i++) {
+        const int message = m_dbc->signal(m_series.at(i).signal).message;
+        m_messageSeries[message].append(i);
+    }
+}
@@ -0,0 +1,67 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QColor>
+#include <QHash>
+#include <QVector>
+#include <QWidget>
+
+class xToolsCanBusDbc;
+
+/// Plots the decoded values of DBC signals over the last seconds. Every signal keeps a ring of the
+/// latest samples, a frame is decoded only if its message has a plotted signal, and the widget is
+/// repainted by the caller, not every sample.
+class xToolsCanBusSignalPlot : public QWidget
+{
+    Q_OBJECT
+public:
+    static const int maxSignals = 8;
+    static const int samplesPerSignal = 4096;
+
+public:
+    explicit xToolsCanBusSignalPlot(QWidget *parent = nullptr);
+
+    /// The signals are removed.
+    void setDbc(const xToolsCanBusDbc *dbc);
+    /// Returns false if there are max signals already.
+    bool addSignal(int signal);
+    void removeSignal(int signal);
+    void clearSamples();
+    void setTimeWindow(int seconds);
+
+    /// The timestamp is us since epoch.
+    void addFrame(int message, const uchar *payload, int length, qint64 timestamp);
+    /// Repaint if there are new samples.
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Series
+    {
+        int signal;
+        QColor color;
+        QVector<qint64> timestamps;
+        QVector<double> values;
+        int head; // The index of the next sample.
+        int count;
+    };
+
+    const xToolsCanBusDbc *m_dbc{nullptr};
+    QVector<Series> m_series;
+    QHash<int, QVector<int>> m_messageSeries; // The series of the signals of a message.
+    qint64 m_timeWindow{10000000};            // us
+    qint64 m_latestTimestamp{0};
+    bool m_isDirty{false};
+
+private:
+    void updateMessageSeries();
+};
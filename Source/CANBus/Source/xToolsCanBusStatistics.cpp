@@ -0,0 +1,389 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusStatistics.h"
+
+#include <cmath>
+
+#include "xToolsCanBusFrameBuffer.h"
+#include "xToolsProfiler.h"
+
+namespace {
+
+const qint64 window = 1000000000; // ns
+
+// Counts the bits of the stuffed fields of a frame, a stuff bit of the opposite value is inserted
+// after 5 bits of the same value, it starts the next run. The crc of a classic frame is computed on
+// the way, it is stuffed too.
+struct BitStream
+{
+    int bits{0};
+    int stuffBits{0};
+    int last{-1};
+    int run{0};
+    quint16 crc{0};
+
+    void push(int bit)
+    {
+        bits++;
+        if (bit == last) {
+            run++;
+        } else {
+            last = bit;
+            run = 1;
+        }
+
+        if (run == 5) {
+            stuffBits++;
+            last = !bit;
+            run = 1;
+        }
+    }
+
+    void pushCrc(int bit)
+    {
+        // CRC-15 of CAN, the polynomial 0x4599.
+        const bool isXor = bit ^ ((crc >> 14) & 1);
+        crc = (crc << 1) & 0x7fff;
+        if (isXor) {
+            crc ^= 0x4599;
+        }
+
+        push(bit);
+    }
+
+    void push(quint32 value, int length, bool isCrc)
+    {
+        for (int i = length - 1; i >= 0; i--) {
+            const int bit = (value >> i) & 1;
+            isCrc ? pushCrc(bit) : push(bit);
+        }
+    }
+};
+
+} // namespace
+
+xToolsCanBusStatistics::xToolsCanBusStatistics()
+{
+    clear();
+}
+
+void xToolsCanBusStatistics::setBitrates(int bitrate, int dataBitrate)
+{
+    if (m_bitrate != bitrate || m_dataBitrate != dataBitrate) {
+        m_bitrate = bitrate;
+        m_dataBitrate = dataBitrate;
+        clear();
+    }
+}
+
+void xToolsCanBusStatistics::clear()
+{
+    m_slots.fill(Slot{emptyKey, -1}, 256);
+    m_shift = 24;
+    m_ids.clear();
+    m_frames = 0;
+    m_errorFrames = 0;
+    for (int i = 0; i < errorTypeCount; i++) {
+        m_errorCounts[i] = 0;
+    }
+
+    m_windowStart = 0;
+    m_windowTime = 0;
+    m_busLoad = 0;
+    m_peakBusLoad = 0;
+}
+
+void xToolsCanBusStatistics::add(const QCanBusFrame &frame, bool isTx, qint64 timestamp)
+{
+    const qint64 now = xToolsProfiler::now();
+    roll(now);
+    m_frames++;
+
+    const QCanBusFrame::FrameType type = frame.frameType();
+    if (type == QCanBusFrame::ErrorFrame) {
+        // The error frames are reported by the controller, they are not frames of the bus.
+        m_errorFrames++;
+        const int errors = int(frame.error());
+        for (int i = 0; i < errorTypeCount; i++) {
+            if (errors & (1 << i)) {
+                m_errorCounts[i]++;
+            }
+        }
+        return;
+    }
+
+    if (type != QCanBusFrame::DataFrame && type != QCanBusFrame::RemoteRequestFrame) {
+        return;
+    }
+
+    const qint64 time = frameTime(frame, m_bitrate, m_dataBitrate);
+    m_windowTime += time;
+
+    const quint32 key = frame.frameId() | (frame.hasExtendedFrameFormat() ? 0x80000000 : 0);
+    Id &id = m_ids[findOrInsert(key)];
+    if (isTx) {
+        id.txFrames++;
+    } else {
+        id.rxFrames++;
+    }
+
+    id.windowFrames++;
+    id.windowTime += time;
+
+    const qint64 deviceTimestamp = frame.timeStamp().seconds() * 1000000
+                                   + frame.timeStamp().microSeconds();
+    timestamp = deviceTimestamp != 0 ? deviceTimestamp : timestamp;
+    const qint64 cycle = timestamp - id.lastTimestamp;
+    if (id.lastTimestamp != 0 && cycle >= 0) {
+        id.minCycle = id.cycles > 0 ? qMin(id.minCycle, cycle) : cycle;
+        id.maxCycle = qMax(id.maxCycle, cycle);
+        id.cycles++;
+        const double delta = cycle - id.meanCycle;
+        id.meanCycle += delta / id.cycles;
+        id.m2 += delta * (cycle - id.meanCycle);
+    }
+
+    id.lastTimestamp = timestamp;
+}
+
+double xToolsCanBusStatistics::busLoad()
+{
+    roll(xToolsProfiler::now());
+    return m_busLoad;
+}
+
+double xToolsCanBusStatistics::peakBusLoad() const
+{
+    return m_peakBusLoad;
+}
+
+qint64 xToolsCanBusStatistics::frames() const
+{
+    return m_frames;
+}
+
+qint64 xToolsCanBusStatistics::errorFrames() const
+{
+    return m_errorFrames;
+}
+
+qint64 xToolsCanBusStatistics::errorCount(int type) const
+{
+    return type >= 0 && type < errorTypeCount ? m_errorCounts[type] : 0;
+}
+
+int xToolsCanBusStatistics::idCount() const
+{
+    return m_ids.count();
+}
+
+xToolsCanBusStatistics::IdStatistics xToolsCanBusStatistics::idStatistics(int index)
+{
+    roll(xToolsProfiler::now());
+
+    const Id &id = m_ids.at(index);
+    IdStatistics statistics;
+    statistics.frameId = id.key & 0x1fffffff;
+    statistics.isExtended = id.key & 0x80000000;
+    statistics.rxFrames = id.rxFrames;
+    statistics.txFrames = id.txFrames;
+    statistics.rate = id.rate;
+    statistics.load = id.load;
+    statistics.minCycle = id.minCycle;
+    statistics.maxCycle = id.maxCycle;
+    statistics.meanCycle = id.meanCycle;
+    statistics.jitter = id.cycles > 1 ? std::sqrt(id.m2 / (id.cycles - 1)) : 0;
+    return statistics;
+}
+
+xToolsCanBusStatistics::FrameBits xToolsCanBusStatistics::frameBits(const QCanBusFrame &frame)
+{
+    // The bits after the crc: crc delimiter, ack slot, ack delimiter, end of frame and the
+    // interframe space.
+    const int tailBits = 1 + 1 + 1 + 7 + 3;
+    const bool isExtended = frame.hasExtendedFrameFormat();
+    const bool isRemote = frame.frameType() == QCanBusFrame::RemoteRequestFrame;
+    const QByteArray payload = frame.payload();
+    const quint32 frameId = frame.frameId();
+
+    BitStream stream;
+    FrameBits bits;
+    if (!frame.hasFlexibleDataRateFormat()) {
+        const int length = qMin(payload.length(), 8);
+        const bool isCrc = true;
+        stream.push(0, 1, isCrc); // SOF
+        if (isExtended) {
+            stream.push(frameId >> 18, 11, isCrc);
+            stream.push(3, 2, isCrc); // SRR, IDE
+            stream.push(frameId & 0x3ffff, 18, isCrc);
+            stream.push(isRemote ? 4 : 0, 3, isCrc); // RTR, r1, r0
+        } else {
+            stream.push(frameId, 11, isCrc);
+            stream.push(isRemote ? 4 : 0, 3, isCrc); // RTR, IDE, r0
+        }
+
+        stream.push(length, 4, isCrc);
+        for (int i = 0; !isRemote && i < length; i++) {
+            stream.push(uchar(payload.at(i)), 8, isCrc);
+        }
+
+        stream.push(stream.crc, 15, false);
+        bits.nominalBits = stream.bits + stream.stuffBits + tailBits;
+        bits.dataBits = 0;
+        bits.stuffBits = stream.stuffBits;
+        return bits;
+    }
+
+    // The payload of a CAN FD frame is padded with 0 to the length of its DLC. The stuff count and
+    // the crc are not stuffed dynamically, a fixed stuff bit is ahead of them and after every 4
+    // bits of them.
+    static const int lengths[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+    const int dlc = xToolsCanBusFrameBuffer::dlc(qMin(payload.length(), 64));
+    const int length = lengths[dlc];
+    const bool isBitrateSwitch = frame.hasBitrateSwitch();
+    stream.push(0, 1, false); // SOF
+    if (isExtended) {
+        stream.push(frameId >> 18, 11, false);
+        stream.push(3, 2, false); // SRR, IDE
+        stream.push(frameId & 0x3ffff, 18, false);
+        stream.push(2, 3, false); // RRS, FDF, res
+    } else {
+        stream.push(frameId, 11, false);
+        stream.push(2, 4, false); // RRS, IDE, FDF, res
+    }
+
+    stream.push(isBitrateSwitch ? 1 : 0, 1, false);
+    const int arbitrationBits = stream.bits + stream.stuffBits;
+    stream.push(frame.hasErrorStateIndicator() ? 1 : 0, 1, false);
+    stream.push(dlc, 4, false);
+    for (int i = 0; i < length; i++) {
+        stream.push(i < payload.length() ? uchar(payload.at(i)) : 0, 8, false);
+    }
+
+    const int crcBits = length > 16 ? 21 : 17;
+    const int fixedBits = 4 + crcBits + 2 + (crcBits - 1) / 4;
+    const int dataPhaseBits = stream.bits + stream.stuffBits - arbitrationBits + fixedBits;
+    bits.nominalBits = arbitrationBits + tailBits + (isBitrateSwitch ? 0 : dataPhaseBits);
+    bits.dataBits = isBitrateSwitch ? dataPhaseBits : 0;
+    bits.stuffBits = stream.stuffBits;
+    return bits;
+}
+
+qint64 xToolsCanBusStatistics::frameTime(const QCanBusFrame &frame, int bitrate, int dataBitrate)
+{
+    const FrameBits bits = frameBits(frame);
+    return qint64(bits.nominalBits) * 1000000000 / qMax(bitrate, 1)
+           + qint64(bits.dataBits) * 1000000000 / qMax(dataBitrate, 1);
+}
+
+QString xToolsCanBusStatistics::errorTypeText(int type)
+{
+    static const char *texts[errorTypeCount] = {"Transmission timeout",
+                                                "Lost arbitration",
+                                                "Controller",
+                                                "Protocol violation",
+                                                "Transceiver",
+                                                "Missing acknowledgment",
+                                                "Bus off",
+                                                "Bus error",
+                                                "Controller restart",
+                                                "Unknown"};
+    return type >= 0 && type < errorTypeCount ? QString(texts[type]) : QString();
+}
+
+int xToolsCanBusStatistics::findOrInsert(quint32 key)
+{
+    const int mask = m_slots.count() - 1;
+    int i = int((key * 0x9e3779b1u) >> m_shift);
+    while (true) {
+        Slot &slot = m_slots[i];
+        if (slot.key == key) {
+            return slot.index;
+        }
+
+        if (slot.key == emptyKey) {
+            break;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    // The table is kept at most half full, so the probe sequences stay short.
+    if ((m_ids.count() + 1) * 2 > m_slots.count()) {
+        rehash(m_slots.count() * 2);
+        return findOrInsert(key);
+    }
+
+    Id id;
+    id.key = key;
+    id.rxFrames = 0;
+    id.txFrames = 0;
+    id.windowFrames = 0;
+    id.windowTime = 0;
+    id.rate = 0;
+    id.load = 0;
+    id.lastTimestamp = 0;
+    id.cycles = 0;
+    id.minCycle = 0;
+    id.maxCycle = 0;
+    id.meanCycle = 0;
+    id.m2 = 0;
+    m_ids.append(id);
+
+    m_slots[i] = Slot{key, m_ids.count() - 1};
+    return m_ids.count() - 1;
+}
+
+void xToolsCanBusStatistics::rehash(int capacity)
+{
+    m_slots.fill(Slot{emptyKey, -1}, capacity);
+    m_shift = 32;
+    for (int c = capacity; c > 1; c >>= 1) {
+        m_shift--;
+    }
+
+    const int mask = capacity - 1;
+    for (int index = 0; index < m_ids.count(); index++) {
+        const quint32 key = m_ids.at(index).key;
+        int i = int((key * 0x9e3779b1u) >> m_shift);
+        while (m_slots.at(i).key != emptyKey) {
+            i = (i + 1) & mask;
+        }
+
+        m_slots[i] = Slot{key, index};
+    }
+}
+
+void xToolsCanBusStatistics::roll(qint64 now)
+{
+    if (m_windowStart == 0) {
+        m_windowStart = now;
+        return;
+    }
+
+    const qint64 elapsed = now - m_windowStart;
+    if (elapsed < window) {
+        return;
+    }
+
+    // The windows after the closed one are idle if more than a window has passed.
+    const bool isIdle = elapsed >= 2 * window;
+    const double load = qMin(100.0, m_windowTime * 100.0 / window);
+    m_busLoad = isIdle ? 0 : load;
+    m_peakBusLoad = qMax(m_peakBusLoad, load);
+    for (Id &id : m_ids) {
+        id.rate = isIdle ? 0 : id.windowFrames * 1000000000.0 / window;
+        id.load = isIdle ? 0 : id.windowTime * 100.0 / window;
+        id.windowFrames = 0;
+        id.windowTime = 0;
+    }
+
+    m_windowStart += (elapsed / window) * window;
+    m_windowTime = 0;
+}
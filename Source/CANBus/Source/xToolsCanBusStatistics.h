@@ -0,0 +1,120 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QCanBusFrame>
+#include <QString>
+#include <QVector>
+
+/// The bus load and the statistics of every CAN id. The length of every frame on the bus is
+/// computed bit by bit, with the stuff bits of its actual content, the crc of a classic frame and
+/// the fixed stuff bits of a CAN FD frame, the data phase of a CAN FD frame with bitrate switch is
+/// timed with the data bitrate.
+///
+/// The ids are kept in an open addressing table with linear probing, adding a frame costs a hash
+/// and a few probes no matter how many ids the bus has. The bus load and the rates are computed for
+/// windows of a second of the monotonic clock. The statistics must be used in one thread.
+class xToolsCanBusStatistics
+{
+public:
+    static const int errorTypeCount = 10; // The bits of QCanBusFrame::FrameError.
+
+    struct FrameBits
+    {
+        int nominalBits; // Sent with the nominal bitrate, with the interframe space.
+        int dataBits;    // The data phase of a CAN FD frame with bitrate switch.
+        int stuffBits;   // The dynamic stuff bits, they are counted in the bits above.
+    };
+
+    struct IdStatistics
+    {
+        quint32 frameId;
+        bool isExtended;
+        qint64 rxFrames;
+        qint64 txFrames;
+        double rate;      // frames/s of the last window
+        double load;      // %, the share of the last window the frames of the id took
+        qint64 minCycle;  // us
+        qint64 maxCycle;  // us
+        double meanCycle; // us
+        double jitter;    // us, the standard deviation of the cycle time.
+    };
+
+public:
+    xToolsCanBusStatistics();
+
+    /// The bitrates(bit/s) of the bus, the statistics are cleared.
+    void setBitrates(int bitrate, int dataBitrate);
+    void clear();
+
+    /// The timestamp(us) is used if the frame has no timestamp of the device.
+    void add(const QCanBusFrame &frame, bool isTx, qint64 timestamp);
+
+    /// The bus load(%) of the last window.
+    double busLoad();
+    double peakBusLoad() const;
+    qint64 frames() const;
+    qint64 errorFrames() const;
+    qint64 errorCount(int type) const;
+
+    /// The ids in the order of their first frames.
+    int idCount() const;
+    IdStatistics idStatistics(int index);
+
+    static FrameBits frameBits(const QCanBusFrame &frame);
+    /// The time(ns) the frame takes on the bus.
+    static qint64 frameTime(const QCanBusFrame &frame, int bitrate, int dataBitrate);
+    static QString errorTypeText(int type);
+
+private:
+    struct Slot
+    {
+        quint32 key; // emptyKey = a free slot
+        int index;
+    };
+
+    struct Id
+    {
+        quint32 key;
+        qint64 rxFrames;
+        qint64 txFrames;
+        qint64 windowFrames;
+        qint64 windowTime; // ns
+        double rate;
+        double load;
+        qint64 lastTimestamp; // us, 0 = no frame yet
+        qint64 cycles;
+        qint64 minCycle;
+        qint64 maxCycle;
+        double meanCycle;
+        double m2; // The sum of the squared deviations of the cycles, see Welford's algorithm.
+    };
+
+    static const quint32 emptyKey = 0xffffffff;
+
+    QVector<Slot> m_slots;
+    int m_shift{24}; // 32 - log2(the capacity of the table)
+    QVector<Id> m_ids;
+
+    int m_bitrate{500000};
+    int m_dataBitrate{2000000};
+    qint64 m_frames{0};
+    qint64 m_errorFrames{0};
+    qint64 m_errorCounts[errorTypeCount];
+
+    qint64 m_windowStart{0}; // ns, the monotonic time, 0 = no window yet
+    qint64 m_windowTime{0};  // ns, the time the frames of the window took
+    double m_busLoad{0};
+    double m_peakBusLoad{0};
+
+private:
+    int findOrInsert(quint32 key);
+    void rehash(int capacity);
+    void roll(qint64 now);
+};
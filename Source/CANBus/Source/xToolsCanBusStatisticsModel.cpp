@@ -0,0 +1,123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusStatisticsModel.h"
+
+#include "xToolsCanBusStatistics.h"
+
+xToolsCanBusStatisticsModel::xToolsCanBusStatisticsModel(xToolsCanBusStatistics *statistics,
+                                                         QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_statistics(statistics)
+{}
+
+void xToolsCanBusStatisticsModel::refresh()
+{
+    const int count = m_statistics->idCount();
+    if (count > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, count - 1);
+        m_rowCount = count;
+        endInsertRows();
+    }
+
+    // Only the visible rows are painted again.
+    if (m_rowCount > 0) {
+        emit dataChanged(index(0, 0), index(m_rowCount - 1, ColumnJitter));
+    }
+}
+
+void xToolsCanBusStatisticsModel::reset()
+{
+    beginResetModel();
+    m_rowCount = m_statistics->idCount();
+    endResetModel();
+}
+
+int xToolsCanBusStatisticsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int xToolsCanBusStatisticsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnJitter + 1;
+}
+
+QVariant xToolsCanBusStatisticsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        return int(Qt::AlignCenter);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    const xToolsCanBusStatistics::IdStatistics statistics = m_statistics->idStatistics(
+        index.row());
+    switch (index.column()) {
+    case ColumnId: {
+        const int width = statistics.isExtended ? 8 : 3;
+        return QString("%1").arg(statistics.frameId, width, 16, QChar('0')).toUpper();
+    }
+    case ColumnRx:
+        return statistics.rxFrames;
+    case ColumnTx:
+        return statistics.txFrames;
+    case ColumnRate:
+        return QString::number(statistics.rate, 'f', 1);
+    case ColumnLoad:
+        return QString::number(statistics.load, 'f', 2);
+    case ColumnMinCycle:
+        return QString::number(statistics.minCycle / 1000.0, 'f', 3);
+    case ColumnMeanCycle:
+        return QString::number(statistics.meanCycle / 1000.0, 'f', 3);
+    case ColumnMaxCycle:
+        return QString::number(statistics.maxCycle / 1000.0, 'f', 3);
+    case ColumnJitter:
+        return QString::number(statistics.jitter / 1000.0, 'f', 3);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant xToolsCanBusStatisticsModel::headerData(int section,
+                                                 Qt::Orientation orientation,
+                                                 int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case ColumnId:
+        return tr("ID");
+    case ColumnRx:
+        return tr("Rx");
+    case ColumnTx:
+        return tr("Tx");
+    case ColumnRate:
+        return tr("Rate(fps)");
+    case ColumnLoad:
+        return tr("Load(%)");
+    case ColumnMinCycle:
+        return tr("Min(ms)");
+    case ColumnMeanCycle:
+        return tr("Avg(ms)");
+    case ColumnMaxCycle:
+        return tr("Max(ms)");
+    case ColumnJitter:
+        return tr("Jitter(ms)");
+    default:
+        return QVariant();
+    }
+}
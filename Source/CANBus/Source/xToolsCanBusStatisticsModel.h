@@ -0,0 +1,51 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QAbstractTableModel>
+
+class xToolsCanBusStatistics;
+
+/// A row per CAN id of the statistics, the rows follow the statistics only when refresh() is
+/// called, a timer of the ui calls it.
+class xToolsCanBusStatisticsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        ColumnId,
+        ColumnRx,
+        ColumnTx,
+        ColumnRate,
+        ColumnLoad,
+        ColumnMinCycle,
+        ColumnMeanCycle,
+        ColumnMaxCycle,
+        ColumnJitter
+    };
+
+public:
+    xToolsCanBusStatisticsModel(xToolsCanBusStatistics *statistics, QObject *parent = nullptr);
+
+    /// Insert the new ids and update the rows.
+    void refresh();
+    /// Call it after the statistics are cleared.
+    void reset();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    xToolsCanBusStatistics *m_statistics;
+    int m_rowCount{0};
+};
@@ -9,14 +9,30 @@
 #include "xToolsCanBusStudioUi.h"
 #include "ui_xToolsCanBusStudioUi.h"
 
+#include <limits>
+
 #include <QCanBus>
 #include <QCheckBox>
 #include <QDateTime>
 #include <QDebug>
+#include <QFile>
+#include <QFileDialog>
+#include <QHeaderView>
 #include <QLineEdit>
+#include <QListWidgetItem>
 #include <QMessageBox>
+#include <QRegularExpression>
+#include <QSpinBox>
 #include <QVector>
 
+#include "xToolsCanBusCyclicModel.h"
+#include "xToolsCanBusCyclicTransmitter.h"
+#include "xToolsCanBusDbc.h"
+#include "xToolsCanBusFrameBuffer.h"
+#include "xToolsCanBusStatistics.h"
+#include "xToolsCanBusStatisticsModel.h"
+#include "xToolsCanBusTraceModel.h"
+#include "xToolsPcapng.h"
 #include "xToolsSettings.h"
 
 xToolsCanBusStudioUi::xToolsCanBusStudioUi(QWidget* parent)
@@ -39,6 +55,9 @@ xToolsCanBusStudioUi::xToolsCanBusStudioUi(QWidget* parent)
 xToolsCanBusStudioUi::~xToolsCanBusStudioUi()
 {
     delete ui;
+    delete m_frameBuffer;
+    delete m_dbc;
+    delete m_statistics;
 }
 
 void xToolsCanBusStudioUi::initUi()
@@ -47,6 +66,9 @@ void xToolsCanBusStudioUi::initUi()
     initUiSpecifyConfiguration();
     initUiCanFrame();
     initUiSendCanFrame();
+    initUiDataView();
+    initUiCyclic();
+    initUiStatistics();
 }
 
 void xToolsCanBusStudioUi::initUiSelectPlugin()
@@ -137,12 +159,123 @@ void xToolsCanBusStudioUi::initUiSendCanFrame()
             &xToolsCanBusStudioUi::onSendButtonClicked);
 }
 
+void xToolsCanBusStudioUi::initUiDataView()
+{
+    // The frames are kept in a ring buffer, the view is refreshed by the timer instead of every
+    // frame, so a loaded bus costs a copy per frame only.
+    m_frameBuffer = new xToolsCanBusFrameBuffer();
+    m_traceModel = new xToolsCanBusTraceModel(m_frameBuffer, this);
+    ui->tableView->setModel(m_traceModel);
+    QHeaderView *verticalHeader = ui->tableView->verticalHeader();
+    verticalHeader->hide();
+    verticalHeader->setSectionResizeMode(QHeaderView::Fixed);
+    verticalHeader->setDefaultSectionSize(ui->tableView->fontMetrics().height() + 4);
+    ui->tableView->horizontalHeader()->setStretchLastSection(true);
+    ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    // The signals are decoded when the rows are painted, and when the frames of the plotted
+    // signals are received.
+    m_dbc = new xToolsCanBusDbc();
+    ui->plotWidget->setDbc(m_dbc);
+    ui->dbcMessageComboBox->addItem(tr("None"), -1);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(100);
+    m_refreshTimer->start();
+
+    connect(ui->fixedModeCheckBox,
+            &QCheckBox::clicked,
+            this,
+            &xToolsCanBusStudioUi::onFixedModeChanged);
+    connect(ui->clearPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onClearClicked);
+    connect(ui->exportPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onExportClicked);
+    connect(m_refreshTimer,
+            &QTimer::timeout,
+            this,
+            &xToolsCanBusStudioUi::onRefreshTimerTimeout);
+    connect(ui->loadDbcPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onLoadDbcClicked);
+    connect(ui->signalListWidget,
+            &QListWidget::itemChanged,
+            this,
+            &xToolsCanBusStudioUi::onSignalItemChanged);
+    connect(ui->dbcMessageComboBox,
+            static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this,
+            &xToolsCanBusStudioUi::onDbcMessageChanged);
+}
+
+void xToolsCanBusStudioUi::initUiCyclic()
+{
+    m_cyclicTransmitter = new xToolsCanBusCyclicTransmitter(this);
+    m_cyclicModel = new xToolsCanBusCyclicModel(m_cyclicTransmitter, this);
+    ui->cyclicTableView->setModel(m_cyclicModel);
+    ui->cyclicTableView->verticalHeader()->hide();
+    ui->cyclicTableView->horizontalHeader()->setStretchLastSection(true);
+    ui->cyclicTableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    connect(ui->cyclicAddPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onCyclicAddClicked);
+    connect(ui->cyclicRemovePushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onCyclicRemoveClicked);
+    connect(ui->cyclicStartPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onCyclicStartClicked);
+    connect(ui->busLoadThresholdSpinBox,
+            static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this,
+            &xToolsCanBusStudioUi::onBusLoadThresholdChanged);
+    connect(m_cyclicModel,
+            &xToolsCanBusCyclicModel::messagesChanged,
+            this,
+            &xToolsCanBusStudioUi::onCyclicMessagesChanged);
+    connect(m_cyclicTransmitter,
+            &xToolsCanBusCyclicTransmitter::framesSent,
+            this,
+            &xToolsCanBusStudioUi::onCyclicFramesSent);
+    connect(m_cyclicTransmitter,
+            &xToolsCanBusCyclicTransmitter::busLoadChanged,
+            this,
+            &xToolsCanBusStudioUi::onBusLoadChanged);
+}
+
+void xToolsCanBusStudioUi::initUiStatistics()
+{
+    m_statistics = new xToolsCanBusStatistics();
+    m_statisticsModel = new xToolsCanBusStatisticsModel(m_statistics, this);
+    ui->statisticsTableView->setModel(m_statisticsModel);
+    ui->statisticsTableView->verticalHeader()->hide();
+    ui->statisticsTableView->horizontalHeader()->setStretchLastSection(true);
+    ui->statisticsTableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    updateBitrates();
+
+    connect(ui->statisticsResetPushButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsCanBusStudioUi::onStatisticsResetClicked);
+}
+
 void xToolsCanBusStudioUi::initSetting()
 {
     initSettingSelectPlugin();
     initSettingSpecifyConfiguration();
     initSettingCanFrame();
     initSettingSendCanFrame();
+    initSettingDataView();
+    initSettingCyclic();
 }
 
 void xToolsCanBusStudioUi::initSettingSelectPlugin()
@@ -178,6 +311,32 @@ void xToolsCanBusStudioUi::initSettingCanFrame()
 
 void xToolsCanBusStudioUi::initSettingSendCanFrame() {}
 
+void xToolsCanBusStudioUi::initSettingDataView()
+{
+    setChecked(ui->fixedModeCheckBox, m_settingKeyCtx.fixedMode);
+    onFixedModeChanged();
+
+    QString errorString;
+    QString fileName = m_settings->value(m_settingKeyCtx.dbcFileName).toString();
+    if (!fileName.isEmpty() && !loadDbc(fileName, errorString)) {
+        qWarning() << errorString;
+    }
+}
+
+void xToolsCanBusStudioUi::initSettingCyclic()
+{
+    const int threshold = m_settings->value(m_settingKeyCtx.busLoadThreshold, 70).toInt();
+    ui->busLoadThresholdSpinBox->setValue(threshold);
+    m_cyclicTransmitter->setBusLoadThreshold(ui->busLoadThresholdSpinBox->value());
+
+    const QVariantList messages = m_settings->value(m_settingKeyCtx.cyclicMessages).toList();
+    for (const QVariant &message : messages) {
+        m_cyclicModel->addMessage(xToolsCanBusCyclicTransmitter::loadMessage(message.toMap()));
+    }
+
+    onBusLoadChanged();
+}
+
 void xToolsCanBusStudioUi::onPluginChanged(QString plugin)
 {
     ui->interfaceNameComboBox->clear();
@@ -191,6 +350,9 @@ void xToolsCanBusStudioUi::onPluginChanged(QString plugin)
 
 void xToolsCanBusStudioUi::onDisconnectClicked()
 {
+    m_cyclicTransmitter->setDevice(Q_NULLPTR);
+    ui->cyclicStartPushButton->setText(tr("Start"));
+    m_writingFrames.clear();
     if (m_device) {
         m_device->disconnectDevice();
         m_device->deleteLater();
@@ -244,6 +406,7 @@ void xToolsCanBusStudioUi::onConnectClicked()
     }
 
     m_settings->setValue(m_settingKeyCtx.interfaceName, interfaceName);
+    m_cyclicTransmitter->setDevice(m_device);
     updateUiState(true);
 }
 
@@ -272,11 +435,13 @@ void xToolsCanBusStudioUi::onCanFdIndexChanged(int index)
 void xToolsCanBusStudioUi::onBitrateChanged(int index)
 {
     m_settings->setValue(m_settingKeyCtx.bitrate, index);
+    updateBitrates();
 }
 
 void xToolsCanBusStudioUi::onDataBitrateChanged(int index)
 {
     m_settings->setValue(m_settingKeyCtx.dataBitRate, index);
+    updateBitrates();
 }
 
 void xToolsCanBusStudioUi::onFrameTypeChanged()
@@ -324,35 +489,274 @@ void xToolsCanBusStudioUi::onSendButtonClicked()
         return;
     }
 
-    const uint frameId = ui->frameIdComboBox->currentText().toUInt(Q_NULLPTR, 16);
-    QString data = ui->payloadComboBox->currentText().trimmed();
-    const QByteArray payload = QByteArray::fromHex(data.remove(QLatin1Char(' ')).toLatin1());
+    QCanBusFrame frame;
+    QString errorString;
+    if (!frameOfSendPanel(frame, errorString)) {
+        QMessageBox::warning(this, tr("Invalid Signal Values"), errorString);
+        return;
+    }
+
+    if (!m_device->writeFrame(frame)) {
+        qWarning() << m_device->errorString();
+        return;
+    }
 
-    QCanBusFrame frame = QCanBusFrame(frameId, payload);
-    frame.setExtendedFrameFormat(ui->extendedFormatCheckBox->isChecked());
+    appendFrame(frame, true, QDateTime::currentMSecsSinceEpoch() * 1000);
+    appendWritingFrame(frame);
+}
 
-    if (ui->flexibleDataRateCheckBox->isEnabled()) {
-        frame.setFlexibleDataRateFormat(ui->flexibleDataRateCheckBox->isChecked());
+void xToolsCanBusStudioUi::onFixedModeChanged()
+{
+    bool checked = ui->fixedModeCheckBox->isChecked();
+    m_settings->setValue(m_settingKeyCtx.fixedMode, checked);
+
+    m_traceModel->setFixedMode(checked);
+    updateTraceColumns();
+}
+
+void xToolsCanBusStudioUi::onClearClicked()
+{
+    m_frameBuffer->clear();
+    m_traceModel->reset();
+    updateTraceColumns();
+    ui->plotWidget->clearSamples();
+    onRefreshTimerTimeout();
+}
+
+void xToolsCanBusStudioUi::onExportClicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Frames"),
+                                                    QString(),
+                                                    tr("pcapng files (*.pcapng);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
     }
 
-    if (ui->bitrateSwitchCheckBox->isEnabled()) {
-        frame.setBitrateSwitch(ui->bitrateSwitchCheckBox);
+    // The writer appends a new section to an existing file, the file is replaced here.
+    QFile::remove(fileName);
+    xToolsPcapngWriter writer;
+    if (!writer.open(fileName)) {
+        QMessageBox::warning(this, tr("Export Frames Error"), writer.errorString());
+        return;
     }
 
-    if (!m_device->writeFrame(frame)) {
-        qWarning() << m_device->errorString();
+    QString interfaceName = ui->interfaceNameComboBox->currentText();
+    if (interfaceName.isEmpty()) {
+        interfaceName = QString("can0");
     }
 
-    bool isErrorFrame = frame.frameType() == QCanBusFrame::ErrorFrame;
-    QString view = isErrorFrame ? m_device->interpretErrorFrame(frame) : frame.toString();
-    if (frame.frameType() == QCanBusFrame::ErrorFrame) {
-        view = m_device->interpretErrorFrame(frame);
-    } else {
-        view = frame.toString();
+    const int interfaceId = writer.interfaceId(xToolsPcapng::LinkTypeSocketCan, interfaceName);
+    const quint64 end = m_frameBuffer->endSequence();
+    for (quint64 sequence = m_frameBuffer->firstSequence(); sequence < end; sequence++) {
+        const xToolsCanBusFrameBuffer::Frame *frame = m_frameBuffer->frame(sequence);
+        if (!frame) {
+            continue;
+        }
+
+        const quint8 flags = frame->flags;
+        const bool isExtended = flags & xToolsCanBusFrameBuffer::FlagExtended;
+        const bool isRemote = flags & xToolsCanBusFrameBuffer::FlagRemote;
+        const bool isError = flags & xToolsCanBusFrameBuffer::FlagError;
+        const bool isFd = flags & xToolsCanBusFrameBuffer::FlagFlexibleDataRate;
+        QByteArray data;
+        if (!isRemote) {
+            data = QByteArray(reinterpret_cast<const char *>(frame->payload), frame->length);
+        }
+
+        QByteArray packet = xToolsPcapng::socketCanFrame(frame->frameId,
+                                                         isExtended,
+                                                         isRemote,
+                                                         isError,
+                                                         isFd,
+                                                         data);
+        // The frame timestamps are microseconds, the pcapng timestamps are nanoseconds.
+        int direction = (flags & xToolsCanBusFrameBuffer::FlagTx) ? xToolsCaptureFile::DirectionTx
+                                                                  : xToolsCaptureFile::DirectionRx;
+        writer.appendPacket(interfaceId, frame->timestamp * 1000, direction, packet);
+
+        // Write the packets in batches, the buffer may hold a lot of frames.
+        if ((sequence + 1) % 4096 == 0 && !writer.flush()) {
+            break;
+        }
+    }
+
+    if (!writer.flush()) {
+        QMessageBox::warning(this, tr("Export Frames Error"), writer.errorString());
+    }
+    writer.close();
+}
+
+void xToolsCanBusStudioUi::onRefreshTimerTimeout()
+{
+    const quint64 dropped = m_frameBuffer->firstSequence();
+    m_traceModel->refresh();
+    ui->framesLabel->setText(tr("Frames: %1, IDs: %2, dropped: %3")
+                                 .arg(m_frameBuffer->endSequence())
+                                 .arg(m_frameBuffer->idCount())
+                                 .arg(dropped));
+
+    if (!m_traceModel->isFixedMode() && ui->autoScrollCheckBox->isChecked()) {
+        ui->tableView->scrollToBottom();
     }
 
-    QString flag = QString("<font color=green>[Tx] </font>");
-    outputMessage(flag + view);
+    ui->plotWidget->refresh();
+    m_cyclicModel->refresh();
+    m_statisticsModel->refresh();
+    updateStatisticsLabel();
+}
+
+void xToolsCanBusStudioUi::onLoadDbcClicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Load DBC File"),
+                                                    m_dbc->fileName(),
+                                                    tr("DBC files (*.dbc);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QString errorString;
+    if (!loadDbc(fileName, errorString)) {
+        QMessageBox::warning(this, tr("Load DBC File Error"), errorString);
+        return;
+    }
+
+    m_settings->setValue(m_settingKeyCtx.dbcFileName, fileName);
+}
+
+void xToolsCanBusStudioUi::onSignalItemChanged(QListWidgetItem *item)
+{
+    const int signal = item->data(Qt::UserRole).toInt();
+    if (item->checkState() == Qt::Unchecked) {
+        ui->plotWidget->removeSignal(signal);
+        return;
+    }
+
+    if (!ui->plotWidget->addSignal(signal)) {
+        QSignalBlocker blocker(ui->signalListWidget);
+        item->setCheckState(Qt::Unchecked);
+    }
+}
+
+void xToolsCanBusStudioUi::onDbcMessageChanged()
+{
+    const int message = ui->dbcMessageComboBox->currentData().toInt();
+    ui->frameIdComboBox->setEnabled(message < 0);
+    ui->extendedFormatCheckBox->setEnabled(message < 0);
+    if (message < 0) {
+        ui->payloadComboBox->lineEdit()->setPlaceholderText(tr("Hex"));
+        return;
+    }
+
+    const xToolsCanBusDbc::Message &m = m_dbc->message(message);
+    QStringList names;
+    for (int i = m.firstSignal; i < m.firstSignal + m.signalCount; i++) {
+        names.append(m_dbc->signal(i).name + "=0");
+    }
+
+    ui->frameIdComboBox->setEditText(QString::number(m.frameId, 16).toUpper());
+    ui->extendedFormatCheckBox->setChecked(m.isExtended);
+    ui->payloadComboBox->lineEdit()->setPlaceholderText(names.join(", "));
+}
+
+void xToolsCanBusStudioUi::onCyclicAddClicked()
+{
+    QCanBusFrame frame;
+    QString errorString;
+    if (!frameOfSendPanel(frame, errorString)) {
+        QMessageBox::warning(this, tr("Invalid Signal Values"), errorString);
+        return;
+    }
+
+    xToolsCanBusCyclicTransmitter::Message message;
+    message.frameId = frame.frameId();
+    message.isExtended = frame.hasExtendedFrameFormat();
+    message.isFlexibleDataRate = frame.hasFlexibleDataRateFormat();
+    message.bitrateSwitch = frame.hasBitrateSwitch();
+    message.payload = frame.payload();
+    m_cyclicModel->addMessage(message);
+}
+
+void xToolsCanBusStudioUi::onCyclicRemoveClicked()
+{
+    const QModelIndex index = ui->cyclicTableView->currentIndex();
+    if (index.isValid()) {
+        m_cyclicModel->removeMessage(index.row());
+    }
+}
+
+void xToolsCanBusStudioUi::onCyclicStartClicked()
+{
+    if (m_cyclicTransmitter->isRunning()) {
+        m_cyclicTransmitter->stop();
+        ui->cyclicStartPushButton->setText(tr("Start"));
+        return;
+    }
+
+    if (!m_device) {
+        QString title = tr("Device is Not Ready");
+        QString msg = tr("Device is not ready, please connect the device then try angin!");
+        QMessageBox::warning(this, title, msg);
+        return;
+    }
+
+    if (m_cyclicTransmitter->isBusLoadExceeded()) {
+        QString title = tr("Bus Load Exceeded");
+        QString msg = tr("The estimated bus load %1% is above the threshold %2%, the frames "
+                         "may be delayed by the bus.")
+                          .arg(m_cyclicTransmitter->busLoad(), 0, 'f', 1)
+                          .arg(m_cyclicTransmitter->busLoadThreshold());
+        QMessageBox::warning(this, title, msg);
+    }
+
+    m_cyclicTransmitter->start();
+    ui->cyclicStartPushButton->setText(tr("Stop"));
+}
+
+void xToolsCanBusStudioUi::onCyclicMessagesChanged()
+{
+    QVariantList messages;
+    for (int i = 0; i < m_cyclicTransmitter->messageCount(); i++) {
+        const xToolsCanBusCyclicTransmitter::Message &message = m_cyclicTransmitter->message(i);
+        messages.append(xToolsCanBusCyclicTransmitter::saveMessage(message));
+    }
+
+    m_settings->setValue(m_settingKeyCtx.cyclicMessages, messages);
+}
+
+void xToolsCanBusStudioUi::onCyclicFramesSent(const QVector<QCanBusFrame> &frames)
+{
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch() * 1000;
+    for (const QCanBusFrame &frame : frames) {
+        appendFrame(frame, true, timestamp);
+        appendWritingFrame(frame);
+    }
+}
+
+void xToolsCanBusStudioUi::onBusLoadChanged()
+{
+    const bool isExceeded = m_cyclicTransmitter->isBusLoadExceeded();
+    ui->busLoadLabel->setText(tr("Bus load: %1%").arg(m_cyclicTransmitter->busLoad(), 0, 'f', 1));
+    ui->busLoadLabel->setStyleSheet(isExceeded ? QString("color: red") : QString());
+    if (isExceeded && m_cyclicTransmitter->isRunning()) {
+        qWarning() << "The estimated bus load is above the threshold:"
+                   << m_cyclicTransmitter->busLoad();
+    }
+}
+
+void xToolsCanBusStudioUi::onBusLoadThresholdChanged(int threshold)
+{
+    m_settings->setValue(m_settingKeyCtx.busLoadThreshold, threshold);
+    m_cyclicTransmitter->setBusLoadThreshold(threshold);
+    onBusLoadChanged();
+}
+
+void xToolsCanBusStudioUi::onStatisticsResetClicked()
+{
+    m_statistics->clear();
+    m_statisticsModel->reset();
+    updateStatisticsLabel();
 }
 
 void xToolsCanBusStudioUi::onErrorOccure(QCanBusDevice::CanBusError error)
@@ -370,24 +774,29 @@ void xToolsCanBusStudioUi::onFrameReceived()
         return;
     }
 
+    // The frames without a timestamp of the device get the time they are read.
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch() * 1000;
     while (m_device->framesAvailable()) {
         const QCanBusFrame frame = m_device->readFrame();
+        appendFrame(frame, false, timestamp);
 
-        QString view;
-        if (frame.frameType() == QCanBusFrame::ErrorFrame) {
-            view = m_device->interpretErrorFrame(frame);
-        } else {
-            view = frame.toString();
+        // The own frames received again are counted when they are written.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        if (frame.hasLocalEcho()) {
+            continue;
         }
-
-        QString flag = QString("<font color=blue>[Rx] </font>");
-        outputMessage(flag + view);
+#endif
+        m_statistics->add(frame, false, timestamp);
     }
 }
 
 void xToolsCanBusStudioUi::onFrameWritten(qint64 framesCount)
 {
-    qInfo() << framesCount;
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch() * 1000;
+    for (qint64 i = 0; i < framesCount && !m_writingFrames.empty(); i++) {
+        m_statistics->add(m_writingFrames.front(), true, timestamp);
+        m_writingFrames.pop_front();
+    }
 }
 
 void xToolsCanBusStudioUi::setOptions(QComboBox* cb, bool usingUnspecified)
@@ -428,13 +837,6 @@ void xToolsCanBusStudioUi::setCustomConfigurationEnable(bool enable)
     ui->dataBitrateComboBox->setEnabled(enable);
 }
 
-void xToolsCanBusStudioUi::outputMessage(const QString& msg)
-{
-    QString datetimeString = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-    QString cookedMsg = QString("<font color=silver>%1 </font>").arg(datetimeString);
-    ui->textBrowser->append(cookedMsg + msg);
-}
-
 void xToolsCanBusStudioUi::updateUiState(bool connected)
 {
     ui->connectPushButton->setEnabled(!connected);
@@ -450,6 +852,187 @@ void xToolsCanBusStudioUi::updateUiState(bool connected)
     }
 }
 
+bool xToolsCanBusStudioUi::loadDbc(const QString &fileName, QString &errorString)
+{
+    if (!m_dbc->load(fileName, errorString)) {
+        return false;
+    }
+
+    m_traceModel->setDbc(m_dbc);
+    ui->plotWidget->setDbc(m_dbc);
+    updateTraceColumns();
+
+    QSignalBlocker signalListBlocker(ui->signalListWidget);
+    QSignalBlocker messageBlocker(ui->dbcMessageComboBox);
+    ui->signalListWidget->clear();
+    ui->dbcMessageComboBox->clear();
+    ui->dbcMessageComboBox->addItem(tr("None"), -1);
+    for (int i = 0; i < m_dbc->messageCount(); i++) {
+        const xToolsCanBusDbc::Message &message = m_dbc->message(i);
+        ui->dbcMessageComboBox->addItem(message.name, i);
+        for (int j = message.firstSignal; j < message.firstSignal + message.signalCount; j++) {
+            auto *item = new QListWidgetItem(message.name + "." + m_dbc->signal(j).name);
+            item->setData(Qt::UserRole, j);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+            item->setCheckState(Qt::Unchecked);
+            ui->signalListWidget->addItem(item);
+        }
+    }
+
+    onDbcMessageChanged();
+    return true;
+}
+
+void xToolsCanBusStudioUi::updateTraceColumns()
+{
+    // The hidden columns are shown again when the model is reset.
+    const bool isFixedMode = m_traceModel->isFixedMode();
+    ui->tableView->setColumnHidden(xToolsCanBusTraceModel::ColumnCount, !isFixedMode);
+    ui->tableView->setColumnHidden(xToolsCanBusTraceModel::ColumnSignals, m_dbc->isEmpty());
+    ui->autoScrollCheckBox->setEnabled(!isFixedMode);
+}
+
+void xToolsCanBusStudioUi::appendFrame(const QCanBusFrame &frame, bool isTx, qint64 timestamp)
+{
+    QString errorText;
+    if (frame.frameType() == QCanBusFrame::ErrorFrame && m_device) {
+        errorText = m_device->interpretErrorFrame(frame);
+    }
+
+    m_frameBuffer->append(frame, isTx, timestamp, errorText);
+    plotFrame(m_frameBuffer->endSequence() - 1);
+}
+
+void xToolsCanBusStudioUi::plotFrame(quint64 sequence)
+{
+    const xToolsCanBusFrameBuffer::Frame *frame = m_frameBuffer->frame(sequence);
+    const quint8 skipped = xToolsCanBusFrameBuffer::FlagError | xToolsCanBusFrameBuffer::FlagRemote;
+    if (m_dbc->isEmpty() || !frame || (frame->flags & skipped)) {
+        return;
+    }
+
+    const bool isExtended = frame->flags & xToolsCanBusFrameBuffer::FlagExtended;
+    const int message = m_dbc->findMessage(frame->frameId, isExtended);
+    if (message != -1) {
+        ui->plotWidget->addFrame(message, frame->payload, frame->length, frame->timestamp);
+    }
+}
+
+bool xToolsCanBusStudioUi::encodeDbcPayload(int message,
+                                            QByteArray &payload,
+                                            QString &errorString)
+{
+    // "Speed=12.5, Gear=3", the signals that are not given are 0.
+    const xToolsCanBusDbc::Message &m = m_dbc->message(message);
+    QVector<double> values(m.signalCount, 0);
+    const QStringList items = ui->payloadComboBox->currentText().split(QRegularExpression("[,;]"));
+    for (const QString &item : items) {
+        if (item.trimmed().isEmpty()) {
+            continue;
+        }
+
+        const QStringList pair = item.split('=');
+        const int signal = pair.size() == 2 ? m_dbc->findSignal(message, pair.at(0).trimmed()) : -1;
+        bool ok = false;
+        const double value = pair.size() == 2 ? pair.at(1).trimmed().toDouble(&ok) : 0;
+        if (signal == -1 || !ok) {
+            errorString = tr("Invalid signal value \"%1\" of %2.").arg(item.trimmed(), m.name);
+            return false;
+        }
+
+        values[signal - m.firstSignal] = value;
+    }
+
+    // The signals of other multiplexor values are not written, the multiplexor is a raw value.
+    if (m.multiplexor != -1) {
+        const double multiplexValue = values.at(m.multiplexor - m.firstSignal);
+        for (int i = 0; i < m.signalCount; i++) {
+            const int multiplexed = m_dbc->signal(m.firstSignal + i).multiplexValue;
+            if (multiplexed != -1 && multiplexed != multiplexValue) {
+                values[i] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+    }
+
+    payload = QByteArray(m.length, 0);
+    m_dbc->encode(message, values.constData(), reinterpret_cast<uchar *>(payload.data()));
+    return true;
+}
+
+bool xToolsCanBusStudioUi::frameOfSendPanel(QCanBusFrame &frame, QString &errorString)
+{
+    uint frameId = ui->frameIdComboBox->currentText().toUInt(Q_NULLPTR, 16);
+    bool isExtended = ui->extendedFormatCheckBox->isChecked();
+    QString data = ui->payloadComboBox->currentText().trimmed();
+    QByteArray payload;
+
+    // The payload of a DBC message is encoded from the signal values of the payload text.
+    const int message = ui->dbcMessageComboBox->currentData().toInt();
+    if (message >= 0) {
+        if (!encodeDbcPayload(message, payload, errorString)) {
+            return false;
+        }
+
+        frameId = m_dbc->message(message).frameId;
+        isExtended = m_dbc->message(message).isExtended;
+    } else {
+        payload = QByteArray::fromHex(data.remove(QLatin1Char(' ')).toLatin1());
+    }
+
+    frame = QCanBusFrame(frameId, payload);
+    frame.setExtendedFrameFormat(isExtended);
+
+    if (ui->flexibleDataRateCheckBox->isEnabled()) {
+        frame.setFlexibleDataRateFormat(ui->flexibleDataRateCheckBox->isChecked());
+    }
+
+    if (ui->bitrateSwitchCheckBox->isEnabled()) {
+        frame.setBitrateSwitch(ui->bitrateSwitchCheckBox->isChecked());
+    }
+
+    return true;
+}
+
+void xToolsCanBusStudioUi::updateBitrates()
+{
+    // The bitrates of the configuration, the configuration of the device may differ from them if
+    // the custom configuration is not used.
+    const int bitrate = ui->bitrateComboBox->currentData().toInt();
+    const int dataBitrate = ui->dataBitrateComboBox->currentData().toInt();
+    m_cyclicTransmitter->setBitrates(bitrate, dataBitrate);
+    m_statistics->setBitrates(bitrate, dataBitrate);
+    m_statisticsModel->reset();
+}
+
+void xToolsCanBusStudioUi::appendWritingFrame(const QCanBusFrame &frame)
+{
+    // A device that does not report the written frames must not grow the queue forever.
+    if (m_writingFrames.size() >= 10000) {
+        m_writingFrames.pop_front();
+    }
+
+    m_writingFrames.push_back(frame);
+}
+
+void xToolsCanBusStudioUi::updateStatisticsLabel()
+{
+    QStringList errors;
+    for (int i = 0; i < xToolsCanBusStatistics::errorTypeCount; i++) {
+        if (m_statistics->errorCount(i) > 0) {
+            errors.append(QString("%1: %2")
+                              .arg(xToolsCanBusStatistics::errorTypeText(i))
+                              .arg(m_statistics->errorCount(i)));
+        }
+    }
+
+    ui->statisticsLabel->setText(tr("Bus load: %1%, peak: %2%, frames: %3, error frames: %4")
+                                     .arg(m_statistics->busLoad(), 0, 'f', 1)
+                                     .arg(m_statistics->peakBusLoad(), 0, 'f', 1)
+                                     .arg(m_statistics->frames())
+                                     .arg(m_statistics->errorFrames()));
+    ui->statisticsLabel->setToolTip(errors.join("\n"));
+}
+
 QVector<xToolsCanBusStudioUi::ConfigurationItem> xToolsCanBusStudioUi::configurationItems()
 {
     QVector<xToolsCanBusStudioUi::ConfigurationItem> items;
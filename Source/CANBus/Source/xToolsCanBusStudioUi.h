@@ -8,15 +8,26 @@
  **************************************************************************************************/
 #pragma once
 
+#include <deque>
 #include <QCanBusDevice>
 #include <QCanBusDeviceInfo>
 #include <QCanBusFrame>
 #include <QCheckBox>
 #include <QComboBox>
 #include <QSettings>
+#include <QTimer>
 #include <QVector>
 #include <QWidget>
 
+class QListWidgetItem;
+class xToolsCanBusCyclicModel;
+class xToolsCanBusCyclicTransmitter;
+class xToolsCanBusDbc;
+class xToolsCanBusFrameBuffer;
+class xToolsCanBusStatistics;
+class xToolsCanBusStatisticsModel;
+class xToolsCanBusTraceModel;
+
 namespace Ui {
 class xToolsCanBusStudioUi;
 }
@@ -48,6 +59,12 @@ private:
         const QString extendedFormat = "CANStudio/extendedFormat";
         const QString flexibleDataRate = "CANStudio/fleibleDataRate";
         const QString bitrateSwitch = "CANStudio/bitrateSwitch";
+
+        const QString fixedMode = "CANStudio/fixedMode";
+        const QString dbcFileName = "CANStudio/dbcFileName";
+
+        const QString cyclicMessages = "CANStudio/cyclicMessages";
+        const QString busLoadThreshold = "CANStudio/busLoadThreshold";
     } m_settingKeyCtx;
 
 private:
@@ -55,6 +72,16 @@ private:
     QSettings *m_settings{nullptr};
     QCanBusDevice *m_device{nullptr};
     QList<QCanBusDeviceInfo> m_interfaces;
+    xToolsCanBusFrameBuffer *m_frameBuffer{nullptr};
+    xToolsCanBusTraceModel *m_traceModel{nullptr};
+    xToolsCanBusDbc *m_dbc{nullptr};
+    QTimer *m_refreshTimer{nullptr};
+    xToolsCanBusCyclicTransmitter *m_cyclicTransmitter{nullptr};
+    xToolsCanBusCyclicModel *m_cyclicModel{nullptr};
+    xToolsCanBusStatistics *m_statistics{nullptr};
+    xToolsCanBusStatisticsModel *m_statisticsModel{nullptr};
+    // The frames written to the device, they are on the bus when the device reports them written.
+    std::deque<QCanBusFrame> m_writingFrames;
 
 private:
     void initUi();
@@ -62,12 +89,17 @@ private:
     void initUiSpecifyConfiguration();
     void initUiCanFrame();
     void initUiSendCanFrame();
+    void initUiDataView();
+    void initUiCyclic();
+    void initUiStatistics();
 
     void initSetting();
     void initSettingSelectPlugin();
     void initSettingSpecifyConfiguration();
     void initSettingCanFrame();
     void initSettingSendCanFrame();
+    void initSettingDataView();
+    void initSettingCyclic();
 
 private slots:
     // These are slots.
@@ -89,6 +121,23 @@ private slots:
 
     void onSendButtonClicked();
 
+    void onFixedModeChanged();
+    void onClearClicked();
+    void onExportClicked();
+    void onRefreshTimerTimeout();
+    void onLoadDbcClicked();
+    void onSignalItemChanged(QListWidgetItem *item);
+    void onDbcMessageChanged();
+
+    void onCyclicAddClicked();
+    void onCyclicRemoveClicked();
+    void onCyclicStartClicked();
+    void onCyclicMessagesChanged();
+    void onCyclicFramesSent(const QVector<QCanBusFrame> &frames);
+    void onBusLoadChanged();
+    void onBusLoadThresholdChanged(int threshold);
+    void onStatisticsResetClicked();
+
     // Slots about CAN bus device
     void onErrorOccure(QCanBusDevice::CanBusError error);
     void onFrameReceived();
@@ -100,7 +149,15 @@ private:
     void setBitRates(QComboBox *cb, bool isFlexibleDataRateEnable);
     void setChecked(QCheckBox *cb, const QString &key);
     void setCustomConfigurationEnable(bool enable);
-    void outputMessage(const QString &msg);
     void updateUiState(bool connected);
+    bool loadDbc(const QString &fileName, QString &errorString);
+    void updateTraceColumns();
+    void appendFrame(const QCanBusFrame &frame, bool isTx, qint64 timestamp);
+    void plotFrame(quint64 sequence);
+    bool encodeDbcPayload(int message, QByteArray &payload, QString &errorString);
+    bool frameOfSendPanel(QCanBusFrame &frame, QString &errorString);
+    void updateBitrates();
+    void appendWritingFrame(const QCanBusFrame &frame);
+    void updateStatisticsLabel();
     QVector<ConfigurationItem> configurationItems();
 };
@@ -0,0 +1,240 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCanBusTraceModel.h"
+
+#include <cmath>
+
+#include <QDateTime>
+
+#include "xToolsCanBusDbc.h"
+
+xToolsCanBusTraceModel::xToolsCanBusTraceModel(xToolsCanBusFrameBuffer *buffer, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_buffer(buffer)
+{}
+
+void xToolsCanBusTraceModel::setFixedMode(bool fixed)
+{
+    if (m_isFixedMode == fixed) {
+        return;
+    }
+
+    beginResetModel();
+    m_isFixedMode = fixed;
+    m_firstSequence = m_buffer->firstSequence();
+    m_rowCount = fixed ? m_buffer->idCount() : int(m_buffer->endSequence() - m_firstSequence);
+    endResetModel();
+}
+
+bool xToolsCanBusTraceModel::isFixedMode() const
+{
+    return m_isFixedMode;
+}
+
+void xToolsCanBusTraceModel::setDbc(const xToolsCanBusDbc *dbc)
+{
+    m_dbc = dbc;
+    if (m_rowCount > 0) {
+        emit dataChanged(index(0, ColumnSignals), index(m_rowCount - 1, ColumnSignals));
+    }
+}
+
+void xToolsCanBusTraceModel::refresh()
+{
+    if (m_isFixedMode) {
+        const int count = m_buffer->idCount();
+        if (count > m_rowCount) {
+            beginInsertRows(QModelIndex(), m_rowCount, count - 1);
+            m_rowCount = count;
+            endInsertRows();
+        }
+
+        // Only the visible rows are painted again.
+        if (m_rowCount > 0) {
+            emit dataChanged(index(0, 0), index(m_rowCount - 1, columnCount() - 1));
+        }
+        return;
+    }
+
+    const quint64 firstSequence = m_buffer->firstSequence();
+    const quint64 endSequence = m_buffer->endSequence();
+    const quint64 removed = firstSequence - m_firstSequence;
+    if (removed >= quint64(m_rowCount)) {
+        // All rows are overwritten, the view starts over.
+        if (m_rowCount > 0) {
+            beginRemoveRows(QModelIndex(), 0, m_rowCount - 1);
+            m_rowCount = 0;
+            endRemoveRows();
+        }
+        m_firstSequence = firstSequence;
+    } else if (removed > 0) {
+        beginRemoveRows(QModelIndex(), 0, int(removed) - 1);
+        m_rowCount -= int(removed);
+        m_firstSequence = firstSequence;
+        endRemoveRows();
+    }
+
+    const int count = int(endSequence - m_firstSequence);
+    if (count > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, count - 1);
+        m_rowCount = count;
+        endInsertRows();
+    }
+}
+
+void xToolsCanBusTraceModel::reset()
+{
+    beginResetModel();
+    m_firstSequence = m_buffer->firstSequence();
+    m_rowCount = m_isFixedMode ? m_buffer->idCount()
+                               : int(m_buffer->endSequence() - m_firstSequence);
+    endResetModel();
+}
+
+int xToolsCanBusTraceModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int xToolsCanBusTraceModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnSignals + 1;
+}
+
+QVariant xToolsCanBusTraceModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        if (index.column() == ColumnData || index.column() == ColumnSignals) {
+            return QVariant();
+        }
+
+        return int(Qt::AlignCenter);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    // The frame of a row may be overwritten before the next refresh.
+    const xToolsCanBusFrameBuffer::Frame *frame = nullptr;
+    const xToolsCanBusFrameBuffer::IdRow *row = nullptr;
+    qint64 count = 0;
+    if (m_isFixedMode) {
+        row = &m_buffer->idRow(index.row());
+        frame = &row->frame;
+        count = row->count;
+    } else {
+        frame = m_buffer->frame(m_firstSequence + index.row());
+    }
+
+    if (!frame) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case ColumnTime: {
+        QDateTime time = QDateTime::fromMSecsSinceEpoch(frame->timestamp / 1000);
+        return QString("%1%2")
+            .arg(time.toString("hh:mm:ss.zzz"))
+            .arg(frame->timestamp % 1000, 3, 10, QChar('0'));
+    }
+    case ColumnDirection:
+        return (frame->flags & xToolsCanBusFrameBuffer::FlagTx) ? QString("Tx") : QString("Rx");
+    case ColumnId:
+        return xToolsCanBusFrameBuffer::idText(*frame);
+    case ColumnType:
+        return xToolsCanBusFrameBuffer::typeText(*frame);
+    case ColumnDlc:
+        return xToolsCanBusFrameBuffer::dlc(frame->length);
+    case ColumnData: {
+        // The error frames are shown as the text interpreted by the device.
+        if (frame->flags & xToolsCanBusFrameBuffer::FlagError) {
+            const quint64 sequence = m_firstSequence + index.row();
+            QString text = row ? row->errorText : m_buffer->errorText(sequence);
+            if (!text.isEmpty()) {
+                return text;
+            }
+        }
+
+        return xToolsCanBusFrameBuffer::payloadText(*frame);
+    }
+    case ColumnDelta:
+        return QString::number(frame->delta / 1000.0, 'f', 3);
+    case ColumnCount:
+        return count;
+    case ColumnSignals:
+        return signalsText(*frame);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant xToolsCanBusTraceModel::headerData(int section,
+                                            Qt::Orientation orientation,
+                                            int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case ColumnTime:
+        return tr("Time");
+    case ColumnDirection:
+        return tr("Dir");
+    case ColumnId:
+        return tr("ID");
+    case ColumnType:
+        return tr("Type");
+    case ColumnDlc:
+        return tr("DLC");
+    case ColumnData:
+        return tr("Data");
+    case ColumnDelta:
+        return m_isFixedMode ? tr("Cycle(ms)") : tr("Δt(ms)");
+    case ColumnCount:
+        return tr("Count");
+    case ColumnSignals:
+        return tr("Signals");
+    default:
+        return QVariant();
+    }
+}
+
+QString xToolsCanBusTraceModel::signalsText(const xToolsCanBusFrameBuffer::Frame &frame) const
+{
+    const quint8 skipped = xToolsCanBusFrameBuffer::FlagError | xToolsCanBusFrameBuffer::FlagRemote;
+    if (!m_dbc || (frame.flags & skipped)) {
+        return QString();
+    }
+
+    const bool isExtended = frame.flags & xToolsCanBusFrameBuffer::FlagExtended;
+    const int message = m_dbc->findMessage(frame.frameId, isExtended);
+    if (message == -1) {
+        return QString();
+    }
+
+    const xToolsCanBusDbc::Message &m = m_dbc->message(message);
+    QString text = m.name + ":";
+    for (int i = m.firstSignal; i < m.firstSignal + m.signalCount; i++) {
+        const double value = m_dbc->decodeSignal(i, frame.payload, frame.length);
+        if (std::isnan(value)) {
+            continue;
+        }
+
+        const xToolsCanBusDbc::Signal &signal = m_dbc->signal(i);
+        text += QString(" %1=%2%3").arg(signal.name, QString::number(value, 'g', 8), signal.unit);
+    }
+
+    return text;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QAbstractTableModel>
+
+#include "xToolsCanBusFrameBuffer.h"
+
+class xToolsCanBusDbc;
+
+/// A view of a frame buffer. The model holds no frames, the rows are formatted from the buffer
+/// when they are painted, so only the visible rows cost anything. The rows follow the buffer only
+/// when refresh() is called, a timer of the ui calls it, not every frame.
+///
+/// In the trace mode a row is a frame, in the fixed mode a row is a CAN id with its latest frame,
+/// the count and the cycle time of the id. With a DBC, the signals of the frames are decoded when
+/// the rows are painted too.
+class xToolsCanBusTraceModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        ColumnTime,
+        ColumnDirection,
+        ColumnId,
+        ColumnType,
+        ColumnDlc,
+        ColumnData,
+        ColumnDelta,
+        ColumnCount, // The fixed mode only, the view hides it in the trace mode.
+        ColumnSignals
+    };
+
+public:
+    xToolsCanBusTraceModel(xToolsCanBusFrameBuffer *buffer, QObject *parent = nullptr);
+
+    void setFixedMode(bool fixed);
+    bool isFixedMode() const;
+    /// Set nullptr to show no signals.
+    void setDbc(const xToolsCanBusDbc *dbc);
+    /// Insert the new frames and remove the overwritten ones.
+    void refresh();
+    /// Call it after the buffer is cleared.
+    void reset();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    xToolsCanBusFrameBuffer *m_buffer;
+    const xToolsCanBusDbc *m_dbc{nullptr};
+    bool m_isFixedMode{false};
+    quint64 m_firstSequence{0}; // The sequence of the frame of the first row, the trace mode.
+    int m_rowCount{0};
+
+private:
+    QString signalsText(const xToolsCanBusFrameBuffer::Frame &frame) const;
+};
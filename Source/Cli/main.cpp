@@ -0,0 +1,89 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "xToolsCli.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("xtools-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Run xTools pipelines without the gui.");
+    parser.addHelpOption();
+    QCommandLineOption configOption({"c", "config"},
+                                    "The JSON configuration file of the pipelines.",
+                                    "file");
+    QCommandLineOption intervalOption({"i", "interval"},
+                                      "The interval of the metrics output, 0 = no output.",
+                                      "ms",
+                                      "1000");
+    QCommandLineOption durationOption({"d", "duration"},
+                                      "Quit after the duration, 0 = run until interrupted.",
+                                      "s",
+                                      "0");
+    QCommandLineOption metricsPortOption({"p", "metrics-port"},
+                                         "Serve the metrics on 127.0.0.1:<port>/metrics.",
+                                         "port",
+                                         "0");
+    QCommandLineOption modbusLoadOption({"m", "modbus-load"},
+                                        "Run a modbus load test instead of the pipelines, the "
+                                        "duration overrides the one of the configuration.",
+                                        "file");
+    QCommandLineOption modbusPollerOption({"P", "modbus-poller"},
+                                          "Poll the tags of a modbus client instead of the "
+                                          "pipelines, the values and the statistics of every "
+                                          "server are written at the interval.",
+                                          "file");
+    QCommandLineOption modbusSimulatorOption({"S", "modbus-simulator"},
+                                             "Run a modbus tcp simulator(or gateway) instead of "
+                                             "the pipelines, the statistics are written at the "
+                                             "interval.",
+                                             "file");
+    QCommandLineOption outputOption({"o", "output"},
+                                    "The JSON statistics of the load test, default = stdout.",
+                                    "file");
+    parser.addOption(configOption);
+    parser.addOption(intervalOption);
+    parser.addOption(durationOption);
+    parser.addOption(metricsPortOption);
+    parser.addOption(modbusLoadOption);
+    parser.addOption(modbusPollerOption);
+    parser.addOption(modbusSimulatorOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    if (!parser.isSet(configOption) && !parser.isSet(modbusLoadOption)
+        && !parser.isSet(modbusPollerOption) && !parser.isSet(modbusSimulatorOption)) {
+        parser.showHelp(1);
+    }
+
+    xToolsCli::Parameters parameters;
+    parameters.configFileName = parser.value(configOption);
+    parameters.metricsInterval = parser.value(intervalOption).toInt();
+    parameters.duration = parser.value(durationOption).toInt();
+    parameters.metricsPort = parser.value(metricsPortOption).toInt();
+    parameters.modbusLoadFileName = parser.value(modbusLoadOption);
+    parameters.modbusPollerFileName = parser.value(modbusPollerOption);
+    parameters.modbusSimulatorFileName = parser.value(modbusSimulatorOption);
+    parameters.outputFileName = parser.value(outputOption);
+
+    xToolsCli cli;
+    QString errorString;
+    if (!cli.start(parameters, errorString)) {
+        QTextStream(stderr) << errorString << "\n";
+        return 1;
+    }
+
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &cli, &xToolsCli::stop);
+    return app.exec();
+}
@@ -0,0 +1,728 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCli.h"
+
+#include <csignal>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QTextStream>
+
+#include "xToolsMetricsServer.h"
+#include "xToolsToolFactory.h"
+
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+#include "xToolsModbusLoadTester.h"
+#include "xToolsModbusPoller.h"
+#include "xToolsModbusSimulator.h"
+#include "xToolsModbusStudio.h"
+#endif
+
+static volatile std::sig_atomic_t quitRequested = 0;
+
+static void onQuitSignal(int)
+{
+    quitRequested = 1;
+}
+
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+// An enum value can be written as the name of it, such as "ModbusTcpClient".
+static void resolveEnum(QVariantMap &map, const QString &key, const QMetaEnum &metaEnum)
+{
+    QVariant value = map.value(key);
+    if (value.userType() == QMetaType::QString) {
+        bool ok = false;
+        int v = value.toString().toInt(&ok);
+        if (!ok) {
+            v = metaEnum.keyToValue(value.toString().toLatin1().constData());
+        }
+        map.insert(key, v);
+    }
+}
+
+// QModbusDataUnit::RegisterType is not a meta enum.
+static void resolveTable(QVariantMap &map, const QString &key)
+{
+    static const QMap<QString, int> tables{{"DiscreteInputs", QModbusDataUnit::DiscreteInputs},
+                                           {"Coils", QModbusDataUnit::Coils},
+                                           {"InputRegisters", QModbusDataUnit::InputRegisters},
+                                           {"HoldingRegisters", QModbusDataUnit::HoldingRegisters}};
+    const QString name = map.value(key).toString();
+    if (tables.contains(name)) {
+        map.insert(key, tables.value(name));
+    }
+}
+#endif
+
+xToolsCli::xToolsCli(QObject *parent)
+    : QObject{parent}
+    , m_metricsTimer{new QTimer(this)}
+    , m_signalTimer{new QTimer(this)}
+{
+    connect(m_metricsTimer, &QTimer::timeout, this, &xToolsCli::outputMetrics);
+
+    // Nothing but a flag can be set in a signal handler, the flag is polled in the event loop.
+    m_signalTimer->setInterval(100);
+    connect(m_signalTimer, &QTimer::timeout, this, [this]() {
+        if (!quitRequested) {
+            return;
+        }
+
+        // The load test is stopped first, its statistics are written when it is finished.
+        quitRequested = 0;
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+        if (m_loadTester) {
+            m_loadTester->stop();
+            return;
+        }
+#endif
+        QCoreApplication::quit();
+    });
+}
+
+xToolsCli::~xToolsCli()
+{
+    stop();
+}
+
+bool xToolsCli::start(const Parameters &parameters, QString &errorString)
+{
+    if (!parameters.modbusLoadFileName.isEmpty()) {
+        if (!startModbusLoad(parameters, errorString)) {
+            return false;
+        }
+
+        std::signal(SIGINT, onQuitSignal);
+        std::signal(SIGTERM, onQuitSignal);
+        m_signalTimer->start();
+        return true;
+    }
+
+    if (!parameters.modbusPollerFileName.isEmpty()) {
+        if (!startModbusPoller(parameters, errorString)) {
+            return false;
+        }
+
+        startTimers(parameters);
+        return true;
+    }
+
+    if (!parameters.modbusSimulatorFileName.isEmpty()) {
+        if (!startModbusSimulator(parameters, errorString)) {
+            return false;
+        }
+
+        startTimers(parameters);
+        return true;
+    }
+
+    QList<QVariantMap> configs;
+    if (!loadConfig(parameters.configFileName, configs, errorString)) {
+        return false;
+    }
+
+    for (int i = 0; i < configs.length(); i++) {
+        const QVariantMap &config = configs.at(i);
+        QString name = config.value(m_keys.name, QString("pipeline%1").arg(i)).toString();
+        Pipeline pipeline = createPipeline(name, config);
+        if (!pipeline.toolBox->getCommunicationTool()) {
+            errorString = QString("Invalid communication type of %1.").arg(name);
+            delete pipeline.toolBox;
+            delete pipeline.rxMeter;
+            delete pipeline.txMeter;
+            return false;
+        }
+
+        m_pipelines.append(pipeline);
+    }
+
+    m_metricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            for (const Pipeline &pipeline : m_pipelines) {
+                xToolsMetricsServer::Labels rx{qMakePair(QString("pipeline"), pipeline.name),
+                                               qMakePair(QString("direction"), QString("rx"))};
+                xToolsMetricsServer::Labels tx{qMakePair(QString("pipeline"), pipeline.name),
+                                               qMakePair(QString("direction"), QString("tx"))};
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_pipeline_bytes",
+                                                "Bytes read or written by the pipeline.",
+                                                rx,
+                                                pipeline.rxMeter->totalBytes());
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_pipeline_bytes",
+                                                "Bytes read or written by the pipeline.",
+                                                tx,
+                                                pipeline.txMeter->totalBytes());
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_pipeline_frames",
+                                                "Frames read or written by the pipeline.",
+                                                rx,
+                                                pipeline.rxMeter->totalFrames());
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_pipeline_frames",
+                                                "Frames read or written by the pipeline.",
+                                                tx,
+                                                pipeline.txMeter->totalFrames());
+            }
+        });
+
+    if (parameters.metricsPort > 0) {
+        xToolsMetricsServer *server = xToolsMetricsServer::instance();
+        connect(server, &xToolsMetricsServer::errorOccurred, this, [](const QString &errorString) {
+            qWarning() << "Metrics endpoint:" << errorString;
+        });
+        server->setPort(parameters.metricsPort);
+        server->start();
+    }
+
+    for (const Pipeline &pipeline : m_pipelines) {
+        pipeline.toolBox->open();
+    }
+
+    startTimers(parameters);
+    return true;
+}
+
+void xToolsCli::stop()
+{
+    m_metricsTimer->stop();
+    m_signalTimer->stop();
+
+    if (m_metricsCollector != -1) {
+        xToolsMetricsServer::instance()->removeCollector(m_metricsCollector);
+        m_metricsCollector = -1;
+    }
+    xToolsMetricsServer::instance()->stop();
+
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    delete m_loadTester;
+    m_loadTester = nullptr;
+
+    // The poller and the gateway are children of the client.
+    delete m_poller;
+    m_poller = nullptr;
+    delete m_simulator;
+    m_simulator = nullptr;
+    if (m_modbusClient) {
+        m_modbusClient->disconnect(this);
+        m_modbusClient->disconnectDevice();
+        xToolsModbusStudio::Instance()->DeleteModbusDevuce(&m_modbusClient);
+    }
+#endif
+
+    // The storers flush the pending frames when they are closed.
+    for (const Pipeline &pipeline : m_pipelines) {
+        pipeline.toolBox->close();
+        delete pipeline.toolBox;
+        delete pipeline.rxMeter;
+        delete pipeline.txMeter;
+    }
+    m_pipelines.clear();
+}
+
+bool xToolsCli::loadConfig(const QString &fileName,
+                           QList<QVariantMap> &configs,
+                           QString &errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        errorString = QString("Can not open %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    file.close();
+    if (!doc.isObject()) {
+        errorString = QString("Invalid configuration file %1: %2");
+        errorString = errorString.arg(fileName, error.errorString());
+        return false;
+    }
+
+    QJsonObject obj = doc.object();
+    if (obj.contains(m_keys.pipelines)) {
+        const QJsonArray pipelines = obj.value(m_keys.pipelines).toArray();
+        for (const QJsonValue &pipeline : pipelines) {
+            configs.append(pipeline.toObject().toVariantMap());
+        }
+    } else {
+        configs.append(obj.toVariantMap());
+    }
+
+    if (configs.isEmpty()) {
+        errorString = QString("No pipeline is configured in %1.").arg(fileName);
+        return false;
+    }
+
+    // The communication type can be written as the name of the tool, such as "TcpServerTool".
+    QMetaEnum toolsType = QMetaEnum::fromType<xToolsToolFactory::ToolsType>();
+    for (QVariantMap &config : configs) {
+        QVariant type = config.value(m_keys.communicationType);
+        if (type.userType() == QMetaType::QString) {
+            bool ok = false;
+            int value = type.toString().toInt(&ok);
+            if (!ok) {
+                value = toolsType.keyToValue(type.toString().toLatin1().constData());
+            }
+            config.insert(m_keys.communicationType, value);
+        }
+    }
+
+    return true;
+}
+
+xToolsCli::Pipeline xToolsCli::createPipeline(const QString &name, const QVariantMap &config)
+{
+    Pipeline pipeline;
+    pipeline.name = name;
+    pipeline.toolBox = new xToolsToolBox();
+    pipeline.rxMeter = new xToolsRateMeter();
+    pipeline.txMeter = new xToolsRateMeter();
+    pipeline.toolBox->load(config);
+
+    xToolsCommunicationTool *communicator = pipeline.toolBox->getCommunicationTool();
+    if (!communicator) {
+        return pipeline;
+    }
+
+    communicator->setObjectName(name);
+    connect(pipeline.toolBox, &xToolsToolBox::errorOccurred, this, [name](const QString &error) {
+        QTextStream(stderr) << name << ": " << error << "\n";
+        QCoreApplication::exit(1);
+    });
+
+    // The meters and the storer are fed in the thread of the communication tool, the ui of the
+    // tool box feeds the storer with the formatted text instead.
+    xToolsRateMeter *rxMeter = pipeline.rxMeter;
+    xToolsRateMeter *txMeter = pipeline.txMeter;
+    xToolsStorerTool *storer = pipeline.toolBox->getStorerTool();
+    connect(
+        communicator,
+        &xToolsCommunicationTool::bytesRead,
+        communicator,
+        [rxMeter, storer](const QByteArray &bytes, const QString &) {
+            rxMeter->add(bytes.size());
+            if (storer->saveRx()) {
+                storer->inputBytes(bytes);
+            }
+        },
+        Qt::DirectConnection);
+    connect(
+        communicator,
+        &xToolsCommunicationTool::bytesWritten,
+        communicator,
+        [txMeter, storer](const QByteArray &bytes, const QString &) {
+            txMeter->add(bytes.size());
+            if (storer->saveTx()) {
+                storer->inputBytes(bytes);
+            }
+        },
+        Qt::DirectConnection);
+
+    return pipeline;
+}
+
+void xToolsCli::startTimers(const Parameters &parameters)
+{
+    if (parameters.metricsInterval > 0) {
+        m_metricsTimer->start(parameters.metricsInterval);
+    }
+
+    if (parameters.duration > 0) {
+        QTimer::singleShot(parameters.duration * 1000, qApp, &QCoreApplication::quit);
+    }
+
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+    m_signalTimer->start();
+}
+
+void xToolsCli::outputMetrics()
+{
+    QTextStream out(stdout);
+    QString time = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    for (const Pipeline &pipeline : m_pipelines) {
+        xToolsRateMeter::Rate rxRate = pipeline.rxMeter->rate(xToolsRateMeter::Window1s);
+        xToolsRateMeter::Rate txRate = pipeline.txMeter->rate(xToolsRateMeter::Window1s);
+
+        QJsonObject obj;
+        obj.insert("time", time);
+        obj.insert("pipeline", pipeline.name);
+        obj.insert("rxBytes", pipeline.rxMeter->totalBytes());
+        obj.insert("rxFrames", pipeline.rxMeter->totalFrames());
+        obj.insert("rxBytesPerSecond", rxRate.bytesPerSecond);
+        obj.insert("txBytes", pipeline.txMeter->totalBytes());
+        obj.insert("txFrames", pipeline.txMeter->totalFrames());
+        obj.insert("txBytesPerSecond", txRate.bytesPerSecond);
+        out << QJsonDocument(obj).toJson(QJsonDocument::Compact) << "\n";
+    }
+    out.flush();
+
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    if (m_poller) {
+        outputModbusPoller();
+    }
+
+    if (m_simulator) {
+        outputModbusSimulator();
+    }
+#endif
+}
+
+bool xToolsCli::loadModbusConfig(const QString &fileName, QVariantMap &config, QString &errorString)
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        errorString = QString("Can not open %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    file.close();
+    if (!doc.isObject()) {
+        errorString = QString("Invalid configuration file %1: %2");
+        errorString = errorString.arg(fileName, error.errorString());
+        return false;
+    }
+
+    config = doc.object().toVariantMap();
+    const QMetaEnum deviceType = QMetaEnum::fromType<xToolsModbusStudio::ModbusDeviceType>();
+    resolveEnum(config, m_keys.deviceType, deviceType);
+    return true;
+#else
+    Q_UNUSED(fileName);
+    Q_UNUSED(config);
+    errorString = QString("The modbus module is not enabled.");
+    return false;
+#endif
+}
+
+QModbusDevice *xToolsCli::createModbusClient(const QVariantMap &config, QString &errorString)
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    xToolsModbusStudio *studio = xToolsModbusStudio::Instance();
+    const int type = config.value(m_keys.deviceType, xToolsModbusStudio::ModbusTcpClient).toInt();
+    QModbusDevice *device = nullptr;
+    if (type == xToolsModbusStudio::ModbusTcpClient) {
+        device = studio->CreateTcpDevice(type,
+                                         config.value(m_keys.address, "127.0.0.1").toString(),
+                                         config.value(m_keys.port, 502).toInt());
+    } else if (type == xToolsModbusStudio::ModbusRtuSerialClient) {
+        device = studio->CreateRtuSerialDevice(type,
+                                               config.value(m_keys.portName).toString(),
+                                               config.value(m_keys.parity, 0).toInt(),
+                                               config.value(m_keys.baudRate, 9600).toInt(),
+                                               config.value(m_keys.dataBits, 8).toInt(),
+                                               config.value(m_keys.stopBits, 1).toInt());
+    } else {
+        errorString = QString("The device must be a tcp client or a rtu serial client.");
+        return nullptr;
+    }
+
+    studio->SetClientDeviceParameters(device,
+                                      config.value(m_keys.timeout, 1000).toInt(),
+                                      config.value(m_keys.retries, 0).toInt());
+    return device;
+#else
+    Q_UNUSED(config);
+    errorString = QString("The modbus module is not enabled.");
+    return nullptr;
+#endif
+}
+
+bool xToolsCli::startModbusLoad(const Parameters &parameters, QString &errorString)
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    QVariantMap config;
+    if (!loadModbusConfig(parameters.modbusLoadFileName, config, errorString)) {
+        return false;
+    }
+
+    xToolsModbusLoadTester::Parameters loadParameters;
+    loadParameters = xToolsModbusLoadTester::loadParameters(config);
+    if (parameters.duration > 0) {
+        loadParameters.duration = parameters.duration;
+    }
+
+    m_outputFileName = parameters.outputFileName;
+    m_loadTester = new xToolsModbusLoadTester();
+    connect(m_loadTester, &xToolsModbusLoadTester::finished, this, [this]() {
+        outputModbusLoad();
+        QCoreApplication::quit();
+    });
+    connect(m_loadTester, &xToolsModbusLoadTester::errorOccurred, this, [](const QString &error) {
+        QTextStream(stderr) << error << "\n";
+        QCoreApplication::exit(1);
+    });
+    connect(m_loadTester, &xToolsModbusLoadTester::started, this, []() {
+        QTextStream(stderr) << "All clients are connected, the load test is started.\n";
+    });
+
+    if (!m_loadTester->start(loadParameters, errorString)) {
+        delete m_loadTester;
+        m_loadTester = nullptr;
+        return false;
+    }
+
+    return true;
+#else
+    Q_UNUSED(parameters);
+    errorString = QString("The modbus module is not enabled.");
+    return false;
+#endif
+}
+
+void xToolsCli::outputModbusLoad()
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    xToolsModbusLoadTester::Statistics statistics = m_loadTester->statistics();
+    QTextStream(stderr) << xToolsModbusLoadTester::summary(statistics);
+
+    QJsonObject obj = xToolsModbusLoadTester::toJson(statistics);
+    obj.insert("time", QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    const QByteArray json = QJsonDocument(obj).toJson(QJsonDocument::Indented);
+    if (m_outputFileName.isEmpty()) {
+        QTextStream out(stdout);
+        out << json;
+        out.flush();
+        return;
+    }
+
+    QFile file(m_outputFileName);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        file.write(json);
+        file.close();
+    } else {
+        QTextStream(stderr) << "Can not open " << m_outputFileName << ": " << file.errorString()
+                            << "\n";
+    }
+#endif
+}
+
+bool xToolsCli::startModbusPoller(const Parameters &parameters, QString &errorString)
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    QVariantMap config;
+    if (!loadModbusConfig(parameters.modbusPollerFileName, config, errorString)) {
+        return false;
+    }
+
+    // The tag type can be written as a name, such as "TagTypeFloat", the table too.
+    QList<xToolsModbusPoller::Tag> tags;
+    const QMetaEnum tagType = QMetaEnum::fromType<xToolsModbusPoller::TagType>();
+    const QVariantList list = config.value(m_keys.tags).toList();
+    for (const QVariant &item : list) {
+        QVariantMap tag = item.toMap();
+        resolveEnum(tag, m_keys.type, tagType);
+        resolveTable(tag, m_keys.table);
+        tags.append(xToolsModbusPoller::loadTag(tag));
+    }
+
+    if (tags.isEmpty()) {
+        errorString = QString("No tag is configured in %1.").arg(parameters.modbusPollerFileName);
+        return false;
+    }
+
+    m_modbusClient = createModbusClient(config, errorString);
+    if (!m_modbusClient) {
+        return false;
+    }
+
+    xToolsModbusStudio *studio = xToolsModbusStudio::Instance();
+    m_poller = studio->CreatePoller(m_modbusClient);
+    m_poller->setMaxGap(config.value(m_keys.maxGap, 0).toInt());
+    m_poller->setTags(tags);
+
+    // The polls that are due before the client is connected would be lost.
+    connect(m_modbusClient, &QModbusDevice::stateChanged, this, [this](QModbusDevice::State state) {
+        if (state == QModbusDevice::ConnectedState) {
+            m_poller->start();
+        }
+    });
+    connect(m_modbusClient, &QModbusDevice::errorOccurred, this, [this]() {
+        QTextStream(stderr) << m_modbusClient->errorString() << "\n";
+        if (!m_poller->isRunning()) {
+            QCoreApplication::exit(1);
+        }
+    });
+
+    if (!studio->ConnectDeivce(m_modbusClient)) {
+        errorString = m_modbusClient->errorString();
+        return false;
+    }
+
+    if (m_modbusClient->state() == QModbusDevice::ConnectedState) {
+        m_poller->start();
+    }
+
+    return true;
+#else
+    Q_UNUSED(parameters);
+    errorString = QString("The modbus module is not enabled.");
+    return false;
+#endif
+}
+
+void xToolsCli::outputModbusPoller()
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    const QList<xToolsModbusPoller::Tag> tags = m_poller->tags();
+    const QVector<xToolsModbusPoller::TagValue> values = m_poller->tagValues();
+    QJsonArray tagArray;
+    for (int i = 0; i < tags.size() && i < values.size(); i++) {
+        const xToolsModbusPoller::TagValue &value = values.at(i);
+        QJsonObject obj;
+        obj.insert("name", tags.at(i).name);
+        obj.insert("serverAddress", tags.at(i).serverAddress);
+        obj.insert("value", QJsonValue::fromVariant(value.value));
+        obj.insert("timestamp", value.timestamp);
+        obj.insert("valid", value.isValid);
+        tagArray.append(obj);
+    }
+
+    QJsonObject servers;
+    const QMap<int, xToolsModbusPoller::ServerStatistics> statistics = m_poller->serverStatistics();
+    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
+        const xToolsModbusPoller::ServerStatistics &server = it.value();
+        QJsonObject obj;
+        obj.insert("requests", server.requests);
+        obj.insert("replies", server.replies);
+        obj.insert("errors", server.errors);
+        obj.insert("timeouts", server.timeouts);
+        obj.insert("skipped", server.skipped);
+        obj.insert("lastRtt", server.lastRtt);
+        obj.insert("minRtt", server.minRtt);
+        obj.insert("maxRtt", server.maxRtt);
+        obj.insert("meanRtt", server.meanRtt);
+        obj.insert("lastError", server.lastError);
+        servers.insert(QString::number(it.key()), obj);
+    }
+
+    QJsonObject obj;
+    obj.insert("time", QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    obj.insert("tags", tagArray);
+    obj.insert("servers", servers);
+    QTextStream out(stdout);
+    out << QJsonDocument(obj).toJson(QJsonDocument::Compact) << "\n";
+    out.flush();
+#endif
+}
+
+bool xToolsCli::startModbusSimulator(const Parameters &parameters, QString &errorString)
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    QVariantMap config;
+    if (!loadModbusConfig(parameters.modbusSimulatorFileName, config, errorString)) {
+        return false;
+    }
+
+    // The mode and the generator types can be written as names, such as "GatewayMode", the tables
+    // too.
+    resolveEnum(config, m_keys.mode, QMetaEnum::fromType<xToolsModbusSimulator::Mode>());
+    QVariantList units = config.value(m_keys.units).toList();
+    for (QVariant &unit : units) {
+        QVariantMap map = unit.toMap();
+        QVariantList ranges = map.value(m_keys.ranges).toList();
+        for (QVariant &range : ranges) {
+            QVariantMap r = range.toMap();
+            resolveTable(r, m_keys.table);
+            range = r;
+        }
+        map.insert(m_keys.ranges, ranges);
+        unit = map;
+    }
+    config.insert(m_keys.units, units);
+
+    const QMetaEnum generatorType = QMetaEnum::fromType<xToolsModbusSimulator::GeneratorType>();
+    QVariantList generators = config.value(m_keys.generators).toList();
+    for (QVariant &generator : generators) {
+        QVariantMap map = generator.toMap();
+        resolveEnum(map, m_keys.type, generatorType);
+        resolveTable(map, m_keys.table);
+        generator = map;
+    }
+    config.insert(m_keys.generators, generators);
+
+    xToolsModbusStudio *studio = xToolsModbusStudio::Instance();
+    if (config.value(m_keys.mode).toInt() == xToolsModbusSimulator::GatewayMode) {
+        QVariantMap client = config.value(m_keys.gateway).toMap();
+        const QMetaEnum deviceType = QMetaEnum::fromType<xToolsModbusStudio::ModbusDeviceType>();
+        resolveEnum(client, m_keys.deviceType, deviceType);
+        client.insert(m_keys.deviceType,
+                      client.value(m_keys.deviceType, xToolsModbusStudio::ModbusRtuSerialClient));
+        m_modbusClient = createModbusClient(client, errorString);
+        if (!m_modbusClient) {
+            return false;
+        }
+
+        m_simulator = studio->CreateGateway(m_modbusClient, config.value(m_keys.port, 502).toInt());
+        connect(m_modbusClient, &QModbusDevice::errorOccurred, this, [this]() {
+            QTextStream(stderr) << m_modbusClient->errorString() << "\n";
+        });
+        if (!studio->ConnectDeivce(m_modbusClient)) {
+            errorString = m_modbusClient->errorString();
+            return false;
+        }
+    } else {
+        m_simulator = new xToolsModbusSimulator();
+    }
+
+    connect(m_simulator, &xToolsModbusSimulator::errorOccurred, this, [](const QString &error) {
+        QTextStream(stderr) << error << "\n";
+    });
+    if (!m_simulator->load(config) || !m_simulator->start()) {
+        errorString = m_simulator->errorString();
+        return false;
+    }
+
+    return true;
+#else
+    Q_UNUSED(parameters);
+    errorString = QString("The modbus module is not enabled.");
+    return false;
+#endif
+}
+
+void xToolsCli::outputModbusSimulator()
+{
+#ifdef X_TOOLS_ENABLE_MODULE_MODBUS
+    const xToolsModbusSimulator::Statistics statistics = m_simulator->statistics();
+    QJsonObject obj;
+    obj.insert("time", QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    obj.insert("connections", statistics.connections);
+    obj.insert("requests", statistics.requests);
+    obj.insert("responses", statistics.responses);
+    obj.insert("exceptions", statistics.exceptions);
+    obj.insert("invalidFrames", statistics.invalidFrames);
+    obj.insert("unknownUnits", statistics.unknownUnits);
+    if (m_simulator->parameters().mode == xToolsModbusSimulator::GatewayMode) {
+        obj.insert("forwarded", statistics.forwarded);
+        obj.insert("answered", statistics.answered);
+        obj.insert("timeouts", statistics.timeouts);
+        obj.insert("busy", statistics.busy);
+        obj.insert("queueDepth", statistics.queueDepth);
+        obj.insert("maxQueueDepth", statistics.maxQueueDepth);
+        obj.insert("lastRtt", statistics.lastRtt);
+        obj.insert("maxRtt", statistics.maxRtt);
+        obj.insert("meanRtt", statistics.meanRtt);
+    }
+
+    QTextStream out(stdout);
+    out << QJsonDocument(obj).toJson(QJsonDocument::Compact) << "\n";
+    out.flush();
+#endif
+}
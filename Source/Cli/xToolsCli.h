@@ -0,0 +1,120 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "xToolsRateMeter.h"
+#include "xToolsToolBox.h"
+
+class QModbusDevice;
+class xToolsModbusLoadTester;
+class xToolsModbusPoller;
+class xToolsModbusSimulator;
+
+/// Run tool box pipelines without the gui. The configuration file is a JSON object saved by
+/// xToolsToolBox::save(), or an object with a "pipelines" array of such objects. The metrics of
+/// every pipeline are written to stdout as one JSON object per line.
+///
+/// With a modbus load configuration, the parameters of xToolsModbusLoadTester as a JSON object,
+/// the cli runs a load test instead. The summary is written to stderr at the end, the statistics
+/// are written to the output file(or stdout) as a JSON object.
+///
+/// With a modbus poller configuration, the parameters of the client and a "tags" array of
+/// xToolsModbusPoller tags, the values of the tags and the statistics of every server are written
+/// to stdout as one JSON object per line instead of the metrics.
+///
+/// With a modbus simulator configuration, see xToolsModbusSimulator::load(), the cli serves the
+/// units of it, or forwards the requests to the client of the "gateway" object in gateway mode.
+/// The statistics of the simulator are written to stdout as one JSON object per line.
+class xToolsCli : public QObject
+{
+    Q_OBJECT
+public:
+    struct Parameters
+    {
+        QString configFileName;
+        int metricsInterval{1000}; // ms, 0 = no metrics output.
+        int duration{0};           // s, 0 = run until the process is interrupted.
+        int metricsPort{0};        // The port of the metrics endpoint, 0 = disabled.
+        QString modbusLoadFileName;
+        QString modbusPollerFileName;
+        QString modbusSimulatorFileName;
+        QString outputFileName; // The statistics of the load test, empty = stdout.
+    };
+
+public:
+    explicit xToolsCli(QObject *parent = nullptr);
+    ~xToolsCli() override;
+
+    bool start(const Parameters &parameters, QString &errorString);
+    void stop();
+
+private:
+    struct Pipeline
+    {
+        QString name;
+        xToolsToolBox *toolBox;
+        xToolsRateMeter *rxMeter;
+        xToolsRateMeter *txMeter;
+    };
+
+    QList<Pipeline> m_pipelines;
+    QTimer *m_metricsTimer;
+    QTimer *m_signalTimer;
+    int m_metricsCollector{-1};
+    xToolsModbusLoadTester *m_loadTester{nullptr};
+    QModbusDevice *m_modbusClient{nullptr};
+    xToolsModbusPoller *m_poller{nullptr};
+    xToolsModbusSimulator *m_simulator{nullptr};
+    QString m_outputFileName;
+
+    struct
+    {
+        const QString pipelines{"pipelines"};
+        const QString name{"name"};
+        const QString communicationType{"communicationType"};
+        const QString deviceType{"deviceType"};
+        const QString address{"address"};
+        const QString port{"port"};
+        const QString portName{"portName"};
+        const QString baudRate{"baudRate"};
+        const QString dataBits{"dataBits"};
+        const QString parity{"parity"};
+        const QString stopBits{"stopBits"};
+        const QString timeout{"timeout"};
+        const QString retries{"retries"};
+        const QString maxGap{"maxGap"};
+        const QString tags{"tags"};
+        const QString table{"table"};
+        const QString type{"type"};
+        const QString mode{"mode"};
+        const QString gateway{"gateway"};
+        const QString units{"units"};
+        const QString ranges{"ranges"};
+        const QString generators{"generators"};
+    } m_keys;
+
+private:
+    bool loadConfig(const QString &fileName, QList<QVariantMap> &configs, QString &errorString);
+    Pipeline createPipeline(const QString &name, const QVariantMap &config);
+    void startTimers(const Parameters &parameters);
+    void outputMetrics();
+    bool loadModbusConfig(const QString &fileName, QVariantMap &config, QString &errorString);
+    QModbusDevice *createModbusClient(const QVariantMap &config, QString &errorString);
+    bool startModbusLoad(const Parameters &parameters, QString &errorString);
+    void outputModbusLoad();
+    bool startModbusPoller(const Parameters &parameters, QString &errorString);
+    void outputModbusPoller();
+    bool startModbusSimulator(const Parameters &parameters, QString &errorString);
+    void outputModbusSimulator();
+};
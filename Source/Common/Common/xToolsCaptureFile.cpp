@@ -0,0 +1,684 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCaptureFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QTemporaryFile>
+#include <QtEndian>
+
+#include "xToolsDataStructure.h"
+#include "xToolsPcapng.h"
+#include "xToolsSegmentCodec.h"
+
+static const char segmentMagic[8] = {'X', 'T', 'O', 'O', 'L', 'C', 'A', 'P'};
+static const char footerMagic[8] = {'X', 'T', 'C', 'A', 'P', 'E', 'N', 'D'};
+static const quint16 segmentVersion = 1;
+static const int maxPendingIndexEntries = 128;
+
+struct RecordHeader
+{
+    int type;
+    int direction;
+    quint16 endpoint;
+    quint32 length;
+    qint64 timestamp;
+};
+
+static RecordHeader recordHeader(const uchar *ptr)
+{
+    RecordHeader header;
+    header.type = ptr[0];
+    header.direction = ptr[1];
+    header.endpoint = qFromLittleEndian<quint16>(ptr + 2);
+    header.length = qFromLittleEndian<quint32>(ptr + 4);
+    header.timestamp = qFromLittleEndian<qint64>(ptr + 8);
+    return header;
+}
+
+static qint64 alignedSize(qint64 length)
+{
+    return (length + 7) & ~qint64(7);
+}
+
+qint64 xToolsCaptureFile::currentTimestamp()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+QString xToolsCaptureFile::directionName(int direction)
+{
+    if (direction == DirectionRx) {
+        return QStringLiteral("Rx");
+    } else if (direction == DirectionTx) {
+        return QStringLiteral("Tx");
+    }
+
+    return QStringLiteral("--");
+}
+
+xToolsAbstractCaptureWriter *xToolsCaptureFile::createWriter(const QString &fileName)
+{
+    if (fileName.endsWith(QStringLiteral(".pcapng"), Qt::CaseInsensitive)) {
+        return new xToolsPcapngWriter();
+    }
+
+    return new xToolsCaptureWriter();
+}
+
+xToolsAbstractCaptureReader *xToolsCaptureFile::createReader(const QString &fileName)
+{
+    QByteArray magic;
+    if (xToolsSegmentCodec::isSegmentFile(fileName)) {
+        xToolsSegmentDevice device(fileName);
+        if (device.open(QIODevice::ReadOnly)) {
+            magic = device.read(sizeof(segmentMagic));
+        }
+    } else {
+        QFile file(fileName);
+        if (file.open(QFile::ReadOnly)) {
+            magic = file.read(sizeof(segmentMagic));
+        }
+    }
+
+    if (magic.startsWith(QByteArray(segmentMagic, sizeof(segmentMagic)))) {
+        return new xToolsCaptureReader();
+    }
+
+    return new xToolsPcapngReader();
+}
+
+/**************************************************************************************************/
+QString xToolsAbstractCaptureWriter::errorString() const
+{
+    return m_errorString;
+}
+
+/**************************************************************************************************/
+QString xToolsAbstractCaptureReader::errorString() const
+{
+    return m_errorString;
+}
+
+bool xToolsAbstractCaptureReader::exportText(const QString &fileName, int textFormat)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+
+    rewind();
+
+    QByteArray buffer;
+    xToolsCaptureFrame frame;
+    while (readFrame(frame)) {
+        auto dt = QDateTime::fromMSecsSinceEpoch(frame.timestamp / 1000000);
+        QString line = QString("[%1 %2 %3] %4\n")
+                           .arg(xToolsCaptureFile::directionName(frame.direction),
+                                dt.toString("yyyy-MM-dd hh:mm:ss.zzz"),
+                                endpointName(frame.endpoint),
+                                xToolsDataStructure::byteArrayToString(frame.payload, textFormat));
+        buffer.append(line.toUtf8());
+        if (buffer.size() > 1024 * 1024) {
+            file.write(buffer);
+            buffer.resize(0);
+        }
+    }
+
+    file.write(buffer);
+    file.close();
+    rewind();
+    return true;
+}
+
+/**************************************************************************************************/
+xToolsCaptureWriter::xToolsCaptureWriter() {}
+
+xToolsCaptureWriter::~xToolsCaptureWriter()
+{
+    close();
+}
+
+bool xToolsCaptureWriter::open(const QString &fileName)
+{
+    return open(fileName, 0);
+}
+
+bool xToolsCaptureWriter::open(const QString &fileName, quint32 segmentIndex)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    m_endpoints.clear();
+    m_pendingIndex.clear();
+    m_frameCount = 0;
+    m_lastIndexOffset = 0;
+    m_batch.resize(0);
+    m_batch.reserve(64 * 1024);
+
+    if (m_file.exists() && m_file.size() > 0) {
+        if (!recover()) {
+            return false;
+        }
+    }
+
+    if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_fileSize = m_file.size();
+    if (m_fileSize == 0) {
+        char header[xToolsCaptureFile::segmentHeaderSize] = {0};
+        memcpy(header, segmentMagic, sizeof(segmentMagic));
+        qToLittleEndian<quint16>(segmentVersion, header + 8);
+        qToLittleEndian<quint16>(xToolsCaptureFile::segmentHeaderSize, header + 10);
+        qToLittleEndian<quint32>(segmentIndex, header + 12);
+        qToLittleEndian<qint64>(xToolsCaptureFile::currentTimestamp(), header + 16);
+        qToLittleEndian<quint32>(xToolsCaptureFile::indexInterval, header + 24);
+        m_batch.append(header, sizeof(header));
+        return flush();
+    }
+
+    return true;
+}
+
+void xToolsCaptureWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    appendIndexRecord();
+    appendTrailerRecord();
+    flush();
+    m_file.close();
+}
+
+bool xToolsCaptureWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString xToolsCaptureWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+qint64 xToolsCaptureWriter::size() const
+{
+    return m_fileSize + m_batch.size();
+}
+
+void xToolsCaptureWriter::append(qint64 timestamp,
+                                 int direction,
+                                 const QString &endpoint,
+                                 const QByteArray &payload)
+{
+    quint16 id = 0;
+    if (!endpoint.isEmpty()) {
+        if (m_endpoints.contains(endpoint)) {
+            id = m_endpoints.value(endpoint);
+        } else if (m_endpoints.count() < 0xffff) {
+            id = static_cast<quint16>(m_endpoints.count() + 1);
+            m_endpoints.insert(endpoint, id);
+            appendRecord(xToolsCaptureFile::RecordTypeEndpoint,
+                         xToolsCaptureFile::DirectionUnknown,
+                         id,
+                         timestamp,
+                         endpoint.toUtf8());
+        }
+    }
+
+    if (m_frameCount % xToolsCaptureFile::indexInterval == 0) {
+        m_pendingIndex.append(qMakePair(timestamp, static_cast<quint64>(size())));
+    }
+
+    appendRecord(xToolsCaptureFile::RecordTypeFrame, direction, id, timestamp, payload);
+    m_frameCount++;
+
+    if (m_pendingIndex.count() >= maxPendingIndexEntries) {
+        appendIndexRecord();
+    }
+}
+
+bool xToolsCaptureWriter::flush()
+{
+    if (m_batch.isEmpty()) {
+        return true;
+    }
+
+    qint64 ret = m_file.write(m_batch);
+    if (ret > 0) {
+        m_fileSize += ret;
+    }
+
+    if (ret != m_batch.size()) {
+        m_errorString = m_file.errorString();
+        qWarning() << "Failed to write capture file:" << m_file.fileName() << m_errorString;
+        m_batch.resize(0);
+        return false;
+    }
+
+    m_batch.resize(0);
+    return true;
+}
+
+void xToolsCaptureWriter::appendRecord(
+    int type, int direction, quint16 endpoint, qint64 timestamp, const QByteArray &payload)
+{
+    char header[xToolsCaptureFile::recordHeaderSize];
+    header[0] = static_cast<char>(type);
+    header[1] = static_cast<char>(direction);
+    qToLittleEndian<quint16>(endpoint, header + 2);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header + 4);
+    qToLittleEndian<qint64>(timestamp, header + 8);
+
+    m_batch.append(header, sizeof(header));
+    m_batch.append(payload);
+    m_batch.append(static_cast<int>(alignedSize(payload.size()) - payload.size()), '\0');
+}
+
+void xToolsCaptureWriter::appendIndexRecord()
+{
+    if (m_pendingIndex.isEmpty()) {
+        return;
+    }
+
+    QByteArray payload(16 + m_pendingIndex.count() * 16, '\0');
+    char *ptr = payload.data();
+    qToLittleEndian<quint64>(m_lastIndexOffset, ptr);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_pendingIndex.count()), ptr + 8);
+    ptr += 16;
+    for (auto &entry : m_pendingIndex) {
+        qToLittleEndian<qint64>(entry.first, ptr);
+        qToLittleEndian<quint64>(entry.second, ptr + 8);
+        ptr += 16;
+    }
+
+    m_lastIndexOffset = static_cast<quint64>(size());
+    qint64 timestamp = m_pendingIndex.last().first;
+    m_pendingIndex.clear();
+    appendRecord(xToolsCaptureFile::RecordTypeIndex,
+                 xToolsCaptureFile::DirectionUnknown,
+                 0,
+                 timestamp,
+                 payload);
+}
+
+void xToolsCaptureWriter::appendTrailerRecord()
+{
+    QByteArray payload(24, '\0');
+    qToLittleEndian<quint64>(m_lastIndexOffset, payload.data());
+    qToLittleEndian<quint64>(m_frameCount, payload.data() + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_endpoints.count()), payload.data() + 16);
+    for (auto it = m_endpoints.constBegin(); it != m_endpoints.constEnd(); ++it) {
+        QByteArray name = it.key().toUtf8().left(0xffff);
+        char entry[4];
+        qToLittleEndian<quint16>(it.value(), entry);
+        qToLittleEndian<quint16>(static_cast<quint16>(name.size()), entry + 2);
+        payload.append(entry, sizeof(entry));
+        payload.append(name);
+    }
+
+    // The footer must be the last 16 bytes of the segment, so the padding goes before it.
+    payload.append(static_cast<int>(alignedSize(payload.size()) - payload.size()), '\0');
+    char footer[xToolsCaptureFile::footerSize];
+    qToLittleEndian<quint64>(static_cast<quint64>(size()), footer);
+    memcpy(footer + 8, footerMagic, sizeof(footerMagic));
+    payload.append(footer, sizeof(footer));
+
+    appendRecord(xToolsCaptureFile::RecordTypeTrailer,
+                 xToolsCaptureFile::DirectionUnknown,
+                 0,
+                 xToolsCaptureFile::currentTimestamp(),
+                 payload);
+}
+
+bool xToolsCaptureWriter::recover()
+{
+    xToolsCaptureReader reader;
+    if (!reader.open(m_file.fileName())) {
+        m_errorString = reader.errorString();
+        return false;
+    }
+
+    m_endpoints = reader.endpoints();
+    m_frameCount = reader.frameCount();
+    m_lastIndexOffset = reader.lastIndexOffset();
+    qint64 validSize = reader.validSize();
+    reader.close();
+
+    // Drop the torn record which is left by a crashed writer.
+    if (m_file.size() > validSize) {
+        qWarning() << "Truncate the torn tail of capture file:" << m_file.fileName();
+        if (!m_file.resize(validSize)) {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**************************************************************************************************/
+xToolsCaptureReader::xToolsCaptureReader() {}
+
+xToolsCaptureReader::~xToolsCaptureReader()
+{
+    close();
+}
+
+bool xToolsCaptureReader::open(const QString &fileName)
+{
+    close();
+
+    // A compressed segment can't be mapped, it is decompressed to a temporary file on the disk.
+    m_file.setFileName(fileName);
+    if (xToolsSegmentCodec::isSegmentFile(fileName)) {
+        m_inflatedFile = new QTemporaryFile();
+        if (!m_inflatedFile->open()) {
+            m_errorString = m_inflatedFile->errorString();
+            close();
+            return false;
+        }
+
+        m_inflatedFile->close();
+        if (!xToolsSegmentCodec::decompressFile(fileName, m_inflatedFile->fileName())) {
+            m_errorString = QStringLiteral("Failed to decompress the capture file.");
+            close();
+            return false;
+        }
+
+        m_file.setFileName(m_inflatedFile->fileName());
+    }
+
+    if (!m_file.open(QFile::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < xToolsCaptureFile::segmentHeaderSize) {
+        m_errorString = QStringLiteral("The file is too small to be a capture file.");
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        m_errorString = m_file.errorString();
+        close();
+        return false;
+    }
+
+    if (memcmp(m_data, segmentMagic, sizeof(segmentMagic)) != 0) {
+        m_errorString = QStringLiteral("The file is not a capture file.");
+        close();
+        return false;
+    }
+
+    if (!readTrailer()) {
+        scan();
+    }
+
+    rewind();
+    return true;
+}
+
+void xToolsCaptureReader::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    if (m_inflatedFile) {
+        delete m_inflatedFile;
+        m_inflatedFile = nullptr;
+    }
+
+    m_size = 0;
+    m_offset = 0;
+    m_validSize = 0;
+    m_frameCount = 0;
+    m_lastIndexOffset = 0;
+    m_endpointNames.clear();
+    m_index.clear();
+}
+
+bool xToolsCaptureReader::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool xToolsCaptureReader::readFrame(xToolsCaptureFrame &frame)
+{
+    const int headerSize = xToolsCaptureFile::recordHeaderSize;
+    while (m_data && m_offset >= 0 && m_offset + headerSize <= m_validSize) {
+        RecordHeader header = recordHeader(m_data + m_offset);
+        const qint64 end = m_offset + headerSize + alignedSize(header.length);
+        if (end > m_validSize) {
+            // A corrupted length(or an offset of a corrupted index) must not read out of the map.
+            m_offset = m_validSize;
+            return false;
+        }
+
+        const uchar *payload = m_data + m_offset + headerSize;
+        m_offset = end;
+
+        if (header.type == xToolsCaptureFile::RecordTypeFrame) {
+            frame.timestamp = header.timestamp;
+            frame.direction = header.direction;
+            frame.endpoint = header.endpoint;
+            frame.payload = QByteArray::fromRawData(reinterpret_cast<const char *>(payload),
+                                                    static_cast<int>(header.length));
+            return true;
+        } else if (header.type == xToolsCaptureFile::RecordTypeEndpoint) {
+            parseEndpoint(header.endpoint, payload, header.length);
+        }
+    }
+
+    return false;
+}
+
+bool xToolsCaptureReader::seek(qint64 timestamp)
+{
+    rewind();
+    auto cmp = [](qint64 value, const QPair<qint64, quint64> &entry) {
+        return value < entry.first;
+    };
+    auto it = std::upper_bound(m_index.constBegin(), m_index.constEnd(), timestamp, cmp);
+    if (it != m_index.constBegin()) {
+        m_offset = static_cast<qint64>((it - 1)->second);
+    }
+
+    xToolsCaptureFrame frame;
+    qint64 offset = m_offset;
+    while (readFrame(frame)) {
+        if (frame.timestamp >= timestamp) {
+            m_offset = offset;
+            return true;
+        }
+        offset = m_offset;
+    }
+
+    return false;
+}
+
+void xToolsCaptureReader::rewind()
+{
+    m_offset = xToolsCaptureFile::segmentHeaderSize;
+}
+
+QString xToolsCaptureReader::endpointName(quint16 endpoint) const
+{
+    return m_endpointNames.value(endpoint);
+}
+
+quint64 xToolsCaptureReader::frameCount() const
+{
+    return m_frameCount;
+}
+
+qint64 xToolsCaptureReader::validSize() const
+{
+    return m_validSize;
+}
+
+quint64 xToolsCaptureReader::lastIndexOffset() const
+{
+    return m_lastIndexOffset;
+}
+
+QHash<QString, quint16> xToolsCaptureReader::endpoints() const
+{
+    QHash<QString, quint16> endpoints;
+    for (auto it = m_endpointNames.constBegin(); it != m_endpointNames.constEnd(); ++it) {
+        endpoints.insert(it.value(), it.key());
+    }
+
+    return endpoints;
+}
+
+bool xToolsCaptureReader::readTrailer()
+{
+    const int headerSize = xToolsCaptureFile::recordHeaderSize;
+    const int footerSize = xToolsCaptureFile::footerSize;
+    if (m_size < xToolsCaptureFile::segmentHeaderSize + headerSize + 24 + footerSize) {
+        return false;
+    }
+
+    const uchar *footer = m_data + m_size - footerSize;
+    if (memcmp(footer + 8, footerMagic, sizeof(footerMagic)) != 0) {
+        return false;
+    }
+
+    qint64 offset = static_cast<qint64>(qFromLittleEndian<quint64>(footer));
+    if (offset < xToolsCaptureFile::segmentHeaderSize || offset + headerSize > m_size) {
+        return false;
+    }
+
+    RecordHeader header = recordHeader(m_data + offset);
+    if (header.type != xToolsCaptureFile::RecordTypeTrailer
+        || offset + headerSize + qint64(header.length) != m_size
+        || header.length < quint32(24 + footerSize)) {
+        return false;
+    }
+
+    const uchar *payload = m_data + offset + headerSize;
+    const uchar *end = payload + header.length - footerSize;
+    m_lastIndexOffset = qFromLittleEndian<quint64>(payload);
+    m_frameCount = qFromLittleEndian<quint64>(payload + 8);
+    quint32 count = qFromLittleEndian<quint32>(payload + 16);
+    const uchar *ptr = payload + 24;
+    for (quint32 i = 0; i < count && ptr + 4 <= end; i++) {
+        quint16 id = qFromLittleEndian<quint16>(ptr);
+        quint16 length = qFromLittleEndian<quint16>(ptr + 2);
+        if (ptr + 4 + length > end) {
+            break;
+        }
+
+        auto name = QString::fromUtf8(reinterpret_cast<const char *>(ptr + 4), length);
+        m_endpointNames.insert(id, name);
+        ptr += 4 + length;
+    }
+
+    m_validSize = m_size;
+    loadIndex();
+    return true;
+}
+
+void xToolsCaptureReader::scan()
+{
+    const int headerSize = xToolsCaptureFile::recordHeaderSize;
+    qint64 offset = xToolsCaptureFile::segmentHeaderSize;
+    while (offset + headerSize <= m_size) {
+        RecordHeader header = recordHeader(m_data + offset);
+        if (header.type < xToolsCaptureFile::RecordTypeFrame
+            || header.type > xToolsCaptureFile::RecordTypeTrailer) {
+            break;
+        }
+
+        qint64 end = offset + headerSize + alignedSize(header.length);
+        if (end > m_size) {
+            break;
+        }
+
+        if (header.type == xToolsCaptureFile::RecordTypeFrame) {
+            if (m_frameCount % xToolsCaptureFile::indexInterval == 0) {
+                m_index.append(qMakePair(header.timestamp, static_cast<quint64>(offset)));
+            }
+            m_frameCount++;
+        } else if (header.type == xToolsCaptureFile::RecordTypeEndpoint) {
+            parseEndpoint(header.endpoint, m_data + offset + headerSize, header.length);
+        } else if (header.type == xToolsCaptureFile::RecordTypeIndex) {
+            m_lastIndexOffset = static_cast<quint64>(offset);
+        }
+
+        offset = end;
+    }
+
+    m_validSize = offset;
+}
+
+void xToolsCaptureReader::loadIndex()
+{
+    const int headerSize = xToolsCaptureFile::recordHeaderSize;
+    QVector<QVector<QPair<qint64, quint64>>> chain;
+    quint64 offset = m_lastIndexOffset;
+    while (offset >= quint64(xToolsCaptureFile::segmentHeaderSize)
+           && offset + headerSize + 16 <= quint64(m_validSize)) {
+        RecordHeader header = recordHeader(m_data + offset);
+        if (header.type != xToolsCaptureFile::RecordTypeIndex || header.length < 16
+            || offset + headerSize + header.length > quint64(m_validSize)) {
+            break;
+        }
+
+        const uchar *payload = m_data + offset + headerSize;
+        quint64 previous = qFromLittleEndian<quint64>(payload);
+        quint32 count = qFromLittleEndian<quint32>(payload + 8);
+        count = qMin(count, (header.length - 16) / 16);
+
+        QVector<QPair<qint64, quint64>> entries;
+        entries.reserve(static_cast<int>(count));
+        for (quint32 i = 0; i < count; i++) {
+            const uchar *entry = payload + 16 + i * 16;
+            entries.append(qMakePair(qFromLittleEndian<qint64>(entry),
+                                     qFromLittleEndian<quint64>(entry + 8)));
+        }
+        chain.prepend(entries);
+
+        // The chain is always going backward, stop at a corrupted link.
+        if (previous >= offset) {
+            break;
+        }
+        offset = previous;
+    }
+
+    for (auto &entries : chain) {
+        m_index += entries;
+    }
+}
+
+void xToolsCaptureReader::parseEndpoint(quint16 endpoint, const uchar *payload, quint32 length)
+{
+    const char *data = reinterpret_cast<const char *>(payload);
+    m_endpointNames.insert(endpoint, QString::fromUtf8(data, static_cast<int>(length)));
+}
@@ -0,0 +1,186 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QTemporaryFile;
+class xToolsAbstractCaptureReader;
+class xToolsAbstractCaptureWriter;
+
+/// A capture file is an append-only binary segment, all fields are little endian. The segment
+/// starts with a 32 bytes header, followed by 8 bytes aligned records:
+///
+/// | type(1) | direction(1) | endpoint(2) | length(4) | timestamp(8) | payload(length) | padding |
+///
+/// Frame records hold the data, endpoint records map an endpoint id to its name and index records
+/// hold the offset of every N-th frame. A trailer record is appended when the segment is closed,
+/// so a reader can find the index without scanning the segment.
+class xToolsCaptureFile
+{
+public:
+    enum Direction { DirectionUnknown, DirectionRx, DirectionTx };
+    enum RecordType { RecordTypeFrame = 1, RecordTypeEndpoint, RecordTypeIndex, RecordTypeTrailer };
+
+    static const int segmentHeaderSize = 32;
+    static const int recordHeaderSize = 16;
+    static const int footerSize = 16;
+    static const int indexInterval = 64;
+
+    /// Nanoseconds since epoch.
+    static qint64 currentTimestamp();
+    static QString directionName(int direction);
+
+    /// Create a writer according to the suffix of the file, "pcapng" files are written as pcapng.
+    static xToolsAbstractCaptureWriter *createWriter(const QString &fileName);
+    /// Create a reader according to the magic of the file, the caller takes the ownership.
+    static xToolsAbstractCaptureReader *createReader(const QString &fileName);
+};
+
+struct xToolsCaptureFrame
+{
+    qint64 timestamp{0};
+    int direction{xToolsCaptureFile::DirectionUnknown};
+    quint16 endpoint{0};
+    QByteArray payload;
+};
+
+class xToolsAbstractCaptureWriter
+{
+public:
+    virtual ~xToolsAbstractCaptureWriter() {}
+
+    virtual bool open(const QString &fileName) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    virtual QString fileName() const = 0;
+    virtual qint64 size() const = 0;
+
+    /// Encode a frame into the pending batch, nothing is written until flush() is called.
+    virtual void append(qint64 timestamp,
+                        int direction,
+                        const QString &endpoint,
+                        const QByteArray &payload)
+        = 0;
+    /// Write the pending batch to the file with a single write.
+    virtual bool flush() = 0;
+
+    QString errorString() const;
+
+protected:
+    QString m_errorString;
+};
+
+class xToolsAbstractCaptureReader
+{
+public:
+    virtual ~xToolsAbstractCaptureReader() {}
+
+    virtual bool open(const QString &fileName) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    virtual bool readFrame(xToolsCaptureFrame &frame) = 0;
+    /// Move to the first frame whose timestamp is not less than the timestamp.
+    virtual bool seek(qint64 timestamp) = 0;
+    virtual void rewind() = 0;
+    virtual QString endpointName(quint16 endpoint) const = 0;
+
+    QString errorString() const;
+    /// Export all frames to a text file, the reader is rewound after exporting.
+    bool exportText(const QString &fileName, int textFormat);
+
+protected:
+    QString m_errorString;
+};
+
+class xToolsCaptureWriter : public xToolsAbstractCaptureWriter
+{
+public:
+    xToolsCaptureWriter();
+    ~xToolsCaptureWriter();
+
+    bool open(const QString &fileName) override;
+    bool open(const QString &fileName, quint32 segmentIndex);
+    void close() override;
+    bool isOpen() const override;
+    QString fileName() const override;
+    qint64 size() const override;
+
+    void append(qint64 timestamp,
+                int direction,
+                const QString &endpoint,
+                const QByteArray &payload) override;
+    bool flush() override;
+
+private:
+    QFile m_file;
+    QByteArray m_batch;
+    qint64 m_fileSize{0};
+    quint64 m_frameCount{0};
+    quint64 m_lastIndexOffset{0};
+    QHash<QString, quint16> m_endpoints;
+    QVector<QPair<qint64, quint64>> m_pendingIndex;
+
+private:
+    void appendRecord(int type,
+                      int direction,
+                      quint16 endpoint,
+                      qint64 timestamp,
+                      const QByteArray &payload);
+    void appendIndexRecord();
+    void appendTrailerRecord();
+    bool recover();
+};
+
+class xToolsCaptureReader : public xToolsAbstractCaptureReader
+{
+public:
+    xToolsCaptureReader();
+    ~xToolsCaptureReader();
+
+    bool open(const QString &fileName) override;
+    void close() override;
+    bool isOpen() const override;
+
+    /// The payload of the frame refers to the mapped file, it is valid until the reader is closed.
+    bool readFrame(xToolsCaptureFrame &frame) override;
+    bool seek(qint64 timestamp) override;
+    void rewind() override;
+    QString endpointName(quint16 endpoint) const override;
+
+    quint64 frameCount() const;
+    /// Offset behind the last complete record, a crashed writer may leave a torn record behind it.
+    qint64 validSize() const;
+    quint64 lastIndexOffset() const;
+    QHash<QString, quint16> endpoints() const;
+
+private:
+    QFile m_file;
+    QTemporaryFile *m_inflatedFile{nullptr};
+    const uchar *m_data{nullptr};
+    qint64 m_size{0};
+    qint64 m_offset{0};
+    qint64 m_validSize{0};
+    quint64 m_frameCount{0};
+    quint64 m_lastIndexOffset{0};
+    QHash<quint16, QString> m_endpointNames;
+    QVector<QPair<qint64, quint64>> m_index;
+
+private:
+    bool readTrailer();
+    void scan();
+    void loadIndex();
+    void parseEndpoint(quint16 endpoint, const uchar *payload, quint32 length);
+};
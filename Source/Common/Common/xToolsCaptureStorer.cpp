@@ -0,0 +1,117 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsCaptureStorer.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+xToolsCaptureStorer::xToolsCaptureStorer() {}
+
+xToolsCaptureStorer::~xToolsCaptureStorer()
+{
+    closeWriter();
+}
+
+bool xToolsCaptureStorer::append(const QByteArray &bytes, int *pendingFrames)
+{
+    xToolsCaptureFrame frame;
+    frame.timestamp = xToolsCaptureFile::currentTimestamp();
+    frame.payload = bytes;
+
+    bool isAppended = false;
+    m_framesMutex.lock();
+    if (m_bytes + bytes.size() > maxPendingBytes) {
+        m_droppedFrames++;
+    } else {
+        m_frames.append(frame);
+        m_bytes += bytes.size();
+        isAppended = true;
+    }
+
+    if (pendingFrames) {
+        *pendingFrames = m_frames.size();
+    }
+    m_framesMutex.unlock();
+    return isAppended;
+}
+
+void xToolsCaptureStorer::flush(const QString &fileName)
+{
+    // Take the frames and write them out of the lock.
+    QList<xToolsCaptureFrame> frames;
+    m_framesMutex.lock();
+    frames.swap(m_frames);
+    m_bytes = 0;
+    qint64 droppedFrames = m_droppedFrames;
+    m_droppedFrames = 0;
+    m_framesMutex.unlock();
+
+    if (droppedFrames > 0) {
+        QString msg = QString("%1 frames are dropped, the disk is too slow.");
+        qWarning() << msg.arg(droppedFrames);
+    }
+
+    write2file(fileName, frames);
+}
+
+void xToolsCaptureStorer::write2file(const QString &fileName,
+                                     const QList<xToolsCaptureFrame> &frames)
+{
+    if (m_writer && m_writer->fileName() != fileName) {
+        closeWriter();
+    }
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    // The format of the file is decided by the suffix, "*.pcapng" files are written as pcapng.
+    if (!m_writer) {
+        m_writer = xToolsCaptureFile::createWriter(fileName);
+        if (!m_writer->open(fileName)) {
+            qWarning() << m_writer->errorString();
+            delete m_writer;
+            m_writer = nullptr;
+            return;
+        }
+    }
+
+    for (const xToolsCaptureFrame &frame : frames) {
+        m_writer->append(frame.timestamp, frame.direction, QString(), frame.payload);
+    }
+
+    if (!m_writer->flush()) {
+        qWarning() << m_writer->errorString();
+        return;
+    }
+
+    // Rotate the file, the closed segment is renamed with a time prefix and kept as it is.
+    if (m_writer->size() > maxFileSize) {
+        closeWriter();
+
+        const QString format = QString("yyyy-MM-dd-hh-mm-ss_");
+        auto dt = QDateTime::currentDateTime().toString(format);
+        QFileInfo info(fileName);
+        QString newFileName = info.absolutePath() + "/" + dt + info.fileName();
+        if (!QFile::rename(fileName, newFileName)) {
+            qWarning() << QString("Failed to rename the file(%1) to %2").arg(fileName, newFileName);
+        }
+    }
+}
+
+void xToolsCaptureStorer::closeWriter()
+{
+    if (m_writer) {
+        m_writer->close();
+        delete m_writer;
+        m_writer = nullptr;
+    }
+}
@@ -0,0 +1,48 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include "xToolsCaptureFile.h"
+
+/// The pending frames and the capture file of a storer. The frames are appended by the input
+/// thread and written out by the thread of the storer, the input thread is never blocked by the
+/// file system. The pending frames are bounded when the disk stalls, the frames out of the bound
+/// are dropped. The file is rotated when it grows larger than maxFileSize.
+class xToolsCaptureStorer
+{
+public:
+    static const qint64 maxPendingBytes = 64 * 1024 * 1024;
+    static const qint64 maxFileSize = 1024 * 1024;
+
+public:
+    xToolsCaptureStorer();
+    ~xToolsCaptureStorer();
+
+    /// Returns false if the frame is dropped, the number of the pending frames is returned by
+    /// pendingFrames if it is not nullptr. It can be called in any thread.
+    bool append(const QByteArray &bytes, int *pendingFrames = nullptr);
+    /// Write the pending frames to the file, the file is closed if the name is changed, an empty
+    /// name closes the file.
+    void flush(const QString &fileName);
+
+private:
+    QList<xToolsCaptureFrame> m_frames;
+    qint64 m_bytes{0};
+    qint64 m_droppedFrames{0};
+    QMutex m_framesMutex;
+    xToolsAbstractCaptureWriter *m_writer{nullptr};
+
+private:
+    void write2file(const QString &fileName, const QList<xToolsCaptureFrame> &frames);
+    void closeWriter();
+};
@@ -338,6 +338,7 @@ QString xToolsDataStructure::responseOptionName(int option)
         optionMap.insert(ResponseOptionInputEqualReference, tr("Rx Data Equal Reference Data"));
         optionMap.insert(ResponseOptionInputContainReference, tr("Rx Data Contain Reference Data"));
         optionMap.insert(ResponseOptionInputDiscontainReference, tr("Rx Data Discontain Reference Data"));
+        optionMap.insert(ResponseOptionInputMatchRule, tr("Rx Data Match Reference Rule"));
         // clang-format on
     }
 
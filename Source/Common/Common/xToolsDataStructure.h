@@ -93,7 +93,8 @@ public:
         ResponseOptionAlways, // Response the data that set by user when data received.
         ResponseOptionInputEqualReference,
         ResponseOptionInputContainReference,
-        ResponseOptionInputDiscontainReference
+        ResponseOptionInputDiscontainReference,
+        ResponseOptionInputMatchRule // The reference is a rule, see xToolsRuleProgram.
     };
     Q_ENUM(ResponseOption)
     Q_INVOKABLE static QVariantList supportedResponseOptions();
@@ -0,0 +1,188 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsDeadlineScheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <QTimer>
+
+#include "xToolsProfiler.h"
+
+xToolsDeadlineScheduler::xToolsDeadlineScheduler(QObject *parent)
+    : QObject{parent}
+    , m_timer{new QTimer(this)}
+    , m_lateness{1, 10ll * 1000 * 1000 * 1000, 3}
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &xToolsDeadlineScheduler::onTimeout);
+}
+
+xToolsDeadlineScheduler::~xToolsDeadlineScheduler() {}
+
+void xToolsDeadlineScheduler::schedule(int id, qint64 interval)
+{
+    interval = qMax<qint64>(interval, 1);
+    auto it = m_tasks.find(id);
+    if (it != m_tasks.end() && it->interval == interval) {
+        return;
+    }
+
+    // The entry of the old interval stays in the heap until it is popped, the generation tells it
+    // is stale.
+    Task task{interval, ++m_generation};
+    m_tasks.insert(id, task);
+    m_heap.push_back(Entry{xToolsProfiler::now() + interval, id, task.generation});
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+    rearm();
+}
+
+void xToolsDeadlineScheduler::cancel(int id)
+{
+    if (m_tasks.remove(id) > 0) {
+        rearm();
+    }
+}
+
+void xToolsDeadlineScheduler::clear()
+{
+    m_tasks.clear();
+    m_heap.clear();
+    m_timer->stop();
+}
+
+bool xToolsDeadlineScheduler::isScheduled(int id) const
+{
+    return m_tasks.contains(id);
+}
+
+QList<int> xToolsDeadlineScheduler::ids() const
+{
+    return m_tasks.keys();
+}
+
+void xToolsDeadlineScheduler::setSpinThreshold(qint64 threshold)
+{
+    if (m_spinThreshold != threshold) {
+        m_spinThreshold = qMax<qint64>(threshold, 0);
+        rearm();
+    }
+}
+
+qint64 xToolsDeadlineScheduler::spinThreshold() const
+{
+    return m_spinThreshold;
+}
+
+xToolsDeadlineScheduler::Jitter xToolsDeadlineScheduler::jitter()
+{
+    Jitter jitter;
+    m_jitterMutex.lock();
+    jitter.count = m_lateness.count();
+    jitter.missed = m_missed;
+    jitter.min = m_lateness.min();
+    jitter.max = m_lateness.max();
+    jitter.mean = m_lateness.mean();
+    jitter.p50 = m_lateness.valueAtPercentile(50);
+    jitter.p99 = m_lateness.valueAtPercentile(99);
+    jitter.p999 = m_lateness.valueAtPercentile(99.9);
+    m_jitterMutex.unlock();
+    return jitter;
+}
+
+void xToolsDeadlineScheduler::resetJitter()
+{
+    m_jitterMutex.lock();
+    m_lateness.reset();
+    m_missed = 0;
+    m_jitterMutex.unlock();
+}
+
+void xToolsDeadlineScheduler::onTimeout()
+{
+    dropStaleEntries();
+    if (m_heap.empty()) {
+        return;
+    }
+
+    qint64 now = xToolsProfiler::now();
+    if (m_spinThreshold > 0) {
+        const qint64 deadline = m_heap.front().deadline;
+        while (now < deadline && deadline - now <= m_spinThreshold) {
+            now = xToolsProfiler::now();
+        }
+    }
+
+    bool isTimeout = false;
+    while (!m_heap.empty() && m_heap.front().deadline <= now) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+        Entry entry = m_heap.back();
+        m_heap.pop_back();
+
+        auto it = m_tasks.constFind(entry.id);
+        if (it == m_tasks.constEnd() || it->generation != entry.generation) {
+            continue;
+        }
+
+        // A deadline that has passed completely is skipped instead of being fired in a burst, the
+        // following deadlines stay on the grid of the interval.
+        const qint64 lateness = now - entry.deadline;
+        const qint64 missed = lateness / it->interval;
+        m_jitterMutex.lock();
+        m_lateness.record(lateness);
+        m_missed += missed;
+        m_jitterMutex.unlock();
+
+        entry.deadline += (missed + 1) * it->interval;
+        m_heap.push_back(entry);
+        std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+
+        // The task may be cancelled or rescheduled by the receiver.
+        isTimeout = true;
+        emit timeout(entry.id);
+    }
+
+    rearm();
+    if (isTimeout) {
+        emit timeoutsFinished();
+    }
+}
+
+void xToolsDeadlineScheduler::rearm()
+{
+    dropStaleEntries();
+    if (m_heap.empty()) {
+        m_timer->stop();
+        return;
+    }
+
+    // Sleep until the spinning begins, or until the deadline has passed if there is no spinning.
+    const qint64 remaining = m_heap.front().deadline - xToolsProfiler::now() - m_spinThreshold;
+    if (remaining <= 0) {
+        m_timer->start(0);
+    } else if (m_spinThreshold > 0) {
+        m_timer->start(static_cast<int>(remaining / 1000000));
+    } else {
+        m_timer->start(static_cast<int>((remaining + 999999) / 1000000));
+    }
+}
+
+void xToolsDeadlineScheduler::dropStaleEntries()
+{
+    while (!m_heap.empty()) {
+        const Entry &entry = m_heap.front();
+        auto it = m_tasks.constFind(entry.id);
+        if (it != m_tasks.constEnd() && it->generation == entry.generation) {
+            break;
+        }
+
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+        m_heap.pop_back();
+    }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <vector>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+
+#include "xToolsHdrHistogram.h"
+
+class QTimer;
+
+/// Fires periodic tasks at absolute deadlines of the monotonic clock. The deadline of a task is
+/// advanced by its interval, not by the time the task is handled, so the processing time and the
+/// latency of the timer never accumulate into drift. The deadlines of all tasks are kept in a heap
+/// and a single timer sleeps until the earliest one. With a spin threshold, the last part of the
+/// wait is spent spinning, it trades a cpu core for sub-millisecond precision.
+///
+/// The scheduler must be used in the thread it lives in, except jitter() and resetJitter().
+class xToolsDeadlineScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    struct Jitter
+    {
+        qint64 count{0};  // Deadlines handled.
+        qint64 missed{0}; // Deadlines skipped because the previous one was handled too late.
+        qint64 min{0};    // ns, the lateness of the deadlines.
+        qint64 max{0};
+        double mean{0};
+        qint64 p50{0};
+        qint64 p99{0};
+        qint64 p999{0};
+    };
+
+public:
+    explicit xToolsDeadlineScheduler(QObject *parent = nullptr);
+    ~xToolsDeadlineScheduler() override;
+
+    /// Fire the task every interval(ns), the first deadline is an interval after now. Nothing is
+    /// changed if the task is scheduled with the same interval already, so the phase is kept.
+    void schedule(int id, qint64 interval);
+    void cancel(int id);
+    void clear();
+    bool isScheduled(int id) const;
+    QList<int> ids() const;
+
+    /// The remaining wait(ns) shorter than the threshold is spun instead of slept, 0 = never spin.
+    void setSpinThreshold(qint64 threshold);
+    qint64 spinThreshold() const;
+
+    Jitter jitter();
+    void resetJitter();
+
+signals:
+    void timeout(int id);
+    /// Emitted after the timeouts of the deadlines handled in one wake-up, the receivers can batch
+    /// the work of the tasks that are due together.
+    void timeoutsFinished();
+
+private:
+    struct Entry
+    {
+        qint64 deadline;
+        int id;
+        quint32 generation;
+
+        bool operator>(const Entry &other) const { return deadline > other.deadline; }
+    };
+
+    struct Task
+    {
+        qint64 interval;
+        quint32 generation;
+    };
+
+    std::vector<Entry> m_heap;
+    QHash<int, Task> m_tasks;
+    quint32 m_generation{0};
+    QTimer *m_timer;
+    qint64 m_spinThreshold{0};
+
+    xToolsHdrHistogram m_lateness;
+    qint64 m_missed{0};
+    QMutex m_jitterMutex;
+
+private:
+    void onTimeout();
+    void rearm();
+    void dropStaleEntries();
+};
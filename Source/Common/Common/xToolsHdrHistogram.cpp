@@ -0,0 +1,196 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsHdrHistogram.h"
+
+#include <cmath>
+#include <limits>
+
+#include <QJsonArray>
+#include <QtAlgorithms>
+
+xToolsHdrHistogram::xToolsHdrHistogram(qint64 lowestValue,
+                                       qint64 highestValue,
+                                       int significantDigits)
+{
+    m_lowestValue = qMax<qint64>(1, lowestValue);
+    m_highestValue = qMax<qint64>(2 * m_lowestValue, highestValue);
+    significantDigits = qBound(1, significantDigits, 5);
+
+    // Values below it are counted with a resolution of 1 unit.
+    qint64 largestValueWithSingleUnitResolution = 2 * qint64(std::pow(10, significantDigits));
+    int subBucketCountMagnitude = int(std::ceil(std::log2(largestValueWithSingleUnitResolution)));
+    m_subBucketHalfCountMagnitude = qMax(subBucketCountMagnitude, 1) - 1;
+    m_unitMagnitude = int(std::floor(std::log2(m_lowestValue)));
+
+    qint64 subBucketCount = qint64(1) << (m_subBucketHalfCountMagnitude + 1);
+    m_subBucketHalfCount = subBucketCount / 2;
+    m_subBucketMask = (subBucketCount - 1) << m_unitMagnitude;
+
+    qint64 smallestUntrackableValue = subBucketCount << m_unitMagnitude;
+    m_bucketCount = 1;
+    while (smallestUntrackableValue <= m_highestValue) {
+        if (smallestUntrackableValue > std::numeric_limits<qint64>::max() / 2) {
+            m_bucketCount++;
+            break;
+        }
+
+        smallestUntrackableValue <<= 1;
+        m_bucketCount++;
+    }
+
+    m_counts.fill(0, int((m_bucketCount + 1) * m_subBucketHalfCount));
+}
+
+void xToolsHdrHistogram::record(qint64 value, qint64 count)
+{
+    value = qBound(m_lowestValue, value, m_highestValue);
+    int index = countsIndex(value);
+    if (index < 0 || index >= m_counts.size()) {
+        return;
+    }
+
+    m_counts[index] += count;
+    if (m_count == 0) {
+        m_min = value;
+        m_max = value;
+    } else {
+        m_min = qMin(m_min, value);
+        m_max = qMax(m_max, value);
+    }
+
+    m_count += count;
+    m_sum += double(value) * count;
+}
+
+void xToolsHdrHistogram::reset()
+{
+    m_counts.fill(0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0;
+}
+
+qint64 xToolsHdrHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 xToolsHdrHistogram::min() const
+{
+    return m_min;
+}
+
+qint64 xToolsHdrHistogram::max() const
+{
+    return m_max;
+}
+
+double xToolsHdrHistogram::mean() const
+{
+    return m_count > 0 ? m_sum / m_count : 0;
+}
+
+qint64 xToolsHdrHistogram::valueAtPercentile(double percentile) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    percentile = qBound(0.0, percentile, 100.0);
+    qint64 countAtPercentile = qint64(percentile / 100 * m_count + 0.5);
+    countAtPercentile = qMax<qint64>(1, countAtPercentile);
+
+    qint64 total = 0;
+    for (int i = 0; i < m_counts.size(); i++) {
+        total += m_counts.at(i);
+        if (total >= countAtPercentile) {
+            return qMin(highestEquivalentValue(valueFromIndex(i)), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+QString xToolsHdrHistogram::toCsv(const QString &valueName) const
+{
+    QString csv = QString("%1,count,percentile\n").arg(valueName);
+    qint64 total = 0;
+    for (int i = 0; i < m_counts.size(); i++) {
+        qint64 count = m_counts.at(i);
+        if (count == 0) {
+            continue;
+        }
+
+        total += count;
+        qint64 value = qMin(highestEquivalentValue(valueFromIndex(i)), m_max);
+        double percentile = 100.0 * total / m_count;
+        csv += QString("%1,%2,%3\n").arg(value).arg(count).arg(percentile, 0, 'f', 3);
+    }
+
+    return csv;
+}
+
+QJsonObject xToolsHdrHistogram::toJson() const
+{
+    QJsonObject obj;
+    obj.insert("count", m_count);
+    obj.insert("min", m_min);
+    obj.insert("max", m_max);
+    obj.insert("mean", mean());
+    obj.insert("p50", valueAtPercentile(50));
+    obj.insert("p90", valueAtPercentile(90));
+    obj.insert("p99", valueAtPercentile(99));
+    obj.insert("p99.9", valueAtPercentile(99.9));
+
+    QJsonArray buckets;
+    for (int i = 0; i < m_counts.size(); i++) {
+        if (m_counts.at(i) == 0) {
+            continue;
+        }
+
+        QJsonObject bucket;
+        bucket.insert("value", qMin(highestEquivalentValue(valueFromIndex(i)), m_max));
+        bucket.insert("count", m_counts.at(i));
+        buckets.append(bucket);
+    }
+
+    obj.insert("buckets", buckets);
+    return obj;
+}
+
+int xToolsHdrHistogram::countsIndex(qint64 value) const
+{
+    int pow2Ceiling = 64 - qCountLeadingZeroBits(quint64(value | m_subBucketMask));
+    int bucketIndex = pow2Ceiling - m_unitMagnitude - (m_subBucketHalfCountMagnitude + 1);
+    qint64 subBucketIndex = value >> (bucketIndex + m_unitMagnitude);
+    qint64 base = qint64(bucketIndex + 1) << m_subBucketHalfCountMagnitude;
+    return int(base + (subBucketIndex - m_subBucketHalfCount));
+}
+
+qint64 xToolsHdrHistogram::valueFromIndex(int index) const
+{
+    int bucketIndex = (index >> m_subBucketHalfCountMagnitude) - 1;
+    qint64 subBucketIndex = (index & (m_subBucketHalfCount - 1)) + m_subBucketHalfCount;
+    if (bucketIndex < 0) {
+        subBucketIndex -= m_subBucketHalfCount;
+        bucketIndex = 0;
+    }
+
+    return subBucketIndex << (bucketIndex + m_unitMagnitude);
+}
+
+qint64 xToolsHdrHistogram::highestEquivalentValue(qint64 value) const
+{
+    int pow2Ceiling = 64 - qCountLeadingZeroBits(quint64(value | m_subBucketMask));
+    int bucketIndex = pow2Ceiling - m_unitMagnitude - (m_subBucketHalfCountMagnitude + 1);
+    qint64 lowestEquivalentValue = (value >> (bucketIndex + m_unitMagnitude))
+                                   << (bucketIndex + m_unitMagnitude);
+    return lowestEquivalentValue + (qint64(1) << (bucketIndex + m_unitMagnitude)) - 1;
+}
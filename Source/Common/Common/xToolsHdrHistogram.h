@@ -0,0 +1,59 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+/// A high dynamic range histogram. Values are counted in buckets whose width grows with the
+/// value, so every recorded value is kept with the given number of significant decimal digits,
+/// and the memory does not depend on the number of values. Values out of the range are clamped.
+class xToolsHdrHistogram
+{
+public:
+    xToolsHdrHistogram(qint64 lowestValue = 1,
+                       qint64 highestValue = 3600ll * 1000 * 1000,
+                       int significantDigits = 3);
+
+    void record(qint64 value, qint64 count = 1);
+    void reset();
+
+    qint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    /// The highest value that is equivalent to the value at the percentile(0-100).
+    qint64 valueAtPercentile(double percentile) const;
+
+    /// One line per non-empty bucket: "value,count,percentile", the first line is the header.
+    QString toCsv(const QString &valueName = QString("value")) const;
+    /// The summary(count, min, max, mean, p50, p90, p99, p99.9) and the non-empty buckets.
+    QJsonObject toJson() const;
+
+private:
+    qint64 m_lowestValue;
+    qint64 m_highestValue;
+    int m_unitMagnitude;
+    int m_subBucketHalfCountMagnitude;
+    qint64 m_subBucketHalfCount;
+    qint64 m_subBucketMask;
+    int m_bucketCount;
+    QVector<qint64> m_counts;
+
+    qint64 m_count{0};
+    qint64 m_min{0};
+    qint64 m_max{0};
+    double m_sum{0};
+
+private:
+    int countsIndex(qint64 value) const;
+    qint64 valueFromIndex(int index) const;
+    qint64 highestEquivalentValue(qint64 value) const;
+};
@@ -0,0 +1,385 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsLogWriter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include "xToolsSegmentCodec.h"
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static const int maxBatchSize = 1024 * 1024;
+
+xToolsLogWriter::xToolsLogWriter(QObject *parent)
+    : QThread(parent)
+{}
+
+xToolsLogWriter::~xToolsLogWriter()
+{
+    stop();
+}
+
+xToolsLogWriter::Parameters xToolsLogWriter::parameters()
+{
+    m_mutex.lock();
+    Parameters parameters = m_parameters;
+    m_mutex.unlock();
+    return parameters;
+}
+
+void xToolsLogWriter::setParameters(const Parameters &parameters)
+{
+    m_mutex.lock();
+    m_parameters = parameters;
+    m_parametersChanged = true;
+    m_mutex.unlock();
+    m_condition.wakeOne();
+}
+
+bool xToolsLogWriter::append(const QByteArray &bytes)
+{
+    m_mutex.lock();
+    if (m_pendingBytes.load() + bytes.size() > m_parameters.maxPendingBytes) {
+        m_mutex.unlock();
+        m_droppedBytes += bytes.size();
+        m_droppedAppends++;
+        profilerStage()->addDropped();
+        return false;
+    }
+
+    m_queue.append(bytes);
+    qint64 pendingBytes = (m_pendingBytes += bytes.size());
+    profilerStage()->setQueueDepth(m_queue.size());
+    m_mutex.unlock();
+
+    // Wake the writer early only if a full batch is queued, small appends are collected until the
+    // flush interval is reached.
+    if (pendingBytes >= maxBatchSize) {
+        m_condition.wakeOne();
+    }
+
+    return true;
+}
+
+void xToolsLogWriter::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    m_mutex.lock();
+    m_stopRequested = true;
+    m_mutex.unlock();
+    m_condition.wakeOne();
+    wait();
+
+    m_stopRequested = false;
+}
+
+qint64 xToolsLogWriter::pendingBytes() const
+{
+    return m_pendingBytes.load();
+}
+
+qint64 xToolsLogWriter::writtenBytes() const
+{
+    return m_writtenBytes.load();
+}
+
+qint64 xToolsLogWriter::rawBytes() const
+{
+    return m_rawBytes.load();
+}
+
+qint64 xToolsLogWriter::compressionTime() const
+{
+    return m_compressionTime.load();
+}
+
+qint64 xToolsLogWriter::droppedBytes() const
+{
+    return m_droppedBytes.load();
+}
+
+qint64 xToolsLogWriter::droppedAppends() const
+{
+    return m_droppedAppends.load();
+}
+
+QString xToolsLogWriter::rotatedFileName(const QString &fileName, qint64 msecsSinceEpoch)
+{
+    QFileInfo info(fileName);
+    QString name = info.absolutePath() + "/" + info.baseName() + "_"
+                   + QString::number(msecsSinceEpoch);
+    if (!info.completeSuffix().isEmpty()) {
+        name += "." + info.completeSuffix();
+    }
+
+    return name;
+}
+
+void xToolsLogWriter::run()
+{
+    Parameters parameters = this->parameters();
+    m_batch.reserve(maxBatchSize);
+
+    while (true) {
+        m_mutex.lock();
+        if (m_queue.isEmpty() && !m_stopRequested && !m_parametersChanged) {
+            m_condition.wait(&m_mutex, qMax(parameters.flushInterval, 1));
+        }
+
+        QList<QByteArray> queue;
+        queue.swap(m_queue);
+        bool parametersChanged = m_parametersChanged;
+        m_parametersChanged = false;
+        Parameters newParameters = m_parameters;
+        bool stopRequested = m_stopRequested;
+        profilerStage()->setQueueDepth(0);
+        m_mutex.unlock();
+
+        // The queued bytes were appended before the parameters were changed.
+        profilerStage()->addWakeup();
+        {
+            xToolsProfilerScope scope(queue.isEmpty() ? nullptr : profilerStage());
+            writeQueue(parameters, queue);
+        }
+
+        if (parametersChanged) {
+            if (newParameters.fileName != parameters.fileName) {
+                closeFile();
+            }
+            parameters = newParameters;
+        }
+
+        if (stopRequested) {
+            break;
+        }
+    }
+
+    closeFile();
+}
+
+xToolsProfiler::Stage *xToolsLogWriter::profilerStage()
+{
+    return xToolsProfiler::instance()->objectStage(this, m_profilerStage);
+}
+
+bool xToolsLogWriter::openFile(const Parameters &parameters)
+{
+    m_codec = parameters.codec;
+    if (!xToolsSegmentCodec::isCodecAvailable(m_codec)) {
+        m_codec = xToolsSegmentCodec::CodecZlib;
+    }
+
+    // Every block of a compressed segment is independent, so an existing segment is appended. An
+    // existing file of the other kind is rotated, compressed blocks and plain text are never mixed.
+    QFileInfo info(parameters.fileName);
+    if (info.exists() && info.size() > 0) {
+        bool isSegment = xToolsSegmentCodec::isSegmentFile(parameters.fileName);
+        bool isCompressed = m_codec != xToolsSegmentCodec::CodecNone;
+        if (isSegment != isCompressed && !renameFile(parameters)) {
+            emit errorOccurred(tr("The file(%1) can not be appended").arg(parameters.fileName));
+            return false;
+        }
+    }
+
+    m_file.setFileName(parameters.fileName);
+    if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+        emit errorOccurred(m_file.errorString());
+        return false;
+    }
+
+    m_segmentOpenedTime = QDateTime::currentMSecsSinceEpoch();
+    m_lastSyncTime = m_segmentOpenedTime;
+
+    if (m_codec != xToolsSegmentCodec::CodecNone && m_file.size() == 0) {
+        m_file.write(xToolsSegmentCodec::fileHeader());
+    }
+
+    return true;
+}
+
+void xToolsLogWriter::closeFile()
+{
+    if (!m_file.isOpen()) {
+        m_batch.resize(0);
+        return;
+    }
+
+    writeBatch();
+    if (this->parameters().syncPolicy != SyncPolicyNone) {
+        sync();
+    }
+
+    m_file.close();
+}
+
+void xToolsLogWriter::writeQueue(const Parameters &parameters, QList<QByteArray> &queue)
+{
+    qint64 bytes = 0;
+    for (const QByteArray &item : queue) {
+        bytes += item.size();
+    }
+
+    if (parameters.fileName.isEmpty()) {
+        m_pendingBytes -= bytes;
+        return;
+    }
+
+    if (!m_file.isOpen() && !openFile(parameters)) {
+        m_droppedBytes += bytes;
+        m_droppedAppends += queue.count();
+        m_pendingBytes -= bytes;
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (parameters.rotationInterval > 0 && m_file.size() > 0
+        && now - m_segmentOpenedTime >= qint64(parameters.rotationInterval) * 1000) {
+        rotate(parameters);
+    }
+
+    for (const QByteArray &item : queue) {
+        qint64 segmentSize = m_file.size() + m_batch.size();
+        if (parameters.maxSegmentSize > 0 && segmentSize > 0
+            && segmentSize + item.size() > parameters.maxSegmentSize) {
+            writeBatch();
+            rotate(parameters);
+        }
+
+        m_batch.append(item);
+        m_pendingBytes -= item.size();
+        if (m_batch.size() >= maxBatchSize) {
+            writeBatch();
+        }
+    }
+    queue.clear();
+
+    writeBatch();
+    if (parameters.syncPolicy == SyncPolicyEveryBatch) {
+        sync();
+    } else if (parameters.syncPolicy == SyncPolicyInterval) {
+        if (now - m_lastSyncTime >= parameters.syncInterval) {
+            sync();
+        }
+    }
+}
+
+bool xToolsLogWriter::writeBatch()
+{
+    if (m_batch.isEmpty() || !m_file.isOpen()) {
+        m_batch.resize(0);
+        return true;
+    }
+
+    m_rawBytes += m_batch.size();
+    if (m_codec != xToolsSegmentCodec::CodecNone) {
+        QElapsedTimer timer;
+        timer.start();
+        m_batch = xToolsSegmentCodec::encodeBlock(m_batch, m_codec);
+        m_compressionTime += timer.nsecsElapsed();
+    }
+
+    qint64 ret = m_file.write(m_batch);
+    if (ret > 0) {
+        m_writtenBytes += ret;
+    }
+
+    bool ok = ret == m_batch.size();
+    if (!ok) {
+        m_droppedBytes += m_batch.size() - qMax<qint64>(ret, 0);
+        emit errorOccurred(m_file.errorString());
+    }
+
+    m_batch.resize(0);
+    return ok;
+}
+
+void xToolsLogWriter::rotate(const Parameters &parameters)
+{
+    if (parameters.syncPolicy != SyncPolicyNone) {
+        sync();
+    }
+    m_file.close();
+    renameFile(parameters);
+    openFile(parameters);
+}
+
+bool xToolsLogWriter::renameFile(const Parameters &parameters)
+{
+    const QString fileName = parameters.fileName;
+    QString newFileName = rotatedFileName(fileName, QDateTime::currentMSecsSinceEpoch());
+    if (!QFile::rename(fileName, newFileName)) {
+        qWarning() << "Failed to rename file" << fileName << "to" << newFileName;
+        return false;
+    }
+
+    emit segmentRotated(newFileName);
+    removeExpiredSegments(parameters);
+    return true;
+}
+
+void xToolsLogWriter::sync()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    m_file.flush();
+    int handle = m_file.handle();
+#if defined(Q_OS_WIN)
+    _commit(handle);
+#elif defined(Q_OS_MACOS)
+    fsync(handle);
+#else
+    fdatasync(handle);
+#endif
+    m_lastSyncTime = QDateTime::currentMSecsSinceEpoch();
+}
+
+void xToolsLogWriter::removeExpiredSegments(const Parameters &parameters)
+{
+    if (parameters.retentionCount <= 0) {
+        return;
+    }
+
+    // Only the names made by rotatedFileName() are segments, "log_old.txt" of "log.txt" is not.
+    QFileInfo info(parameters.fileName);
+    QString pattern = "^" + QRegularExpression::escape(info.baseName()) + "_\\d+";
+    if (!info.completeSuffix().isEmpty()) {
+        pattern += QRegularExpression::escape("." + info.completeSuffix());
+    }
+    pattern += "$";
+
+    QDir dir(info.absolutePath());
+    QRegularExpression expression(pattern);
+    QStringList segments;
+    const QStringList names = dir.entryList(QStringList{info.baseName() + "_*"},
+                                            QDir::Files,
+                                            QDir::Name);
+    for (const QString &name : names) {
+        if (expression.match(name).hasMatch()) {
+            segments.append(name);
+        }
+    }
+
+    while (segments.count() > parameters.retentionCount) {
+        dir.remove(segments.takeFirst());
+    }
+}
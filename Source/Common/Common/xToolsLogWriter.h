@@ -0,0 +1,110 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "xToolsProfiler.h"
+
+/// An asynchronous file writer. append() only queues the bytes, the file is written by the thread
+/// of the writer with large batched writes. The queue is bounded, when the disk stalls the bytes
+/// that don't fit in the queue are dropped and counted instead of growing the memory.
+class xToolsLogWriter : public QThread
+{
+    Q_OBJECT
+public:
+    enum SyncPolicy { SyncPolicyNone, SyncPolicyInterval, SyncPolicyEveryBatch };
+
+    struct Parameters
+    {
+        QString fileName;
+        qint64 maxSegmentSize{0}; // Rotate when the segment is larger than it, 0 = never.
+        int rotationInterval{0};  // Rotate every N seconds, 0 = never.
+        int retentionCount{0};    // Rotated segments to keep, 0 = keep all.
+        int syncPolicy{SyncPolicyNone};
+        int syncInterval{1000}; // ms, for SyncPolicyInterval.
+        int flushInterval{200}; // ms, the maximum time bytes stay in the queue.
+        int codec{0}; // xToolsSegmentCodec::Codec, the file is written as a compressed segment.
+        qint64 maxPendingBytes{16 * 1024 * 1024};
+    };
+
+public:
+    explicit xToolsLogWriter(QObject *parent = nullptr);
+    ~xToolsLogWriter();
+
+    Parameters parameters();
+    /// The file is reopened by the writer thread if the file name is changed.
+    void setParameters(const Parameters &parameters);
+
+    /// Queue the bytes, an append is never split into two segments. Returns false if the bytes are
+    /// dropped because the queue is full.
+    bool append(const QByteArray &bytes);
+    void stop();
+
+    qint64 pendingBytes() const;
+    /// Bytes written to the disk, they are compressed bytes if a codec is set.
+    qint64 writtenBytes() const;
+    qint64 rawBytes() const;
+    /// Nanoseconds spent on compressing in the writer thread.
+    qint64 compressionTime() const;
+    qint64 droppedBytes() const;
+    qint64 droppedAppends() const;
+
+    /// The name of a rotated segment: "name_<ms since epoch>.suffix".
+    static QString rotatedFileName(const QString &fileName, qint64 msecsSinceEpoch);
+
+signals:
+    void errorOccurred(const QString &errorString);
+    void segmentRotated(const QString &fileName);
+
+protected:
+    void run() override;
+
+private:
+    Parameters m_parameters;
+    bool m_parametersChanged{false};
+    QList<QByteArray> m_queue;
+    bool m_stopRequested{false};
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    std::atomic<xToolsProfiler::Stage *> m_profilerStage{nullptr};
+
+    std::atomic<qint64> m_pendingBytes{0};
+    std::atomic<qint64> m_writtenBytes{0};
+    std::atomic<qint64> m_rawBytes{0};
+    std::atomic<qint64> m_compressionTime{0};
+    std::atomic<qint64> m_droppedBytes{0};
+    std::atomic<qint64> m_droppedAppends{0};
+
+    // Only accessed by the writer thread.
+    QFile m_file;
+    QByteArray m_batch;
+    qint64 m_segmentOpenedTime{0};
+    qint64 m_lastSyncTime{0};
+
+private:
+    int m_codec{0};
+
+private:
+    xToolsProfiler::Stage *profilerStage();
+    bool openFile(const Parameters &parameters);
+    void closeFile();
+    void writeQueue(const Parameters &parameters, QList<QByteArray> &queue);
+    bool writeBatch();
+    void rotate(const Parameters &parameters);
+    bool renameFile(const Parameters &parameters);
+    void sync();
+    void removeExpiredSegments(const Parameters &parameters);
+};
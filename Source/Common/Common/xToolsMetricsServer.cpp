@@ -0,0 +1,280 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsMetricsServer.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "xToolsProfiler.h"
+
+static const int maxRequestBytes = 8 * 1024;
+
+static QString escapeLabelValue(const QString &value)
+{
+    QString cookedValue = value;
+    cookedValue.replace("\\", "\\\\");
+    cookedValue.replace("\"", "\\\"");
+    cookedValue.replace("\n", "\\n");
+    return cookedValue;
+}
+
+static QString valueString(double value)
+{
+    if (value == qint64(value)) {
+        return QString::number(qint64(value));
+    }
+
+    return QString::number(value, 'g', 15);
+}
+
+static QByteArray response(const QByteArray &status,
+                           const QByteArray &contentType,
+                           const QByteArray &body)
+{
+    QByteArray bytes;
+    bytes.append("HTTP/1.1 " + status + "\r\n");
+    bytes.append("Content-Type: " + contentType + "\r\n");
+    bytes.append("Content-Length: " + QByteArray::number(body.length()) + "\r\n");
+    bytes.append("Connection: close\r\n\r\n");
+    bytes.append(body);
+    return bytes;
+}
+
+xToolsMetricsServer::xToolsMetricsServer(QObject *parent)
+    : QThread(parent)
+{}
+
+xToolsMetricsServer *xToolsMetricsServer::instance()
+{
+    static xToolsMetricsServer *server = nullptr;
+    if (!server) {
+        server = new xToolsMetricsServer(qApp);
+    }
+
+    return server;
+}
+
+xToolsMetricsServer::~xToolsMetricsServer()
+{
+    stop();
+}
+
+int xToolsMetricsServer::addCollector(const Collector &collector)
+{
+    m_collectorsMutex.lock();
+    int id = m_nextCollectorId++;
+    m_collectors.insert(id, collector);
+    m_collectorsMutex.unlock();
+    return id;
+}
+
+void xToolsMetricsServer::removeCollector(int id)
+{
+    // The collector may be running in the thread of the server, the mutex makes the caller wait
+    // for it, the collector is never called after it is removed.
+    m_collectorsMutex.lock();
+    m_collectors.remove(id);
+    m_collectorsMutex.unlock();
+}
+
+void xToolsMetricsServer::setPort(quint16 port)
+{
+    m_port = port;
+}
+
+quint16 xToolsMetricsServer::port() const
+{
+    return m_port;
+}
+
+bool xToolsMetricsServer::isListening() const
+{
+    return m_isListening;
+}
+
+void xToolsMetricsServer::stop()
+{
+    if (isRunning()) {
+        exit();
+        wait();
+    }
+}
+
+QByteArray xToolsMetricsServer::exposition()
+{
+    QList<Sample> samples;
+    m_collectorsMutex.lock();
+    for (auto it = m_collectors.constBegin(); it != m_collectors.constEnd(); ++it) {
+        it.value()(samples);
+    }
+    m_collectorsMutex.unlock();
+    collectProfiler(samples);
+
+    // The samples of a family must be grouped, the families keep the order they are collected.
+    QStringList families;
+    QHash<QString, QList<int>> familySamples;
+    for (int i = 0; i < samples.length(); i++) {
+        const QString &family = samples.at(i).family;
+        if (!familySamples.contains(family)) {
+            families.append(family);
+        }
+        familySamples[family].append(i);
+    }
+
+    QString text;
+    for (const QString &family : families) {
+        const QList<int> &indexes = familySamples[family];
+        const Sample &first = samples.at(indexes.first());
+        bool isCounter = first.type == MetricTypeCounter;
+        text.append(QString("# TYPE %1 %2\n").arg(family, isCounter ? "counter" : "gauge"));
+        if (!first.help.isEmpty()) {
+            text.append(QString("# HELP %1 %2\n").arg(family, first.help));
+        }
+
+        for (int index : indexes) {
+            const Sample &sample = samples.at(index);
+            text.append(isCounter ? family + "_total" : family);
+            if (!sample.labels.isEmpty()) {
+                QStringList labels;
+                for (const auto &label : sample.labels) {
+                    labels.append(label.first + "=\"" + escapeLabelValue(label.second) + "\"");
+                }
+                text.append("{" + labels.join(",") + "}");
+            }
+            text.append(" " + valueString(sample.value) + "\n");
+        }
+    }
+    text.append("# EOF\n");
+
+    return text.toUtf8();
+}
+
+void xToolsMetricsServer::addCounter(QList<Sample> &samples,
+                                     const QString &family,
+                                     const QString &help,
+                                     const Labels &labels,
+                                     double value)
+{
+    Sample sample;
+    sample.family = family;
+    sample.type = MetricTypeCounter;
+    sample.help = help;
+    sample.labels = labels;
+    sample.value = value;
+    samples.append(sample);
+}
+
+void xToolsMetricsServer::addGauge(QList<Sample> &samples,
+                                   const QString &family,
+                                   const QString &help,
+                                   const Labels &labels,
+                                   double value)
+{
+    Sample sample;
+    sample.family = family;
+    sample.type = MetricTypeGauge;
+    sample.help = help;
+    sample.labels = labels;
+    sample.value = value;
+    samples.append(sample);
+}
+
+void xToolsMetricsServer::run()
+{
+    QTcpServer *tcpServer = new QTcpServer();
+    if (!tcpServer->listen(QHostAddress::LocalHost, m_port)) {
+        emit errorOccurred(tcpServer->errorString());
+        delete tcpServer;
+        return;
+    }
+
+    connect(tcpServer, &QTcpServer::newConnection, tcpServer, [=]() {
+        while (tcpServer->hasPendingConnections()) {
+            QTcpSocket *socket = tcpServer->nextPendingConnection();
+            connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+            connect(socket, &QTcpSocket::readyRead, socket, [=]() {
+                QByteArray request = socket->property("request").toByteArray();
+                request.append(socket->readAll());
+                if (request.length() > maxRequestBytes) {
+                    socket->abort();
+                    socket->deleteLater();
+                    return;
+                }
+
+                socket->setProperty("request", request);
+                if (!request.contains("\r\n\r\n")) {
+                    return;
+                }
+
+                QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+                QByteArray method = requestLine.value(0);
+                QByteArray path = requestLine.value(1).split('?').first();
+                if (method != "GET") {
+                    socket->write(response("405 Method Not Allowed", "text/plain", QByteArray()));
+                } else if (path == "/metrics") {
+                    QByteArray contentType
+                        = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+                    socket->write(response("200 OK", contentType, exposition()));
+                } else {
+                    socket->write(response("404 Not Found", "text/plain", QByteArray()));
+                }
+                socket->disconnectFromHost();
+            });
+        }
+    });
+
+    m_isListening = true;
+    exec();
+    m_isListening = false;
+
+    tcpServer->close();
+    delete tcpServer;
+}
+
+void xToolsMetricsServer::collectProfiler(QList<Sample> &samples)
+{
+    const QList<xToolsProfiler::StageStatistics> statistics = xToolsProfiler::instance()
+                                                                  ->statistics();
+    for (const auto &stage : statistics) {
+        Labels labels{qMakePair(QString("stage"), stage.name)};
+        addCounter(samples,
+                   "xtools_stage_calls",
+                   "Processing calls of the pipeline stage.",
+                   labels,
+                   stage.calls);
+        addCounter(samples,
+                   "xtools_stage_processing_seconds",
+                   "Time spent on processing in the pipeline stage.",
+                   labels,
+                   stage.totalTime / 1e9);
+        addGauge(samples,
+                 "xtools_stage_queue_depth",
+                 "Items queued for the pipeline stage.",
+                 labels,
+                 stage.queueDepth);
+        addGauge(samples,
+                 "xtools_stage_max_queue_depth",
+                 "The highest queue depth of the pipeline stage.",
+                 labels,
+                 stage.maxQueueDepth);
+        addCounter(samples,
+                   "xtools_stage_dropped",
+                   "Items dropped by the pipeline stage.",
+                   labels,
+                   stage.dropped);
+        addCounter(samples,
+                   "xtools_stage_wakeups",
+                   "Wake-ups of the pipeline stage.",
+                   labels,
+                   stage.wakeups);
+    }
+}
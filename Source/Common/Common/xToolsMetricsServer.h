@@ -0,0 +1,87 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QThread>
+
+/// A local metrics endpoint. "GET /metrics" on 127.0.0.1 returns the counters of the registered
+/// collectors and of the pipeline profiler in the OpenMetrics text format. The listener runs in
+/// the thread of the server, a collector is called in that thread too, so it must only read
+/// atomic counters or take short locks, a scrape never waits for the data path.
+class xToolsMetricsServer : public QThread
+{
+    Q_OBJECT
+public:
+    enum MetricType { MetricTypeCounter, MetricTypeGauge };
+
+    typedef QList<QPair<QString, QString>> Labels;
+    struct Sample
+    {
+        QString family; // "xtools_xxx", "_total" is appended to the name of a counter.
+        int type{MetricTypeGauge};
+        QString help;
+        Labels labels;
+        double value{0};
+    };
+    typedef std::function<void(QList<Sample> &samples)> Collector;
+
+    static const quint16 defaultPort = 9464;
+
+public:
+    static xToolsMetricsServer *instance();
+    ~xToolsMetricsServer() override;
+
+    /// Returns the id of the collector, remove it before the objects it reads are destroyed.
+    int addCollector(const Collector &collector);
+    void removeCollector(int id);
+
+    /// The port is used when the server is started.
+    void setPort(quint16 port);
+    quint16 port() const;
+    bool isListening() const;
+    void stop();
+
+    /// The exposition of all metrics, it is the body of the response.
+    QByteArray exposition();
+
+    static void addCounter(QList<Sample> &samples,
+                           const QString &family,
+                           const QString &help,
+                           const Labels &labels,
+                           double value);
+    static void addGauge(QList<Sample> &samples,
+                         const QString &family,
+                         const QString &help,
+                         const Labels &labels,
+                         double value);
+
+signals:
+    void errorOccurred(const QString &errorString);
+
+protected:
+    void run() override;
+
+private:
+    QMap<int, Collector> m_collectors;
+    int m_nextCollectorId{0};
+    QMutex m_collectorsMutex;
+    std::atomic<quint16> m_port{defaultPort};
+    std::atomic_bool m_isListening{false};
+
+private:
+    explicit xToolsMetricsServer(QObject *parent = nullptr);
+    void collectProfiler(QList<Sample> &samples);
+};
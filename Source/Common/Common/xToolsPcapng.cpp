@@ -0,0 +1,633 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsPcapng.h"
+
+#include <cstring>
+
+#include <QDebug>
+#include <QtEndian>
+
+#include "xToolsSegmentCodec.h"
+
+static const quint32 byteOrderMagic = 0x1A2B3C4D;
+static const quint16 optionEndOfOpt = 0;
+static const quint16 optionShbUserAppl = 4;
+static const quint16 optionIfName = 2;
+static const quint16 optionIfTsResol = 9;
+static const quint16 optionEpbFlags = 2;
+static const int readBufferSize = 4 * 1024 * 1024;
+static const quint32 maxBlockSize = 256 * 1024 * 1024;
+
+static int paddedSize(int length)
+{
+    return (length + 3) & ~3;
+}
+
+static void appendUInt16(QByteArray &bytes, quint16 value)
+{
+    char buffer[2];
+    qToLittleEndian<quint16>(value, buffer);
+    bytes.append(buffer, sizeof(buffer));
+}
+
+static void appendUInt32(QByteArray &bytes, quint32 value)
+{
+    char buffer[4];
+    qToLittleEndian<quint32>(value, buffer);
+    bytes.append(buffer, sizeof(buffer));
+}
+
+static void appendOption(QByteArray &bytes, quint16 code, const QByteArray &value)
+{
+    appendUInt16(bytes, code);
+    appendUInt16(bytes, static_cast<quint16>(value.size()));
+    bytes.append(value);
+    bytes.append(paddedSize(value.size()) - value.size(), '\0');
+}
+
+static void appendBlock(QByteArray &bytes, quint32 type, const QByteArray &body)
+{
+    const quint32 length = static_cast<quint32>(body.size() + 12);
+    appendUInt32(bytes, type);
+    appendUInt32(bytes, length);
+    bytes.append(body);
+    appendUInt32(bytes, length);
+}
+
+QByteArray xToolsPcapng::socketCanFrame(
+    quint32 frameId, bool isExtended, bool isRemote, bool isError, bool isFd, const QByteArray &data)
+{
+    quint32 canId = frameId & (isExtended ? 0x1FFFFFFF : 0x7FF);
+    canId |= isExtended ? 0x80000000 : 0;
+    canId |= isRemote ? 0x40000000 : 0;
+    canId |= isError ? 0x20000000 : 0;
+
+    QByteArray bytes(8, '\0');
+    qToBigEndian<quint32>(canId, bytes.data());
+    bytes[4] = static_cast<char>(data.size());
+    bytes[5] = static_cast<char>(isFd ? 0x04 : 0x00); // CANFD_FDF
+    bytes.append(data);
+    return bytes;
+}
+
+/**************************************************************************************************/
+xToolsPcapngWriter::xToolsPcapngWriter() {}
+
+xToolsPcapngWriter::~xToolsPcapngWriter()
+{
+    close();
+}
+
+bool xToolsPcapngWriter::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    m_interfaces.clear();
+    m_batch.resize(0);
+    m_batch.reserve(256 * 1024);
+
+    if (!m_file.open(QFile::WriteOnly | QFile::Append)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_fileSize = m_file.size();
+    appendSectionHeaderBlock();
+    return flush();
+}
+
+void xToolsPcapngWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    flush();
+    m_file.close();
+}
+
+bool xToolsPcapngWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString xToolsPcapngWriter::fileName() const
+{
+    return m_file.fileName();
+}
+
+qint64 xToolsPcapngWriter::size() const
+{
+    return m_fileSize + m_batch.size();
+}
+
+void xToolsPcapngWriter::append(qint64 timestamp,
+                                int direction,
+                                const QString &endpoint,
+                                const QByteArray &payload)
+{
+    appendPacket(interfaceId(m_linkType, endpoint), timestamp, direction, payload);
+}
+
+bool xToolsPcapngWriter::flush()
+{
+    if (m_batch.isEmpty()) {
+        return true;
+    }
+
+    qint64 ret = m_file.write(m_batch);
+    if (ret > 0) {
+        m_fileSize += ret;
+    }
+
+    if (ret != m_batch.size()) {
+        m_errorString = m_file.errorString();
+        qWarning() << "Failed to write pcapng file:" << m_file.fileName() << m_errorString;
+        m_batch.resize(0);
+        return false;
+    }
+
+    m_batch.resize(0);
+    return true;
+}
+
+void xToolsPcapngWriter::setLinkType(int linkType)
+{
+    m_linkType = linkType;
+}
+
+int xToolsPcapngWriter::interfaceId(int linkType, const QString &name)
+{
+    const QString key = QString::number(linkType) + QChar(':') + name;
+    auto it = m_interfaces.constFind(key);
+    if (it != m_interfaces.constEnd()) {
+        return it.value();
+    }
+
+    int id = m_interfaces.count();
+    m_interfaces.insert(key, id);
+    appendInterfaceDescriptionBlock(linkType, name);
+    return id;
+}
+
+void xToolsPcapngWriter::appendPacket(int interfaceId,
+                                      qint64 timestamp,
+                                      int direction,
+                                      const QByteArray &payload)
+{
+    // The enhanced packet block is encoded in place, it is the hot path of the writer.
+    const bool hasFlags = direction != xToolsCaptureFile::DirectionUnknown;
+    const int dataSize = paddedSize(payload.size());
+    const int length = 32 + dataSize + (hasFlags ? 12 : 0);
+    const quint64 ts = static_cast<quint64>(timestamp);
+
+    const int offset = m_batch.size();
+    m_batch.resize(offset + length);
+    char *ptr = m_batch.data() + offset;
+    qToLittleEndian<quint32>(xToolsPcapng::BlockTypeEnhancedPacket, ptr);
+    qToLittleEndian<quint32>(length, ptr + 4);
+    qToLittleEndian<quint32>(interfaceId, ptr + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(ts >> 32), ptr + 12);
+    qToLittleEndian<quint32>(static_cast<quint32>(ts & 0xFFFFFFFF), ptr + 16);
+    qToLittleEndian<quint32>(payload.size(), ptr + 20);
+    qToLittleEndian<quint32>(payload.size(), ptr + 24);
+    memcpy(ptr + 28, payload.constData(), payload.size());
+    memset(ptr + 28 + payload.size(), 0, dataSize - payload.size());
+
+    ptr += 28 + dataSize;
+    if (hasFlags) {
+        // Bits 0-1 of the flags: 01 = inbound, 10 = outbound.
+        quint32 flags = direction == xToolsCaptureFile::DirectionRx ? 1 : 2;
+        qToLittleEndian<quint16>(optionEpbFlags, ptr);
+        qToLittleEndian<quint16>(4, ptr + 2);
+        qToLittleEndian<quint32>(flags, ptr + 4);
+        qToLittleEndian<quint32>(optionEndOfOpt, ptr + 8);
+        ptr += 12;
+    }
+
+    qToLittleEndian<quint32>(length, ptr);
+}
+
+void xToolsPcapngWriter::appendSectionHeaderBlock()
+{
+    QByteArray body;
+    appendUInt32(body, byteOrderMagic);
+    appendUInt16(body, 1);
+    appendUInt16(body, 0);
+    appendUInt32(body, 0xFFFFFFFF); // Section length is not specified.
+    appendUInt32(body, 0xFFFFFFFF);
+    appendOption(body, optionShbUserAppl, QByteArrayLiteral("xTools"));
+    appendUInt32(body, optionEndOfOpt);
+    appendBlock(m_batch, xToolsPcapng::BlockTypeSectionHeader, body);
+}
+
+void xToolsPcapngWriter::appendInterfaceDescriptionBlock(int linkType, const QString &name)
+{
+    QByteArray body;
+    appendUInt16(body, static_cast<quint16>(linkType));
+    appendUInt16(body, 0);
+    appendUInt32(body, 0);
+    if (!name.isEmpty()) {
+        appendOption(body, optionIfName, name.toUtf8());
+    }
+    appendOption(body, optionIfTsResol, QByteArray(1, 9)); // Nanoseconds
+    appendUInt32(body, optionEndOfOpt);
+    appendBlock(m_batch, xToolsPcapng::BlockTypeInterfaceDescription, body);
+}
+
+/**************************************************************************************************/
+xToolsPcapngReader::xToolsPcapngReader() {}
+
+xToolsPcapngReader::~xToolsPcapngReader()
+{
+    close();
+}
+
+bool xToolsPcapngReader::open(const QString &fileName)
+{
+    close();
+
+    // Compressed segments are decompressed on the fly.
+    if (xToolsSegmentCodec::isSegmentFile(fileName)) {
+        m_device = new xToolsSegmentDevice(fileName);
+    } else {
+        m_device = new QFile(fileName);
+    }
+
+    if (!m_device->open(QIODevice::ReadOnly)) {
+        m_errorString = m_device->errorString();
+        close();
+        return false;
+    }
+
+    m_buffer.resize(readBufferSize);
+    if (!fill(4)) {
+        m_errorString = QStringLiteral("The file is too small to be a pcap or pcapng file.");
+        close();
+        return false;
+    }
+
+    const uchar *ptr = reinterpret_cast<const uchar *>(m_buffer.constData());
+    quint32 magic = qFromLittleEndian<quint32>(ptr);
+    if (magic == xToolsPcapng::BlockTypeSectionHeader) {
+        m_isPcap = false;
+    } else if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D
+               || magic == 0x4D3CB2A1) {
+        m_isPcap = true;
+    } else {
+        m_errorString = QStringLiteral("The file is not a pcap or pcapng file.");
+        close();
+        return false;
+    }
+
+    rewind();
+    if (m_isPcap && m_interfaces.isEmpty()) {
+        m_errorString = QStringLiteral("The pcap file header is truncated.");
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void xToolsPcapngReader::close()
+{
+    if (m_device) {
+        m_device->close();
+        delete m_device;
+        m_device = nullptr;
+    }
+
+    m_buffer.clear();
+    m_bufferBegin = 0;
+    m_bufferEnd = 0;
+    m_lastBlockBegin = 0;
+    m_bigEndian = false;
+    m_sectionBegin = 0;
+    m_interfaces.clear();
+}
+
+bool xToolsPcapngReader::isOpen() const
+{
+    return m_device != nullptr;
+}
+
+bool xToolsPcapngReader::readFrame(xToolsCaptureFrame &frame)
+{
+    if (!m_device) {
+        return false;
+    }
+
+    if (m_isPcap) {
+        return readPcapRecord(frame);
+    }
+
+    bool isFrame = false;
+    while (readPcapngBlock(frame, isFrame)) {
+        if (isFrame) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool xToolsPcapngReader::seek(qint64 timestamp)
+{
+    rewind();
+
+    xToolsCaptureFrame frame;
+    while (readFrame(frame)) {
+        if (frame.timestamp >= timestamp) {
+            // The block of the frame is still in the buffer, step back to it.
+            m_bufferBegin = m_lastBlockBegin;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void xToolsPcapngReader::rewind()
+{
+    m_device->seek(0);
+    m_bufferBegin = 0;
+    m_bufferEnd = 0;
+    m_lastBlockBegin = 0;
+    m_bigEndian = false;
+    m_sectionBegin = 0;
+    m_interfaces.clear();
+
+    if (m_isPcap) {
+        readPcapHeader();
+    }
+}
+
+QString xToolsPcapngReader::endpointName(quint16 endpoint) const
+{
+    if (endpoint < m_interfaces.count() && !m_interfaces.at(endpoint).name.isEmpty()) {
+        return m_interfaces.at(endpoint).name;
+    }
+
+    return QString("if%1").arg(endpoint);
+}
+
+int xToolsPcapngReader::linkType(quint16 endpoint) const
+{
+    if (endpoint < m_interfaces.count()) {
+        return m_interfaces.at(endpoint).linkType;
+    }
+
+    return -1;
+}
+
+bool xToolsPcapngReader::fill(int bytes)
+{
+    if (m_bufferEnd - m_bufferBegin >= bytes) {
+        return true;
+    }
+
+    // Move the remaining bytes to the front of the buffer, then read as much as possible.
+    const int remaining = m_bufferEnd - m_bufferBegin;
+    char *data = m_buffer.data();
+    if (remaining > 0 && m_bufferBegin > 0) {
+        memmove(data, data + m_bufferBegin, remaining);
+    }
+    m_bufferBegin = 0;
+    m_bufferEnd = remaining;
+    m_lastBlockBegin = 0;
+
+    if (bytes > m_buffer.size()) {
+        m_buffer.resize(paddedSize(bytes));
+        data = m_buffer.data();
+    }
+
+    while (m_bufferEnd < bytes) {
+        qint64 ret = m_device->read(data + m_bufferEnd, m_buffer.size() - m_bufferEnd);
+        if (ret <= 0) {
+            return false;
+        }
+
+        m_bufferEnd += static_cast<int>(ret);
+    }
+
+    return true;
+}
+
+quint16 xToolsPcapngReader::toUInt16(const uchar *ptr) const
+{
+    return m_bigEndian ? qFromBigEndian<quint16>(ptr) : qFromLittleEndian<quint16>(ptr);
+}
+
+quint32 xToolsPcapngReader::toUInt32(const uchar *ptr) const
+{
+    return m_bigEndian ? qFromBigEndian<quint32>(ptr) : qFromLittleEndian<quint32>(ptr);
+}
+
+bool xToolsPcapngReader::readPcapHeader()
+{
+    if (!fill(24)) {
+        return false;
+    }
+
+    const uchar *ptr = reinterpret_cast<const uchar *>(m_buffer.constData()) + m_bufferBegin;
+    quint32 magic = qFromLittleEndian<quint32>(ptr);
+    m_bigEndian = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+    bool isNanosecond = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+
+    Interface iface;
+    iface.linkType = static_cast<int>(toUInt32(ptr + 20) & 0xFFFF);
+    iface.unitsPerSecond = isNanosecond ? 1000000000 : 1000000;
+    m_interfaces.append(iface);
+    m_bufferBegin += 24;
+    return true;
+}
+
+bool xToolsPcapngReader::readPcapRecord(xToolsCaptureFrame &frame)
+{
+    if (!fill(16)) {
+        return false;
+    }
+
+    const uchar *ptr = reinterpret_cast<const uchar *>(m_buffer.constData()) + m_bufferBegin;
+    quint32 capturedLength = toUInt32(ptr + 8);
+    if (capturedLength > maxBlockSize) {
+        m_errorString = QStringLiteral("The pcap file is corrupted.");
+        return false;
+    }
+
+    if (!fill(16 + capturedLength)) {
+        return false;
+    }
+
+    ptr = reinterpret_cast<const uchar *>(m_buffer.constData()) + m_bufferBegin;
+    m_lastBlockBegin = m_bufferBegin;
+    m_bufferBegin += 16 + capturedLength;
+
+    const Interface &iface = m_interfaces.first();
+    quint64 seconds = toUInt32(ptr);
+    quint64 fraction = toUInt32(ptr + 4);
+    frame.timestamp = toNanoseconds(iface, seconds * iface.unitsPerSecond + fraction);
+    frame.direction = xToolsCaptureFile::DirectionUnknown;
+    frame.endpoint = 0;
+    frame.payload = QByteArray::fromRawData(reinterpret_cast<const char *>(ptr + 16),
+                                            static_cast<int>(capturedLength));
+    return true;
+}
+
+bool xToolsPcapngReader::readPcapngBlock(xToolsCaptureFrame &frame, bool &isFrame)
+{
+    isFrame = false;
+    if (!fill(12)) {
+        return false;
+    }
+
+    const uchar *ptr = reinterpret_cast<const uchar *>(m_buffer.constData()) + m_bufferBegin;
+    quint32 type = qFromLittleEndian<quint32>(ptr);
+    if (type == xToolsPcapng::BlockTypeSectionHeader) {
+        // The byte order of the section is decided by the byte order magic.
+        m_bigEndian = qFromLittleEndian<quint32>(ptr + 8) != byteOrderMagic;
+    } else {
+        type = toUInt32(ptr);
+    }
+
+    quint32 length = toUInt32(ptr + 4);
+    if (length < 12 || length % 4 != 0 || length > maxBlockSize) {
+        m_errorString = QStringLiteral("The pcapng file is corrupted.");
+        return false;
+    }
+
+    // A torn block at the end of the file is ignored.
+    if (!fill(static_cast<int>(length))) {
+        return false;
+    }
+
+    ptr = reinterpret_cast<const uchar *>(m_buffer.constData()) + m_bufferBegin;
+    m_lastBlockBegin = m_bufferBegin;
+    m_bufferBegin += static_cast<int>(length);
+
+    if (type == xToolsPcapng::BlockTypeSectionHeader) {
+        parseSectionHeader(ptr);
+    } else if (type == xToolsPcapng::BlockTypeInterfaceDescription) {
+        parseInterfaceDescription(ptr, length);
+    } else if (type == xToolsPcapng::BlockTypeEnhancedPacket && length >= 32) {
+        int iface = m_sectionBegin + static_cast<int>(toUInt32(ptr + 8));
+        quint32 capturedLength = toUInt32(ptr + 20);
+        if (iface >= m_interfaces.count() || capturedLength > length - 32
+            || 32 + quint32(paddedSize(capturedLength)) > length) {
+            return true;
+        }
+
+        quint64 ts = (quint64(toUInt32(ptr + 12)) << 32) | toUInt32(ptr + 16);
+        frame.timestamp = toNanoseconds(m_interfaces.at(iface), ts);
+        frame.direction = xToolsCaptureFile::DirectionUnknown;
+        frame.endpoint = static_cast<quint16>(iface);
+        frame.payload = QByteArray::fromRawData(reinterpret_cast<const char *>(ptr + 28),
+                                                static_cast<int>(capturedLength));
+
+        const uchar *option = ptr + 28 + paddedSize(capturedLength);
+        const uchar *end = ptr + length - 4;
+        while (option + 4 <= end) {
+            quint16 code = toUInt16(option);
+            quint16 optionLength = toUInt16(option + 2);
+            if (code == optionEndOfOpt || option + 4 + optionLength > end) {
+                break;
+            }
+
+            if (code == optionEpbFlags && optionLength == 4) {
+                quint32 flags = toUInt32(option + 4) & 0x03;
+                if (flags == 1) {
+                    frame.direction = xToolsCaptureFile::DirectionRx;
+                } else if (flags == 2) {
+                    frame.direction = xToolsCaptureFile::DirectionTx;
+                }
+            }
+
+            option += 4 + paddedSize(optionLength);
+        }
+
+        isFrame = true;
+    } else if (type == xToolsPcapng::BlockTypeSimplePacket && length >= 16) {
+        if (m_sectionBegin >= m_interfaces.count()) {
+            return true;
+        }
+
+        quint32 capturedLength = qMin(toUInt32(ptr + 8), length - 16);
+        frame.timestamp = 0;
+        frame.direction = xToolsCaptureFile::DirectionUnknown;
+        frame.endpoint = static_cast<quint16>(m_sectionBegin);
+        frame.payload = QByteArray::fromRawData(reinterpret_cast<const char *>(ptr + 12),
+                                                static_cast<int>(capturedLength));
+        isFrame = true;
+    }
+
+    return true;
+}
+
+void xToolsPcapngReader::parseSectionHeader(const uchar *block)
+{
+    Q_UNUSED(block);
+    // Interface ids start from 0 in every section.
+    m_sectionBegin = m_interfaces.count();
+}
+
+void xToolsPcapngReader::parseInterfaceDescription(const uchar *block, quint32 length)
+{
+    if (length < 20) {
+        return;
+    }
+
+    Interface iface;
+    iface.linkType = toUInt16(block + 8);
+    iface.unitsPerSecond = 1000000;
+
+    const uchar *option = block + 16;
+    const uchar *end = block + length - 4;
+    while (option + 4 <= end) {
+        quint16 code = toUInt16(option);
+        quint16 optionLength = toUInt16(option + 2);
+        if (code == optionEndOfOpt || option + 4 + optionLength > end) {
+            break;
+        }
+
+        const uchar *value = option + 4;
+        if (code == optionIfName) {
+            iface.name = QString::fromUtf8(reinterpret_cast<const char *>(value), optionLength);
+        } else if (code == optionIfTsResol && optionLength == 1) {
+            // The most significant bit selects a power of 2, otherwise it's a power of 10.
+            int exponent = value[0] & 0x7F;
+            if (value[0] & 0x80) {
+                iface.unitsPerSecond = qint64(1) << qMin(exponent, 62);
+            } else {
+                iface.unitsPerSecond = 1;
+                for (int i = 0; i < qMin(exponent, 18); i++) {
+                    iface.unitsPerSecond *= 10;
+                }
+            }
+        }
+
+        option += 4 + paddedSize(optionLength);
+    }
+
+    m_interfaces.append(iface);
+}
+
+qint64 xToolsPcapngReader::toNanoseconds(const Interface &iface, quint64 value) const
+{
+    const qint64 nsPerSecond = 1000000000;
+    if (iface.unitsPerSecond == nsPerSecond) {
+        return static_cast<qint64>(value);
+    }
+
+    quint64 seconds = value / iface.unitsPerSecond;
+    quint64 remainder = value % iface.unitsPerSecond;
+    double ns = static_cast<double>(remainder) * nsPerSecond / iface.unitsPerSecond;
+    return static_cast<qint64>(seconds) * nsPerSecond + static_cast<qint64>(ns);
+}
@@ -0,0 +1,135 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "xToolsCaptureFile.h"
+
+/// Pcapng files can be opened by wireshark and tcpdump. The user link types(147-162) are used for
+/// payloads without a protocol header, wireshark can be told to decode them with the "DLT_USER"
+/// protocol preferences.
+class xToolsPcapng
+{
+public:
+    enum LinkType {
+        LinkTypeSerial = 147,    // LINKTYPE_USER0
+        LinkTypeTcp = 148,       // LINKTYPE_USER1
+        LinkTypeUdp = 149,       // LINKTYPE_USER2
+        LinkTypeWebSocket = 150, // LINKTYPE_USER3
+        LinkTypeBle = 151,       // LINKTYPE_USER4
+        LinkTypeSocketCan = 227  // LINKTYPE_CAN_SOCKETCAN
+    };
+
+    enum BlockType {
+        BlockTypeInterfaceDescription = 0x00000001,
+        BlockTypeSimplePacket = 0x00000003,
+        BlockTypeEnhancedPacket = 0x00000006,
+        BlockTypeSectionHeader = 0x0A0D0D0A
+    };
+
+    /// The SocketCAN header(id, length, flags, reserved) and the data of a CAN or CAN FD frame.
+    static QByteArray socketCanFrame(quint32 frameId,
+                                     bool isExtended,
+                                     bool isRemote,
+                                     bool isError,
+                                     bool isFd,
+                                     const QByteArray &data);
+};
+
+class xToolsPcapngWriter : public xToolsAbstractCaptureWriter
+{
+public:
+    xToolsPcapngWriter();
+    ~xToolsPcapngWriter();
+
+    /// A new section is appended if the file is not empty, so the file can be reopened and still
+    /// is a valid pcapng file.
+    bool open(const QString &fileName) override;
+    void close() override;
+    bool isOpen() const override;
+    QString fileName() const override;
+    qint64 size() const override;
+
+    /// An interface is added for every endpoint, the link type is the one set by setLinkType().
+    void append(qint64 timestamp,
+                int direction,
+                const QString &endpoint,
+                const QByteArray &payload) override;
+    bool flush() override;
+
+    void setLinkType(int linkType);
+    int interfaceId(int linkType, const QString &name);
+    void appendPacket(int interfaceId, qint64 timestamp, int direction, const QByteArray &payload);
+
+private:
+    QFile m_file;
+    QByteArray m_batch;
+    qint64 m_fileSize{0};
+    int m_linkType{xToolsPcapng::LinkTypeSerial};
+    QHash<QString, int> m_interfaces;
+
+private:
+    void appendSectionHeaderBlock();
+    void appendInterfaceDescriptionBlock(int linkType, const QString &name);
+};
+
+/// The reader streams the file with large buffered reads, it is never loaded entirely. Both pcapng
+/// and the classic pcap format are supported, compressed segments are read transparently.
+class xToolsPcapngReader : public xToolsAbstractCaptureReader
+{
+public:
+    xToolsPcapngReader();
+    ~xToolsPcapngReader();
+
+    bool open(const QString &fileName) override;
+    void close() override;
+    bool isOpen() const override;
+
+    /// The payload of the frame refers to the read buffer, it is valid until the next read.
+    bool readFrame(xToolsCaptureFrame &frame) override;
+    bool seek(qint64 timestamp) override;
+    void rewind() override;
+    QString endpointName(quint16 endpoint) const override;
+
+    int linkType(quint16 endpoint) const;
+
+private:
+    struct Interface
+    {
+        int linkType;
+        QString name;
+        qint64 unitsPerSecond;
+    };
+
+    QIODevice *m_device{nullptr};
+    QByteArray m_buffer;
+    int m_bufferBegin{0};
+    int m_bufferEnd{0};
+    int m_lastBlockBegin{0};
+    bool m_isPcap{false};
+    bool m_bigEndian{false};
+    int m_sectionBegin{0};
+    QVector<Interface> m_interfaces;
+
+private:
+    bool fill(int bytes);
+    quint16 toUInt16(const uchar *ptr) const;
+    quint32 toUInt32(const uchar *ptr) const;
+    bool readPcapHeader();
+    bool readPcapRecord(xToolsCaptureFrame &frame);
+    bool readPcapngBlock(xToolsCaptureFrame &frame, bool &isFrame);
+    void parseSectionHeader(const uchar *block);
+    void parseInterfaceDescription(const uchar *block, quint32 length);
+    qint64 toNanoseconds(const Interface &iface, quint64 value) const;
+};
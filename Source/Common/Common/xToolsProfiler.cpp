@@ -0,0 +1,317 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsProfiler.h"
+
+#include <chrono>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QThread>
+
+static void updateMax(std::atomic<qint64> &max, qint64 value)
+{
+    qint64 current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value)) {
+    }
+}
+
+xToolsProfiler::Stage::Stage(int id, const QString &name)
+    : m_id(id)
+    , m_name(name)
+{}
+
+int xToolsProfiler::Stage::id() const
+{
+    return m_id;
+}
+
+QString xToolsProfiler::Stage::name() const
+{
+    return m_name;
+}
+
+void xToolsProfiler::Stage::addTime(qint64 begin, qint64 end)
+{
+    const qint64 elapsed = end - begin;
+    m_calls.fetch_add(1, std::memory_order_relaxed);
+    m_totalTime.fetch_add(elapsed, std::memory_order_relaxed);
+    updateMax(m_maxTime, elapsed);
+
+    xToolsProfiler *profiler = xToolsProfiler::instance();
+    if (profiler->isTracing()) {
+        profiler->addTraceEvent(m_id, 'X', begin, elapsed);
+    }
+}
+
+void xToolsProfiler::Stage::setQueueDepth(qint64 depth)
+{
+    qint64 old = m_queueDepth.exchange(depth, std::memory_order_relaxed);
+    updateMax(m_maxQueueDepth, depth);
+
+    xToolsProfiler *profiler = xToolsProfiler::instance();
+    if (old != depth && profiler->isTracing()) {
+        profiler->addTraceEvent(m_id, 'C', xToolsProfiler::now(), depth);
+    }
+}
+
+void xToolsProfiler::Stage::addDropped(qint64 count)
+{
+    m_dropped.fetch_add(count, std::memory_order_relaxed);
+
+    xToolsProfiler *profiler = xToolsProfiler::instance();
+    if (profiler->isTracing()) {
+        profiler->addTraceEvent(m_id, 'i', xToolsProfiler::now(), count);
+    }
+}
+
+void xToolsProfiler::Stage::addWakeup()
+{
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void xToolsProfiler::Stage::resetCounters()
+{
+    m_calls.store(0);
+    m_totalTime.store(0);
+    m_maxTime.store(0);
+    m_maxQueueDepth.store(m_queueDepth.load());
+    m_dropped.store(0);
+    m_wakeups.store(0);
+}
+
+/**************************************************************************************************/
+xToolsProfiler::xToolsProfiler() {}
+
+xToolsProfiler *xToolsProfiler::instance()
+{
+    static xToolsProfiler profiler;
+    return &profiler;
+}
+
+qint64 xToolsProfiler::now()
+{
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+xToolsProfiler::Stage *xToolsProfiler::stage(const QString &name)
+{
+    m_stagesMutex.lock();
+    Stage *stage = m_stageHash.value(name, nullptr);
+    if (!stage) {
+        stage = new Stage(m_stages.count(), name);
+        m_stages.append(stage);
+        m_stageHash.insert(name, stage);
+    }
+    m_stagesMutex.unlock();
+    return stage;
+}
+
+xToolsProfiler::Stage *xToolsProfiler::objectStage(const QObject *object,
+                                                   std::atomic<Stage *> &cache)
+{
+    Stage *stage = cache.load();
+    if (stage) {
+        return stage;
+    }
+
+    QString name = object->objectName();
+    if (name.isEmpty()) {
+        name = QString::fromLatin1(object->metaObject()->className());
+    }
+
+    m_stagesMutex.lock();
+    stage = cache.load();
+    if (!stage) {
+        // Reuse the stage of a destroyed object, the stages(and the metric series) grow with the
+        // living instances only.
+        QList<Stage *> &releasedStages = m_releasedStages[name];
+        if (releasedStages.isEmpty()) {
+            int instance = ++m_objectInstances[name];
+            QString stageName = QString("%1 #%2").arg(name).arg(instance);
+            stage = new Stage(m_stages.count(), stageName);
+            m_stages.append(stage);
+            m_stageHash.insert(stageName, stage);
+        } else {
+            stage = releasedStages.takeFirst();
+            stage->m_queueDepth.store(0);
+            stage->resetCounters();
+        }
+
+        cache.store(stage);
+        QObject::connect(object, &QObject::destroyed, [this, name, stage]() {
+            this->m_stagesMutex.lock();
+            this->m_releasedStages[name].append(stage);
+            this->m_stagesMutex.unlock();
+        });
+    }
+    m_stagesMutex.unlock();
+    return stage;
+}
+
+QList<xToolsProfiler::StageStatistics> xToolsProfiler::statistics()
+{
+    m_stagesMutex.lock();
+    QList<Stage *> stages = m_stages;
+    m_stagesMutex.unlock();
+
+    QList<StageStatistics> list;
+    for (Stage *stage : stages) {
+        StageStatistics ctx;
+        ctx.name = stage->m_name;
+        ctx.calls = stage->m_calls.load();
+        ctx.totalTime = stage->m_totalTime.load();
+        ctx.maxTime = stage->m_maxTime.load();
+        ctx.queueDepth = stage->m_queueDepth.load();
+        ctx.maxQueueDepth = stage->m_maxQueueDepth.load();
+        ctx.dropped = stage->m_dropped.load();
+        ctx.wakeups = stage->m_wakeups.load();
+        list.append(ctx);
+    }
+
+    return list;
+}
+
+void xToolsProfiler::reset()
+{
+    m_stagesMutex.lock();
+    for (Stage *stage : m_stages) {
+        stage->resetCounters();
+    }
+    m_stagesMutex.unlock();
+}
+
+bool xToolsProfiler::isTracing() const
+{
+    return m_isTracing.load(std::memory_order_relaxed);
+}
+
+void xToolsProfiler::setTracing(bool enable)
+{
+    m_traceEventsMutex.lock();
+    if (enable && !m_isTracing) {
+        m_traceEvents.clear();
+        m_threadNames.clear();
+    }
+    m_isTracing = enable;
+    m_traceEventsMutex.unlock();
+}
+
+qint64 xToolsProfiler::traceEventCount()
+{
+    m_traceEventsMutex.lock();
+    qint64 count = m_traceEvents.count();
+    m_traceEventsMutex.unlock();
+    return count;
+}
+
+bool xToolsProfiler::exportChromeTrace(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    m_stagesMutex.lock();
+    QStringList stageNames;
+    for (Stage *stage : m_stages) {
+        stageNames.append(stage->m_name);
+    }
+    m_stagesMutex.unlock();
+
+    m_traceEventsMutex.lock();
+    QVector<TraceEvent> events = m_traceEvents;
+    QHash<quintptr, QString> threadNames = m_threadNames;
+    m_traceEventsMutex.unlock();
+
+    // The timestamps of the trace-event format are microseconds.
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    for (auto it = threadNames.constBegin(); it != threadNames.constEnd(); ++it) {
+        QJsonObject args;
+        args.insert("name", it.value());
+        QJsonObject obj;
+        obj.insert("name", "thread_name");
+        obj.insert("ph", "M");
+        obj.insert("pid", pid);
+        obj.insert("tid", double(it.key()));
+        obj.insert("args", args);
+        traceEvents.append(obj);
+    }
+
+    for (const TraceEvent &event : events) {
+        QString name = stageNames.value(event.stage);
+        QJsonObject obj;
+        obj.insert("name", name);
+        obj.insert("cat", "xTools");
+        obj.insert("ph", QString(QChar(event.type)));
+        obj.insert("pid", pid);
+        obj.insert("tid", double(event.thread));
+        obj.insert("ts", event.timestamp / 1000.0);
+        if (event.type == 'X') {
+            obj.insert("dur", event.value / 1000.0);
+        } else if (event.type == 'C') {
+            QJsonObject args;
+            args.insert("queue", event.value);
+            obj.insert("args", args);
+        } else {
+            QJsonObject args;
+            args.insert("dropped", event.value);
+            obj.insert("s", "t");
+            obj.insert("args", args);
+        }
+        traceEvents.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", "ns");
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+void xToolsProfiler::addTraceEvent(int stage, char type, qint64 timestamp, qint64 value)
+{
+    TraceEvent event;
+    event.stage = stage;
+    event.type = type;
+    event.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    event.timestamp = timestamp;
+    event.value = value;
+
+    m_traceEventsMutex.lock();
+    if (m_isTracing && m_traceEvents.count() < maxTraceEvents) {
+        m_traceEvents.append(event);
+        if (!m_threadNames.contains(event.thread)) {
+            QThread *thread = QThread::currentThread();
+            QString name = thread->objectName();
+            if (name.isEmpty()) {
+                name = QString::fromLatin1(thread->metaObject()->className());
+            }
+            m_threadNames.insert(event.thread, name);
+        }
+    }
+    m_traceEventsMutex.unlock();
+}
+
+/**************************************************************************************************/
+xToolsProfilerScope::xToolsProfilerScope(xToolsProfiler::Stage *stage)
+    : m_stage(stage)
+    , m_begin(stage ? xToolsProfiler::now() : 0)
+{}
+
+xToolsProfilerScope::~xToolsProfilerScope()
+{
+    if (m_stage) {
+        m_stage->addTime(m_begin, xToolsProfiler::now());
+    }
+}
@@ -0,0 +1,128 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+class QObject;
+
+/// The pipeline profiler. Every stage of the data path(a device, a processor, a tool, the ui...)
+/// owns a set of atomic counters: the processing time, the queue depth, the dropped frames and the
+/// wake-ups. Updating a stage costs a few relaxed atomic operations. When tracing is enabled, the
+/// samples are also recorded as events that can be exported in the Chrome trace-event format.
+class xToolsProfiler
+{
+public:
+    class Stage
+    {
+    public:
+        explicit Stage(int id, const QString &name);
+
+        int id() const;
+        QString name() const;
+
+        /// Add a processing time sample, begin is the timestamp returned by xToolsProfiler::now().
+        void addTime(qint64 begin, qint64 end);
+        void setQueueDepth(qint64 depth);
+        void addDropped(qint64 count = 1);
+        void addWakeup();
+
+    private:
+        friend class xToolsProfiler;
+        void resetCounters();
+
+    private:
+        const int m_id;
+        const QString m_name;
+        std::atomic<qint64> m_calls{0};
+        std::atomic<qint64> m_totalTime{0};
+        std::atomic<qint64> m_maxTime{0};
+        std::atomic<qint64> m_queueDepth{0};
+        std::atomic<qint64> m_maxQueueDepth{0};
+        std::atomic<qint64> m_dropped{0};
+        std::atomic<qint64> m_wakeups{0};
+    };
+
+    struct StageStatistics
+    {
+        QString name;
+        qint64 calls{0};
+        qint64 totalTime{0}; // ns
+        qint64 maxTime{0};   // ns
+        qint64 queueDepth{0};
+        qint64 maxQueueDepth{0};
+        qint64 dropped{0};
+        qint64 wakeups{0};
+    };
+
+    static const int maxTraceEvents = 1000000;
+
+public:
+    static xToolsProfiler *instance();
+    /// Nanoseconds of the steady clock.
+    static qint64 now();
+
+    /// The stage is created when it is used for the first time, it is never destroyed.
+    Stage *stage(const QString &name);
+    /// The stage of an object, it is named after the object name or the class name with an
+    /// instance suffix, so the living instances never share a stage. The stage is cached in cache,
+    /// it is released when the object is destroyed and reused(with cleared counters) by the next
+    /// object of the same name.
+    Stage *objectStage(const QObject *object, std::atomic<Stage *> &cache);
+    QList<StageStatistics> statistics();
+    void reset();
+
+    bool isTracing() const;
+    /// The recorded events are cleared when tracing is enabled.
+    void setTracing(bool enable);
+    qint64 traceEventCount();
+    bool exportChromeTrace(const QString &fileName);
+
+private:
+    struct TraceEvent
+    {
+        int stage;
+        char type; // 'X': duration, 'C': queue depth, 'i': dropped.
+        quintptr thread;
+        qint64 timestamp;
+        qint64 value;
+    };
+
+    QList<Stage *> m_stages;
+    QHash<QString, Stage *> m_stageHash;
+    QHash<QString, int> m_objectInstances;
+    QHash<QString, QList<Stage *>> m_releasedStages;
+    QMutex m_stagesMutex;
+
+    std::atomic_bool m_isTracing{false};
+    QVector<TraceEvent> m_traceEvents;
+    QHash<quintptr, QString> m_threadNames;
+    QMutex m_traceEventsMutex;
+
+private:
+    xToolsProfiler();
+    void addTraceEvent(int stage, char type, qint64 timestamp, qint64 value);
+};
+
+/// Measure the time of a scope, nothing is measured if the stage is null.
+class xToolsProfilerScope
+{
+public:
+    explicit xToolsProfilerScope(xToolsProfiler::Stage *stage);
+    ~xToolsProfilerScope();
+
+private:
+    xToolsProfiler::Stage *m_stage;
+    qint64 m_begin;
+};
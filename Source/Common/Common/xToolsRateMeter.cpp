@@ -0,0 +1,124 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsRateMeter.h"
+
+#include <chrono>
+
+xToolsRateMeter::xToolsRateMeter() {}
+
+void xToolsRateMeter::add(qint64 bytes, qint64 frames)
+{
+    m_totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_totalFrames.fetch_add(frames, std::memory_order_relaxed);
+
+    const qint64 number = currentBucketNumber();
+    Bucket &bucket = m_buckets[number % bucketCount];
+    qint64 oldNumber = bucket.number.load(std::memory_order_acquire);
+    if (oldNumber != number) {
+        // The first add() of the interval recycles the bucket.
+        if (oldNumber < number && bucket.number.compare_exchange_strong(oldNumber, number)) {
+            bucket.bytes.store(0, std::memory_order_relaxed);
+            bucket.frames.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bucket.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    bucket.frames.fetch_add(frames, std::memory_order_relaxed);
+}
+
+void xToolsRateMeter::reset()
+{
+    for (Bucket &bucket : m_buckets) {
+        bucket.number.store(-1);
+        bucket.bytes.store(0);
+        bucket.frames.store(0);
+    }
+
+    m_totalBytes.store(0);
+    m_totalFrames.store(0);
+    m_peakBytes.store(0);
+    m_peakFrames.store(0);
+}
+
+qint64 xToolsRateMeter::totalBytes() const
+{
+    return m_totalBytes.load(std::memory_order_relaxed);
+}
+
+qint64 xToolsRateMeter::totalFrames() const
+{
+    return m_totalFrames.load(std::memory_order_relaxed);
+}
+
+xToolsRateMeter::Rate xToolsRateMeter::rate(int window) const
+{
+    const qint64 number = currentBucketNumber();
+    const int count = windowBuckets(window);
+    qint64 bytes = 0;
+    qint64 frames = 0;
+    for (int i = 1; i <= count; i++) {
+        const Bucket &bucket = m_buckets[(number - i) % bucketCount];
+        if (bucket.number.load(std::memory_order_acquire) == number - i) {
+            bytes += bucket.bytes.load(std::memory_order_relaxed);
+            frames += bucket.frames.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (window == Window1s) {
+        qint64 peak = m_peakBytes.load();
+        while (bytes > peak && !m_peakBytes.compare_exchange_weak(peak, bytes)) {
+        }
+
+        peak = m_peakFrames.load();
+        while (frames > peak && !m_peakFrames.compare_exchange_weak(peak, frames)) {
+        }
+    }
+
+    const double seconds = count * bucketInterval / 1000.0;
+    Rate rate;
+    rate.bytesPerSecond = bytes / seconds;
+    rate.framesPerSecond = frames / seconds;
+    return rate;
+}
+
+xToolsRateMeter::Rate xToolsRateMeter::peakRate() const
+{
+    Rate rate;
+    rate.bytesPerSecond = m_peakBytes.load();
+    rate.framesPerSecond = m_peakFrames.load();
+    return rate;
+}
+
+QString xToolsRateMeter::speedString(double bytesPerSecond)
+{
+    if (bytesPerSecond < 1024) {
+        return QString("%1B/s").arg(qRound64(bytesPerSecond));
+    } else if (bytesPerSecond < 1024 * 1024) {
+        return QString("%1KB/s").arg(bytesPerSecond / 1024, 0, 'f', 1);
+    }
+
+    return QString("%1MB/s").arg(bytesPerSecond / (1024 * 1024), 0, 'f', 1);
+}
+
+qint64 xToolsRateMeter::currentBucketNumber()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count() / bucketInterval;
+}
+
+int xToolsRateMeter::windowBuckets(int window)
+{
+    if (window == Window10s) {
+        return 10000 / bucketInterval;
+    } else if (window == Window60s) {
+        return 60000 / bucketInterval;
+    }
+
+    return 1000 / bucketInterval;
+}
@@ -0,0 +1,67 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <QString>
+
+/// Throughput counters without payload retention. The bytes and the frames are counted in a ring
+/// of 100 ms buckets, a bucket is recycled when the ring wraps around, so the rates of the last
+/// 60 s are available at any time. add() is lock-free and can be called in any thread, an add()
+/// that races with the recycling of its bucket in another thread may be missed by the rates, the
+/// totals are always exact.
+class xToolsRateMeter
+{
+public:
+    enum Window { Window1s, Window10s, Window60s };
+
+    struct Rate
+    {
+        double bytesPerSecond{0};
+        double framesPerSecond{0};
+    };
+
+    static const int bucketInterval = 100; // ms
+    static const int bucketCount = 640;    // 64 s, a little more than the largest window.
+
+public:
+    xToolsRateMeter();
+
+    void add(qint64 bytes, qint64 frames = 1);
+    void reset();
+
+    qint64 totalBytes() const;
+    qint64 totalFrames() const;
+
+    /// The rates of the complete buckets in the window, the bucket being filled is not included.
+    Rate rate(int window) const;
+    /// The highest 1 s rates since the meter is reset, they are sampled by rate(Window1s).
+    Rate peakRate() const;
+
+    /// Format bytes per second as "B/s", "KB/s" or "MB/s".
+    static QString speedString(double bytesPerSecond);
+
+private:
+    struct Bucket
+    {
+        std::atomic<qint64> number{-1};
+        std::atomic<qint64> bytes{0};
+        std::atomic<qint64> frames{0};
+    };
+
+    Bucket m_buckets[bucketCount];
+    std::atomic<qint64> m_totalBytes{0};
+    std::atomic<qint64> m_totalFrames{0};
+    mutable std::atomic<qint64> m_peakBytes{0};
+    mutable std::atomic<qint64> m_peakFrames{0};
+
+private:
+    static qint64 currentBucketNumber();
+    static int windowBuckets(int window);
+};
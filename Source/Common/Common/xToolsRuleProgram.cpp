@@ -0,0 +1,1123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsRuleProgram.h"
+
+#include <QHash>
+#include <QList>
+#include <QMetaEnum>
+
+#include "IO/xIO.h"
+#include "xToolsCrcInterface.h"
+
+namespace {
+
+enum Opcode {
+    OpPush,
+    OpLength,
+    OpLoad, // The operand is the format.
+    OpGet,  // The operand is the index of the variable.
+    OpSet,
+    OpAdd,
+    OpSubtract,
+    OpMultiply,
+    OpDivide,
+    OpModulo,
+    OpAnd,
+    OpOr,
+    OpXor,
+    OpShiftLeft,
+    OpShiftRight,
+    OpEqual,
+    OpNotEqual,
+    OpLess,
+    OpLessEqual,
+    OpGreater,
+    OpGreaterEqual,
+    OpNegate,
+    OpNot,
+    OpBitNot,
+    OpJump, // The operand is the index of the target instruction.
+    OpJumpIfZero,
+    OpJumpIfNotZero,
+    OpAssert,
+    OpSum,
+    OpXorSum,
+    OpMin,
+    OpMax,
+    OpMatch, // The operand is the index of the value of the pattern, the mask is the next literal.
+    OpEmit,  // The operand is the format.
+    OpEmitLiteral,
+    OpEmitSlice,
+    OpEmitCrc // The operand is "algorithm * 2 + bigEndian".
+};
+
+enum Format { FormatU8, FormatI8, FormatU16, FormatU16Le, FormatU32, FormatU32Le, FormatDec };
+
+int fieldFormat(const QByteArray &name)
+{
+    static const char *names[] = {"u8", "i8", "u16", "u16le", "u32", "u32le"};
+    for (int i = 0; i < 6; i++) {
+        if (name == names[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int fieldSize(int format)
+{
+    return format <= FormatI8 ? 1 : (format <= FormatU16Le ? 2 : 4);
+}
+
+qint64 readField(const uchar *p, int format)
+{
+    switch (format) {
+    case FormatI8:
+        return static_cast<qint8>(p[0]);
+    case FormatU16:
+        return (p[0] << 8) | p[1];
+    case FormatU16Le:
+        return p[0] | (p[1] << 8);
+    case FormatU32:
+        return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | p[3];
+    case FormatU32Le:
+        return p[0] | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+    default:
+        return p[0];
+    }
+}
+
+void writeField(QByteArray &bytes, qint64 value, int format)
+{
+    switch (format) {
+    case FormatU16:
+        bytes.append(static_cast<char>(value >> 8));
+        bytes.append(static_cast<char>(value));
+        break;
+    case FormatU16Le:
+        bytes.append(static_cast<char>(value));
+        bytes.append(static_cast<char>(value >> 8));
+        break;
+    case FormatU32:
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            bytes.append(static_cast<char>(value >> shift));
+        }
+        break;
+    case FormatU32Le:
+        for (int shift = 0; shift <= 24; shift += 8) {
+            bytes.append(static_cast<char>(value >> shift));
+        }
+        break;
+    case FormatDec:
+        bytes.append(QByteArray::number(value));
+        break;
+    default:
+        bytes.append(static_cast<char>(value));
+        break;
+    }
+}
+
+// Offsets and ranges that are negative count from the end of the frame.
+bool cookRange(qint64 &begin, qint64 &end, qint64 size)
+{
+    begin = begin < 0 ? begin + size : begin;
+    end = end < 0 ? end + size : end;
+    return begin >= 0 && begin <= end && end <= size;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isHexDigit(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+bool isNameCharacter(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+int hexValue(char c)
+{
+    if (isDigit(c)) {
+        return c - '0';
+    }
+
+    return (c | 0x20) - 'a' + 10;
+}
+
+// Returns the position after the closing quote, or -1 if the text is not terminated.
+int readString(const QByteArray &text, int position, QByteArray &bytes)
+{
+    for (int i = position + 1; i < text.size(); i++) {
+        char c = text.at(i);
+        if (c == '"') {
+            return i + 1;
+        }
+
+        if (c != '\\' || i + 1 >= text.size()) {
+            bytes.append(c);
+            continue;
+        }
+
+        c = text.at(++i);
+        if (c == 'r') {
+            bytes.append('\r');
+        } else if (c == 'n') {
+            bytes.append('\n');
+        } else if (c == 't') {
+            bytes.append('\t');
+        } else if (c == '0') {
+            bytes.append('\0');
+        } else if (c == 'x' && i + 2 < text.size() && isHexDigit(text.at(i + 1))
+                   && isHexDigit(text.at(i + 2))) {
+            int value = hexValue(text.at(i + 1)) * 16 + hexValue(text.at(i + 2));
+            bytes.append(static_cast<char>(value));
+            i += 2;
+        } else {
+            bytes.append(c);
+        }
+    }
+
+    return -1;
+}
+
+} // namespace
+
+class xToolsRuleProgram::Compiler
+{
+public:
+    explicit Compiler(xToolsRuleProgram *program)
+        : m_program{program}
+    {}
+
+    bool compileRule(const QByteArray &text);
+    bool compileResponse(const QByteArray &text);
+    QString errorString() const { return m_errorString; }
+
+private:
+    enum TokenType { TokenEnd, TokenNumber, TokenName, TokenString, TokenSymbol };
+    struct Token
+    {
+        int type{TokenEnd};
+        qint64 number{0};
+        QByteArray text;
+        int position{0};
+    };
+
+    xToolsRuleProgram *m_program;
+    QVector<Instruction> *m_code{nullptr};
+    QByteArray m_text;
+    int m_position{0};
+    int m_offset{0};
+    Token m_token;
+    QHash<QByteArray, int> m_variables;
+    int m_depth{0};
+    QString m_errorString;
+
+private:
+    void setText(const QByteArray &text, int offset);
+    void next();
+    bool isSymbol(const char *symbol) const;
+    bool accept(const char *symbol);
+    bool expect(const char *symbol);
+    bool fail(const QString &message);
+    bool unexpected();
+    int append(int opcode, qint64 operand, int depth);
+    void patch(int index);
+    static bool isReserved(const QByteArray &name);
+
+    bool statement();
+    bool field(const QByteArray &text, int offset);
+    bool expression();
+    bool logicalOr();
+    bool logicalAnd();
+    bool comparison();
+    bool binary(int level);
+    bool unary();
+    bool primary();
+    bool pattern();
+};
+
+bool xToolsRuleProgram::Compiler::compileRule(const QByteArray &text)
+{
+    m_code = &m_program->m_ruleCode;
+    setText(text, 0);
+    while (m_token.type != TokenEnd) {
+        if (accept(";")) {
+            continue;
+        }
+
+        if (!statement()) {
+            return false;
+        }
+
+        if (m_token.type != TokenEnd && !expect(";")) {
+            return false;
+        }
+    }
+
+    return m_errorString.isEmpty();
+}
+
+bool xToolsRuleProgram::Compiler::compileResponse(const QByteArray &text)
+{
+    m_code = &m_program->m_responseCode;
+    QByteArray literal;
+    auto appendLiteral = [this, &literal]() {
+        if (!literal.isEmpty()) {
+            append(OpEmitLiteral, m_program->m_literals.size(), 0);
+            m_program->m_literals.append(literal);
+            literal.clear();
+        }
+    };
+
+    int i = 0;
+    while (i < text.size()) {
+        const char c = text.at(i);
+        if (isSpace(c)) {
+            i++;
+        } else if (c == '"') {
+            i = readString(text, i, literal);
+            if (i == -1) {
+                return fail(QString("The text is not terminated"));
+            }
+        } else if (c == '{') {
+            int end = i + 1;
+            while (end < text.size() && text.at(end) != '}') {
+                if (text.at(end) == '"') {
+                    QByteArray ignored;
+                    end = readString(text, end, ignored);
+                    if (end == -1) {
+                        return fail(QString("The text is not terminated"));
+                    }
+                } else {
+                    end++;
+                }
+            }
+
+            if (end >= text.size()) {
+                return fail(QString("'}' is missing at %1").arg(i));
+            }
+
+            appendLiteral();
+            if (!field(text.mid(i + 1, end - i - 1), i + 1)) {
+                return false;
+            }
+            i = end + 1;
+        } else if (isHexDigit(c)) {
+            int end = i;
+            while (end < text.size() && isHexDigit(text.at(end))) {
+                end++;
+            }
+
+            if ((end - i) % 2) {
+                return fail(QString("Odd number of hex digits at %1").arg(i));
+            }
+            literal.append(QByteArray::fromHex(text.mid(i, end - i)));
+            i = end;
+        } else {
+            return fail(QString("Unexpected '%1' at %2").arg(QChar(c)).arg(i));
+        }
+    }
+
+    appendLiteral();
+    return m_errorString.isEmpty();
+}
+
+void xToolsRuleProgram::Compiler::setText(const QByteArray &text, int offset)
+{
+    m_text = text;
+    m_position = 0;
+    m_offset = offset;
+    m_depth = 0;
+    next();
+}
+
+void xToolsRuleProgram::Compiler::next()
+{
+    while (m_position < m_text.size() && isSpace(m_text.at(m_position))) {
+        m_position++;
+    }
+
+    m_token = Token();
+    m_token.position = m_offset + m_position;
+    if (m_position >= m_text.size()) {
+        return;
+    }
+
+    const int begin = m_position;
+    const char c = m_text.at(m_position);
+    if (isDigit(c)) {
+        int base = 10;
+        if (c == '0' && m_position + 1 < m_text.size()) {
+            const char prefix = m_text.at(m_position + 1) | 0x20;
+            base = prefix == 'x' ? 16 : (prefix == 'b' ? 2 : 10);
+            m_position += base == 10 ? 0 : 2;
+        }
+
+        while (m_position < m_text.size() && isNameCharacter(m_text.at(m_position))) {
+            m_position++;
+        }
+
+        QByteArray digits = m_text.mid(begin, m_position - begin);
+        bool ok = false;
+        m_token.number = base == 10 ? digits.toLongLong(&ok) : digits.mid(2).toLongLong(&ok, base);
+        m_token.type = ok ? TokenNumber : TokenSymbol;
+        m_token.text = digits;
+    } else if (isNameCharacter(c)) {
+        while (m_position < m_text.size() && isNameCharacter(m_text.at(m_position))) {
+            m_position++;
+        }
+        m_token.type = TokenName;
+        m_token.text = m_text.mid(begin, m_position - begin);
+    } else if (c == '"') {
+        m_position = readString(m_text, m_position, m_token.text);
+        if (m_position == -1) {
+            m_position = m_text.size();
+            fail(QString("The text is not terminated at %1").arg(m_token.position));
+            m_token = Token();
+            return;
+        }
+        m_token.type = TokenString;
+    } else {
+        static const char *symbols[] = {"==", "!=", "<=", ">=", "<<", ">>", "&&", "||"};
+        m_token.type = TokenSymbol;
+        m_token.text = m_text.mid(begin, 1);
+        for (const char *symbol : symbols) {
+            if (m_text.mid(begin, 2) == symbol) {
+                m_token.text = symbol;
+                break;
+            }
+        }
+        m_position += m_token.text.size();
+    }
+}
+
+bool xToolsRuleProgram::Compiler::isSymbol(const char *symbol) const
+{
+    return m_token.type == TokenSymbol && m_token.text == symbol;
+}
+
+bool xToolsRuleProgram::Compiler::accept(const char *symbol)
+{
+    if (isSymbol(symbol)) {
+        next();
+        return true;
+    }
+
+    return false;
+}
+
+bool xToolsRuleProgram::Compiler::expect(const char *symbol)
+{
+    if (accept(symbol)) {
+        return true;
+    }
+
+    return fail(QString("'%1' is expected at %2").arg(QString(symbol)).arg(m_token.position));
+}
+
+bool xToolsRuleProgram::Compiler::fail(const QString &message)
+{
+    // The first error is the cause of the others.
+    if (m_errorString.isEmpty()) {
+        m_errorString = message;
+    }
+
+    return false;
+}
+
+bool xToolsRuleProgram::Compiler::unexpected()
+{
+    if (m_token.type == TokenEnd) {
+        return fail(QString("Unexpected end at %1").arg(m_token.position));
+    }
+
+    QString text = QString::fromUtf8(m_token.text);
+    return fail(QString("Unexpected '%1' at %2").arg(text).arg(m_token.position));
+}
+
+int xToolsRuleProgram::Compiler::append(int opcode, qint64 operand, int depth)
+{
+    m_depth += depth;
+    if (m_depth > maxStackDepth) {
+        fail(QString("The expression is too complex at %1").arg(m_token.position));
+    }
+
+    m_code->append(Instruction{opcode, operand});
+    return m_code->size() - 1;
+}
+
+void xToolsRuleProgram::Compiler::patch(int index)
+{
+    (*m_code)[index].operand = m_code->size();
+}
+
+bool xToolsRuleProgram::Compiler::isReserved(const QByteArray &name)
+{
+    static const char *names[] = {"len", "sum", "xor", "min", "max", "match", "slice", "dec"};
+    for (const char *reserved : names) {
+        if (name == reserved) {
+            return true;
+        }
+    }
+
+    return fieldFormat(name) != -1;
+}
+
+bool xToolsRuleProgram::Compiler::statement()
+{
+    if (m_token.type == TokenName) {
+        const Token name = m_token;
+        const int position = m_position;
+        next();
+        if (accept("=")) {
+            if (isReserved(name.text)) {
+                return fail(QString("'%1' is reserved").arg(QString::fromUtf8(name.text)));
+            }
+
+            if (!expression()) {
+                return false;
+            }
+
+            int index = m_variables.value(name.text, m_variables.size());
+            if (index >= maxVariables) {
+                return fail(QString("Too many variables at %1").arg(name.position));
+            }
+
+            m_variables.insert(name.text, index);
+            append(OpSet, index, -1);
+            return m_errorString.isEmpty();
+        }
+
+        m_token = name;
+        m_position = position;
+    }
+
+    if (!expression()) {
+        return false;
+    }
+
+    append(OpAssert, 0, -1);
+    return m_errorString.isEmpty();
+}
+
+bool xToolsRuleProgram::Compiler::field(const QByteArray &text, int offset)
+{
+    const QByteArray trimmed = text.trimmed();
+    if (trimmed.startsWith("crc:")) {
+        QList<QByteArray> parts = trimmed.split(':');
+        bool ok = parts.size() == 2 || parts.size() == 3;
+        QMetaEnum algorithms = QMetaEnum::fromType<xToolsCrcInterface::SAKEnumCrcAlgorithm>();
+        int algorithm = ok ? algorithms.keyToValue(parts.at(1).trimmed().constData(), &ok) : -1;
+        if (!ok) {
+            return fail(QString("Unknown crc algorithm at %1").arg(offset));
+        }
+
+        bool bigEndian = true;
+        if (parts.size() == 3) {
+            QByteArray order = parts.at(2).trimmed();
+            if (order != "le" && order != "be") {
+                return fail(QString("The byte order must be le or be at %1").arg(offset));
+            }
+            bigEndian = order == "be";
+        }
+
+        append(OpEmitCrc, algorithm * 2 + (bigEndian ? 1 : 0), 0);
+        return true;
+    }
+
+    setText(text, offset);
+    if (m_token.type == TokenName && m_token.text == "slice") {
+        next();
+        if (!expect("(") || !expression() || !expect(",") || !expression() || !expect(")")) {
+            return false;
+        }
+        append(OpEmitSlice, 0, -2);
+    } else {
+        if (!expression()) {
+            return false;
+        }
+
+        int format = FormatU8;
+        if (accept(":")) {
+            format = m_token.text == "dec" ? int(FormatDec) : fieldFormat(m_token.text);
+            if (m_token.type != TokenName || format == -1) {
+                return fail(QString("Unknown format at %1").arg(m_token.position));
+            }
+            next();
+        }
+        append(OpEmit, format, -1);
+    }
+
+    if (m_token.type != TokenEnd) {
+        return unexpected();
+    }
+
+    return m_errorString.isEmpty();
+}
+
+bool xToolsRuleProgram::Compiler::expression()
+{
+    if (!logicalOr()) {
+        return false;
+    }
+
+    if (!accept("?")) {
+        return true;
+    }
+
+    int elseJump = append(OpJumpIfZero, 0, -1);
+    if (!expression()) {
+        return false;
+    }
+
+    int endJump = append(OpJump, 0, 0);
+    // The branches push one value, only one of them is run.
+    m_depth--;
+    patch(elseJump);
+    if (!expect(":") || !expression()) {
+        return false;
+    }
+
+    patch(endJump);
+    return true;
+}
+
+bool xToolsRuleProgram::Compiler::logicalOr()
+{
+    if (!logicalAnd()) {
+        return false;
+    }
+
+    if (!isSymbol("||")) {
+        return true;
+    }
+
+    QList<int> trueJumps;
+    while (accept("||")) {
+        trueJumps.append(append(OpJumpIfNotZero, 0, -1));
+        if (!logicalAnd()) {
+            return false;
+        }
+    }
+
+    trueJumps.append(append(OpJumpIfNotZero, 0, -1));
+    append(OpPush, 0, 1);
+    int endJump = append(OpJump, 0, 0);
+    for (int jump : trueJumps) {
+        patch(jump);
+    }
+    m_depth--;
+    append(OpPush, 1, 1);
+    patch(endJump);
+    return true;
+}
+
+bool xToolsRuleProgram::Compiler::logicalAnd()
+{
+    if (!comparison()) {
+        return false;
+    }
+
+    if (!isSymbol("&&")) {
+        return true;
+    }
+
+    QList<int> falseJumps;
+    while (accept("&&")) {
+        falseJumps.append(append(OpJumpIfZero, 0, -1));
+        if (!comparison()) {
+            return false;
+        }
+    }
+
+    falseJumps.append(append(OpJumpIfZero, 0, -1));
+    append(OpPush, 1, 1);
+    int endJump = append(OpJump, 0, 0);
+    for (int jump : falseJumps) {
+        patch(jump);
+    }
+    m_depth--;
+    append(OpPush, 0, 1);
+    patch(endJump);
+    return true;
+}
+
+bool xToolsRuleProgram::Compiler::comparison()
+{
+    if (!binary(0)) {
+        return false;
+    }
+
+    struct Operator
+    {
+        const char *symbol;
+        int opcode;
+    };
+    static const Operator operators[] = {{"==", OpEqual},
+                                         {"!=", OpNotEqual},
+                                         {"<", OpLess},
+                                         {"<=", OpLessEqual},
+                                         {">", OpGreater},
+                                         {">=", OpGreaterEqual}};
+    for (const Operator &op : operators) {
+        if (accept(op.symbol)) {
+            if (!binary(0)) {
+                return false;
+            }
+
+            append(op.opcode, 0, -1);
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool xToolsRuleProgram::Compiler::binary(int level)
+{
+    struct Operator
+    {
+        const char *symbol;
+        int opcode;
+        int level;
+    };
+    // The bitwise operators bind tighter than the comparisons, unlike C.
+    static const Operator operators[] = {{"|", OpOr, 0},
+                                         {"^", OpXor, 1},
+                                         {"&", OpAnd, 2},
+                                         {"<<", OpShiftLeft, 3},
+                                         {">>", OpShiftRight, 3},
+                                         {"+", OpAdd, 4},
+                                         {"-", OpSubtract, 4},
+                                         {"*", OpMultiply, 5},
+                                         {"/", OpDivide, 5},
+                                         {"%", OpModulo, 5}};
+    if (level > 5) {
+        return unary();
+    }
+
+    if (!binary(level + 1)) {
+        return false;
+    }
+
+    for (;;) {
+        const Operator *matched = nullptr;
+        for (const Operator &op : operators) {
+            if (op.level == level && isSymbol(op.symbol)) {
+                matched = &op;
+                break;
+            }
+        }
+
+        if (!matched) {
+            return true;
+        }
+
+        next();
+        if (!binary(level + 1)) {
+            return false;
+        }
+        append(matched->opcode, 0, -1);
+    }
+}
+
+// The unary operators bind tighter than the binary ones, -1 + len is (-1) + len.
+bool xToolsRuleProgram::Compiler::unary()
+{
+    if (accept("-")) {
+        if (!unary()) {
+            return false;
+        }
+        append(OpNegate, 0, 0);
+        return true;
+    } else if (accept("!")) {
+        if (!unary()) {
+            return false;
+        }
+        append(OpNot, 0, 0);
+        return true;
+    } else if (accept("~")) {
+        if (!unary()) {
+            return false;
+        }
+        append(OpBitNot, 0, 0);
+        return true;
+    }
+
+    return primary();
+}
+
+bool xToolsRuleProgram::Compiler::primary()
+{
+    if (m_token.type == TokenNumber) {
+        append(OpPush, m_token.number, 1);
+        next();
+        return true;
+    }
+
+    if (accept("(")) {
+        return expression() && expect(")");
+    }
+
+    if (m_token.type != TokenName) {
+        return unexpected();
+    }
+
+    const Token name = m_token;
+    next();
+    if (name.text == "len") {
+        append(OpLength, 0, 1);
+        return true;
+    }
+
+    int format = fieldFormat(name.text);
+    if (format != -1) {
+        if (!expect("[") || !expression() || !expect("]")) {
+            return false;
+        }
+
+        append(OpLoad, format, 0);
+        return true;
+    }
+
+    if (name.text == "match") {
+        return expect("(") && expression() && expect(",") && pattern() && expect(")");
+    }
+
+    const QByteArray functions[] = {"sum", "xor", "min", "max"};
+    const int opcodes[] = {OpSum, OpXorSum, OpMin, OpMax};
+    for (int i = 0; i < 4; i++) {
+        if (name.text == functions[i]) {
+            if (!expect("(") || !expression() || !expect(",") || !expression() || !expect(")")) {
+                return false;
+            }
+
+            append(opcodes[i], 0, -1);
+            return true;
+        }
+    }
+
+    if (name.text == "slice") {
+        return fail(QString("slice() is only valid in the response at %1").arg(name.position));
+    }
+
+    if (!m_variables.contains(name.text)) {
+        QString text = QString::fromUtf8(name.text);
+        return fail(QString("Unknown name '%1' at %2").arg(text).arg(name.position));
+    }
+
+    append(OpGet, m_variables.value(name.text), 1);
+    return true;
+}
+
+bool xToolsRuleProgram::Compiler::pattern()
+{
+    if (m_token.type != TokenString) {
+        return fail(QString("A pattern is expected at %1").arg(m_token.position));
+    }
+
+    QByteArray nibbles;
+    for (char c : m_token.text) {
+        if (isHexDigit(c) || c == '?') {
+            nibbles.append(c);
+        } else if (!isSpace(c)) {
+            return fail(QString("Invalid pattern at %1").arg(m_token.position));
+        }
+    }
+
+    if (nibbles.isEmpty() || nibbles.size() % 2) {
+        return fail(QString("Invalid pattern at %1").arg(m_token.position));
+    }
+
+    QByteArray value(nibbles.size() / 2, '\0');
+    QByteArray mask(nibbles.size() / 2, '\0');
+    for (int i = 0; i < nibbles.size(); i++) {
+        const char c = nibbles.at(i);
+        const int shift = i % 2 ? 0 : 4;
+        if (c != '?') {
+            value[i / 2] = static_cast<char>(value.at(i / 2) | (hexValue(c) << shift));
+            mask[i / 2] = static_cast<char>(mask.at(i / 2) | (0x0f << shift));
+        }
+    }
+
+    append(OpMatch, m_program->m_literals.size(), 0);
+    m_program->m_literals.append(value);
+    m_program->m_literals.append(mask);
+    next();
+    return true;
+}
+
+xToolsRuleProgram::xToolsRuleProgram() {}
+
+bool xToolsRuleProgram::compile(const QString &rule, const QString &response)
+{
+    m_ruleCode.clear();
+    m_responseCode.clear();
+    m_literals.clear();
+
+    Compiler compiler(this);
+    m_isValid = compiler.compileRule(rule.toUtf8());
+    if (!m_isValid) {
+        m_errorString = QString("Rule: ") + compiler.errorString();
+    } else {
+        m_isValid = compiler.compileResponse(response.toUtf8());
+        m_errorString = m_isValid ? QString() : QString("Response: ") + compiler.errorString();
+    }
+
+    if (!m_isValid) {
+        m_ruleCode.clear();
+        m_responseCode.clear();
+        m_literals.clear();
+    }
+
+    return m_isValid;
+}
+
+bool xToolsRuleProgram::isValid() const
+{
+    return m_isValid;
+}
+
+QString xToolsRuleProgram::errorString() const
+{
+    return m_errorString;
+}
+
+bool xToolsRuleProgram::match(const QByteArray &frame, Context &context) const
+{
+    return m_isValid && run(m_ruleCode, frame, context, nullptr);
+}
+
+bool xToolsRuleProgram::response(const QByteArray &frame, Context &context, QByteArray &bytes) const
+{
+    if (!m_isValid) {
+        return false;
+    }
+
+    const int size = bytes.size();
+    if (!run(m_responseCode, frame, context, &bytes)) {
+        bytes.truncate(size);
+        return false;
+    }
+
+    return true;
+}
+
+bool xToolsRuleProgram::run(const QVector<Instruction> &code,
+                            const QByteArray &frame,
+                            Context &context,
+                            QByteArray *bytes) const
+{
+    const uchar *data = reinterpret_cast<const uchar *>(frame.constData());
+    const qint64 size = frame.size();
+    const Instruction *instructions = code.constData();
+    const int count = code.size();
+    qint64 *stack = context.stack;
+    int top = -1;
+
+    for (int pc = 0; pc < count; pc++) {
+        const Instruction &instruction = instructions[pc];
+        switch (instruction.opcode) {
+        case OpPush:
+            stack[++top] = instruction.operand;
+            break;
+        case OpLength:
+            stack[++top] = size;
+            break;
+        case OpLoad: {
+            qint64 offset = stack[top];
+            offset = offset < 0 ? offset + size : offset;
+            const int format = static_cast<int>(instruction.operand);
+            if (offset < 0 || offset + fieldSize(format) > size) {
+                return false;
+            }
+            stack[top] = readField(data + offset, format);
+            break;
+        }
+        case OpGet:
+            stack[++top] = context.variables[instruction.operand];
+            break;
+        case OpSet:
+            context.variables[instruction.operand] = stack[top--];
+            break;
+        case OpAdd:
+            top--;
+            stack[top] = stack[top] + stack[top + 1];
+            break;
+        case OpSubtract:
+            top--;
+            stack[top] = stack[top] - stack[top + 1];
+            break;
+        case OpMultiply:
+            top--;
+            stack[top] = stack[top] * stack[top + 1];
+            break;
+        case OpDivide:
+            top--;
+            if (stack[top + 1] == 0) {
+                return false;
+            }
+            stack[top] = stack[top] / stack[top + 1];
+            break;
+        case OpModulo:
+            top--;
+            if (stack[top + 1] == 0) {
+                return false;
+            }
+            stack[top] = stack[top] % stack[top + 1];
+            break;
+        case OpAnd:
+            top--;
+            stack[top] = stack[top] & stack[top + 1];
+            break;
+        case OpOr:
+            top--;
+            stack[top] = stack[top] | stack[top + 1];
+            break;
+        case OpXor:
+            top--;
+            stack[top] = stack[top] ^ stack[top + 1];
+            break;
+        case OpShiftLeft:
+            top--;
+            stack[top] = static_cast<qint64>(quint64(stack[top]) << (stack[top + 1] & 63));
+            break;
+        case OpShiftRight:
+            top--;
+            stack[top] = stack[top] >> (stack[top + 1] & 63);
+            break;
+        case OpEqual:
+            top--;
+            stack[top] = stack[top] == stack[top + 1];
+            break;
+        case OpNotEqual:
+            top--;
+            stack[top] = stack[top] != stack[top + 1];
+            break;
+        case OpLess:
+            top--;
+            stack[top] = stack[top] < stack[top + 1];
+            break;
+        case OpLessEqual:
+            top--;
+            stack[top] = stack[top] <= stack[top + 1];
+            break;
+        case OpGreater:
+            top--;
+            stack[top] = stack[top] > stack[top + 1];
+            break;
+        case OpGreaterEqual:
+            top--;
+            stack[top] = stack[top] >= stack[top + 1];
+            break;
+        case OpNegate:
+            stack[top] = -stack[top];
+            break;
+        case OpNot:
+            stack[top] = !stack[top];
+            break;
+        case OpBitNot:
+            stack[top] = ~stack[top];
+            break;
+        case OpJump:
+            pc = static_cast<int>(instruction.operand) - 1;
+            break;
+        case OpJumpIfZero:
+            if (stack[top--] == 0) {
+                pc = static_cast<int>(instruction.operand) - 1;
+            }
+            break;
+        case OpJumpIfNotZero:
+            if (stack[top--] != 0) {
+                pc = static_cast<int>(instruction.operand) - 1;
+            }
+            break;
+        case OpAssert:
+            if (stack[top--] == 0) {
+                return false;
+            }
+            break;
+        case OpSum:
+        case OpXorSum: {
+            top--;
+            qint64 begin = stack[top];
+            qint64 end = stack[top + 1];
+            if (!cookRange(begin, end, size)) {
+                return false;
+            }
+
+            quint8 value = 0;
+            for (qint64 i = begin; i < end; i++) {
+                value = instruction.opcode == OpSum ? value + data[i] : value ^ data[i];
+            }
+            stack[top] = value;
+            break;
+        }
+        case OpMin:
+            top--;
+            stack[top] = qMin(stack[top], stack[top + 1]);
+            break;
+        case OpMax:
+            top--;
+            stack[top] = qMax(stack[top], stack[top + 1]);
+            break;
+        case OpMatch: {
+            qint64 offset = stack[top];
+            const QByteArray &value = m_literals.at(instruction.operand);
+            const QByteArray &mask = m_literals.at(instruction.operand + 1);
+            qint64 end = (offset < 0 ? offset + size : offset) + value.size();
+            bool matched = cookRange(offset, end, size);
+            for (int i = 0; matched && i < value.size(); i++) {
+                matched = (data[offset + i] & uchar(mask.at(i))) == uchar(value.at(i));
+            }
+            stack[top] = matched;
+            break;
+        }
+        case OpEmit:
+            writeField(*bytes, stack[top--], static_cast<int>(instruction.operand));
+            break;
+        case OpEmitLiteral:
+            bytes->append(m_literals.at(instruction.operand));
+            break;
+        case OpEmitSlice: {
+            top -= 2;
+            qint64 begin = stack[top + 1];
+            qint64 end = stack[top + 2];
+            if (!cookRange(begin, end, size)) {
+                return false;
+            }
+            bytes->append(frame.constData() + begin, static_cast<int>(end - begin));
+            break;
+        }
+        case OpEmitCrc: {
+            // xIO::CrcAlgorithm is in the order of the compiled names, the bytes are not copied.
+            auto algorithm = static_cast<xIO::CrcAlgorithm>(instruction.operand / 2);
+            const bool bigEndian = instruction.operand % 2;
+            bytes->append(xIO::calculateCrc(*bytes, algorithm, bigEndian));
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,88 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/// A response rule compiled to the bytecode of a small stack machine. The rule is compiled once,
+/// matching a frame does not allocate memory, the scratch memory is a context of the caller.
+///
+/// The rule is a list of statements separated by ';', a frame matches if all expressions of the
+/// rule are not 0, "name = expression" captures a value for the following statements and for the
+/// response, an empty rule matches every frame:
+///     u8[0] == 0x01; u8[1] == 0x03; len == 8; address = u16[2]; count = u16[4]; address < 100
+///
+/// Expressions are 64 bits integers with the operators of C, except that the bitwise operators
+/// bind tighter than the comparisons("u8[1] & 0xf0 == 0x30" tests the masked value):
+///     len                         The length of the frame.
+///     u8[i] i8[i]                 The byte at the offset, negative offsets count from the end.
+///     u16[i] u32[i]               Big endian fields.
+///     u16le[i] u32le[i]           Little endian fields.
+///     sum(a, b) xor(a, b)         The 8 bits sum or xor of the bytes [a, b).
+///     min(a, b) max(a, b)
+///     match(i, "01 03 ?? 0?")     The bytes at the offset, '?' is a wildcard nibble.
+///     c ? a : b
+///
+/// The response is a template of hex bytes("01 03"), quoted text("\"OK\r\n\"") and fields:
+///     {expression}                One byte of the value.
+///     {expression:format}         u8, i8, u16, u16le, u32, u32le or dec(decimal text).
+///     {slice(a, b)}               The bytes [a, b) of the frame.
+///     {crc:CRC_16_MODBUS:le}      The crc of the response bytes before the field, the order is
+///                                 be(default) or le.
+/// A frame that does not match, or a rule or response that reads out of the frame, or divides by
+/// 0, gets no response.
+class xToolsRuleProgram
+{
+public:
+    static const int maxStackDepth = 32;
+    static const int maxVariables = 16;
+
+    /// The scratch memory of a run. A thread reuses one context for all frames and all rules, the
+    /// captured values are kept between match() and response().
+    struct Context
+    {
+        qint64 stack[maxStackDepth];
+        qint64 variables[maxVariables];
+    };
+
+public:
+    xToolsRuleProgram();
+
+    /// Returns false if the rule or the response is invalid, see errorString().
+    bool compile(const QString &rule, const QString &response);
+    bool isValid() const;
+    QString errorString() const;
+
+    bool match(const QByteArray &frame, Context &context) const;
+    /// Append the response of a matched frame to the bytes.
+    bool response(const QByteArray &frame, Context &context, QByteArray &bytes) const;
+
+private:
+    struct Instruction
+    {
+        int opcode;
+        qint64 operand;
+    };
+
+    QVector<Instruction> m_ruleCode;
+    QVector<Instruction> m_responseCode;
+    // The literals of the response, and the values and the masks of the patterns.
+    QVector<QByteArray> m_literals;
+    bool m_isValid{false};
+    QString m_errorString;
+
+private:
+    class Compiler;
+    bool run(const QVector<Instruction> &code,
+             const QByteArray &frame,
+             Context &context,
+             QByteArray *bytes) const;
+};
@@ -0,0 +1,364 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsSegmentCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#ifdef X_TOOLS_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+static const char segmentMagic[8] = {'X', 'T', 'S', 'E', 'G', 'Z', 'I', 'P'};
+static const quint16 segmentVersion = 1;
+static const quint32 maxBlockSize = 64 * 1024 * 1024;
+
+bool xToolsSegmentCodec::isCodecAvailable(int codec)
+{
+#ifdef X_TOOLS_ENABLE_ZSTD
+    if (codec == CodecZstd) {
+        return true;
+    }
+#endif
+
+    return codec == CodecNone || codec == CodecZlib;
+}
+
+int xToolsSegmentCodec::defaultCodec()
+{
+    return isCodecAvailable(CodecZstd) ? CodecZstd : CodecZlib;
+}
+
+QString xToolsSegmentCodec::codecName(int codec)
+{
+    if (codec == CodecZlib) {
+        return QStringLiteral("zlib");
+    } else if (codec == CodecZstd) {
+        return QStringLiteral("zstd");
+    }
+
+    return QStringLiteral("none");
+}
+
+QByteArray xToolsSegmentCodec::fileHeader()
+{
+    QByteArray header(fileHeaderSize, '\0');
+    memcpy(header.data(), segmentMagic, sizeof(segmentMagic));
+    qToLittleEndian<quint16>(segmentVersion, header.data() + 8);
+    return header;
+}
+
+bool xToolsSegmentCodec::isSegmentFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    return isSegmentHeader(file.read(fileHeaderSize));
+}
+
+bool xToolsSegmentCodec::isSegmentHeader(const QByteArray &header)
+{
+    return header.size() >= int(sizeof(segmentMagic))
+           && memcmp(header.constData(), segmentMagic, sizeof(segmentMagic)) == 0;
+}
+
+QByteArray xToolsSegmentCodec::encodeBlock(const QByteArray &bytes, int codec)
+{
+    QByteArray compressed;
+    if (codec == CodecZlib) {
+        // qCompress() prefixes the raw size, it is in the block header already.
+        compressed = qCompress(bytes).mid(4);
+#ifdef X_TOOLS_ENABLE_ZSTD
+    } else if (codec == CodecZstd) {
+        compressed.resize(static_cast<int>(ZSTD_compressBound(bytes.size())));
+        size_t ret = ZSTD_compress(compressed.data(),
+                                   compressed.size(),
+                                   bytes.constData(),
+                                   bytes.size(),
+                                   3);
+        if (ZSTD_isError(ret)) {
+            codec = CodecNone;
+        } else {
+            compressed.resize(static_cast<int>(ret));
+        }
+#endif
+    } else {
+        codec = CodecNone;
+    }
+
+    // Incompressible data is stored as it is.
+    if (codec == CodecNone || compressed.size() >= bytes.size()) {
+        codec = CodecNone;
+        compressed = bytes;
+    }
+
+    QByteArray block(blockHeaderSize, '\0');
+    qToLittleEndian<quint32>(bytes.size(), block.data());
+    qToLittleEndian<quint32>(compressed.size(), block.data() + 4);
+    block[8] = static_cast<char>(codec);
+    block.append(compressed);
+    return block;
+}
+
+QByteArray xToolsSegmentCodec::decodeBlock(const char *data,
+                                           int compressedSize,
+                                           int rawSize,
+                                           int codec)
+{
+    if (codec == CodecNone) {
+        return QByteArray(data, compressedSize);
+    } else if (codec == CodecZlib) {
+        QByteArray bytes(4 + compressedSize, '\0');
+        qToBigEndian<quint32>(rawSize, bytes.data());
+        memcpy(bytes.data() + 4, data, compressedSize);
+        return qUncompress(bytes);
+#ifdef X_TOOLS_ENABLE_ZSTD
+    } else if (codec == CodecZstd) {
+        QByteArray bytes(rawSize, '\0');
+        size_t ret = ZSTD_decompress(bytes.data(), rawSize, data, compressedSize);
+        if (ZSTD_isError(ret) || ret != static_cast<size_t>(rawSize)) {
+            return QByteArray();
+        }
+        return bytes;
+#endif
+    }
+
+    return QByteArray();
+}
+
+bool xToolsSegmentCodec::compressFile(const QString &fileName,
+                                      const QString &segmentFileName,
+                                      int codec,
+                                      int blockSize,
+                                      qint64 *compressionTime)
+{
+    QFile in(fileName);
+    QFile out(segmentFileName);
+    if (!in.open(QFile::ReadOnly) || !out.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    if (out.write(fileHeader()) != fileHeaderSize) {
+        return false;
+    }
+
+    QElapsedTimer elapsedTimer;
+    while (!in.atEnd()) {
+        QByteArray bytes = in.read(blockSize);
+        if (bytes.isEmpty()) {
+            return false;
+        }
+
+        elapsedTimer.start();
+        QByteArray block = encodeBlock(bytes, codec);
+        if (compressionTime) {
+            *compressionTime += elapsedTimer.nsecsElapsed();
+        }
+
+        if (out.write(block) != block.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool xToolsSegmentCodec::decompressFile(const QString &segmentFileName, const QString &fileName)
+{
+    xToolsSegmentDevice in(segmentFileName);
+    QFile out(fileName);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    while (!in.atEnd()) {
+        QByteArray bytes = in.read(4 * 1024 * 1024);
+        if (bytes.isEmpty() || out.write(bytes) != bytes.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**************************************************************************************************/
+xToolsSegmentDevice::xToolsSegmentDevice(const QString &fileName, QObject *parent)
+    : QIODevice(parent)
+    , m_file(fileName)
+{}
+
+xToolsSegmentDevice::~xToolsSegmentDevice()
+{
+    close();
+}
+
+bool xToolsSegmentDevice::open(OpenMode mode)
+{
+    if (mode & (QIODevice::WriteOnly | QIODevice::Append)) {
+        setErrorString(QStringLiteral("The segment device is read only."));
+        return false;
+    }
+
+    if (!m_file.open(QFile::ReadOnly)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    if (!xToolsSegmentCodec::isSegmentHeader(m_file.read(xToolsSegmentCodec::fileHeaderSize))) {
+        setErrorString(QStringLiteral("The file is not a compressed segment."));
+        m_file.close();
+        return false;
+    }
+
+    // Only the block headers are read, the blocks are decoded when they are read.
+    m_blocks.clear();
+    m_size = 0;
+    const qint64 fileSize = m_file.size();
+    qint64 offset = xToolsSegmentCodec::fileHeaderSize;
+    char header[xToolsSegmentCodec::blockHeaderSize];
+    while (offset + xToolsSegmentCodec::blockHeaderSize <= fileSize) {
+        m_file.seek(offset);
+        if (m_file.read(header, sizeof(header)) != sizeof(header)) {
+            break;
+        }
+
+        Block block;
+        block.rawOffset = m_size;
+        block.fileOffset = offset + xToolsSegmentCodec::blockHeaderSize;
+        block.rawSize = qFromLittleEndian<quint32>(header);
+        block.compressedSize = qFromLittleEndian<quint32>(header + 4);
+        block.codec = static_cast<uchar>(header[8]);
+        if (block.rawSize > maxBlockSize || block.compressedSize > maxBlockSize
+            || block.fileOffset + block.compressedSize > fileSize) {
+            break;
+        }
+
+        m_blocks.append(block);
+        m_size += block.rawSize;
+        offset = block.fileOffset + block.compressedSize;
+    }
+
+    m_position = 0;
+    m_currentBlock = -1;
+    m_currentData.clear();
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void xToolsSegmentDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    QIODevice::close();
+    m_file.close();
+    m_blocks.clear();
+    m_currentBlock = -1;
+    m_currentData.clear();
+    m_size = 0;
+    m_position = 0;
+}
+
+bool xToolsSegmentDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 xToolsSegmentDevice::size() const
+{
+    return m_size;
+}
+
+bool xToolsSegmentDevice::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_size) {
+        return false;
+    }
+
+    QIODevice::seek(pos);
+    m_position = pos;
+    return true;
+}
+
+bool xToolsSegmentDevice::atEnd() const
+{
+    return m_position >= m_size;
+}
+
+qint64 xToolsSegmentDevice::compressedSize() const
+{
+    return m_file.size();
+}
+
+qint64 xToolsSegmentDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 total = 0;
+    while (total < maxSize && m_position < m_size) {
+        auto cmp = [](qint64 value, const Block &block) { return value < block.rawOffset; };
+        auto it = std::upper_bound(m_blocks.constBegin(), m_blocks.constEnd(), m_position, cmp);
+        int index = static_cast<int>(it - m_blocks.constBegin()) - 1;
+        if (!loadBlock(index)) {
+            return total > 0 ? total : -1;
+        }
+
+        const Block &block = m_blocks.at(index);
+        qint64 offset = m_position - block.rawOffset;
+        qint64 length = qMin<qint64>(maxSize - total, block.rawSize - offset);
+        memcpy(data + total, m_currentData.constData() + offset, length);
+        total += length;
+        m_position += length;
+    }
+
+    return total;
+}
+
+qint64 xToolsSegmentDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+bool xToolsSegmentDevice::loadBlock(int index)
+{
+    if (index < 0 || index >= m_blocks.count()) {
+        return false;
+    }
+
+    if (index == m_currentBlock) {
+        return true;
+    }
+
+    const Block &block = m_blocks.at(index);
+    m_file.seek(block.fileOffset);
+    QByteArray compressed = m_file.read(block.compressedSize);
+    if (compressed.size() != static_cast<int>(block.compressedSize)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_currentData = xToolsSegmentCodec::decodeBlock(compressed.constData(),
+                                                    compressed.size(),
+                                                    static_cast<int>(block.rawSize),
+                                                    block.codec);
+    if (m_currentData.size() != static_cast<int>(block.rawSize)) {
+        setErrorString(QStringLiteral("Failed to decode the block, the codec is not supported "
+                                      "or the block is corrupted."));
+        m_currentBlock = -1;
+        return false;
+    }
+
+    m_currentBlock = index;
+    return true;
+}
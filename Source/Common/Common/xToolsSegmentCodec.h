@@ -0,0 +1,95 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QVector>
+
+/// A compressed segment starts with a 16 bytes header(magic and version), followed by independent
+/// blocks. Every block can be decoded without the others, so a segment can be read randomly and a
+/// segment that is not closed properly loses the torn block only:
+///
+/// | raw size(4) | compressed size(4) | codec(1) | reserved(3) | compressed data |
+///
+/// All fields are little endian. zstd is used if it's found when configuring the project,
+/// otherwise blocks are compressed by qCompress().
+class xToolsSegmentCodec
+{
+public:
+    enum Codec { CodecNone, CodecZlib, CodecZstd };
+
+    static const int fileHeaderSize = 16;
+    static const int blockHeaderSize = 12;
+
+    static bool isCodecAvailable(int codec);
+    static int defaultCodec();
+    static QString codecName(int codec);
+
+    static QByteArray fileHeader();
+    static bool isSegmentFile(const QString &fileName);
+    static bool isSegmentHeader(const QByteArray &header);
+
+    /// Encode the bytes to a block, the header of the block is included.
+    static QByteArray encodeBlock(const QByteArray &bytes, int codec);
+    static QByteArray decodeBlock(const char *data, int compressedSize, int rawSize, int codec);
+
+    /// Compress a closed file to a segment, every block holds blockSize raw bytes at most. The
+    /// nanoseconds spent on compressing are added to compressionTime if it's not null.
+    static bool compressFile(const QString &fileName,
+                             const QString &segmentFileName,
+                             int codec,
+                             int blockSize = 1024 * 1024,
+                             qint64 *compressionTime = nullptr);
+    static bool decompressFile(const QString &segmentFileName, const QString &fileName);
+};
+
+/// A read only device that decompresses a segment on demand, only the block that is being read is
+/// held in the memory. It can be used everywhere a QFile is read.
+class xToolsSegmentDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit xToolsSegmentDevice(const QString &fileName, QObject *parent = nullptr);
+    ~xToolsSegmentDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+    bool atEnd() const override;
+
+    qint64 compressedSize() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    struct Block
+    {
+        qint64 rawOffset;
+        qint64 fileOffset;
+        quint32 rawSize;
+        quint32 compressedSize;
+        int codec;
+    };
+
+    QFile m_file;
+    QVector<Block> m_blocks;
+    qint64 m_size{0};
+    qint64 m_position{0};
+    int m_currentBlock{-1};
+    QByteArray m_currentData;
+
+private:
+    bool loadBlock(int index);
+};
@@ -0,0 +1,123 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsTimerWheel.h"
+
+#include <algorithm>
+
+xToolsTimerWheel::xToolsTimerWheel(qint64 now)
+    : m_currentTick{now}
+{}
+
+void xToolsTimerWheel::reset(qint64 now)
+{
+    for (int level = 0; level < levelCount; level++) {
+        for (int slot = 0; slot < slotCount; slot++) {
+            m_slots[level][slot].clear();
+        }
+    }
+
+    m_currentTick = now;
+    m_size = 0;
+}
+
+void xToolsTimerWheel::add(qint64 delay, const QByteArray &bytes)
+{
+    // The current tick has been expired already, the earliest deadline is the next tick.
+    Entry entry{m_currentTick + qBound<qint64>(1, delay, maxDelay), m_sequence++, bytes};
+    insert(entry);
+    m_size++;
+}
+
+void xToolsTimerWheel::advance(qint64 now, QList<QByteArray> &expired)
+{
+    if (m_size == 0) {
+        m_currentTick = qMax(m_currentTick, now);
+        return;
+    }
+
+    while (m_currentTick < now) {
+        m_currentTick++;
+
+        // When a level wraps around, the next slot of the level above is moved down. The upper
+        // levels are cascaded first, their entries may land in the slots cascaded next.
+        int level = 1;
+        while (level < levelCount
+               && ((m_currentTick >> (slotBits * (level - 1))) & (slotCount - 1)) == 0) {
+            level++;
+        }
+        for (int i = level - 1; i >= 1; i--) {
+            cascade(i);
+        }
+
+        expire(m_slots[0][m_currentTick & (slotCount - 1)], expired);
+        if (m_size == 0) {
+            m_currentTick = now;
+            break;
+        }
+    }
+}
+
+int xToolsTimerWheel::size() const
+{
+    return m_size;
+}
+
+bool xToolsTimerWheel::isEmpty() const
+{
+    return m_size == 0;
+}
+
+qint64 xToolsTimerWheel::currentTick() const
+{
+    return m_currentTick;
+}
+
+void xToolsTimerWheel::insert(Entry &entry)
+{
+    const qint64 delta = entry.deadline - m_currentTick;
+    int level = 0;
+    while (level < levelCount - 1 && delta >= (1ll << (slotBits * (level + 1)))) {
+        level++;
+    }
+
+    const int slot = (entry.deadline >> (slotBits * level)) & (slotCount - 1);
+    m_slots[level][slot].push_back(std::move(entry));
+}
+
+void xToolsTimerWheel::cascade(int level)
+{
+    const int slot = (m_currentTick >> (slotBits * level)) & (slotCount - 1);
+    m_cascading.swap(m_slots[level][slot]);
+    for (Entry &entry : m_cascading) {
+        insert(entry);
+    }
+    m_cascading.clear();
+}
+
+void xToolsTimerWheel::expire(std::vector<Entry> &slot, QList<QByteArray> &expired)
+{
+    if (slot.empty()) {
+        return;
+    }
+
+    // All entries of a slot of the first level have the same deadline, the entries cascaded from
+    // the upper levels may be behind the entries added later.
+    m_expired.swap(slot);
+    auto isEarlier = [](const Entry &a, const Entry &b) { return a.sequence < b.sequence; };
+    if (!std::is_sorted(m_expired.begin(), m_expired.end(), isEarlier)) {
+        std::sort(m_expired.begin(), m_expired.end(), isEarlier);
+    }
+
+    for (const Entry &entry : m_expired) {
+        expired.append(entry.bytes);
+    }
+
+    m_size -= static_cast<int>(m_expired.size());
+    m_expired.clear();
+}
@@ -0,0 +1,62 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <vector>
+#include <QByteArray>
+#include <QList>
+
+/// A hierarchical timer wheel of delayed byte arrays. Adding and expiring an entry cost O(1), an
+/// entry is moved down a level at most once per level. The slots keep their capacity when they are
+/// emptied, so the memory stays flat however many entries are pending. Entries with the same
+/// deadline expire in the order they were added.
+class xToolsTimerWheel
+{
+public:
+    static const int slotBits = 6;
+    static const int slotCount = 1 << slotBits;
+    static const int levelCount = 4;
+    /// About 4.6 hours with 1 ms ticks, longer delays are clamped.
+    static const qint64 maxDelay = (1ll << (slotBits * levelCount)) - 1;
+
+public:
+    explicit xToolsTimerWheel(qint64 now = 0);
+
+    /// Remove all entries and set the current tick.
+    void reset(qint64 now);
+    /// The bytes expire delay ticks after the current tick, a delay <= 0 expires at the next
+    /// advance().
+    void add(qint64 delay, const QByteArray &bytes);
+    /// Advance the wheel to the tick, the expired bytes are appended in the order of the deadlines.
+    void advance(qint64 now, QList<QByteArray> &expired);
+
+    int size() const;
+    bool isEmpty() const;
+    qint64 currentTick() const;
+
+private:
+    struct Entry
+    {
+        qint64 deadline;
+        quint64 sequence;
+        QByteArray bytes;
+    };
+
+    std::vector<Entry> m_slots[levelCount][slotCount];
+    std::vector<Entry> m_cascading;
+    std::vector<Entry> m_expired;
+    qint64 m_currentTick;
+    quint64 m_sequence{0};
+    int m_size{0};
+
+private:
+    void insert(Entry &entry);
+    void cascade(int level);
+    void expire(std::vector<Entry> &slot, QList<QByteArray> &expired);
+};
@@ -0,0 +1,129 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsPipelineHealthUi.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStandardPaths>
+#include <QVBoxLayout>
+
+#include "xToolsProfiler.h"
+
+xToolsPipelineHealthUi::xToolsPipelineHealthUi(QWidget *parent)
+    : QWidget{parent}
+    , m_tableWidget{new QTableWidget(this)}
+    , m_tracingCheckBox{new QCheckBox(tr("Record trace"), this)}
+    , m_traceLabel{new QLabel(this)}
+    , m_refreshTimer{new QTimer(this)}
+{
+    setWindowTitle(tr("Pipeline Health"));
+    resize(800, 360);
+
+    QStringList headers;
+    headers << tr("Stage") << tr("Calls") << tr("Mean(us)") << tr("Max(us)") << tr("Queue")
+            << tr("Max Queue") << tr("Dropped") << tr("Wake-ups");
+    m_tableWidget->setColumnCount(headers.count());
+    m_tableWidget->setHorizontalHeaderLabels(headers);
+    m_tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_tableWidget->verticalHeader()->hide();
+    m_tableWidget->horizontalHeader()->setStretchLastSection(true);
+
+    auto *resetButton = new QPushButton(tr("Reset"), this);
+    auto *exportButton = new QPushButton(tr("Export Trace"), this);
+    auto *bottomLayout = new QHBoxLayout();
+    bottomLayout->addWidget(m_tracingCheckBox);
+    bottomLayout->addWidget(m_traceLabel);
+    bottomLayout->addStretch();
+    bottomLayout->addWidget(resetButton);
+    bottomLayout->addWidget(exportButton);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(m_tableWidget);
+    layout->addLayout(bottomLayout);
+
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        xToolsProfiler::instance()->reset();
+        refresh();
+    });
+    connect(exportButton,
+            &QPushButton::clicked,
+            this,
+            &xToolsPipelineHealthUi::onExportButtonClicked);
+    connect(m_tracingCheckBox, &QCheckBox::clicked, this, [this](bool checked) {
+        xToolsProfiler::instance()->setTracing(checked);
+        refresh();
+    });
+
+    m_refreshTimer->setInterval(500);
+    connect(m_refreshTimer, &QTimer::timeout, this, &xToolsPipelineHealthUi::refresh);
+}
+
+void xToolsPipelineHealthUi::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    m_refreshTimer->start();
+}
+
+void xToolsPipelineHealthUi::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_refreshTimer->stop();
+}
+
+void xToolsPipelineHealthUi::refresh()
+{
+    QList<xToolsProfiler::StageStatistics> list = xToolsProfiler::instance()->statistics();
+    m_tableWidget->setRowCount(list.count());
+    for (int row = 0; row < list.count(); row++) {
+        const xToolsProfiler::StageStatistics &ctx = list.at(row);
+        double meanTime = ctx.calls > 0 ? ctx.totalTime / 1000.0 / ctx.calls : 0;
+        QStringList texts;
+        texts << ctx.name << QString::number(ctx.calls) << QString::number(meanTime, 'f', 1)
+              << QString::number(ctx.maxTime / 1000.0, 'f', 1) << QString::number(ctx.queueDepth)
+              << QString::number(ctx.maxQueueDepth) << QString::number(ctx.dropped)
+              << QString::number(ctx.wakeups);
+        for (int column = 0; column < texts.count(); column++) {
+            QTableWidgetItem *item = m_tableWidget->item(row, column);
+            if (!item) {
+                item = new QTableWidgetItem();
+                m_tableWidget->setItem(row, column, item);
+            }
+            item->setText(texts.at(column));
+        }
+    }
+
+    xToolsProfiler *profiler = xToolsProfiler::instance();
+    if (profiler->isTracing()) {
+        qint64 count = profiler->traceEventCount();
+        m_traceLabel->setText(tr("%1/%2 events").arg(count).arg(xToolsProfiler::maxTraceEvents));
+    } else {
+        m_traceLabel->clear();
+    }
+}
+
+void xToolsPipelineHealthUi::onExportButtonClicked()
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Trace"),
+                                                    path + "/xTools-trace.json",
+                                                    tr("Trace Event File(*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    if (!xToolsProfiler::instance()->exportChromeTrace(fileName)) {
+        QMessageBox::warning(this, tr("Export Failed"), tr("Failed to write %1.").arg(fileName));
+    }
+}
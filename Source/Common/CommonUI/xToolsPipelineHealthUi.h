@@ -0,0 +1,37 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QCheckBox>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+
+/// The live view of the pipeline profiler, the stages are refreshed while the widget is visible.
+class xToolsPipelineHealthUi : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit xToolsPipelineHealthUi(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    QTableWidget *m_tableWidget;
+    QCheckBox *m_tracingCheckBox;
+    QLabel *m_traceLabel;
+    QTimer *m_refreshTimer;
+
+private:
+    void refresh();
+    void onExportButtonClicked();
+};
@@ -56,6 +56,11 @@ void AbstractIO::load(const QVariantMap &data)
     emit isEnableChanged();
 }
 
+qint64 AbstractIO::pendingBytes()
+{
+    return 0;
+}
+
 bool AbstractIO::isWorking()
 {
     return m_isWorking;
@@ -71,3 +76,8 @@ void AbstractIO::setIsEnable(bool enable)
     m_enable = enable;
     emit isEnableChanged();
 }
+
+xToolsProfiler::Stage *AbstractIO::profilerStage()
+{
+    return xToolsProfiler::instance()->objectStage(this, m_profilerStage);
+}
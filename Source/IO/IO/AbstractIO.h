@@ -13,6 +13,8 @@
 #include <QThread>
 #include <QVariantMap>
 
+#include "xToolsProfiler.h"
+
 class AbstractIO : public QThread
 {
     Q_OBJECT
@@ -22,6 +24,9 @@ public:
     explicit AbstractIO(QObject *parent = Q_NULLPTR);
     virtual ~AbstractIO();
     virtual void inputBytes(const QByteArray &bytes) = 0;
+    /// The bytes passed to inputBytes() that are not processed yet, a producer that is faster
+    /// than the io(a replayer in fast mode) waits while there are too many of them.
+    virtual qint64 pendingBytes();
 
     virtual QVariantMap save() const;
     virtual void load(const QVariantMap &data);
@@ -35,11 +40,16 @@ public:
     bool isWorking();
     bool isEnable();
     void setIsEnable(bool enable);
+    /// The stage of the pipeline profiler, every instance has its own stage.
+    xToolsProfiler::Stage *profilerStage();
 
 protected:
     std::atomic_bool m_isWorking{false};
     std::atomic_bool m_enable{true};
 
+private:
+    std::atomic<xToolsProfiler::Stage *> m_profilerStage{nullptr};
+
 signals:
     void isWorkingChanged();
     void isEnableChanged();
@@ -36,9 +36,19 @@ void Communication::closeDevice()
 
 void Communication::inputBytes(const QByteArray &bytes)
 {
+    // The bytes are dropped if the device is not opened, they are not pending.
+    if (isRunning()) {
+        m_pendingBytes += bytes.size();
+    }
+
     emit invokeWriteBytes(bytes);
 }
 
+qint64 Communication::pendingBytes()
+{
+    return m_pendingBytes.load();
+}
+
 void Communication::setParameters(const QVariantMap &parameters)
 {
     m_parametersMutex.lock();
@@ -56,11 +66,14 @@ void Communication::run()
 
     connect(this, &Communication::invokeWriteBytes, m_deviceObj, [this](const QByteArray &bytes) {
         writeBytes(bytes);
+        m_pendingBytes -= bytes.size();
     });
 
     emit opened();
     exec();
 
+    // The bytes that are still queued are dropped with the device.
+    m_pendingBytes.store(0);
     m_deviceObj = nullptr;
     deinitDevice();
     emit closed();
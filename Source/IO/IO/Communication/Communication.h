@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QMutex>
 #include <QThread>
 #include <QVariantMap>
@@ -25,6 +26,7 @@ public:
     void closeDevice();
 
     void inputBytes(const QByteArray &bytes) override;
+    qint64 pendingBytes() override;
 
     virtual void setParameters(const QVariantMap &parameters);
     virtual QObject *initDevice() { return nullptr; };
@@ -47,6 +49,7 @@ protected:
 
 private:
     QObject *m_deviceObj{nullptr};
+    std::atomic<qint64> m_pendingBytes{0}; // Queued to the device thread, not written yet.
 
 private:
     Q_SIGNAL void invokeWriteBytes(const QByteArray &bytes);
@@ -8,11 +8,78 @@
  **************************************************************************************************/
 #include "SocketServer.h"
 
+#include <QDateTime>
+
+#include "xToolsMetricsServer.h"
+
 SocketServer::SocketServer(QObject *parent)
     : Socket(parent)
-{}
+{
+    // The signals are emitted in the thread of the device, the statistics are updated there.
+    connect(
+        this,
+        &SocketServer::bytesRead,
+        this,
+        [this](const QByteArray &bytes, const QString &from) {
+            updateClientStatistics(from, bytes.size(), true);
+        },
+        Qt::DirectConnection);
+    connect(
+        this,
+        &SocketServer::bytesWritten,
+        this,
+        [this](const QByteArray &bytes, const QString &to) {
+            updateClientStatistics(to, bytes.size(), false);
+        },
+        Qt::DirectConnection);
 
-SocketServer::~SocketServer() {}
+    m_metricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            const QString server = profilerStage()->name();
+            const QList<ClientStatistics> statistics = clientStatistics();
+            xToolsMetricsServer::addGauge(samples,
+                                          "xtools_socket_server_clients",
+                                          "Clients connected to the server.",
+                                          {qMakePair(QString("server"), server)},
+                                          statistics.length());
+
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            for (const auto &client : statistics) {
+                xToolsMetricsServer::Labels labels{qMakePair(QString("server"), server),
+                                                   qMakePair(QString("client"), client.flag)};
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_socket_client_rx_bytes",
+                                                "Bytes read from the client.",
+                                                labels,
+                                                client.rxBytes);
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_socket_client_rx_frames",
+                                                "Frames read from the client.",
+                                                labels,
+                                                client.rxFrames);
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_socket_client_tx_bytes",
+                                                "Bytes written to the client.",
+                                                labels,
+                                                client.txBytes);
+                xToolsMetricsServer::addCounter(samples,
+                                                "xtools_socket_client_tx_frames",
+                                                "Frames written to the client.",
+                                                labels,
+                                                client.txFrames);
+                xToolsMetricsServer::addGauge(samples,
+                                              "xtools_socket_client_connected_seconds",
+                                              "Seconds since the client is connected.",
+                                              labels,
+                                              (now - client.connectedTime) / 1000.0);
+            }
+        });
+}
+
+SocketServer::~SocketServer()
+{
+    xToolsMetricsServer::instance()->removeCollector(m_metricsCollector);
+}
 
 QStringList SocketServer::clients() const
 {
@@ -37,12 +104,27 @@ void SocketServer::setCurrentClientFlag(const QString &flag)
     m_currentClientMutex.unlock();
 }
 
+QList<SocketServer::ClientStatistics> SocketServer::clientStatistics() const
+{
+    m_clientsMutex.lock();
+    QList<ClientStatistics> statistics;
+    for (const QString &flag : m_clients) {
+        statistics.append(m_clientStatistics.value(flag));
+    }
+    m_clientsMutex.unlock();
+    return statistics;
+}
+
 void SocketServer::addClient(const QString &flag)
 {
     bool changed = false;
     m_clientsMutex.lock();
     if (!m_clients.contains(flag)) {
         m_clients.append(flag);
+        ClientStatistics statistics;
+        statistics.flag = flag;
+        statistics.connectedTime = QDateTime::currentMSecsSinceEpoch();
+        m_clientStatistics.insert(flag, statistics);
         changed = true;
     }
     m_clientsMutex.unlock();
@@ -58,6 +140,7 @@ void SocketServer::removeClient(const QString &flag)
     m_clientsMutex.lock();
     if (m_clients.contains(flag)) {
         m_clients.removeAll(flag);
+        m_clientStatistics.remove(flag);
         changed = true;
     }
     m_clientsMutex.unlock();
@@ -71,6 +154,29 @@ void SocketServer::clearClients()
 {
     m_clientsMutex.lock();
     m_clients.clear();
+    m_clientStatistics.clear();
     m_clientsMutex.unlock();
     emit clientsChanged(SocketPrivateSignal{});
 }
+
+void SocketServer::updateClientStatistics(const QString &flag, qint64 bytes, bool isRx)
+{
+    // The web socket server appends the channel to the flag, such as "[T]".
+    QString cookedFlag = flag;
+    if (cookedFlag.endsWith(']') && cookedFlag.contains('[')) {
+        cookedFlag = cookedFlag.left(cookedFlag.lastIndexOf('['));
+    }
+
+    m_clientsMutex.lock();
+    auto it = m_clientStatistics.find(cookedFlag);
+    if (it != m_clientStatistics.end()) {
+        if (isRx) {
+            it->rxBytes += bytes;
+            it->rxFrames += 1;
+        } else {
+            it->txBytes += bytes;
+            it->txFrames += 1;
+        }
+    }
+    m_clientsMutex.unlock();
+}
@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QHash>
 #include <QMutex>
 
 #include "Socket.h"
@@ -15,6 +16,17 @@
 class SocketServer : public Socket
 {
     Q_OBJECT
+public:
+    struct ClientStatistics
+    {
+        QString flag;
+        qint64 connectedTime{0}; // ms since epoch
+        qint64 rxBytes{0};
+        qint64 rxFrames{0};
+        qint64 txBytes{0};
+        qint64 txFrames{0};
+    };
+
 public:
     explicit SocketServer(QObject *parent = nullptr);
     ~SocketServer() override;
@@ -24,6 +36,8 @@ public:
     QStringList clients() const;
     QString currentClientFlag() const;
     void setCurrentClientFlag(const QString &flag);
+    /// The statistics of the connected clients.
+    QList<ClientStatistics> clientStatistics() const;
 
 signals:
     void clientsChanged(const SocketPrivateSignal &);
@@ -35,7 +49,12 @@ protected:
 
 private:
     QStringList m_clients;
+    QHash<QString, ClientStatistics> m_clientStatistics;
     mutable QMutex m_clientsMutex;
     QString m_currentClientFlag;
     mutable QMutex m_currentClientMutex;
+    int m_metricsCollector;
+
+private:
+    void updateClientStatistics(const QString &flag, qint64 bytes, bool isRx);
 };
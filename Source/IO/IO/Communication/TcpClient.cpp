@@ -18,6 +18,9 @@ QObject *TcpClient::initDevice()
 {
     m_tcpSocket = new QTcpSocket();
     connect(m_tcpSocket, &QTcpSocket::readyRead, m_tcpSocket, [this]() { readBytesFromDevice(); });
+    connect(m_tcpSocket, &QTcpSocket::bytesWritten, m_tcpSocket, [this]() {
+        m_bytesToWrite.store(m_tcpSocket->bytesToWrite());
+    });
     connect(m_tcpSocket, &QTcpSocket::disconnected, m_tcpSocket, [this]() {
 #if 0
         emit errorOccurred("Disconnected!");
@@ -56,11 +59,13 @@ void TcpClient::deinitDevice()
     m_tcpSocket->close();
     m_tcpSocket->deleteLater();
     m_tcpSocket = nullptr;
+    m_bytesToWrite.store(0);
 }
 
 void TcpClient::writeBytes(const QByteArray &bytes)
 {
     qint64 ret = m_tcpSocket->write(bytes);
+    m_bytesToWrite.store(m_tcpSocket->bytesToWrite());
     if (ret == bytes.length()) {
         emit bytesWritten(bytes, makeFlag(m_serverAddress, m_serverPort));
     } else {
@@ -68,6 +73,11 @@ void TcpClient::writeBytes(const QByteArray &bytes)
     }
 }
 
+qint64 TcpClient::pendingBytes()
+{
+    return Communication::pendingBytes() + m_bytesToWrite.load();
+}
+
 void TcpClient::readBytesFromDevice()
 {
     QByteArray bytes = m_tcpSocket->readAll();
@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QTcpSocket>
 
 #include "SocketClient.h"
@@ -22,9 +23,12 @@ public:
     QObject *initDevice() override;
     void deinitDevice() override;
     void writeBytes(const QByteArray &bytes) override;
+    /// The socket buffers the written bytes without a limit, they are pending too.
+    qint64 pendingBytes() override;
 
 private:
     QTcpSocket *m_tcpSocket{nullptr};
+    std::atomic<qint64> m_bytesToWrite{0};
 
 private:
     void readBytesFromDevice();
@@ -63,11 +63,16 @@ void WebSocketClient::deinitDevice()
 
 void WebSocketClient::writeBytes(const QByteArray &bytes)
 {
-    if (m_channel == static_cast<int>(xIO::WebSocketDataChannel::Text))
-        m_webSocket->sendTextMessage(QString::fromUtf8(bytes));
-    else if (m_channel == static_cast<int>(xIO::WebSocketDataChannel::Binary))
-        m_webSocket->sendBinaryMessage(bytes);
-    m_webSocket->sendTextMessage(QString::fromUtf8(bytes));
+    QString flag = makeFlag(m_serverAddress, m_serverPort);
+    if (m_channel == static_cast<int>(xIO::WebSocketDataChannel::Binary)) {
+        if (m_webSocket->sendBinaryMessage(bytes) > 0) {
+            emit bytesWritten(bytes, flag + "[B]");
+        }
+    } else {
+        if (m_webSocket->sendTextMessage(QString::fromUtf8(bytes)) > 0) {
+            emit bytesWritten(bytes, flag + "[T]");
+        }
+    }
 }
 
 void WebSocketClient::onTextMessageReceived(const QString &message)
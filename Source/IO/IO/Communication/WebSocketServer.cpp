@@ -95,10 +95,12 @@ void WebSocketServer::writeBytes(QWebSocket *socket, const QByteArray &bytes)
 {
     if (m_channel == static_cast<int>(xIO::WebSocketDataChannel::Binary)) {
         socket->sendBinaryMessage(bytes);
-        emit bytesRead(bytes,
-                       makeFlag(socket->peerAddress().toString(), socket->peerPort()) + "[B]");
+        emit bytesWritten(bytes,
+                          makeFlag(socket->peerAddress().toString(), socket->peerPort()) + "[B]");
     } else if (m_channel == static_cast<int>(xIO::WebSocketDataChannel::Text)) {
         socket->sendTextMessage(QString::fromUtf8(bytes));
+        emit bytesWritten(bytes,
+                          makeFlag(socket->peerAddress().toString(), socket->peerPort()) + "[T]");
     }
 }
 
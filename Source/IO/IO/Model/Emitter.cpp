@@ -64,18 +64,25 @@ bool Emitter::insertRows(int row, int count, const QModelIndex &parent)
     Data ctx;
     EmitterItem item;
     item.data = ctx;
-    item.elapsedTime = 0;
+    mItemsMutex.lock();
     for (int i = 0; i < count; i++) {
+        item.id = mNextItemId++;
         mItems.insert(row, item);
     }
+    mItemsMutex.unlock();
 
+    emit itemsChanged();
     return true;
 }
 
 bool Emitter::removeRows(int row, int count, const QModelIndex &parent)
 {
     Q_UNUSED(parent)
+    mItemsMutex.lock();
     mItems.remove(row, count);
+    mItemsMutex.unlock();
+
+    emit itemsChanged();
     return true;
 }
 
@@ -118,36 +125,85 @@ QVariant Emitter::headerData(int section, Qt::Orientation orientation, int role)
     return QVariant("");
 }
 
-void Emitter::run()
+xToolsDeadlineScheduler::Jitter Emitter::jitter()
 {
-    mEmittingTimer = new QTimer();
-    mEmittingTimer->setInterval(mScanInterval);
-    mEmittingTimer->setSingleShot(true);
-    connect(mEmittingTimer, &QTimer::timeout, mEmittingTimer, [=]() { try2emit(); });
-    mEmittingTimer->start();
+    xToolsDeadlineScheduler::Jitter jitter;
+    mSchedulerMutex.lock();
+    if (mScheduler) {
+        jitter = mScheduler->jitter();
+    }
+    mSchedulerMutex.unlock();
+    return jitter;
+}
 
+void Emitter::run()
+{
+    auto *scheduler = new xToolsDeadlineScheduler();
+    connect(scheduler, &xToolsDeadlineScheduler::timeout, scheduler, [this](int id) {
+        try2emit(id);
+    });
+    // The items are changed in the ui thread, the schedule is updated in the thread of the emitter.
+    connect(this, &Emitter::itemsChanged, scheduler, [this]() { updateSchedule(); });
+
+    mSchedulerMutex.lock();
+    mScheduler = scheduler;
+    mSchedulerMutex.unlock();
+
+    updateSchedule();
     exec();
 
-    if (mEmittingTimer) {
-        mEmittingTimer->stop();
-        mEmittingTimer->deleteLater();
-        mEmittingTimer = nullptr;
+    mSchedulerMutex.lock();
+    mScheduler = nullptr;
+    mSchedulerMutex.unlock();
+    delete scheduler;
+}
+
+void Emitter::updateSchedule()
+{
+    QHash<int, qint64> intervals;
+    double minInterval = mSpinInterval;
+    mItemsMutex.lock();
+    for (const auto &item : mItems) {
+        if (item.data.itemEnable && item.data.itemInterval > 0) {
+            intervals.insert(item.id, qRound64(item.data.itemInterval * 1000000));
+            minInterval = qMin(minInterval, item.data.itemInterval);
+        }
+    }
+    mItemsMutex.unlock();
+
+    const QList<int> ids = mScheduler->ids();
+    for (int id : ids) {
+        if (!intervals.contains(id)) {
+            mScheduler->cancel(id);
+        }
     }
+
+    for (auto it = intervals.constBegin(); it != intervals.constEnd(); ++it) {
+        mScheduler->schedule(it.key(), it.value());
+    }
+
+    mScheduler->setSpinThreshold(minInterval < mSpinInterval ? mSpinThreshold : 0);
 }
 
-void Emitter::try2emit()
+void Emitter::try2emit(int id)
 {
+    QByteArray bytes;
+    bool emitting = false;
     mItemsMutex.lock();
-    for (auto &item : mItems) {
-        int elapsedTime = item.elapsedTime += mScanInterval;
-        if (elapsedTime > item.data.itemInterval && item.data.itemEnable) {
-            item.elapsedTime = 0;
-            const auto bytes = itemBytes(item.data);
-            emit outputBytes(bytes);
+    for (const auto &item : mItems) {
+        if (item.id == id) {
+            emitting = item.data.itemEnable;
+            if (emitting) {
+                bytes = itemBytes(item.data);
+            }
+            break;
         }
     }
     mItemsMutex.unlock();
-    mEmittingTimer->start();
+
+    if (emitting) {
+        emit outputBytes(bytes);
+    }
 }
 
 QByteArray Emitter::itemBytes(const Emitter::Data &item)
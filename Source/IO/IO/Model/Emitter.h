@@ -9,10 +9,10 @@
 #pragma once
 
 #include <QMutex>
-#include <QTimer>
 #include <QVariant>
 
 #include "AbstractModel.h"
+#include "xToolsDeadlineScheduler.h"
 
 namespace xTools {
 
@@ -60,7 +60,7 @@ public:
         int itemPrefix;
         QString itemText;
         int itemSuffix;
-        int itemInterval;
+        double itemInterval{1000}; // ms, fractions of a millisecond are allowed.
 
         bool itemCrcEnable;
         bool itemCrcBigEndian;
@@ -72,13 +72,17 @@ public:
     struct EmitterItem
     {
         Data data;
-        int elapsedTime{0};
+        int id{0}; // The id of the item in the scheduler.
     };
 
 public:
     explicit Emitter(QObject *parent = Q_NULLPTR);
     virtual void inputBytes(const QByteArray &bytes) override;
 
+    /// The lateness of the emitting against the deadlines of the items, it is empty if the
+    /// emitter is not working.
+    xToolsDeadlineScheduler::Jitter jitter();
+
 protected:
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -94,6 +98,9 @@ protected:
 
     virtual void run() final;
 
+signals:
+    void itemsChanged();
+
 private:
     QVector<EmitterItem> mItems;
     QMutex mItemsMutex;
@@ -102,11 +109,16 @@ private:
     const int mItemTextColumnIndex{2};
     DataKeys mDataKeys;
     const int mTableColumnCount{13};
-    QTimer *mEmittingTimer;
-    const int mScanInterval{5};
+    int mNextItemId{0};
+    xToolsDeadlineScheduler *mScheduler{nullptr};
+    QMutex mSchedulerMutex;
+    // Items faster than the interval(ms) are emitted with spinning for sub-millisecond precision.
+    const double mSpinInterval{10};
+    const qint64 mSpinThreshold{1000000};
 
 private:
-    void try2emit();
+    void updateSchedule();
+    void try2emit(int id);
     QByteArray itemBytes(const Emitter::Data &item);
     QVariant columnDisplayRoleData(const EmitterItem &item, int column) const;
 
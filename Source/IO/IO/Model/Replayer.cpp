@@ -0,0 +1,222 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "Replayer.h"
+
+#include <chrono>
+#include <thread>
+
+#include <QScopedPointer>
+
+#include "xToolsCaptureFile.h"
+
+namespace xTools {
+
+Replayer::Replayer(QObject *parent)
+    : AbstractIO{parent}
+{}
+
+Replayer::~Replayer()
+{
+    stop();
+}
+
+void Replayer::inputBytes(const QByteArray &bytes)
+{
+    Q_UNUSED(bytes)
+}
+
+QVariantMap Replayer::save() const
+{
+    QVariantMap data = AbstractIO::save();
+    auto *self = const_cast<Replayer *>(this);
+    Parameters parameters = self->parameters();
+    data["fileName"] = parameters.fileName;
+    data["timingMode"] = parameters.timingMode;
+    data["speed"] = parameters.speed;
+    data["directionFilter"] = parameters.directionFilter;
+    data["loop"] = parameters.loop;
+    data["spinTime"] = parameters.spinTime;
+    return data;
+}
+
+void Replayer::load(const QVariantMap &data)
+{
+    AbstractIO::load(data);
+    if (data.isEmpty()) {
+        return;
+    }
+
+    Parameters parameters;
+    parameters.fileName = data.value("fileName").toString();
+    parameters.timingMode = data.value("timingMode", TimingModeOriginal).toInt();
+    parameters.speed = data.value("speed", 1.0).toDouble();
+    parameters.directionFilter = data.value("directionFilter", DirectionFilterAll).toInt();
+    parameters.loop = data.value("loop").toBool();
+    parameters.spinTime = data.value("spinTime", 1000).toInt();
+    setParameters(parameters);
+}
+
+Replayer::Parameters Replayer::parameters()
+{
+    m_parametersMutex.lock();
+    Parameters parameters = m_parameters;
+    m_parametersMutex.unlock();
+    return parameters;
+}
+
+void Replayer::setParameters(const Parameters &parameters)
+{
+    m_parametersMutex.lock();
+    m_parameters = parameters;
+    m_parametersMutex.unlock();
+}
+
+void Replayer::setSink(AbstractIO *sink)
+{
+    m_sink.store(sink);
+}
+
+void Replayer::stop()
+{
+    if (isRunning()) {
+        requestInterruption();
+        wait();
+    }
+}
+
+qint64 Replayer::frames()
+{
+    return m_frames.load();
+}
+
+qint64 Replayer::maxJitter()
+{
+    return m_maxJitter.load();
+}
+
+qint64 Replayer::meanJitter()
+{
+    qint64 frames = m_frames.load();
+    return frames > 0 ? m_totalJitter.load() / frames : 0;
+}
+
+static bool isAccepted(int directionFilter, int direction)
+{
+    if (directionFilter == Replayer::DirectionFilterRx) {
+        return direction == xToolsCaptureFile::DirectionRx;
+    } else if (directionFilter == Replayer::DirectionFilterTx) {
+        return direction == xToolsCaptureFile::DirectionTx;
+    }
+
+    return true;
+}
+
+void Replayer::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    m_frames.store(0);
+    m_maxJitter.store(0);
+    m_totalJitter.store(0);
+    emit statisticsChanged();
+
+    const Parameters parameters = this->parameters();
+    QScopedPointer<xToolsAbstractCaptureReader> reader(
+        xToolsCaptureFile::createReader(parameters.fileName));
+    if (!reader->open(parameters.fileName)) {
+        emit errorOccurred(reader->errorString());
+        return;
+    }
+
+    double speed = 1.0;
+    if (parameters.timingMode == TimingModeScaled && parameters.speed > 0) {
+        speed = parameters.speed;
+    }
+
+    const bool isFast = parameters.timingMode == TimingModeFast;
+    const auto spinTime = std::chrono::microseconds(qMax(parameters.spinTime, 0));
+    auto lastNotification = Clock::now();
+    xToolsCaptureFrame frame;
+
+    bool hasFrames = false;
+    do {
+        // Deadlines are absolute, so an oversleep is not accumulated frame after frame.
+        bool isFirstFrame = true;
+        qint64 firstTimestamp = 0;
+        Clock::time_point startTime;
+
+        reader->rewind();
+        while (!isInterruptionRequested() && reader->readFrame(frame)) {
+            if (!isAccepted(parameters.directionFilter, frame.direction)) {
+                continue;
+            }
+
+            if (isFirstFrame) {
+                isFirstFrame = false;
+                hasFrames = true;
+                firstTimestamp = frame.timestamp;
+                startTime = Clock::now();
+            }
+
+            Clock::time_point deadline = startTime;
+            if (!isFast && frame.timestamp > firstTimestamp) {
+                auto offset = static_cast<qint64>((frame.timestamp - firstTimestamp) / speed);
+                deadline += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::nanoseconds(offset));
+            }
+
+            auto now = Clock::now();
+            while (deadline - now > spinTime && !isInterruptionRequested()) {
+                // Sleep in short slices, so stopping the replayer doesn't wait for a long gap.
+                Clock::duration remaining = deadline - now;
+                remaining -= std::chrono::duration_cast<Clock::duration>(spinTime);
+                auto slice = Clock::duration(std::chrono::milliseconds(100));
+                std::this_thread::sleep_for(qMin(remaining, slice));
+                now = Clock::now();
+            }
+            while (now < deadline && !isInterruptionRequested()) {
+                std::this_thread::yield();
+                now = Clock::now();
+            }
+
+            AbstractIO *sink = m_sink.load();
+            while (sink && sink->pendingBytes() > maxPendingBytes && !isInterruptionRequested()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            if (isInterruptionRequested()) {
+                break;
+            }
+
+            // The payload may refer to the read buffer of the reader, it must be copied.
+            emit outputBytes(QByteArray(frame.payload.constData(), frame.payload.size()));
+
+            if (!isFast) {
+                auto elapsed = Clock::now() - deadline;
+                auto jitter = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+                m_totalJitter += jitter.count();
+                if (jitter.count() > m_maxJitter.load()) {
+                    m_maxJitter.store(jitter.count());
+                }
+            }
+            m_frames++;
+
+            if (Clock::now() - lastNotification > std::chrono::milliseconds(100)) {
+                lastNotification = Clock::now();
+                emit statisticsChanged();
+            }
+        }
+    } while (parameters.loop && hasFrames && !isInterruptionRequested());
+
+    reader->close();
+    emit statisticsChanged();
+    emit finishedReplaying();
+}
+
+} // namespace xTools
@@ -0,0 +1,82 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <QMutex>
+
+#include "../AbstractIO.h"
+
+namespace xTools {
+
+/// The replayer reads a capture file(xTools capture, pcapng or pcap) frame by frame and outputs
+/// the payloads with the timing of the capture. Connect outputBytes() to inputBytes() of a
+/// communication or a transmitter with Qt::DirectConnection, so the frames are not delayed by the
+/// event loop of the ui thread. Set the sink to the same object, so the replayer waits while the
+/// sink has too many pending bytes instead of queuing the whole capture(fast mode especially).
+class Replayer : public AbstractIO
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 frames READ frames NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 maxJitter READ maxJitter NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 meanJitter READ meanJitter NOTIFY statisticsChanged)
+public:
+    enum TimingMode { TimingModeOriginal, TimingModeScaled, TimingModeFast };
+    enum DirectionFilter { DirectionFilterAll, DirectionFilterRx, DirectionFilterTx };
+
+    struct Parameters
+    {
+        QString fileName;
+        int timingMode{TimingModeOriginal};
+        double speed{1.0};
+        int directionFilter{DirectionFilterAll};
+        bool loop{false};
+        /// Frames ahead of the deadline are slept until the deadline is closer than the spin time,
+        /// then the replayer spins. A longer spin time means a smaller jitter and a busier core.
+        int spinTime{1000}; // us
+    };
+
+public:
+    explicit Replayer(QObject *parent = nullptr);
+    ~Replayer();
+
+    void inputBytes(const QByteArray &bytes) override;
+    QVariantMap save() const override;
+    void load(const QVariantMap &data) override;
+
+    Parameters parameters();
+    void setParameters(const Parameters &parameters);
+    void setSink(AbstractIO *sink);
+    void stop();
+
+    qint64 frames();
+    /// Jitter in microseconds, the distance between the deadline and the time the frame is output.
+    qint64 maxJitter();
+    qint64 meanJitter();
+
+signals:
+    void statisticsChanged();
+    void finishedReplaying();
+
+protected:
+    void run() override;
+
+private:
+    static const qint64 maxPendingBytes = 1024 * 1024;
+
+    Parameters m_parameters;
+    QMutex m_parametersMutex;
+    std::atomic<AbstractIO *> m_sink{nullptr};
+
+    std::atomic<qint64> m_frames{0};
+    std::atomic<qint64> m_maxJitter{0};
+    std::atomic<qint64> m_totalJitter{0};
+};
+
+} // namespace xTools
@@ -8,12 +8,6 @@
  **************************************************************************************************/
 #include "Storage.h"
 
-#include <QDataStream>
-#include <QDateTime>
-#include <QDebug>
-#include <QDir>
-#include <QFile>
-
 namespace xTools {
 
 Storage::Storage(QObject *parent)
@@ -25,9 +19,7 @@ Storage::~Storage() {}
 void Storage::inputBytes(const QByteArray &bytes)
 {
     if (isEnable()) {
-        m_inputBytesListMutex.lock();
-        m_inputBytesList.append(bytes);
-        m_inputBytesListMutex.unlock();
+        m_storer.append(bytes);
     }
 }
 
@@ -81,16 +73,18 @@ void Storage::setFileName(const QString &name)
 
 void Storage::run()
 {
+    auto flush = [=]() {
+        m_parametersMutex.lock();
+        QString fileName = m_parameters.file;
+        m_parametersMutex.unlock();
+        m_storer.flush(fileName);
+    };
+
     QTimer *writeTimer = new QTimer();
     writeTimer->setInterval(2000);
     writeTimer->setSingleShot(true);
     connect(writeTimer, &QTimer::timeout, writeTimer, [=]() {
-        m_parametersMutex.lock();
-        m_inputBytesListMutex.lock();
-        this->write2file();
-        m_inputBytesListMutex.unlock();
-        m_parametersMutex.unlock();
-
+        flush();
         writeTimer->start();
     });
     writeTimer->start();
@@ -100,46 +94,8 @@ void Storage::run()
     writeTimer->stop();
     writeTimer->deleteLater();
     writeTimer = nullptr;
-    write2file();
-    m_inputBytesList.clear();
-}
-
-void Storage::write2file()
-{
-    if (m_parameters.file.isEmpty()) {
-        m_inputBytesList.clear();
-        return;
-    }
-
-    QString path = m_parameters.file;
-    QFile file(path);
-    // Backup the file.
-    if (file.exists() && (file.size() > 1024 * 1024)) {
-        const QString format = QString("yyyy-MM-dd-hh-mm-ss_");
-        auto dt = QDateTime::currentDateTime().toString(format);
-        QDir dir(path);
-        auto pathTemp = path;
-        auto fileNameTemp = dir.dirName();
-        pathTemp = pathTemp.remove(fileNameTemp);
-        QString newFileName = pathTemp + dt + fileNameTemp;
-        file.copy(newFileName);
-        file.open(QFile::WriteOnly | QFile::Truncate);
-        file.close();
-    } else {
-        qWarning() << QString("the file(%1) is not exist").arg(path);
-    }
-
-    // Write the data to the file.
-    if (file.open(QFile::WriteOnly | QFile::Text | QFile::Append)) {
-        QDataStream outStream(&file);
-        while (!m_inputBytesList.isEmpty()) {
-            auto bytes = m_inputBytesList.takeFirst();
-            outStream << bytes << "\n";
-        }
-        file.close();
-    } else {
-        qWarning() << file.errorString();
-    }
+    flush();
+    m_storer.flush(QString());
 }
 
 } // namespace xTools
@@ -12,6 +12,7 @@
 #include <QTimer>
 
 #include "AbstractModel.h"
+#include "xToolsCaptureStorer.h"
 
 namespace xTools {
 
@@ -52,11 +53,7 @@ private:
     } m_parameters;
     QMutex m_parametersMutex;
 
-    QList<QByteArray> m_inputBytesList;
-    QMutex m_inputBytesListMutex;
-
-private:
-    void write2file();
+    xToolsCaptureStorer m_storer;
 };
 
 } // namespace xTools
@@ -0,0 +1,282 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "LatencyMeter.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QtEndian>
+
+
+LatencyMeter::LatencyMeter(QObject *parent)
+    : AbstractIO{parent}
+{
+    QTimer *timer = new QTimer(this);
+    timer->setInterval(1000);
+    connect(timer, &QTimer::timeout, this, &LatencyMeter::onTimeout);
+
+    connect(this, &LatencyMeter::started, this, [this, timer]() {
+        this->reset();
+        timer->start();
+    });
+
+    connect(this, &LatencyMeter::finished, this, [timer]() { timer->stop(); });
+}
+
+void LatencyMeter::inputBytes(const QByteArray &bytes)
+{
+    inputRx(bytes, xToolsProfiler::now());
+}
+
+QVariantMap LatencyMeter::save() const
+{
+    QVariantMap data = AbstractIO::save();
+    auto *self = const_cast<LatencyMeter *>(this);
+    Parameters parameters = self->parameters();
+    data["matchRule"] = parameters.matchRule;
+    data["sequenceOffset"] = parameters.sequenceOffset;
+    data["sequenceLength"] = parameters.sequenceLength;
+    data["bigEndian"] = parameters.bigEndian;
+    data["timeout"] = parameters.timeout;
+    return data;
+}
+
+void LatencyMeter::load(const QVariantMap &data)
+{
+    AbstractIO::load(data);
+    if (data.isEmpty()) {
+        return;
+    }
+
+    Parameters parameters;
+    parameters.matchRule = data.value("matchRule", MatchRuleNextRx).toInt();
+    parameters.sequenceOffset = data.value("sequenceOffset", 0).toInt();
+    parameters.sequenceLength = data.value("sequenceLength", 1).toInt();
+    parameters.bigEndian = data.value("bigEndian", true).toBool();
+    parameters.timeout = data.value("timeout", 5000).toInt();
+    setParameters(parameters);
+}
+
+void LatencyMeter::inputTx(const QByteArray &bytes, qint64 timestamp)
+{
+    if (!isEnable() || !isWorking()) {
+        return;
+    }
+
+    xToolsProfilerScope scope(profilerStage());
+    m_mutex.lock();
+    removeExpiredRequests(timestamp);
+    if (m_parameters.matchRule == MatchRuleNextRx) {
+        m_pendingRequests.append(timestamp);
+    } else {
+        quint32 value = 0;
+        if (sequence(bytes, value)) {
+            // A request that is sent again before it is answered is measured from the last one.
+            m_pendingSequences.insert(value, timestamp);
+        }
+    }
+    m_mutex.unlock();
+}
+
+void LatencyMeter::inputRx(const QByteArray &bytes, qint64 timestamp)
+{
+    if (!isEnable()) {
+        emit outputBytes(bytes);
+        return;
+    }
+
+    if (!isWorking()) {
+        return;
+    }
+
+    xToolsProfilerScope scope(profilerStage());
+    m_mutex.lock();
+    removeExpiredRequests(timestamp);
+    qint64 requestTimestamp = -1;
+    if (m_parameters.matchRule == MatchRuleNextRx) {
+        if (!m_pendingRequests.isEmpty()) {
+            requestTimestamp = m_pendingRequests.takeFirst();
+        }
+    } else {
+        quint32 value = 0;
+        auto it = sequence(bytes, value) ? m_pendingSequences.find(value)
+                                         : m_pendingSequences.end();
+        if (it != m_pendingSequences.end()) {
+            requestTimestamp = it.value();
+            m_pendingSequences.erase(it);
+        }
+    }
+
+    // A response after the timeout is not a latency, the request has timed out already.
+    const qint64 timeout = qint64(m_parameters.timeout) * 1000000;
+    if (requestTimestamp >= 0 && timestamp - requestTimestamp > timeout) {
+        m_timeouts++;
+    } else if (requestTimestamp >= 0) {
+        m_histogram.record(qMax<qint64>(0, timestamp - requestTimestamp) / 1000);
+    } else {
+        m_unmatched++;
+    }
+    m_mutex.unlock();
+}
+
+LatencyMeter::Parameters LatencyMeter::parameters()
+{
+    m_mutex.lock();
+    Parameters parameters = m_parameters;
+    m_mutex.unlock();
+    return parameters;
+}
+
+void LatencyMeter::setParameters(const Parameters &parameters)
+{
+    m_mutex.lock();
+    if (parameters.matchRule != m_parameters.matchRule) {
+        m_pendingRequests.clear();
+        m_pendingSequences.clear();
+    }
+    m_parameters = parameters;
+    m_mutex.unlock();
+}
+
+LatencyMeter::Statistics LatencyMeter::statistics()
+{
+    Statistics statistics;
+    m_mutex.lock();
+    statistics.matched = m_histogram.count();
+    statistics.timeouts = m_timeouts;
+    statistics.unmatched = m_unmatched;
+    statistics.min = m_histogram.min();
+    statistics.max = m_histogram.max();
+    statistics.mean = m_histogram.mean();
+    statistics.p50 = m_histogram.valueAtPercentile(50);
+    statistics.p90 = m_histogram.valueAtPercentile(90);
+    statistics.p99 = m_histogram.valueAtPercentile(99);
+    statistics.p999 = m_histogram.valueAtPercentile(99.9);
+    m_mutex.unlock();
+    return statistics;
+}
+
+void LatencyMeter::reset()
+{
+    m_mutex.lock();
+    m_histogram.reset();
+    m_pendingRequests.clear();
+    m_pendingSequences.clear();
+    m_timeouts = 0;
+    m_unmatched = 0;
+    m_lastMatched = 0;
+    m_mutex.unlock();
+
+    emit statisticsChanged();
+}
+
+bool LatencyMeter::exportCsv(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        return false;
+    }
+
+    m_mutex.lock();
+    QString csv = m_histogram.toCsv("latency_us");
+    m_mutex.unlock();
+    return file.write(csv.toUtf8()) >= 0;
+}
+
+bool LatencyMeter::exportJson(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        return false;
+    }
+
+    m_mutex.lock();
+    QJsonObject obj = m_histogram.toJson();
+    obj.insert("unit", "us");
+    obj.insert("timeouts", m_timeouts);
+    obj.insert("unmatched", m_unmatched);
+    m_mutex.unlock();
+    return file.write(QJsonDocument(obj).toJson()) >= 0;
+}
+
+void LatencyMeter::run()
+{
+    exec();
+}
+
+bool LatencyMeter::sequence(const QByteArray &bytes, quint32 &value) const
+{
+    int offset = m_parameters.sequenceOffset;
+    int length = m_parameters.sequenceLength;
+    bool bigEndian = m_parameters.bigEndian;
+    if (m_parameters.matchRule == MatchRuleModbusTransactionId) {
+        // MBAP header: transaction id(2) | protocol id(2) | length(2) | unit id(1)
+        if (bytes.size() < 8 || bytes.at(2) != 0 || bytes.at(3) != 0) {
+            return false;
+        }
+
+        offset = 0;
+        length = 2;
+        bigEndian = true;
+    }
+
+    if (offset < 0 || offset + length > bytes.size()) {
+        return false;
+    }
+
+    const uchar *ptr = reinterpret_cast<const uchar *>(bytes.constData()) + offset;
+    if (length == 1) {
+        value = ptr[0];
+    } else if (length == 2) {
+        value = bigEndian ? qFromBigEndian<quint16>(ptr) : qFromLittleEndian<quint16>(ptr);
+    } else if (length == 4) {
+        value = bigEndian ? qFromBigEndian<quint32>(ptr) : qFromLittleEndian<quint32>(ptr);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void LatencyMeter::removeExpiredRequests(qint64 timestamp, bool checkAll)
+{
+    const qint64 deadline = timestamp - qint64(m_parameters.timeout) * 1000000;
+    while (!m_pendingRequests.isEmpty() && m_pendingRequests.first() < deadline) {
+        m_pendingRequests.removeFirst();
+        m_timeouts++;
+    }
+
+    if (!checkAll && m_pendingSequences.size() < 1024) {
+        return;
+    }
+
+    for (auto it = m_pendingSequences.begin(); it != m_pendingSequences.end();) {
+        if (it.value() < deadline) {
+            it = m_pendingSequences.erase(it);
+            m_timeouts++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LatencyMeter::onTimeout()
+{
+    m_mutex.lock();
+    qint64 timeouts = m_timeouts;
+    removeExpiredRequests(xToolsProfiler::now(), true);
+    qint64 matched = m_histogram.count();
+    bool changed = matched != m_lastMatched || timeouts != m_timeouts;
+    m_lastMatched = matched;
+    m_mutex.unlock();
+
+    if (changed) {
+        emit statisticsChanged();
+    }
+}
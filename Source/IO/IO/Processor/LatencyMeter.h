@@ -0,0 +1,92 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+#include "../AbstractIO.h"
+#include "xToolsHdrHistogram.h"
+
+/// The latency meter matches the responses(RX) to the requests(TX) and records the round-trip
+/// times in microseconds. inputTx() and inputRx() should be called in the thread of the device
+/// with the timestamps taken when the bytes are written or read, see xToolsProfiler::now(). The
+/// clock is steady, an adjustment of the wall clock is not measured as a latency.
+class LatencyMeter : public AbstractIO
+{
+    Q_OBJECT
+public:
+    enum MatchRule { MatchRuleNextRx, MatchRuleSequenceField, MatchRuleModbusTransactionId };
+
+    struct Parameters
+    {
+        int matchRule{MatchRuleNextRx};
+        int sequenceOffset{0}; // Bytes, for MatchRuleSequenceField.
+        int sequenceLength{1}; // 1, 2 or 4 bytes.
+        bool bigEndian{true};
+        int timeout{5000}; // ms, requests without a response are dropped after it.
+    };
+
+    struct Statistics
+    {
+        qint64 matched{0};
+        qint64 timeouts{0};
+        qint64 unmatched{0}; // Responses without a request.
+        qint64 min{0};
+        qint64 max{0};
+        double mean{0};
+        qint64 p50{0};
+        qint64 p90{0};
+        qint64 p99{0};
+        qint64 p999{0};
+    };
+
+public:
+    explicit LatencyMeter(QObject *parent = nullptr);
+
+    /// The bytes are handled as a response received now.
+    void inputBytes(const QByteArray &bytes) override;
+    QVariantMap save() const override;
+    void load(const QVariantMap &data) override;
+
+    void inputTx(const QByteArray &bytes, qint64 timestamp);
+    void inputRx(const QByteArray &bytes, qint64 timestamp);
+
+    Parameters parameters();
+    void setParameters(const Parameters &parameters);
+    Statistics statistics();
+    void reset();
+
+    bool exportCsv(const QString &fileName);
+    bool exportJson(const QString &fileName);
+
+signals:
+    void statisticsChanged();
+
+protected:
+    void run() override;
+
+private:
+    Parameters m_parameters;
+    QMutex m_mutex;
+    xToolsHdrHistogram m_histogram;
+    QList<qint64> m_pendingRequests;
+    QHash<quint32, qint64> m_pendingSequences;
+    qint64 m_timeouts{0};
+    qint64 m_unmatched{0};
+    qint64 m_lastMatched{0};
+
+private:
+    bool sequence(const QByteArray &bytes, quint32 &value) const;
+    /// The sequences are not ordered, all of them are checked if checkAll is true or there are
+    /// too many of them, the timer checks them every second.
+    void removeExpiredRequests(qint64 timestamp, bool checkAll = false);
+    void onTimeout();
+};
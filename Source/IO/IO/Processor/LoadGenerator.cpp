@@ -0,0 +1,393 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "LoadGenerator.h"
+
+#include <QDateTime>
+#include <QTimer>
+#include <QtEndian>
+
+#include "../Communication/TcpClient.h"
+#include "../Communication/UdpClient.h"
+#include "../Communication/WebSocketClient.h"
+#include "xToolsCaptureFile.h"
+
+LoadGenerator::LoadGenerator(QObject *parent)
+    : AbstractIO{parent}
+{}
+
+LoadGenerator::~LoadGenerator()
+{
+    if (isRunning()) {
+        exit();
+        wait();
+    }
+}
+
+void LoadGenerator::inputBytes(const QByteArray &bytes)
+{
+    Q_UNUSED(bytes);
+}
+
+QVariantMap LoadGenerator::save() const
+{
+    QVariantMap data = AbstractIO::save();
+    auto *self = const_cast<LoadGenerator *>(this);
+    Parameters parameters = self->parameters();
+    data["communicationType"] = parameters.communicationType;
+    data["communicationParameters"] = parameters.communicationParameters;
+    data["clients"] = parameters.clients;
+    data["rate"] = parameters.rate;
+    data["duration"] = parameters.duration;
+    data["sizeDistribution"] = parameters.sizeDistribution;
+    data["size"] = parameters.size;
+    data["minSize"] = parameters.minSize;
+    data["maxSize"] = parameters.maxSize;
+    data["sizeStdDev"] = parameters.sizeStdDev;
+    data["payload"] = parameters.payload;
+    data["payloadTemplate"] = parameters.payloadTemplate;
+    data["sequence"] = parameters.sequence;
+    data["timestamp"] = parameters.timestamp;
+    data["crc"] = parameters.crc;
+    data["crcAlgorithm"] = parameters.crcAlgorithm;
+    data["crcBigEndian"] = parameters.crcBigEndian;
+    data["maxPending"] = parameters.maxPending;
+    return data;
+}
+
+void LoadGenerator::load(const QVariantMap &data)
+{
+    AbstractIO::load(data);
+    if (data.isEmpty()) {
+        return;
+    }
+
+    Parameters parameters;
+    int type = static_cast<int>(xIO::CommunicationType::TcpClient);
+    parameters.communicationType = data.value("communicationType", type).toInt();
+    parameters.communicationParameters = data.value("communicationParameters").toMap();
+    parameters.clients = data.value("clients", 1).toInt();
+    parameters.rate = data.value("rate", 1000).toDouble();
+    parameters.duration = data.value("duration", 0).toInt();
+    parameters.sizeDistribution = data.value("sizeDistribution", SizeFixed).toInt();
+    parameters.size = data.value("size", 64).toInt();
+    parameters.minSize = data.value("minSize", 16).toInt();
+    parameters.maxSize = data.value("maxSize", 256).toInt();
+    parameters.sizeStdDev = data.value("sizeStdDev", 16).toInt();
+    parameters.payload = data.value("payload", PayloadRandom).toInt();
+    parameters.payloadTemplate = data.value("payloadTemplate").toString();
+    parameters.sequence = data.value("sequence", false).toBool();
+    parameters.timestamp = data.value("timestamp", false).toBool();
+    parameters.crc = data.value("crc", false).toBool();
+    parameters.crcAlgorithm = data.value("crcAlgorithm", 0).toInt();
+    parameters.crcBigEndian = data.value("crcBigEndian", true).toBool();
+    parameters.maxPending = data.value("maxPending", 10000).toInt();
+    setParameters(parameters);
+}
+
+LoadGenerator::Parameters LoadGenerator::parameters()
+{
+    m_parametersMutex.lock();
+    Parameters parameters = m_parameters;
+    m_parametersMutex.unlock();
+    return parameters;
+}
+
+void LoadGenerator::setParameters(const Parameters &parameters)
+{
+    m_parametersMutex.lock();
+    m_parameters = parameters;
+    m_parametersMutex.unlock();
+}
+
+LoadGenerator::Statistics LoadGenerator::statistics()
+{
+    Statistics statistics;
+    statistics.elapsed = m_elapsed;
+    statistics.clients = m_clients;
+    statistics.connectedClients = m_connectedClients;
+    statistics.scheduled = m_scheduled;
+    statistics.sent = m_txMeter.totalFrames();
+    statistics.sentBytes = m_txMeter.totalBytes();
+    statistics.received = m_rxMeter.totalFrames();
+    statistics.receivedBytes = m_rxMeter.totalBytes();
+    statistics.dropped = m_dropped;
+    statistics.errors = m_errors;
+    statistics.targetRate = isWorking() ? parameters().rate : 0;
+
+    xToolsRateMeter::Rate txRate = m_txMeter.rate(xToolsRateMeter::Window1s);
+    xToolsRateMeter::Rate rxRate = m_rxMeter.rate(xToolsRateMeter::Window1s);
+    statistics.txRate = txRate.framesPerSecond;
+    statistics.txByteRate = txRate.bytesPerSecond;
+    statistics.rxRate = rxRate.framesPerSecond;
+    statistics.rxByteRate = rxRate.bytesPerSecond;
+    return statistics;
+}
+
+QList<int> LoadGenerator::supportedCommunicationTypes()
+{
+    return QList<int>{static_cast<int>(xIO::CommunicationType::TcpClient),
+                      static_cast<int>(xIO::CommunicationType::UdpClient),
+                      static_cast<int>(xIO::CommunicationType::WebSocketClient)};
+}
+
+void LoadGenerator::run()
+{
+    Parameters parameters = this->parameters();
+    if (parameters.minSize > parameters.maxSize) {
+        qSwap(parameters.minSize, parameters.maxSize);
+    }
+
+    m_txMeter.reset();
+    m_rxMeter.reset();
+    m_elapsed = 0;
+    m_connectedClients = 0;
+    m_scheduled = 0;
+    m_dropped = 0;
+    m_errors = 0;
+    m_nextClient = 0;
+    m_sequence = 0;
+
+    // The random payloads are slices of a random block, it is much cheaper than generating the
+    // bytes of every message.
+    m_engine.seed(std::random_device{}());
+    m_randomBytes.resize(64 * 1024);
+    for (int i = 0; i < m_randomBytes.size(); i++) {
+        m_randomBytes[i] = static_cast<char>(m_engine() & 0xff);
+    }
+    m_template = parameters.payloadTemplate.toUtf8();
+    auto crcAlgorithm = static_cast<xIO::CrcAlgorithm>(parameters.crcAlgorithm);
+    m_crcSize = parameters.crc ? xIO::calculateCrc(QByteArray(1, '\0'), crcAlgorithm).size() : 0;
+
+    m_elapsedTimer.start();
+    for (int i = 0; i < parameters.clients; i++) {
+        Communication *device = createClient(parameters.communicationType);
+        if (!device) {
+            emit warningOccurred(tr("Unsupported communication type for the load generator."));
+            break;
+        }
+
+        Client *client = new Client();
+        client->device = device;
+        m_clientList.append(client);
+        setupClient(client, parameters);
+    }
+    m_clients = m_clientList.size();
+
+    // The clients are opened again a second after they have been closed.
+    QTimer *statisticsTimer = new QTimer();
+    statisticsTimer->setInterval(1000);
+    connect(statisticsTimer, &QTimer::timeout, statisticsTimer, [this]() {
+        const qint64 elapsed = m_elapsedTimer.elapsed();
+        for (Client *client : m_clientList) {
+            if (!client->device->isRunning() && elapsed - client->openedTime >= 1000) {
+                client->openedTime = elapsed;
+                client->device->openDevice();
+            }
+        }
+
+        m_elapsed = elapsed;
+        emit statisticsChanged();
+    });
+
+    // The precise timer fires every millisecond, the number of the messages that are due is
+    // calculated from the elapsed time, so the jitter of the timer does not change the rate.
+    QTimer *timer = new QTimer();
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(1);
+    connect(timer, &QTimer::timeout, timer, [this, parameters]() { onTimeout(parameters); });
+
+    if (!m_clientList.isEmpty()) {
+        statisticsTimer->start();
+        timer->start();
+        exec();
+    }
+
+    timer->stop();
+    timer->deleteLater();
+    statisticsTimer->stop();
+    statisticsTimer->deleteLater();
+
+    for (Client *client : m_clientList) {
+        client->device->closeDevice();
+        delete client->device;
+        delete client;
+    }
+    m_clientList.clear();
+    m_connectedClients = 0;
+    m_elapsed = m_elapsedTimer.elapsed();
+    emit statisticsChanged();
+}
+
+Communication *LoadGenerator::createClient(int type) const
+{
+    switch (type) {
+    case static_cast<int>(xIO::CommunicationType::TcpClient):
+        return new TcpClient();
+    case static_cast<int>(xIO::CommunicationType::UdpClient):
+        return new UdpClient();
+    case static_cast<int>(xIO::CommunicationType::WebSocketClient):
+        return new WebSocketClient();
+    default:
+        return nullptr;
+    }
+}
+
+void LoadGenerator::setupClient(Client *client, const Parameters &parameters)
+{
+    // The signals are emitted in the threads of the clients.
+    Communication *device = client->device;
+    connect(
+        device,
+        &Communication::opened,
+        device,
+        [this, client]() {
+            client->connected = true;
+            m_connectedClients++;
+        },
+        Qt::DirectConnection);
+    connect(
+        device,
+        &Communication::closed,
+        device,
+        [this, client]() {
+            if (client->connected.exchange(false)) {
+                m_connectedClients--;
+            }
+            client->pending = 0;
+        },
+        Qt::DirectConnection);
+    connect(
+        device,
+        &Communication::bytesWritten,
+        device,
+        [this, client](const QByteArray &bytes, const QString &) {
+            client->pending--;
+            m_txMeter.add(bytes.size());
+        },
+        Qt::DirectConnection);
+    connect(
+        device,
+        &Communication::bytesRead,
+        device,
+        [this](const QByteArray &bytes, const QString &) { m_rxMeter.add(bytes.size()); },
+        Qt::DirectConnection);
+    connect(
+        device,
+        &Communication::errorOccurred,
+        device,
+        [this, client](const QString &) {
+            // A message that failed to be written is not pending any more.
+            if (client->pending > 0) {
+                client->pending--;
+            }
+            m_errors++;
+        },
+        Qt::DirectConnection);
+
+    device->setParameters(parameters.communicationParameters);
+    client->openedTime = m_elapsedTimer.elapsed();
+    device->openDevice();
+}
+
+void LoadGenerator::onTimeout(const Parameters &parameters)
+{
+    const qint64 elapsed = m_elapsedTimer.nsecsElapsed();
+    if (parameters.duration > 0 && elapsed >= parameters.duration * 1000000000ll) {
+        exit();
+        return;
+    }
+
+    const qint64 due = static_cast<qint64>(elapsed / 1e9 * parameters.rate);
+    const qint64 count = due - m_scheduled;
+    for (qint64 i = 0; i < count; i++) {
+        int index = nextClient(parameters);
+        if (index == -1) {
+            m_dropped += count - i;
+            break;
+        }
+
+        Client *client = m_clientList.at(index);
+        client->pending++;
+        client->device->inputBytes(message(parameters, index));
+    }
+
+    m_scheduled = due;
+}
+
+int LoadGenerator::nextClient(const Parameters &parameters)
+{
+    for (int i = 0; i < m_clientList.size(); i++) {
+        int index = m_nextClient;
+        m_nextClient = (m_nextClient + 1) % m_clientList.size();
+
+        // A tcp socket buffers the written bytes without a limit and reports them as written at
+        // once, the bytes to write bound the memory.
+        Client *client = m_clientList.at(index);
+        if (client->connected && client->pending < parameters.maxPending
+            && client->device->pendingBytes() < maxPendingBytes) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+QByteArray LoadGenerator::message(const Parameters &parameters, int client)
+{
+    const quint32 sequence = m_sequence++;
+    QByteArray bytes;
+    if (parameters.sequence) {
+        uchar field[4];
+        qToBigEndian<quint32>(sequence, field);
+        bytes.append(reinterpret_cast<char *>(field), 4);
+    }
+
+    if (parameters.timestamp) {
+        uchar field[8];
+        qToBigEndian<qint64>(xToolsCaptureFile::currentTimestamp() / 1000, field);
+        bytes.append(reinterpret_cast<char *>(field), 8);
+    }
+
+    if (parameters.payload == PayloadTemplate) {
+        QByteArray text = m_template;
+        if (text.contains('{')) {
+            text.replace("{seq}", QByteArray::number(sequence));
+            text.replace("{client}", QByteArray::number(client));
+            text.replace("{time}", QByteArray::number(QDateTime::currentMSecsSinceEpoch()));
+        }
+        bytes.append(text);
+    } else {
+        int size = messageSize(parameters) - bytes.size() - m_crcSize;
+        if (size > 0) {
+            std::uniform_int_distribution<int> offset(0, m_randomBytes.size() - size);
+            bytes.append(m_randomBytes.constData() + offset(m_engine), size);
+        }
+    }
+
+    if (parameters.crc) {
+        auto algorithm = static_cast<xIO::CrcAlgorithm>(parameters.crcAlgorithm);
+        bytes.append(xIO::calculateCrc(bytes, algorithm, parameters.crcBigEndian));
+    }
+
+    return bytes;
+}
+
+int LoadGenerator::messageSize(const Parameters &parameters)
+{
+    int size = parameters.size;
+    if (parameters.sizeDistribution == SizeUniform) {
+        std::uniform_int_distribution<int> distribution(parameters.minSize, parameters.maxSize);
+        size = distribution(m_engine);
+    } else if (parameters.sizeDistribution == SizeNormal) {
+        std::normal_distribution<double> distribution(parameters.size, parameters.sizeStdDev);
+        size = qBound(parameters.minSize, qRound(distribution(m_engine)), parameters.maxSize);
+    }
+
+    return qBound(1, size, m_randomBytes.size());
+}
@@ -0,0 +1,141 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <random>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QVariantMap>
+
+#include "../../xIO.h"
+#include "../AbstractIO.h"
+#include "xToolsRateMeter.h"
+
+class Communication;
+
+/// The load generator drives several TCP, UDP or WebSocket clients with synthetic messages. The
+/// messages are scheduled open-loop: the n-th message is due at n / rate seconds after the start,
+/// no matter whether the previous ones have been written. Messages that can not be queued to a
+/// connected client in time are counted as dropped, so a slow target does not lower the load
+/// silently.
+class LoadGenerator : public AbstractIO
+{
+    Q_OBJECT
+public:
+    enum SizeDistribution { SizeFixed, SizeUniform, SizeNormal };
+    enum Payload { PayloadRandom, PayloadTemplate };
+
+    struct Parameters
+    {
+        // TcpClient, UdpClient or WebSocketClient, the parameters are set to every client.
+        int communicationType{static_cast<int>(xIO::CommunicationType::TcpClient)};
+        QVariantMap communicationParameters;
+        int clients{1};
+        double rate{1000}; // Messages per second of all clients.
+        int duration{0};   // s, 0 = until the generator is stopped.
+
+        int sizeDistribution{SizeFixed};
+        int size{64};    // The size of SizeFixed, the mean of SizeNormal.
+        int minSize{16}; // The bounds of SizeUniform and SizeNormal.
+        int maxSize{256};
+        int sizeStdDev{16}; // SizeNormal.
+
+        int payload{PayloadRandom};
+        QString payloadTemplate; // "{seq}", "{client}" and "{time}"(ms since epoch) are replaced.
+        bool sequence{false};    // A 4 bytes big endian counter at the beginning of the message.
+        bool timestamp{false};   // 8 bytes big endian us since epoch after the counter.
+        bool crc{false};         // Appended to the message.
+        int crcAlgorithm{0};     // xIO::CrcAlgorithm
+        bool crcBigEndian{true};
+        int maxPending{10000}; // Messages queued to a client but not written yet.
+    };
+
+    struct Statistics
+    {
+        qint64 elapsed{0}; // ms
+        int clients{0};
+        int connectedClients{0};
+        qint64 scheduled{0};
+        qint64 sent{0};
+        qint64 sentBytes{0};
+        qint64 received{0};
+        qint64 receivedBytes{0};
+        qint64 dropped{0};
+        qint64 errors{0};
+        double targetRate{0};
+        double txRate{0}; // Messages per second in the last second.
+        double txByteRate{0};
+        double rxRate{0};
+        double rxByteRate{0};
+    };
+
+public:
+    explicit LoadGenerator(QObject *parent = nullptr);
+    ~LoadGenerator() override;
+
+    /// The messages are generated by the generator, the bytes are ignored.
+    void inputBytes(const QByteArray &bytes) override;
+    QVariantMap save() const override;
+    void load(const QVariantMap &data) override;
+
+    Parameters parameters();
+    /// The parameters are used by the next start.
+    void setParameters(const Parameters &parameters);
+    Statistics statistics();
+
+    static QList<int> supportedCommunicationTypes();
+
+signals:
+    void statisticsChanged();
+
+protected:
+    void run() override;
+
+private:
+    static const qint64 maxPendingBytes = 4 * 1024 * 1024; // Per client.
+
+    struct Client
+    {
+        Communication *device{nullptr};
+        std::atomic_bool connected{false};
+        std::atomic<qint64> pending{0};
+        qint64 openedTime{0}; // ms, the time of the last openDevice().
+    };
+
+    Parameters m_parameters;
+    QMutex m_parametersMutex;
+    xToolsRateMeter m_txMeter;
+    xToolsRateMeter m_rxMeter;
+    std::atomic<qint64> m_elapsed{0};
+    std::atomic<int> m_clients{0};
+    std::atomic<int> m_connectedClients{0};
+    std::atomic<qint64> m_scheduled{0};
+    std::atomic<qint64> m_dropped{0};
+    std::atomic<qint64> m_errors{0};
+
+    // Only accessed by the thread of the generator.
+    QList<Client *> m_clientList;
+    QElapsedTimer m_elapsedTimer;
+    int m_nextClient{0};
+    quint32 m_sequence{0};
+    QByteArray m_randomBytes;
+    QByteArray m_template;
+    int m_crcSize{0};
+    std::mt19937 m_engine;
+
+private:
+    Communication *createClient(int type) const;
+    void setupClient(Client *client, const Parameters &parameters);
+    void onTimeout(const Parameters &parameters);
+    int nextClient(const Parameters &parameters);
+    QByteArray message(const Parameters &parameters, int client);
+    int messageSize(const Parameters &parameters);
+};
@@ -0,0 +1,561 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ModbusDecoder.h"
+
+#include <QTimer>
+
+#include "../../xIO.h"
+#include "xToolsCaptureFile.h"
+
+namespace {
+
+quint16 uint16At(const uchar *data)
+{
+    return quint16((data[0] << 8) | data[1]);
+}
+
+QVector<quint16> bitValues(const uchar *bytes, int byteCount, int count)
+{
+    count = qMin(count, byteCount * 8);
+    QVector<quint16> values(qMax(0, count));
+    for (int i = 0; i < count; i++) {
+        values[i] = (bytes[i / 8] >> (i % 8)) & 0x01;
+    }
+    return values;
+}
+
+QVector<quint16> registerValues(const uchar *bytes, int count)
+{
+    QVector<quint16> values(qMax(0, count));
+    for (int i = 0; i < count; i++) {
+        values[i] = uint16At(bytes + i * 2);
+    }
+    return values;
+}
+
+} // namespace
+
+ModbusDecoder::ModbusDecoder(QObject *parent)
+    : AbstractIO{parent}
+{
+    QTimer *timer = new QTimer(this);
+    timer->setInterval(100);
+    connect(timer, &QTimer::timeout, this, &ModbusDecoder::onTimeout);
+
+    connect(this, &ModbusDecoder::started, this, [this, timer]() {
+        this->reset();
+        timer->start();
+    });
+
+    connect(this, &ModbusDecoder::finished, this, [timer]() { timer->stop(); });
+}
+
+void ModbusDecoder::inputBytes(const QByteArray &bytes)
+{
+    inputRx(bytes, QString(), xToolsCaptureFile::currentTimestamp());
+}
+
+QVariantMap ModbusDecoder::save() const
+{
+    QVariantMap data = AbstractIO::save();
+    auto *self = const_cast<ModbusDecoder *>(this);
+    Parameters parameters = self->parameters();
+    data["framing"] = parameters.framing;
+    data["baudRate"] = parameters.baudRate;
+    data["silentInterval"] = parameters.silentInterval;
+    data["maxRows"] = parameters.maxRows;
+    return data;
+}
+
+void ModbusDecoder::load(const QVariantMap &data)
+{
+    AbstractIO::load(data);
+    if (data.isEmpty()) {
+        return;
+    }
+
+    Parameters parameters;
+    parameters.framing = data.value("framing", FramingRtu).toInt();
+    parameters.baudRate = data.value("baudRate", 115200).toInt();
+    parameters.silentInterval = data.value("silentInterval", 0).toInt();
+    parameters.maxRows = data.value("maxRows", 10000).toInt();
+    setParameters(parameters);
+}
+
+void ModbusDecoder::inputRx(const QByteArray &bytes, const QString &from, qint64 timestamp)
+{
+    if (!isEnable()) {
+        emit outputBytes(bytes);
+        return;
+    }
+
+    input(bytes, from, true, timestamp);
+}
+
+void ModbusDecoder::inputTx(const QByteArray &bytes, const QString &to, qint64 timestamp)
+{
+    if (!isEnable()) {
+        return;
+    }
+
+    input(bytes, to, false, timestamp);
+}
+
+ModbusDecoder::Parameters ModbusDecoder::parameters()
+{
+    m_mutex.lock();
+    Parameters parameters = m_parameters;
+    m_mutex.unlock();
+    return parameters;
+}
+
+void ModbusDecoder::setParameters(const Parameters &parameters)
+{
+    m_mutex.lock();
+    if (parameters.framing != m_parameters.framing) {
+        m_rxStreams.clear();
+        m_txStreams.clear();
+        m_pendingRequests.clear();
+    }
+    m_parameters = parameters;
+    m_mutex.unlock();
+}
+
+ModbusDecoder::Statistics ModbusDecoder::statistics()
+{
+    m_mutex.lock();
+    Statistics statistics = m_statistics;
+    m_mutex.unlock();
+    return statistics;
+}
+
+void ModbusDecoder::reset()
+{
+    m_mutex.lock();
+    m_rxStreams.clear();
+    m_txStreams.clear();
+    m_pendingRequests.clear();
+    m_rows.clear();
+    m_statistics = Statistics();
+    m_lastFrames = 0;
+    m_mutex.unlock();
+
+    emit statisticsChanged();
+}
+
+QList<ModbusDecoder::Row> ModbusDecoder::takeRows()
+{
+    QList<Row> rows;
+    m_mutex.lock();
+    rows.swap(m_rows);
+    m_mutex.unlock();
+    return rows;
+}
+
+QString ModbusDecoder::functionName(int functionCode)
+{
+    switch (functionCode) {
+    case 0x01:
+        return tr("Read Coils");
+    case 0x02:
+        return tr("Read Discrete Inputs");
+    case 0x03:
+        return tr("Read Holding Registers");
+    case 0x04:
+        return tr("Read Input Registers");
+    case 0x05:
+        return tr("Write Single Coil");
+    case 0x06:
+        return tr("Write Single Register");
+    case 0x07:
+        return tr("Read Exception Status");
+    case 0x08:
+        return tr("Diagnostics");
+    case 0x0b:
+        return tr("Get Comm Event Counter");
+    case 0x0c:
+        return tr("Get Comm Event Log");
+    case 0x0f:
+        return tr("Write Multiple Coils");
+    case 0x10:
+        return tr("Write Multiple Registers");
+    case 0x11:
+        return tr("Report Server ID");
+    case 0x14:
+        return tr("Read File Record");
+    case 0x15:
+        return tr("Write File Record");
+    case 0x16:
+        return tr("Mask Write Register");
+    case 0x17:
+        return tr("Read/Write Multiple Registers");
+    case 0x18:
+        return tr("Read FIFO Queue");
+    case 0x2b:
+        return tr("Encapsulated Interface Transport");
+    default:
+        return tr("Function 0x%1").arg(functionCode, 2, 16, QChar('0'));
+    }
+}
+
+QString ModbusDecoder::rowText(const Row &row)
+{
+    if (!row.isCrcValid) {
+        return tr("crc error");
+    }
+
+    QStringList fields;
+    if (row.exceptionCode) {
+        fields.append(tr("exception %1").arg(row.exceptionCode, 2, 16, QChar('0')));
+    }
+    if (row.address >= 0) {
+        fields.append(tr("address %1").arg(row.address));
+    }
+    if (row.count > 0) {
+        fields.append(tr("count %1").arg(row.count));
+    }
+    if (!row.values.isEmpty()) {
+        // The first values only, the bytes of the row hold all of them.
+        const int count = qMin(row.values.count(), 16);
+        QStringList values;
+        for (int i = 0; i < count; i++) {
+            values.append(QString("%1").arg(row.values.at(i), 4, 16, QChar('0')));
+        }
+        if (count < row.values.count()) {
+            values.append("...");
+        }
+        fields.append(tr("values %1").arg(values.join(' ')));
+    }
+    if (!row.isValid) {
+        fields.append(tr("invalid pdu"));
+    }
+
+    return fields.join(", ");
+}
+
+void ModbusDecoder::run()
+{
+    exec();
+}
+
+void ModbusDecoder::input(const QByteArray &bytes, const QString &peer, bool isRx, qint64 timestamp)
+{
+    if (!isWorking() || bytes.isEmpty()) {
+        return;
+    }
+
+    xToolsProfilerScope scope(profilerStage());
+    m_mutex.lock();
+    m_statistics.bytes += bytes.size();
+    Stream &stream = isRx ? m_rxStreams[peer] : m_txStreams[peer];
+    if (m_parameters.framing == FramingTcp) {
+        stream.buffer.append(bytes);
+        inputTcp(stream, peer, isRx, timestamp);
+    } else {
+        // The timestamp is taken when the last byte is read, the first byte is received the time
+        // of the other bytes earlier.
+        const qint64 characterTime = 11000000000LL / qMax(1, m_parameters.baudRate);
+        const qint64 firstByteTime = timestamp - (bytes.size() - 1) * characterTime;
+        if (!stream.buffer.isEmpty() && firstByteTime - stream.lastTimestamp > silentInterval()) {
+            flushRtu(stream, peer, isRx);
+        }
+
+        stream.buffer.append(bytes);
+        stream.lastTimestamp = timestamp;
+        inputRtu(stream, peer, isRx, timestamp);
+    }
+    m_mutex.unlock();
+}
+
+qint64 ModbusDecoder::silentInterval() const
+{
+    if (m_parameters.silentInterval > 0) {
+        return m_parameters.silentInterval * qint64(1000);
+    }
+
+    if (m_parameters.baudRate > 19200) {
+        return 1750000;
+    }
+
+    return 38500000000LL / qMax(1, m_parameters.baudRate);
+}
+
+void ModbusDecoder::inputRtu(Stream &stream, const QString &peer, bool isRx, qint64 timestamp)
+{
+    const char *data = stream.buffer.constData();
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    const int size = stream.buffer.size();
+    int begin = 0;
+    while (stream.scanned < size) {
+        stream.crc = xIO::crc16Modbus(data + stream.scanned, 1, stream.crc);
+        stream.scanned++;
+
+        // The crc of a frame with its crc is 0.
+        const int length = stream.scanned - begin;
+        if (length >= 4 && stream.crc == 0 && isRtuFrameLength(bytes + begin, length)) {
+            Row row;
+            row.timestamp = timestamp;
+            row.isRx = isRx;
+            row.peer = peer;
+            row.unitId = bytes[begin];
+            row.bytes = QByteArray(data + begin, length);
+            decode(row, bytes + begin + 1, length - 3);
+            appendRow(row);
+        } else if (length >= 256) {
+            // Longer than any frame, the bytes are dropped as a crc error.
+            Row row;
+            row.timestamp = timestamp;
+            row.isRx = isRx;
+            row.peer = peer;
+            row.unitId = bytes[begin];
+            row.functionCode = bytes[begin + 1] & 0x7f;
+            row.isCrcValid = false;
+            row.bytes = QByteArray(data + begin, length);
+            m_statistics.crcErrors++;
+            appendRow(row);
+        } else {
+            continue;
+        }
+
+        begin = stream.scanned;
+        stream.crc = 0xffff;
+    }
+
+    stream.buffer.remove(0, begin);
+    stream.scanned -= begin;
+}
+
+void ModbusDecoder::flushRtu(Stream &stream, const QString &peer, bool isRx)
+{
+    // The bytes before a silent interval that are not a frame.
+    const QByteArray &buffer = stream.buffer;
+    Row row;
+    row.timestamp = stream.lastTimestamp;
+    row.isRx = isRx;
+    row.peer = peer;
+    row.unitId = quint8(buffer.at(0));
+    row.functionCode = buffer.size() > 1 ? buffer.at(1) & 0x7f : 0;
+    row.isCrcValid = false;
+    row.bytes = buffer;
+    m_statistics.crcErrors++;
+    appendRow(row);
+
+    stream.buffer.clear();
+    stream.crc = 0xffff;
+    stream.scanned = 0;
+}
+
+void ModbusDecoder::inputTcp(Stream &stream, const QString &peer, bool isRx, qint64 timestamp)
+{
+    const QByteArray &buffer = stream.buffer;
+    const uchar *data = reinterpret_cast<const uchar *>(buffer.constData());
+    int offset = 0;
+    bool isResyncing = false;
+    while (buffer.size() - offset >= 8) {
+        const uchar *header = data + offset;
+        const quint16 protocolId = uint16At(header + 2);
+        const quint16 length = uint16At(header + 4);
+        if (protocolId != 0 || length < 2 || length > 254) {
+            // Resync a byte at a time, the skipped bytes are counted as one invalid frame.
+            if (!isResyncing) {
+                isResyncing = true;
+                m_statistics.invalidFrames++;
+            }
+            offset++;
+            continue;
+        }
+
+        if (buffer.size() - offset < 6 + length) {
+            break;
+        }
+
+        isResyncing = false;
+        Row row;
+        row.timestamp = timestamp;
+        row.isRx = isRx;
+        row.peer = peer;
+        row.transactionId = uint16At(header);
+        row.unitId = header[6];
+        row.bytes = QByteArray(reinterpret_cast<const char *>(header), 6 + length);
+        decode(row, header + 7, length - 1);
+        appendRow(row);
+        offset += 6 + length;
+    }
+
+    stream.buffer.remove(0, offset);
+}
+
+void ModbusDecoder::decode(Row &row, const uchar *pdu, int size)
+{
+    m_statistics.frames++;
+    row.functionCode = pdu[0] & 0x7f;
+    FunctionStatistics &functionStatistics = m_statistics.functions[row.functionCode];
+    const int id = m_parameters.framing == FramingTcp ? row.transactionId : row.unitId;
+    const quint32 key = (quint32(id) << 8) | quint32(row.functionCode);
+    auto it = m_pendingRequests.find(key);
+
+    if (pdu[0] & 0x80) {
+        row.frameType = FrameTypeResponse;
+        row.exceptionCode = size >= 2 ? pdu[1] : 0;
+        row.isValid = size == 2;
+        if (it != m_pendingRequests.end()) {
+            row.address = it->address;
+            m_pendingRequests.erase(it);
+        }
+        functionStatistics.responses++;
+        functionStatistics.exceptions++;
+        m_statistics.invalidFrames += row.isValid ? 0 : 1;
+        return;
+    }
+
+    // The length tells a request from a response of the most function codes, the others are
+    // responses if a request is pending.
+    bool isResponse = it != m_pendingRequests.end();
+    const int fc = row.functionCode;
+    if (fc >= 0x01 && fc <= 0x04) {
+        const bool isRequest = size == 5;
+        const bool isReply = size >= 2 && size == 2 + pdu[1];
+        isResponse = isRequest != isReply ? isReply : isResponse;
+    } else if (fc == 0x0f || fc == 0x10) {
+        const bool isRequest = size >= 6 && size == 6 + pdu[5];
+        const bool isReply = size == 5;
+        isResponse = isRequest != isReply ? isReply : isResponse;
+    }
+
+    row.frameType = isResponse ? FrameTypeResponse : FrameTypeRequest;
+    if (!isResponse) {
+        functionStatistics.requests++;
+        if (size >= 5) {
+            row.address = uint16At(pdu + 1);
+        }
+
+        if (fc >= 0x01 && fc <= 0x04) {
+            row.isValid = size == 5;
+            row.count = row.isValid ? uint16At(pdu + 3) : 0;
+        } else if (fc == 0x05 || fc == 0x06) {
+            row.isValid = size == 5;
+            if (row.isValid) {
+                const quint16 value = uint16At(pdu + 3);
+                row.count = 1;
+                row.values.append(fc == 0x05 ? (value == 0xff00 ? 1 : 0) : value);
+            }
+        } else if (fc == 0x0f || fc == 0x10) {
+            row.isValid = size >= 6 && size == 6 + pdu[5];
+            if (row.isValid) {
+                row.count = uint16At(pdu + 3);
+                row.values = fc == 0x0f ? bitValues(pdu + 6, pdu[5], row.count)
+                                        : registerValues(pdu + 6, qMin<int>(row.count, pdu[5] / 2));
+            }
+        }
+
+        // Requests without responses(broadcasts, timeouts) would pile up.
+        if (m_pendingRequests.size() >= 4096) {
+            m_pendingRequests.clear();
+        }
+        m_pendingRequests.insert(key, PendingRequest{fc, row.address, row.count});
+    } else {
+        functionStatistics.responses++;
+        int requestCount = -1;
+        if (it != m_pendingRequests.end()) {
+            row.address = it->address;
+            requestCount = it->count;
+            m_pendingRequests.erase(it);
+        }
+
+        if (fc == 0x01 || fc == 0x02) {
+            row.isValid = size >= 2 && size == 2 + pdu[1];
+            if (row.isValid) {
+                row.count = requestCount > 0 ? requestCount : pdu[1] * 8;
+                row.values = bitValues(pdu + 2, pdu[1], row.count);
+            }
+        } else if (fc == 0x03 || fc == 0x04) {
+            row.isValid = size >= 2 && size == 2 + pdu[1] && pdu[1] % 2 == 0;
+            if (row.isValid) {
+                row.count = pdu[1] / 2;
+                row.values = registerValues(pdu + 2, row.count);
+            }
+        } else if (fc == 0x05 || fc == 0x06) {
+            row.isValid = size == 5;
+            if (row.isValid) {
+                const quint16 value = uint16At(pdu + 3);
+                row.address = uint16At(pdu + 1);
+                row.count = 1;
+                row.values.append(fc == 0x05 ? (value == 0xff00 ? 1 : 0) : value);
+            }
+        } else if (fc == 0x0f || fc == 0x10) {
+            row.isValid = size == 5;
+            if (row.isValid) {
+                row.address = uint16At(pdu + 1);
+                row.count = uint16At(pdu + 3);
+            }
+        }
+    }
+
+    m_statistics.invalidFrames += row.isValid ? 0 : 1;
+}
+
+void ModbusDecoder::appendRow(const Row &row)
+{
+    m_rows.append(row);
+    while (m_rows.size() > qMax(1, m_parameters.maxRows)) {
+        m_rows.removeFirst();
+        m_statistics.droppedRows++;
+    }
+}
+
+void ModbusDecoder::onTimeout()
+{
+    m_mutex.lock();
+    if (m_parameters.framing == FramingRtu) {
+        const qint64 now = xToolsCaptureFile::currentTimestamp();
+        const qint64 interval = silentInterval();
+        for (auto it = m_rxStreams.begin(); it != m_rxStreams.end(); ++it) {
+            if (!it->buffer.isEmpty() && now - it->lastTimestamp > interval) {
+                flushRtu(it.value(), it.key(), true);
+            }
+        }
+        for (auto it = m_txStreams.begin(); it != m_txStreams.end(); ++it) {
+            if (!it->buffer.isEmpty() && now - it->lastTimestamp > interval) {
+                flushRtu(it.value(), it.key(), false);
+            }
+        }
+    }
+
+    bool hasRows = !m_rows.isEmpty();
+    bool changed = m_statistics.frames != m_lastFrames;
+    m_lastFrames = m_statistics.frames;
+    m_mutex.unlock();
+
+    if (hasRows) {
+        emit rowsAvailable();
+    }
+
+    if (changed) {
+        emit statisticsChanged();
+    }
+}
+
+bool ModbusDecoder::isRtuFrameLength(const uchar *frame, int length)
+{
+    // The length of the unit id, the pdu and the crc.
+    const int fc = frame[1];
+    if (fc & 0x80) {
+        return length == 5;
+    }
+
+    if (fc >= 0x01 && fc <= 0x04) {
+        return length == 8 || length == 5 + frame[2];
+    } else if (fc == 0x05 || fc == 0x06) {
+        return length == 8;
+    } else if (fc == 0x0f || fc == 0x10) {
+        return length == 8 || (length >= 9 && length == 9 + frame[6]);
+    }
+
+    return fc != 0;
+}
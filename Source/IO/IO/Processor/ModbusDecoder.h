@@ -0,0 +1,151 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+
+#include "../AbstractIO.h"
+
+/// A passive decoder of modbus traffic, it splits the bytes into frames and decodes them into rows
+/// without changing the bytes. inputRx() and inputTx() should be called in the thread of the device
+/// with the timestamps taken when the bytes are read or written, see
+/// xToolsCaptureFile::currentTimestamp().
+///
+/// RTU frames are split by the silent interval(3.5 characters) between two reads. A read may hold
+/// more than one frame, so a frame also ends where the crc of the bytes is valid and the length
+/// fits the function code, the crc is updated a byte at a time and never computed twice. USB serial
+/// adapters deliver the bytes in batches of several milliseconds, a longer silent interval can be
+/// set for them. TCP frames are split by the length of the MBAP header. Every peer("from" or "to")
+/// has its own stream.
+///
+/// A frame is a response if a request of the same function code(and transaction id for TCP) is
+/// pending, the address of a response is taken from its request.
+class ModbusDecoder : public AbstractIO
+{
+    Q_OBJECT
+public:
+    enum Framing { FramingRtu, FramingTcp };
+    enum FrameType { FrameTypeRequest, FrameTypeResponse };
+
+    struct Parameters
+    {
+        int framing{FramingRtu};
+        int baudRate{115200};  // RTU, the silent interval is 1750us above 19200 bits/s.
+        int silentInterval{0}; // us, RTU, 0 = 3.5 characters of the baud rate.
+        int maxRows{10000};    // Rows not taken yet, the oldest rows are dropped.
+    };
+
+    struct Row
+    {
+        qint64 timestamp{0}; // ns since epoch
+        bool isRx{true};
+        QString peer;
+        int frameType{FrameTypeRequest};
+        int unitId{0};
+        int transactionId{-1}; // TCP only.
+        int functionCode{0};   // Without the exception bit.
+        int exceptionCode{0};  // 0 = not an exception.
+        int address{-1};       // -1 = unknown.
+        int count{0};
+        QVector<quint16> values;
+        bool isValid{true};    // The pdu fits the function code.
+        bool isCrcValid{true}; // RTU only.
+        QByteArray bytes;
+    };
+
+    struct FunctionStatistics
+    {
+        qint64 requests{0};
+        qint64 responses{0};
+        qint64 exceptions{0};
+    };
+
+    struct Statistics
+    {
+        qint64 frames{0};
+        qint64 bytes{0};
+        qint64 crcErrors{0};
+        qint64 invalidFrames{0}; // Invalid MBAP headers and pdus that don't fit the function code.
+        qint64 droppedRows{0};
+        QMap<int, FunctionStatistics> functions; // The key is the function code.
+    };
+
+public:
+    explicit ModbusDecoder(QObject *parent = nullptr);
+
+    /// The bytes are handled as bytes received now.
+    void inputBytes(const QByteArray &bytes) override;
+    QVariantMap save() const override;
+    void load(const QVariantMap &data) override;
+
+    void inputRx(const QByteArray &bytes, const QString &from, qint64 timestamp);
+    void inputTx(const QByteArray &bytes, const QString &to, qint64 timestamp);
+
+    Parameters parameters();
+    void setParameters(const Parameters &parameters);
+    Statistics statistics();
+    void reset();
+    /// The rows decoded since the last call.
+    QList<Row> takeRows();
+
+    static QString functionName(int functionCode);
+    /// "address 0, count 10, values 0001 0002" for example.
+    static QString rowText(const Row &row);
+
+signals:
+    /// Emitted at most 10 times a second.
+    void rowsAvailable();
+    void statisticsChanged();
+
+protected:
+    void run() override;
+
+private:
+    struct Stream
+    {
+        QByteArray buffer;
+        quint16 crc{0xffff}; // The crc of the bytes [0, scanned) of the buffer.
+        int scanned{0};
+        qint64 lastTimestamp{0};
+    };
+
+    struct PendingRequest
+    {
+        int functionCode;
+        int address;
+        int count;
+    };
+
+    Parameters m_parameters;
+    QMutex m_mutex;
+    QHash<QString, Stream> m_rxStreams;
+    QHash<QString, Stream> m_txStreams;
+    // The key is "unit id << 8 | function code" for RTU, "transaction id << 8 | function code"
+    // for TCP.
+    QHash<quint32, PendingRequest> m_pendingRequests;
+    QList<Row> m_rows;
+    Statistics m_statistics;
+    qint64 m_lastFrames{0};
+
+private:
+    void input(const QByteArray &bytes, const QString &peer, bool isRx, qint64 timestamp);
+    qint64 silentInterval() const;
+    void inputRtu(Stream &stream, const QString &peer, bool isRx, qint64 timestamp);
+    void flushRtu(Stream &stream, const QString &peer, bool isRx);
+    void inputTcp(Stream &stream, const QString &peer, bool isRx, qint64 timestamp);
+    void decode(Row &row, const uchar *pdu, int size);
+    void appendRow(const Row &row);
+    void onTimeout();
+
+    static bool isRtuFrameLength(const uchar *frame, int length);
+};
@@ -10,6 +10,8 @@
 
 #include <QTimer>
 
+#include "xToolsMetricsServer.h"
+
 Statistician::Statistician(QObject *parent)
     : AbstractIO{parent}
 {
@@ -18,9 +20,9 @@ Statistician::Statistician(QObject *parent)
     connect(timer, &QTimer::timeout, this, &Statistician::updateSpeed);
 
     connect(this, &Statistician::started, this, [this, timer]() {
-        this->m_frames = 0;
-        this->m_bytes = 0;
+        this->m_rateMeter.reset();
         this->m_speed = 0;
+        this->m_lastFrames = 0;
 
         emit this->framesChanged();
         emit this->bytesChanged();
@@ -30,34 +32,73 @@ Statistician::Statistician(QObject *parent)
     });
 
     connect(this, &Statistician::finished, this, [timer]() { timer->stop(); });
+
+    // The counters are atomic, they are read in the thread of the metrics server directly.
+    m_metricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            xToolsMetricsServer::Labels labels{qMakePair(QString("statistician"),
+                                                         profilerStage()->name())};
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_statistician_bytes",
+                                            "Bytes counted by the statistician.",
+                                            labels,
+                                            m_rateMeter.totalBytes());
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_statistician_frames",
+                                            "Frames counted by the statistician.",
+                                            labels,
+                                            m_rateMeter.totalFrames());
+
+            const QString windows[] = {QString("1s"), QString("10s"), QString("60s")};
+            for (int window = xToolsRateMeter::Window1s; window <= xToolsRateMeter::Window60s;
+                 window++) {
+                xToolsMetricsServer::Labels windowLabels = labels;
+                windowLabels.append(qMakePair(QString("window"), windows[window]));
+                xToolsMetricsServer::addGauge(samples,
+                                              "xtools_statistician_bytes_per_second",
+                                              "The average byte rate in the window.",
+                                              windowLabels,
+                                              m_rateMeter.rate(window).bytesPerSecond);
+            }
+        });
+}
+
+Statistician::~Statistician()
+{
+    xToolsMetricsServer::instance()->removeCollector(m_metricsCollector);
 }
 
-int Statistician::frames()
+qint64 Statistician::frames()
 {
-    return m_frames;
+    return m_rateMeter.totalFrames();
 }
 
-int Statistician::bytes()
+qint64 Statistician::bytes()
 {
-    return m_bytes;
+    return m_rateMeter.totalBytes();
 }
 
-int Statistician::speed()
+qint64 Statistician::speed()
 {
     return m_speed;
 }
 
+xToolsRateMeter::Rate Statistician::rate(int window)
+{
+    return m_rateMeter.rate(window);
+}
+
+xToolsRateMeter::Rate Statistician::peakRate()
+{
+    return m_rateMeter.peakRate();
+}
+
 void Statistician::inputBytes(const QByteArray &bytes)
 {
     if (isEnable()) {
         if (isWorking()) {
-            m_frames++;
-            m_bytes += bytes.size();
-
-            emit framesChanged();
-            emit bytesChanged();
-
-            m_tempBytes.append(bytes);
+            xToolsProfilerScope scope(profilerStage());
+            m_rateMeter.add(bytes.size());
         }
     } else {
         emit outputBytes(bytes);
@@ -71,7 +112,14 @@ void Statistician::run()
 
 void Statistician::updateSpeed()
 {
-    m_speed = m_tempBytes.size();
-    m_tempBytes.clear();
+    m_speed = qRound64(m_rateMeter.rate(xToolsRateMeter::Window1s).bytesPerSecond);
     emit speedChanged();
+
+    // Nothing has been changed if no frame has been received.
+    qint64 frames = m_rateMeter.totalFrames();
+    if (frames != m_lastFrames) {
+        m_lastFrames = frames;
+        emit framesChanged();
+        emit bytesChanged();
+    }
 }
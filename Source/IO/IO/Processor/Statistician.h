@@ -8,24 +8,28 @@
  **************************************************************************************************/
 #pragma once
 
-#include <QMutex>
-
 #include "../AbstractIO.h"
+#include "xToolsRateMeter.h"
 
+/// The counters are updated without any signal, the notify signals are emitted once a second.
 class Statistician : public AbstractIO
 {
     Q_OBJECT
-    Q_PROPERTY(int frames READ frames NOTIFY framesChanged)
-    Q_PROPERTY(int bytes READ bytes NOTIFY bytesChanged)
-    Q_PROPERTY(int speed READ speed NOTIFY speedChanged)
+    Q_PROPERTY(qint64 frames READ frames NOTIFY framesChanged)
+    Q_PROPERTY(qint64 bytes READ bytes NOTIFY bytesChanged)
+    Q_PROPERTY(qint64 speed READ speed NOTIFY speedChanged)
 public:
     explicit Statistician(QObject *parent = nullptr);
+    ~Statistician() override;
 
     void inputBytes(const QByteArray &bytes) override;
 
-    int frames();
-    int bytes();
-    int speed();
+    qint64 frames();
+    qint64 bytes();
+    /// Bytes per second in the last second.
+    qint64 speed();
+    xToolsRateMeter::Rate rate(int window);
+    xToolsRateMeter::Rate peakRate();
 
     QString framesString();
     QString bytesString();
@@ -40,11 +44,10 @@ protected:
     virtual void run() final;
 
 private:
-    int m_frames{0};
-    int m_bytes{0};
-    int m_speed{0};
-
-    QByteArray m_tempBytes;
+    xToolsRateMeter m_rateMeter;
+    qint64 m_speed{0};
+    qint64 m_lastFrames{0};
+    int m_metricsCollector;
 
 private:
     void updateSpeed();
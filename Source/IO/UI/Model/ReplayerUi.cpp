@@ -0,0 +1,169 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ReplayerUi.h"
+#include "ui_ReplayerUi.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+
+#include "../../IO/Model/Replayer.h"
+
+namespace xTools {
+
+ReplayerUi::ReplayerUi(QWidget *parent)
+    : AbstractIOUi{parent}
+    , ui(new Ui::ReplayerUi)
+    , m_replayer{nullptr}
+{
+    ui->setupUi(this);
+    ui->comboBoxTiming->addItem(tr("Original"), Replayer::TimingModeOriginal);
+    ui->comboBoxTiming->addItem(tr("Scaled"), Replayer::TimingModeScaled);
+    ui->comboBoxTiming->addItem(tr("As fast as possible"), Replayer::TimingModeFast);
+    ui->comboBoxDirection->addItem(tr("All"), Replayer::DirectionFilterAll);
+    ui->comboBoxDirection->addItem(tr("Rx"), Replayer::DirectionFilterRx);
+    ui->comboBoxDirection->addItem(tr("Tx"), Replayer::DirectionFilterTx);
+
+    connect(ui->comboBoxTiming,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &ReplayerUi::updateUiState);
+    connect(ui->lineEditFile, &QLineEdit::textChanged, this, &ReplayerUi::updateUiState);
+    connect(ui->pushButtonBrowse,
+            &QPushButton::clicked,
+            this,
+            &ReplayerUi::onBrowseButtonClicked);
+    connect(ui->pushButtonStart, &QPushButton::clicked, this, &ReplayerUi::onStartButtonClicked);
+    connect(ui->pushButtonStop, &QPushButton::clicked, this, &ReplayerUi::onStopButtonClicked);
+
+    updateUiState();
+    updateInfo();
+}
+
+ReplayerUi::~ReplayerUi()
+{
+    delete ui;
+}
+
+QVariantMap ReplayerUi::save() const
+{
+    QVariantMap map;
+    map["fileName"] = ui->lineEditFile->text();
+    map["timingMode"] = ui->comboBoxTiming->currentData().toInt();
+    map["speed"] = ui->doubleSpinBoxSpeed->value();
+    map["directionFilter"] = ui->comboBoxDirection->currentData().toInt();
+    map["loop"] = ui->checkBoxLoop->isChecked();
+    map["spinTime"] = ui->spinBoxSpinTime->value();
+    return map;
+}
+
+void ReplayerUi::load(const QVariantMap &parameters)
+{
+    if (parameters.isEmpty()) {
+        return;
+    }
+
+    auto setCurrentData = [](QComboBox *comboBox, const QVariant &data) {
+        int index = comboBox->findData(data.toInt());
+        comboBox->setCurrentIndex(index == -1 ? 0 : index);
+    };
+
+    ui->lineEditFile->setText(parameters.value("fileName").toString());
+    setCurrentData(ui->comboBoxTiming, parameters.value("timingMode"));
+    ui->doubleSpinBoxSpeed->setValue(parameters.value("speed", 1.0).toDouble());
+    setCurrentData(ui->comboBoxDirection, parameters.value("directionFilter"));
+    ui->checkBoxLoop->setChecked(parameters.value("loop", false).toBool());
+    ui->spinBoxSpinTime->setValue(parameters.value("spinTime", 1000).toInt());
+    updateUiState();
+}
+
+void ReplayerUi::setupIO(AbstractIO *io)
+{
+    if (m_replayer) {
+        disconnect(m_replayer, nullptr, this, nullptr);
+    }
+
+    m_replayer = qobject_cast<Replayer *>(io);
+    if (!m_replayer) {
+        return;
+    }
+
+    connect(m_replayer, &Replayer::statisticsChanged, this, &ReplayerUi::updateInfo);
+    connect(m_replayer, &Replayer::started, this, &ReplayerUi::updateUiState);
+    connect(m_replayer, &Replayer::finished, this, &ReplayerUi::updateUiState);
+    connect(m_replayer, &Replayer::errorOccurred, this, &ReplayerUi::onErrorOccurred);
+    updateUiState();
+    updateInfo();
+}
+
+void ReplayerUi::updateUiState()
+{
+    bool isScaled = ui->comboBoxTiming->currentData().toInt() == Replayer::TimingModeScaled;
+    ui->doubleSpinBoxSpeed->setEnabled(isScaled);
+
+    bool isRunning = m_replayer && m_replayer->isRunning();
+    bool hasFile = !ui->lineEditFile->text().isEmpty();
+    ui->pushButtonStart->setEnabled(m_replayer && !isRunning && hasFile);
+    ui->pushButtonStop->setEnabled(isRunning);
+}
+
+void ReplayerUi::updateInfo()
+{
+    qint64 frames = m_replayer ? m_replayer->frames() : 0;
+    qint64 meanJitter = m_replayer ? m_replayer->meanJitter() : 0;
+    qint64 maxJitter = m_replayer ? m_replayer->maxJitter() : 0;
+    QString info = tr("Frames: %1, jitter(mean/max): %2/%3 us")
+                       .arg(frames)
+                       .arg(meanJitter)
+                       .arg(maxJitter);
+    ui->labelStatistics->setText(info);
+}
+
+void ReplayerUi::onBrowseButtonClicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    tr("Open capture file"),
+                                                    QFileInfo(ui->lineEditFile->text()).path(),
+                                                    tr("Capture File(*.xcap *.pcapng *.pcap)"));
+    if (!fileName.isEmpty()) {
+        ui->lineEditFile->setText(fileName);
+    }
+}
+
+void ReplayerUi::onStartButtonClicked()
+{
+    if (!m_replayer || m_replayer->isRunning()) {
+        return;
+    }
+
+    Replayer::Parameters parameters;
+    parameters.fileName = ui->lineEditFile->text();
+    parameters.timingMode = ui->comboBoxTiming->currentData().toInt();
+    parameters.speed = ui->doubleSpinBoxSpeed->value();
+    parameters.directionFilter = ui->comboBoxDirection->currentData().toInt();
+    parameters.loop = ui->checkBoxLoop->isChecked();
+    parameters.spinTime = ui->spinBoxSpinTime->value();
+    m_replayer->setParameters(parameters);
+    m_replayer->start();
+    updateUiState();
+}
+
+void ReplayerUi::onStopButtonClicked()
+{
+    if (m_replayer) {
+        m_replayer->stop();
+    }
+}
+
+void ReplayerUi::onErrorOccurred(const QString &error)
+{
+    QMessageBox::warning(this, tr("Replay Failed"), error);
+}
+
+} // namespace xTools
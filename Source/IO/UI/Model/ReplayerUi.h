@@ -0,0 +1,44 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "../AbstractIOUi.h"
+
+namespace Ui {
+class ReplayerUi;
+}
+
+namespace xTools {
+
+class Replayer;
+class ReplayerUi : public AbstractIOUi
+{
+    Q_OBJECT
+public:
+    explicit ReplayerUi(QWidget *parent = nullptr);
+    ~ReplayerUi();
+
+    QVariantMap save() const override;
+    void load(const QVariantMap &parameters) override;
+    void setupIO(AbstractIO *io) override;
+
+private:
+    Ui::ReplayerUi *ui;
+    Replayer *m_replayer;
+
+private:
+    void updateUiState();
+    void updateInfo();
+    void onBrowseButtonClicked();
+    void onStartButtonClicked();
+    void onStopButtonClicked();
+    void onErrorOccurred(const QString &error);
+};
+
+} // namespace xTools
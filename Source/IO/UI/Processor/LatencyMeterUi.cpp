@@ -0,0 +1,181 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "LatencyMeterUi.h"
+#include "ui_LatencyMeterUi.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QStandardPaths>
+
+#include "../../IO/Processor/LatencyMeter.h"
+
+LatencyMeterUi::LatencyMeterUi(QWidget *parent)
+    : AbstractIOUi{parent}
+    , ui(new Ui::LatencyMeterUi)
+    , m_latencyMeter{nullptr}
+{
+    ui->setupUi(this);
+    ui->comboBoxMatchRule->addItem(tr("Next RX after TX"), LatencyMeter::MatchRuleNextRx);
+    ui->comboBoxMatchRule->addItem(tr("Sequence field"), LatencyMeter::MatchRuleSequenceField);
+    ui->comboBoxMatchRule->addItem(tr("Modbus transaction id"),
+                                   LatencyMeter::MatchRuleModbusTransactionId);
+    ui->comboBoxSequenceLength->addItem(tr("1 byte"), 1);
+    ui->comboBoxSequenceLength->addItem(tr("2 bytes"), 2);
+    ui->comboBoxSequenceLength->addItem(tr("4 bytes"), 4);
+
+    connect(ui->comboBoxMatchRule,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &LatencyMeterUi::updateParameters);
+    connect(ui->comboBoxSequenceLength,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &LatencyMeterUi::updateParameters);
+    connect(ui->spinBoxSequenceOffset,
+            qOverload<int>(&QSpinBox::valueChanged),
+            this,
+            &LatencyMeterUi::updateParameters);
+    connect(ui->spinBoxTimeout,
+            qOverload<int>(&QSpinBox::valueChanged),
+            this,
+            &LatencyMeterUi::updateParameters);
+    connect(ui->checkBoxBigEndian, &QCheckBox::clicked, this, &LatencyMeterUi::updateParameters);
+    connect(ui->pushButtonExport,
+            &QPushButton::clicked,
+            this,
+            &LatencyMeterUi::onExportButtonClicked);
+    connect(ui->pushButtonReset, &QPushButton::clicked, this, [this]() {
+        if (this->m_latencyMeter) {
+            this->m_latencyMeter->reset();
+        }
+    });
+
+    updateInfo();
+}
+
+LatencyMeterUi::~LatencyMeterUi()
+{
+    delete ui;
+}
+
+QVariantMap LatencyMeterUi::save() const
+{
+    QVariantMap map;
+    map["matchRule"] = ui->comboBoxMatchRule->currentData().toInt();
+    map["sequenceOffset"] = ui->spinBoxSequenceOffset->value();
+    map["sequenceLength"] = ui->comboBoxSequenceLength->currentData().toInt();
+    map["bigEndian"] = ui->checkBoxBigEndian->isChecked();
+    map["timeout"] = ui->spinBoxTimeout->value();
+    return map;
+}
+
+void LatencyMeterUi::load(const QVariantMap &parameters)
+{
+    if (parameters.isEmpty()) {
+        return;
+    }
+
+    int index = ui->comboBoxMatchRule->findData(parameters.value("matchRule").toInt());
+    ui->comboBoxMatchRule->setCurrentIndex(index == -1 ? 0 : index);
+    index = ui->comboBoxSequenceLength->findData(parameters.value("sequenceLength").toInt());
+    ui->comboBoxSequenceLength->setCurrentIndex(index == -1 ? 0 : index);
+    ui->spinBoxSequenceOffset->setValue(parameters.value("sequenceOffset").toInt());
+    ui->checkBoxBigEndian->setChecked(parameters.value("bigEndian", true).toBool());
+    ui->spinBoxTimeout->setValue(parameters.value("timeout", 5000).toInt());
+    updateParameters();
+}
+
+void LatencyMeterUi::setupIO(AbstractIO *io)
+{
+    if (m_latencyMeter) {
+        disconnect(m_latencyMeter, nullptr, this, nullptr);
+    }
+
+    m_latencyMeter = qobject_cast<LatencyMeter *>(io);
+    if (!m_latencyMeter) {
+        return;
+    }
+
+    connect(m_latencyMeter,
+            &LatencyMeter::statisticsChanged,
+            this,
+            &LatencyMeterUi::updateInfo);
+    updateParameters();
+    updateInfo();
+}
+
+void LatencyMeterUi::updateParameters()
+{
+    int matchRule = ui->comboBoxMatchRule->currentData().toInt();
+    bool isSequenceField = matchRule == LatencyMeter::MatchRuleSequenceField;
+    ui->spinBoxSequenceOffset->setEnabled(isSequenceField);
+    ui->comboBoxSequenceLength->setEnabled(isSequenceField);
+    ui->checkBoxBigEndian->setEnabled(isSequenceField);
+
+    if (!m_latencyMeter) {
+        return;
+    }
+
+    LatencyMeter::Parameters parameters;
+    parameters.matchRule = matchRule;
+    parameters.sequenceOffset = ui->spinBoxSequenceOffset->value();
+    parameters.sequenceLength = ui->comboBoxSequenceLength->currentData().toInt();
+    parameters.bigEndian = ui->checkBoxBigEndian->isChecked();
+    parameters.timeout = ui->spinBoxTimeout->value();
+    m_latencyMeter->setParameters(parameters);
+}
+
+void LatencyMeterUi::updateInfo()
+{
+    LatencyMeter::Statistics statistics;
+    if (m_latencyMeter) {
+        statistics = m_latencyMeter->statistics();
+    }
+
+    QString info = tr("Matched: %1, timeouts: %2, unmatched: %3")
+                       .arg(statistics.matched)
+                       .arg(statistics.timeouts)
+                       .arg(statistics.unmatched);
+    info += "\n";
+    info += tr("Min: %1us, mean: %2us, max: %3us")
+                .arg(statistics.min)
+                .arg(statistics.mean, 0, 'f', 1)
+                .arg(statistics.max);
+    info += "\n";
+    info += tr("p50: %1us, p90: %2us, p99: %3us, p99.9: %4us")
+                .arg(statistics.p50)
+                .arg(statistics.p90)
+                .arg(statistics.p99)
+                .arg(statistics.p999);
+    ui->labelStatistics->setText(info);
+}
+
+void LatencyMeterUi::onExportButtonClicked()
+{
+    if (!m_latencyMeter) {
+        return;
+    }
+
+    QString path = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+    QString filter = tr("CSV File(*.csv);;JSON File(*.json)");
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export latency histogram"),
+                                                    path + "/latency.csv",
+                                                    filter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    bool ok = fileName.endsWith(".json", Qt::CaseInsensitive)
+                  ? m_latencyMeter->exportJson(fileName)
+                  : m_latencyMeter->exportCsv(fileName);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Export Failed"), tr("Failed to write %1.").arg(fileName));
+    }
+}
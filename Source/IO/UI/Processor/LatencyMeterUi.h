@@ -0,0 +1,37 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "../AbstractIOUi.h"
+
+namespace Ui {
+class LatencyMeterUi;
+}
+
+class LatencyMeter;
+class LatencyMeterUi : public AbstractIOUi
+{
+    Q_OBJECT
+public:
+    LatencyMeterUi(QWidget *parent = nullptr);
+    ~LatencyMeterUi();
+
+    QVariantMap save() const override;
+    void load(const QVariantMap &parameters) override;
+    void setupIO(AbstractIO *io) override;
+
+private:
+    Ui::LatencyMeterUi *ui;
+    LatencyMeter *m_latencyMeter;
+
+private:
+    void updateParameters();
+    void updateInfo();
+    void onExportButtonClicked();
+};
@@ -0,0 +1,238 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "LoadGeneratorUi.h"
+#include "ui_LoadGeneratorUi.h"
+
+#include "../../IO/Processor/LoadGenerator.h"
+#include "../../xIO.h"
+
+LoadGeneratorUi::LoadGeneratorUi(QWidget *parent)
+    : AbstractIOUi{parent}
+    , ui(new Ui::LoadGeneratorUi)
+    , m_loadGenerator{nullptr}
+{
+    ui->setupUi(this);
+    const QList<int> types = LoadGenerator::supportedCommunicationTypes();
+    for (int type : types) {
+        auto communicationType = static_cast<xIO::CommunicationType>(type);
+        ui->comboBoxType->addItem(xIO::CommunicationName(communicationType), type);
+    }
+    xIO::setupWebSocketDataChannel(ui->comboBoxChannel);
+    ui->comboBoxSizeDistribution->addItem(tr("Fixed"), LoadGenerator::SizeFixed);
+    ui->comboBoxSizeDistribution->addItem(tr("Uniform"), LoadGenerator::SizeUniform);
+    ui->comboBoxSizeDistribution->addItem(tr("Normal"), LoadGenerator::SizeNormal);
+    ui->comboBoxPayload->addItem(tr("Random"), LoadGenerator::PayloadRandom);
+    ui->comboBoxPayload->addItem(tr("Template"), LoadGenerator::PayloadTemplate);
+    xIO::setupCrcAlgorithm(ui->comboBoxCrcAlgorithm);
+
+    connect(ui->comboBoxType,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &LoadGeneratorUi::updateUiState);
+    connect(ui->comboBoxSizeDistribution,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &LoadGeneratorUi::updateUiState);
+    connect(ui->comboBoxPayload,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &LoadGeneratorUi::updateUiState);
+    connect(ui->checkBoxCrc, &QCheckBox::clicked, this, &LoadGeneratorUi::updateUiState);
+    connect(ui->pushButtonStart,
+            &QPushButton::clicked,
+            this,
+            &LoadGeneratorUi::onStartButtonClicked);
+    connect(ui->pushButtonStop, &QPushButton::clicked, this, &LoadGeneratorUi::onStopButtonClicked);
+
+    updateUiState();
+    updateInfo();
+}
+
+LoadGeneratorUi::~LoadGeneratorUi()
+{
+    delete ui;
+}
+
+QVariantMap LoadGeneratorUi::save() const
+{
+    QVariantMap map;
+    map["communicationType"] = ui->comboBoxType->currentData().toInt();
+    map["serverAddress"] = ui->lineEditServerAddress->text();
+    map["serverPort"] = ui->spinBoxServerPort->value();
+    map["channel"] = ui->comboBoxChannel->currentData().toInt();
+    map["clients"] = ui->spinBoxClients->value();
+    map["rate"] = ui->spinBoxRate->value();
+    map["duration"] = ui->spinBoxDuration->value();
+    map["sizeDistribution"] = ui->comboBoxSizeDistribution->currentData().toInt();
+    map["size"] = ui->spinBoxSize->value();
+    map["minSize"] = ui->spinBoxMinSize->value();
+    map["maxSize"] = ui->spinBoxMaxSize->value();
+    map["sizeStdDev"] = ui->spinBoxStdDev->value();
+    map["payload"] = ui->comboBoxPayload->currentData().toInt();
+    map["payloadTemplate"] = ui->lineEditTemplate->text();
+    map["sequence"] = ui->checkBoxSequence->isChecked();
+    map["timestamp"] = ui->checkBoxTimestamp->isChecked();
+    map["crc"] = ui->checkBoxCrc->isChecked();
+    map["crcAlgorithm"] = ui->comboBoxCrcAlgorithm->currentData().toInt();
+    map["crcBigEndian"] = ui->checkBoxCrcBigEndian->isChecked();
+    return map;
+}
+
+void LoadGeneratorUi::load(const QVariantMap &parameters)
+{
+    if (parameters.isEmpty()) {
+        return;
+    }
+
+    auto setCurrentData = [](QComboBox *comboBox, const QVariant &data) {
+        int index = comboBox->findData(data.toInt());
+        comboBox->setCurrentIndex(index == -1 ? 0 : index);
+    };
+
+    setCurrentData(ui->comboBoxType, parameters.value("communicationType"));
+    ui->lineEditServerAddress->setText(parameters.value("serverAddress", "127.0.0.1").toString());
+    ui->spinBoxServerPort->setValue(parameters.value("serverPort", 51234).toInt());
+    setCurrentData(ui->comboBoxChannel, parameters.value("channel"));
+    ui->spinBoxClients->setValue(parameters.value("clients", 1).toInt());
+    ui->spinBoxRate->setValue(parameters.value("rate", 1000).toInt());
+    ui->spinBoxDuration->setValue(parameters.value("duration", 0).toInt());
+    setCurrentData(ui->comboBoxSizeDistribution, parameters.value("sizeDistribution"));
+    ui->spinBoxSize->setValue(parameters.value("size", 64).toInt());
+    ui->spinBoxMinSize->setValue(parameters.value("minSize", 16).toInt());
+    ui->spinBoxMaxSize->setValue(parameters.value("maxSize", 256).toInt());
+    ui->spinBoxStdDev->setValue(parameters.value("sizeStdDev", 16).toInt());
+    setCurrentData(ui->comboBoxPayload, parameters.value("payload"));
+    ui->lineEditTemplate->setText(parameters.value("payloadTemplate").toString());
+    ui->checkBoxSequence->setChecked(parameters.value("sequence", false).toBool());
+    ui->checkBoxTimestamp->setChecked(parameters.value("timestamp", false).toBool());
+    ui->checkBoxCrc->setChecked(parameters.value("crc", false).toBool());
+    setCurrentData(ui->comboBoxCrcAlgorithm, parameters.value("crcAlgorithm"));
+    ui->checkBoxCrcBigEndian->setChecked(parameters.value("crcBigEndian", true).toBool());
+    updateUiState();
+}
+
+void LoadGeneratorUi::setupIO(AbstractIO *io)
+{
+    if (m_loadGenerator) {
+        disconnect(m_loadGenerator, nullptr, this, nullptr);
+    }
+
+    m_loadGenerator = qobject_cast<LoadGenerator *>(io);
+    if (!m_loadGenerator) {
+        return;
+    }
+
+    connect(m_loadGenerator,
+            &LoadGenerator::statisticsChanged,
+            this,
+            &LoadGeneratorUi::updateInfo);
+    connect(m_loadGenerator,
+            &LoadGenerator::isWorkingChanged,
+            this,
+            &LoadGeneratorUi::updateUiState);
+    updateUiState();
+    updateInfo();
+}
+
+void LoadGeneratorUi::updateUiState()
+{
+    int type = ui->comboBoxType->currentData().toInt();
+    int webSocketClient = static_cast<int>(xIO::CommunicationType::WebSocketClient);
+    ui->comboBoxChannel->setEnabled(type == webSocketClient);
+
+    int distribution = ui->comboBoxSizeDistribution->currentData().toInt();
+    ui->spinBoxStdDev->setEnabled(distribution == LoadGenerator::SizeNormal);
+    ui->spinBoxMinSize->setEnabled(distribution != LoadGenerator::SizeFixed);
+    ui->spinBoxMaxSize->setEnabled(distribution != LoadGenerator::SizeFixed);
+    ui->spinBoxSize->setEnabled(distribution != LoadGenerator::SizeUniform);
+
+    bool isTemplate = ui->comboBoxPayload->currentData().toInt() == LoadGenerator::PayloadTemplate;
+    ui->lineEditTemplate->setEnabled(isTemplate);
+    ui->comboBoxSizeDistribution->setEnabled(!isTemplate);
+
+    ui->comboBoxCrcAlgorithm->setEnabled(ui->checkBoxCrc->isChecked());
+    ui->checkBoxCrcBigEndian->setEnabled(ui->checkBoxCrc->isChecked());
+
+    bool isWorking = m_loadGenerator && m_loadGenerator->isWorking();
+    ui->pushButtonStart->setEnabled(m_loadGenerator && !isWorking);
+    ui->pushButtonStop->setEnabled(isWorking);
+}
+
+void LoadGeneratorUi::updateInfo()
+{
+    LoadGenerator::Statistics statistics;
+    if (m_loadGenerator) {
+        statistics = m_loadGenerator->statistics();
+    }
+
+    QString info = tr("Clients: %1/%2, elapsed: %3s")
+                       .arg(statistics.connectedClients)
+                       .arg(statistics.clients)
+                       .arg(statistics.elapsed / 1000);
+    info += "\n";
+    info += tr("Scheduled: %1, sent: %2, dropped: %3, errors: %4")
+                .arg(statistics.scheduled)
+                .arg(statistics.sent)
+                .arg(statistics.dropped)
+                .arg(statistics.errors);
+    info += "\n";
+    info += tr("TX: %1 msg/s(%2), target: %3 msg/s")
+                .arg(statistics.txRate, 0, 'f', 0)
+                .arg(xToolsRateMeter::speedString(statistics.txByteRate))
+                .arg(statistics.targetRate, 0, 'f', 0);
+    info += "\n";
+    info += tr("RX: %1 msg/s(%2), received: %3")
+                .arg(statistics.rxRate, 0, 'f', 0)
+                .arg(xToolsRateMeter::speedString(statistics.rxByteRate))
+                .arg(statistics.received);
+    ui->labelStatistics->setText(info);
+}
+
+void LoadGeneratorUi::onStartButtonClicked()
+{
+    if (!m_loadGenerator || m_loadGenerator->isRunning()) {
+        return;
+    }
+
+    QVariantMap communicationParameters;
+    communicationParameters.insert("clientAddress", "0.0.0.0");
+    communicationParameters.insert("clientPort", 0);
+    communicationParameters.insert("serverAddress", ui->lineEditServerAddress->text());
+    communicationParameters.insert("serverPort", ui->spinBoxServerPort->value());
+    communicationParameters.insert("channel", ui->comboBoxChannel->currentData().toInt());
+
+    LoadGenerator::Parameters parameters;
+    parameters.communicationType = ui->comboBoxType->currentData().toInt();
+    parameters.communicationParameters = communicationParameters;
+    parameters.clients = ui->spinBoxClients->value();
+    parameters.rate = ui->spinBoxRate->value();
+    parameters.duration = ui->spinBoxDuration->value();
+    parameters.sizeDistribution = ui->comboBoxSizeDistribution->currentData().toInt();
+    parameters.size = ui->spinBoxSize->value();
+    parameters.minSize = ui->spinBoxMinSize->value();
+    parameters.maxSize = ui->spinBoxMaxSize->value();
+    parameters.sizeStdDev = ui->spinBoxStdDev->value();
+    parameters.payload = ui->comboBoxPayload->currentData().toInt();
+    parameters.payloadTemplate = ui->lineEditTemplate->text();
+    parameters.sequence = ui->checkBoxSequence->isChecked();
+    parameters.timestamp = ui->checkBoxTimestamp->isChecked();
+    parameters.crc = ui->checkBoxCrc->isChecked();
+    parameters.crcAlgorithm = ui->comboBoxCrcAlgorithm->currentData().toInt();
+    parameters.crcBigEndian = ui->checkBoxCrcBigEndian->isChecked();
+    m_loadGenerator->setParameters(parameters);
+    m_loadGenerator->start();
+}
+
+void LoadGeneratorUi::onStopButtonClicked()
+{
+    if (m_loadGenerator) {
+        m_loadGenerator->exit();
+        m_loadGenerator->wait();
+    }
+}
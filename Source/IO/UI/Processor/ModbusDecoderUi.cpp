@@ -0,0 +1,199 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "ModbusDecoderUi.h"
+#include "ui_ModbusDecoderUi.h"
+
+#include <QDateTime>
+#include <QHeaderView>
+#include <QStandardItemModel>
+
+#include "../../IO/Processor/ModbusDecoder.h"
+
+// The rows are decoded faster than they can be read, only the latest rows are shown.
+static const int maxShownRows = 1000;
+
+ModbusDecoderUi::ModbusDecoderUi(QWidget *parent)
+    : AbstractIOUi{parent}
+    , ui(new Ui::ModbusDecoderUi)
+    , m_modbusDecoder{nullptr}
+    , m_model{new QStandardItemModel(this)}
+{
+    ui->setupUi(this);
+    ui->comboBoxFraming->addItem(tr("RTU"), ModbusDecoder::FramingRtu);
+    ui->comboBoxFraming->addItem(tr("TCP"), ModbusDecoder::FramingTcp);
+
+    QStringList labels;
+    labels << tr("Time") << tr("Direction") << tr("Unit") << tr("Transaction") << tr("Function")
+           << tr("Type") << tr("Data");
+    m_model->setHorizontalHeaderLabels(labels);
+    ui->tableView->setModel(m_model);
+    ui->tableView->setEditTriggers(QTableView::EditTrigger::NoEditTriggers);
+    ui->tableView->verticalHeader()->hide();
+    ui->tableView->horizontalHeader()->setStretchLastSection(true);
+
+    connect(ui->comboBoxFraming,
+            qOverload<int>(&QComboBox::currentIndexChanged),
+            this,
+            &ModbusDecoderUi::updateParameters);
+    connect(ui->spinBoxBaudRate,
+            qOverload<int>(&QSpinBox::valueChanged),
+            this,
+            &ModbusDecoderUi::updateParameters);
+    connect(ui->spinBoxSilentInterval,
+            qOverload<int>(&QSpinBox::valueChanged),
+            this,
+            &ModbusDecoderUi::updateParameters);
+    connect(ui->pushButtonClear, &QPushButton::clicked, this, [this]() {
+        this->m_model->removeRows(0, this->m_model->rowCount());
+    });
+    connect(ui->pushButtonReset, &QPushButton::clicked, this, [this]() {
+        if (this->m_modbusDecoder) {
+            this->m_modbusDecoder->reset();
+        }
+    });
+
+    updateInfo();
+}
+
+ModbusDecoderUi::~ModbusDecoderUi()
+{
+    delete ui;
+}
+
+QVariantMap ModbusDecoderUi::save() const
+{
+    QVariantMap map;
+    map["framing"] = ui->comboBoxFraming->currentData().toInt();
+    map["baudRate"] = ui->spinBoxBaudRate->value();
+    map["silentInterval"] = ui->spinBoxSilentInterval->value();
+    return map;
+}
+
+void ModbusDecoderUi::load(const QVariantMap &parameters)
+{
+    if (parameters.isEmpty()) {
+        return;
+    }
+
+    int index = ui->comboBoxFraming->findData(parameters.value("framing").toInt());
+    ui->comboBoxFraming->setCurrentIndex(index == -1 ? 0 : index);
+    ui->spinBoxBaudRate->setValue(parameters.value("baudRate", 115200).toInt());
+    ui->spinBoxSilentInterval->setValue(parameters.value("silentInterval", 0).toInt());
+    updateParameters();
+}
+
+void ModbusDecoderUi::setupIO(AbstractIO *io)
+{
+    if (m_modbusDecoder) {
+        disconnect(m_modbusDecoder, nullptr, this, nullptr);
+    }
+
+    m_modbusDecoder = qobject_cast<ModbusDecoder *>(io);
+    if (!m_modbusDecoder) {
+        return;
+    }
+
+    connect(m_modbusDecoder,
+            &ModbusDecoder::statisticsChanged,
+            this,
+            &ModbusDecoderUi::updateInfo);
+    connect(m_modbusDecoder,
+            &ModbusDecoder::rowsAvailable,
+            this,
+            &ModbusDecoderUi::onRowsAvailable);
+    updateParameters();
+    updateInfo();
+}
+
+void ModbusDecoderUi::updateParameters()
+{
+    int framing = ui->comboBoxFraming->currentData().toInt();
+    bool isRtu = framing == ModbusDecoder::FramingRtu;
+    ui->spinBoxBaudRate->setEnabled(isRtu);
+    ui->spinBoxSilentInterval->setEnabled(isRtu);
+
+    if (!m_modbusDecoder) {
+        return;
+    }
+
+    ModbusDecoder::Parameters parameters = m_modbusDecoder->parameters();
+    parameters.framing = framing;
+    parameters.baudRate = ui->spinBoxBaudRate->value();
+    parameters.silentInterval = ui->spinBoxSilentInterval->value();
+    m_modbusDecoder->setParameters(parameters);
+}
+
+void ModbusDecoderUi::updateInfo()
+{
+    ModbusDecoder::Statistics statistics;
+    if (m_modbusDecoder) {
+        statistics = m_modbusDecoder->statistics();
+    }
+
+    QString info = tr("Frames: %1, bytes: %2, crc errors: %3, invalid: %4, dropped rows: %5")
+                       .arg(statistics.frames)
+                       .arg(statistics.bytes)
+                       .arg(statistics.crcErrors)
+                       .arg(statistics.invalidFrames)
+                       .arg(statistics.droppedRows);
+    for (auto it = statistics.functions.constBegin(); it != statistics.functions.constEnd(); ++it) {
+        info += "\n";
+        info += tr("%1(0x%2): requests: %3, responses: %4, exceptions: %5")
+                    .arg(ModbusDecoder::functionName(it.key()))
+                    .arg(it.key(), 2, 16, QChar('0'))
+                    .arg(it->requests)
+                    .arg(it->responses)
+                    .arg(it->exceptions);
+    }
+    ui->labelStatistics->setText(info);
+}
+
+void ModbusDecoderUi::onRowsAvailable()
+{
+    if (!m_modbusDecoder) {
+        return;
+    }
+
+    QList<ModbusDecoder::Row> rows = m_modbusDecoder->takeRows();
+    if (!ui->checkBoxShowRows->isChecked()) {
+        return;
+    }
+
+    const int first = qMax(0, rows.count() - maxShownRows);
+    for (int i = first; i < rows.count(); i++) {
+        const ModbusDecoder::Row &row = rows.at(i);
+        QList<QStandardItem *> items;
+        QDateTime time = QDateTime::fromMSecsSinceEpoch(row.timestamp / 1000000);
+        items << new QStandardItem(time.toString("hh:mm:ss.zzz"));
+        QString direction = row.isRx ? tr("Rx") : tr("Tx");
+        items << new QStandardItem(row.peer.isEmpty() ? direction
+                                                      : QString("%1 %2").arg(direction, row.peer));
+        items << new QStandardItem(QString::number(row.unitId));
+        items << new QStandardItem(row.transactionId < 0 ? QString()
+                                                         : QString::number(row.transactionId));
+        items << new QStandardItem(ModbusDecoder::functionName(row.functionCode));
+        bool isRequest = row.frameType == ModbusDecoder::FrameTypeRequest;
+        items << new QStandardItem(isRequest ? tr("Request") : tr("Response"));
+        items << new QStandardItem(ModbusDecoder::rowText(row));
+        if (!row.isCrcValid || !row.isValid || row.exceptionCode) {
+            for (QStandardItem *item : items) {
+                item->setForeground(Qt::red);
+            }
+        }
+        items.first()->setToolTip(QString(row.bytes.toHex(' ')));
+        m_model->appendRow(items);
+    }
+
+    const int extra = m_model->rowCount() - maxShownRows;
+    if (extra > 0) {
+        m_model->removeRows(0, extra);
+    }
+
+    ui->tableView->scrollToBottom();
+}
@@ -0,0 +1,39 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include "../AbstractIOUi.h"
+
+namespace Ui {
+class ModbusDecoderUi;
+}
+
+class QStandardItemModel;
+class ModbusDecoder;
+class ModbusDecoderUi : public AbstractIOUi
+{
+    Q_OBJECT
+public:
+    ModbusDecoderUi(QWidget *parent = nullptr);
+    ~ModbusDecoderUi();
+
+    QVariantMap save() const override;
+    void load(const QVariantMap &parameters) override;
+    void setupIO(AbstractIO *io) override;
+
+private:
+    Ui::ModbusDecoderUi *ui;
+    ModbusDecoder *m_modbusDecoder;
+    QStandardItemModel *m_model;
+
+private:
+    void updateParameters();
+    void updateInfo();
+    void onRowsAvailable();
+};
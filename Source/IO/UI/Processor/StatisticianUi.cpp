@@ -53,9 +53,9 @@ void StatisticianUi::setupIO(AbstractIO *io)
 
 void StatisticianUi::updateInfo()
 {
-    int frame = 0;
-    int bytes = 0;
-    int speed = 0;
+    qint64 frame = 0;
+    qint64 bytes = 0;
+    qint64 speed = 0;
 
     if (m_statistician) {
         frame = m_statistician->frames();
@@ -65,4 +65,18 @@ void StatisticianUi::updateInfo()
 
     QString info = tr("%1 frames, %2 bytes, %3B/s").arg(frame).arg(bytes).arg(speed);
     ui->label->setText(info);
+
+    if (m_statistician) {
+        xToolsRateMeter::Rate rate10s = m_statistician->rate(xToolsRateMeter::Window10s);
+        xToolsRateMeter::Rate rate60s = m_statistician->rate(xToolsRateMeter::Window60s);
+        xToolsRateMeter::Rate peak = m_statistician->peakRate();
+        QString tips = tr("10s: %1, %2 frames/s\n60s: %3, %4 frames/s\nPeak: %5, %6 frames/s")
+                           .arg(xToolsRateMeter::speedString(rate10s.bytesPerSecond))
+                           .arg(rate10s.framesPerSecond, 0, 'f', 1)
+                           .arg(xToolsRateMeter::speedString(rate60s.bytesPerSecond))
+                           .arg(rate60s.framesPerSecond, 0, 'f', 1)
+                           .arg(xToolsRateMeter::speedString(peak.bytesPerSecond))
+                           .arg(peak.framesPerSecond, 0, 'f', 1);
+        ui->label->setToolTip(tips);
+    }
 }
@@ -666,6 +666,12 @@ T crcCalculate(const uint8_t *input, uint64_t length, xIO::CrcAlgorithm algorith
 QByteArray xIO::calculateCrc(const QByteArray &data, CrcAlgorithm algorithm)
 {
     QByteArray retBytes;
+    if (algorithm == CrcAlgorithm::CRC_16_MODBUS) {
+        quint16 ret = crc16Modbus(data.constData(), data.length());
+        retBytes = QByteArray(reinterpret_cast<char *>(&ret), sizeof(ret));
+        return retBytes;
+    }
+
     auto const bw = bitsWidth(algorithm);
     auto *ptr = reinterpret_cast<const uint8_t *>(data.constData());
     if (bw == 8) {
@@ -682,6 +688,32 @@ QByteArray xIO::calculateCrc(const QByteArray &data, CrcAlgorithm algorithm)
     return retBytes;
 }
 
+quint16 xIO::crc16Modbus(const char *data, int length, quint16 crc)
+{
+    // The reflected polynomial 0x8005.
+    static const struct Table
+    {
+        quint16 values[256];
+        Table()
+        {
+            for (int i = 0; i < 256; i++) {
+                quint16 value = quint16(i);
+                for (int bit = 0; bit < 8; bit++) {
+                    value = (value & 1) ? quint16((value >> 1) ^ 0xa001) : quint16(value >> 1);
+                }
+                values[i] = value;
+            }
+        }
+    } table;
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    for (int i = 0; i < length; i++) {
+        crc = quint16((crc >> 8) ^ table.values[(crc ^ bytes[i]) & 0xff]);
+    }
+
+    return crc;
+}
+
 QByteArray xIO::calculateCrc(const QByteArray &data, CrcAlgorithm algorithm, bool bigEndian)
 {
     QByteArray retBytes = calculateCrc(data, algorithm);
@@ -82,6 +82,9 @@ public:
     static void setupCrcAlgorithm(QComboBox *comboBox);
     static QByteArray calculateCrc(const QByteArray &data, CrcAlgorithm algorithm);
     static QByteArray calculateCrc(const QByteArray &data, CrcAlgorithm algorithm, bool bigEndian);
+    /// Table driven CRC-16/MODBUS, a byte at a time instead of a bit. Pass the crc of the previous
+    /// bytes to continue it, the crc of a frame with its crc appended(low byte first) is 0.
+    static quint16 crc16Modbus(const char *data, int length, quint16 crc = 0xffff);
     struct CrcParameters
     {
         bool enable;
@@ -10,10 +10,16 @@
 #include "ui_CommunicationSettings.h"
 
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QRegularExpression>
+#include <QScopedPointer>
 #include <QStandardPaths>
 
 #include "./Unit/SaveThread.h"
 #include "IO/xIO.h"
+#include "xToolsCaptureFile.h"
+#include "xToolsSegmentCodec.h"
 
 CommunicationSettings::CommunicationSettings(QWidget *parent)
     : QWidget(parent)
@@ -33,6 +39,11 @@ CommunicationSettings::CommunicationSettings(QWidget *parent)
     ui->comboBoxMaxBytes->addItem("8M", 8192);
     ui->comboBoxMaxBytes->addItem("16M", 16384);
     ui->comboBoxMaxBytes->addItem("32M", 32768);
+    ui->comboBoxFileType->addItem(tr("Text"), SaveThread::FileTypeText);
+    ui->comboBoxFileType->addItem(tr("Capture"), SaveThread::FileTypeCapture);
+    ui->comboBoxFileType->addItem(tr("PCAPNG"), SaveThread::FileTypePcapng);
+    m_parameters.communicationType = 0;
+    updateParameters();
 
     m_saveThread = new SaveThread(this);
     m_saveThread->start();
@@ -41,6 +52,31 @@ CommunicationSettings::CommunicationSettings(QWidget *parent)
             &QPushButton::clicked,
             this,
             &CommunicationSettings::onBroswerButtonClicked);
+    connect(ui->pushButtonExport,
+            &QPushButton::clicked,
+            this,
+            &CommunicationSettings::onExportButtonClicked);
+
+    QList<QCheckBox *> checkBoxes{ui->checkBoxSaveToFile,
+                                  ui->checkBoxSaveRx,
+                                  ui->checkBoxSaveTx,
+                                  ui->checkBoxSaveDate,
+                                  ui->checkBoxSaveTime,
+                                  ui->checkBoxSaveMs,
+                                  ui->checkBoxCompress};
+    for (QCheckBox *checkBox : checkBoxes) {
+        connect(checkBox, &QCheckBox::clicked, this, &CommunicationSettings::updateParameters);
+    }
+
+    QList<QComboBox *> comboBoxes{ui->comboBoxSaveTextFormat,
+                                  ui->comboBoxMaxBytes,
+                                  ui->comboBoxFileType};
+    for (QComboBox *comboBox : comboBoxes) {
+        connect(comboBox,
+                static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+                this,
+                &CommunicationSettings::updateParameters);
+    }
 }
 
 CommunicationSettings::~CommunicationSettings()
@@ -48,20 +84,27 @@ CommunicationSettings::~CommunicationSettings()
     delete ui;
 }
 
-void CommunicationSettings::saveData(const QByteArray &data, bool isRx)
+void CommunicationSettings::saveData(const QByteArray &data, bool isRx, const QString &flag)
+{
+    m_parametersMutex.lock();
+    SaveThread::SaveParameters params = m_parameters;
+    m_parametersMutex.unlock();
+
+    if (params.saveToFile) {
+        m_saveThread->saveData(params, data, isRx, flag);
+    }
+}
+
+SaveThread::Statistics CommunicationSettings::statistics() const
+{
+    return m_saveThread->statistics();
+}
+
+void CommunicationSettings::setCommunicationType(int type)
 {
-    SaveThread::SaveParameters params;
-    params.saveToFile = ui->checkBoxSaveToFile->isChecked();
-    params.fileName = m_fileName;
-    params.saveRx = ui->checkBoxSaveRx->isChecked();
-    params.saveTx = ui->checkBoxSaveTx->isChecked();
-    params.saveTime = ui->checkBoxSaveTime->isChecked();
-    params.saveDate = ui->checkBoxSaveDate->isChecked();
-    params.saveMs = ui->checkBoxSaveMs->isChecked();
-    params.format = ui->comboBoxSaveTextFormat->currentData().toInt();
-    params.maxKBytes = ui->comboBoxMaxBytes->currentData().toInt();
-
-    m_saveThread->saveData(params, data, isRx);
+    m_parametersMutex.lock();
+    m_parameters.communicationType = type;
+    m_parametersMutex.unlock();
 }
 
 QVariantMap CommunicationSettings::save()
@@ -76,6 +119,8 @@ QVariantMap CommunicationSettings::save()
     map["saveMs"] = ui->checkBoxSaveMs->isChecked();
     map["format"] = ui->comboBoxSaveTextFormat->currentData().toInt();
     map["maxKBytes"] = ui->comboBoxMaxBytes->currentData().toInt();
+    map["fileType"] = ui->comboBoxFileType->currentData().toInt();
+    map["compress"] = ui->checkBoxCompress->isChecked();
     return map;
 }
 
@@ -90,6 +135,8 @@ void CommunicationSettings::load(const QVariantMap &data)
     bool saveMs = data.value("saveMs").toBool();
     int format = data.value("format").toInt();
     int maxKBytes = data.value("maxKBytes").toInt();
+    int fileType = data.value("fileType").toInt();
+    bool compress = data.value("compress").toBool();
 
     ui->checkBoxSaveToFile->setChecked(saveToFile);
     ui->checkBoxSaveRx->setChecked(saveRx);
@@ -97,12 +144,35 @@ void CommunicationSettings::load(const QVariantMap &data)
     ui->checkBoxSaveTime->setChecked(saveTime);
     ui->checkBoxSaveDate->setChecked(saveDate);
     ui->checkBoxSaveMs->setChecked(saveMs);
+    ui->checkBoxCompress->setChecked(compress);
 
     int index = ui->comboBoxSaveTextFormat->findData(format);
     ui->comboBoxSaveTextFormat->setCurrentIndex(index);
 
     index = ui->comboBoxMaxBytes->findData(maxKBytes);
     ui->comboBoxMaxBytes->setCurrentIndex(index);
+
+    index = ui->comboBoxFileType->findData(fileType);
+    ui->comboBoxFileType->setCurrentIndex(index == -1 ? 0 : index);
+
+    updateParameters();
+}
+
+void CommunicationSettings::updateParameters()
+{
+    m_parametersMutex.lock();
+    m_parameters.saveToFile = ui->checkBoxSaveToFile->isChecked();
+    m_parameters.fileName = m_fileName;
+    m_parameters.saveRx = ui->checkBoxSaveRx->isChecked();
+    m_parameters.saveTx = ui->checkBoxSaveTx->isChecked();
+    m_parameters.saveTime = ui->checkBoxSaveTime->isChecked();
+    m_parameters.saveDate = ui->checkBoxSaveDate->isChecked();
+    m_parameters.saveMs = ui->checkBoxSaveMs->isChecked();
+    m_parameters.format = ui->comboBoxSaveTextFormat->currentData().toInt();
+    m_parameters.fileType = ui->comboBoxFileType->currentData().toInt();
+    m_parameters.maxKBytes = ui->comboBoxMaxBytes->currentData().toInt();
+    m_parameters.compress = ui->checkBoxCompress->isChecked();
+    m_parametersMutex.unlock();
 }
 
 static const QString settingsFileName()
@@ -118,10 +188,59 @@ void CommunicationSettings::onBroswerButtonClicked()
     QStandardPaths::StandardLocation location = QStandardPaths::DesktopLocation;
     QString defaultPath = QStandardPaths::writableLocation(location);
 
-    auto fileName = QString("%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMddhhmmss"));
+    int fileType = ui->comboBoxFileType->currentData().toInt();
+    QString suffix = "txt";
+    QString filter = tr("Text File(*.txt)");
+    if (fileType == SaveThread::FileTypeCapture) {
+        suffix = "xcap";
+        filter = tr("Capture File(*.xcap)");
+    } else if (fileType == SaveThread::FileTypePcapng) {
+        suffix = "pcapng";
+        filter = tr("PCAPNG File(*.pcapng)");
+    }
+
+    QString dateTime = QDateTime::currentDateTime().toString("yyyyMMddhhmmss");
+    auto fileName = QString("%1.%2").arg(dateTime, suffix);
     QString ret = QFileDialog::getSaveFileName(nullptr,
                                                tr("Save to file"),
                                                defaultPath + "/" + fileName,
-                                               tr("Text File(*.txt)"));
+                                               filter);
     m_fileName = ret;
+    updateParameters();
+}
+
+void CommunicationSettings::onExportButtonClicked()
+{
+    QString captureFileName = QFileDialog::getOpenFileName(nullptr,
+                                                           tr("Open capture file"),
+                                                           QFileInfo(m_fileName).absolutePath(),
+                                                           tr("Capture File(*.xcap *.pcapng *.pcap *.xtz)"));
+    if (captureFileName.isEmpty()) {
+        return;
+    }
+
+    QString textFileName = captureFileName;
+    textFileName.replace(QRegularExpression("(\\.txt)?\\.xtz$|\\.(xcap|pcapng|pcap)$"), "");
+    textFileName = QFileDialog::getSaveFileName(nullptr,
+                                                tr("Export to text file"),
+                                                textFileName + ".txt",
+                                                tr("Text File(*.txt)"));
+    if (textFileName.isEmpty()) {
+        return;
+    }
+
+    // Compressed text files are decompressed only, they are text files already.
+    if (captureFileName.endsWith(".xtz")) {
+        if (!xToolsSegmentCodec::decompressFile(captureFileName, textFileName)) {
+            QMessageBox::warning(this, tr("Export Failed"), tr("Failed to decompress the file."));
+        }
+        return;
+    }
+
+    QScopedPointer<xToolsAbstractCaptureReader> reader(
+        xToolsCaptureFile::createReader(captureFileName));
+    int format = ui->comboBoxSaveTextFormat->currentData().toInt();
+    if (!reader->open(captureFileName) || !reader->exportText(textFileName, format)) {
+        QMessageBox::warning(this, tr("Export Failed"), reader->errorString());
+    }
 }
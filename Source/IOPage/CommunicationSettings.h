@@ -8,15 +8,17 @@
  **************************************************************************************************/
 #pragma once
 
+#include <QMutex>
 #include <QWidget>
 
+#include "./Unit/SaveThread.h"
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class CommunicationSettings;
 }
 QT_END_NAMESPACE
 
-class SaveThread;
 class CommunicationSettings : public QWidget
 {
     Q_OBJECT
@@ -24,7 +26,10 @@ public:
     CommunicationSettings(QWidget *parent = nullptr);
     ~CommunicationSettings();
 
-    void saveData(const QByteArray &data, bool isRx);
+    /// The method can be called in any thread, the parameters are cached when the ui is changed.
+    void saveData(const QByteArray &data, bool isRx, const QString &flag = QString());
+    void setCommunicationType(int type);
+    SaveThread::Statistics statistics() const;
     QVariantMap save();
     void load(const QVariantMap &data);
 
@@ -38,7 +43,11 @@ private:
     Ui::CommunicationSettings *ui;
     SaveThread *m_saveThread;
     QString m_fileName;
+    SaveThread::SaveParameters m_parameters;
+    QMutex m_parametersMutex;
 
 private:
+    void updateParameters();
     void onBroswerButtonClicked();
+    void onExportButtonClicked();
 };
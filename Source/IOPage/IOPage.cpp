@@ -17,6 +17,10 @@
 #include "IO/IO/Communication/Communication.h"
 #include "IO/IO/IOFactory.h"
 #include "IO/IO/Model/Preset.h"
+#include "IO/IO/Model/Replayer.h"
+#include "IO/IO/Processor/LatencyMeter.h"
+#include "IO/IO/Processor/LoadGenerator.h"
+#include "IO/IO/Processor/ModbusDecoder.h"
 #include "IO/IO/Processor/Statistician.h"
 #include "IO/UI/Communication/CommunicationUi.h"
 #include "IO/UI/IOUiFactory.h"
@@ -24,6 +28,7 @@
 #include "InputSettings.h"
 #include "OutputSettings.h"
 #include "Unit/SyntaxHighlighter.h"
+#include "xToolsCaptureFile.h"
 
 IOPage::IOPage(ControllerDirection direction, QWidget *parent)
     : QWidget{parent}
@@ -33,16 +38,38 @@ IOPage::IOPage(ControllerDirection direction, QWidget *parent)
     , m_ioSettings{nullptr}
     , m_outputSettings{nullptr}
     , m_inputSettings{nullptr}
-    , m_writeTimer{new QTimer(this)}
+    , m_writeScheduler{new xToolsDeadlineScheduler(this)}
     , m_updateLabelInfoTimer{new QTimer(this)}
+    , m_updateStorageInfoTimer{new QTimer(this)}
     , m_highlighter{new SyntaxHighlighter(this)}
     , m_rxStatistician{new Statistician(this)}
     , m_txStatistician{new Statistician(this)}
+    , m_latencyMeter{new LatencyMeter(this)}
+    , m_loadGenerator{new LoadGenerator(this)}
+    , m_modbusDecoder{new ModbusDecoder(this)}
     , m_preset{new xTools::Preset(this)}
+    , m_replayer{new xTools::Replayer(this)}
 {
     ui->setupUi(this);
+
+    // The names tell the pages apart in the profiler and the metrics.
+    static int pageCount = 0;
+    m_pageName = QString("IOPage%1").arg(pageCount++);
+    m_rxStage = xToolsProfiler::instance()->stage(m_pageName + " UI RX");
+    m_txStage = xToolsProfiler::instance()->stage(m_pageName + " UI TX");
+    m_rxStatistician->setObjectName(m_pageName + " RX");
+    m_txStatistician->setObjectName(m_pageName + " TX");
+    m_latencyMeter->setObjectName(m_pageName + " Latency");
+    m_loadGenerator->setObjectName(m_pageName + " Load");
+    m_modbusDecoder->setObjectName(m_pageName + " Modbus");
+    m_replayer->setObjectName(m_pageName + " Replay");
+
     ui->widgetRxInfo->setupIO(m_rxStatistician);
     ui->widgetTxInfo->setupIO(m_txStatistician);
+    ui->pageLatency->setupIO(m_latencyMeter);
+    ui->pageLoad->setupIO(m_loadGenerator);
+    ui->pageModbus->setupIO(m_modbusDecoder);
+    ui->pageReplay->setupIO(m_replayer);
 
     if (direction == ControllerDirection::Right) {
         QHBoxLayout *l = qobject_cast<QHBoxLayout *>(layout());
@@ -52,13 +79,17 @@ IOPage::IOPage(ControllerDirection direction, QWidget *parent)
         }
     }
 
-    m_writeTimer->setInterval(1000);
-    connect(m_writeTimer, &QTimer::timeout, this, &IOPage::writeBytes);
+    // The cyclic writing is not spun, the ui thread must not be blocked.
+    connect(m_writeScheduler, &xToolsDeadlineScheduler::timeout, this, &IOPage::writeBytes);
 
     m_updateLabelInfoTimer->setInterval(100);
     connect(m_updateLabelInfoTimer, &QTimer::timeout, this, &IOPage::updateLabelInfo);
     m_updateLabelInfoTimer->start();
 
+    m_updateStorageInfoTimer->setInterval(1000);
+    connect(m_updateStorageInfoTimer, &QTimer::timeout, this, &IOPage::updateStorageInfo);
+    m_updateStorageInfoTimer->start();
+
     initUi();
 
     onShowStatisticianChanged(false);
@@ -66,6 +97,9 @@ IOPage::IOPage(ControllerDirection direction, QWidget *parent)
 
 IOPage::~IOPage()
 {
+    m_loadGenerator->exit();
+    m_loadGenerator->wait();
+    m_replayer->stop();
     delete ui;
 }
 
@@ -88,6 +122,11 @@ QVariantMap IOPage::save()
     map.insert(m_keys.inputFormat, ui->comboBoxInputFormat->currentData());
     map.insert(m_keys.inputSettings, m_inputSettings->save());
 
+    map.insert(m_keys.latencyMeter, ui->pageLatency->save());
+    map.insert(m_keys.loadGenerator, ui->pageLoad->save());
+    map.insert(m_keys.modbusDecoder, ui->pageModbus->save());
+    map.insert(m_keys.replayer, ui->pageReplay->save());
+
     return map;
 }
 
@@ -135,6 +174,11 @@ void IOPage::load(const QVariantMap &parameters)
     index = ui->comboBoxInputFormat->findData(inputFormat);
     ui->comboBoxInputFormat->setCurrentIndex(index == -1 ? 0 : index);
     m_inputSettings->load(inputSettings);
+
+    ui->pageLatency->load(parameters.value(m_keys.latencyMeter).toMap());
+    ui->pageLoad->load(parameters.value(m_keys.loadGenerator).toMap());
+    ui->pageModbus->load(parameters.value(m_keys.modbusDecoder).toMap());
+    ui->pageReplay->load(parameters.value(m_keys.replayer).toMap());
 }
 
 void IOPage::initUi()
@@ -204,6 +248,10 @@ void IOPage::initUiInputControl()
 
     xIO::setupTextFormat(ui->comboBoxInputFormat);
     ui->comboBoxInputInterval->addItem(tr("Disable"), -1);
+    const int fastIntervals[] = {1, 2, 5};
+    for (int i : fastIntervals) {
+        ui->comboBoxInputInterval->addItem(QString::number(i), i);
+    }
     for (int i = 10; i <= 50; i += 10) {
         ui->comboBoxInputInterval->addItem(QString::number(i), i);
     }
@@ -227,6 +275,10 @@ void IOPage::initUiOutput()
     ui->toolButtonEmitter->setCheckable(true);
     ui->toolButtonResponser->setCheckable(true);
     ui->toolButtonTransmitter->setCheckable(true);
+    ui->toolButtonLatency->setCheckable(true);
+    ui->toolButtonLoad->setCheckable(true);
+    ui->toolButtonModbus->setCheckable(true);
+    ui->toolButtonReplay->setCheckable(true);
 
     ui->pagePreset->setupIO(m_preset);
 
@@ -235,9 +287,17 @@ void IOPage::initUiOutput()
     m_pageButtonGroup.addButton(ui->toolButtonEmitter);
     m_pageButtonGroup.addButton(ui->toolButtonResponser);
     m_pageButtonGroup.addButton(ui->toolButtonTransmitter);
+    m_pageButtonGroup.addButton(ui->toolButtonLatency);
+    m_pageButtonGroup.addButton(ui->toolButtonLoad);
+    m_pageButtonGroup.addButton(ui->toolButtonModbus);
+    m_pageButtonGroup.addButton(ui->toolButtonReplay);
 
     m_pageContextMap.insert(ui->toolButtonOutput, ui->pageOutput);
     m_pageContextMap.insert(ui->toolButtonPreset, ui->pagePreset);
+    m_pageContextMap.insert(ui->toolButtonLatency, ui->pageLatency);
+    m_pageContextMap.insert(ui->toolButtonLoad, ui->pageLoad);
+    m_pageContextMap.insert(ui->toolButtonModbus, ui->pageModbus);
+    m_pageContextMap.insert(ui->toolButtonReplay, ui->pageReplay);
 
     connect(&m_pageButtonGroup,
             qOverload<QAbstractButton *>(&QButtonGroup::buttonClicked),
@@ -275,10 +335,10 @@ void IOPage::onCommunicationTypeChanged()
 void IOPage::onCycleIntervalChanged()
 {
     int interval = ui->comboBoxInputInterval->currentData().toInt();
+    m_writeScheduler->clear();
+    m_writeScheduler->resetJitter();
     if (interval > 0) {
-        m_writeTimer->start(interval);
-    } else {
-        m_writeTimer->stop();
+        m_writeScheduler->schedule(0, interval * 1000000ll);
     }
 }
 
@@ -318,6 +378,7 @@ void IOPage::onShowStatisticianChanged(bool checked)
     ui->lineRxTx->setVisible(checked);
     ui->widgetRxInfo->setVisible(checked);
     ui->widgetTxInfo->setVisible(checked);
+    ui->labelStorage->setVisible(checked);
 }
 
 void IOPage::onOpened()
@@ -330,7 +391,7 @@ void IOPage::onOpened()
 
 void IOPage::onClosed()
 {
-    m_writeTimer->stop();
+    m_writeScheduler->clear();
     setUiEnabled(true);
     ui->pushButtonCommunicationOpen->setEnabled(true);
     ui->pushButtonCommunicationOpen->setText(tr("Open"));
@@ -351,14 +412,16 @@ void IOPage::onWarningOccurred(const QString &warning)
 
 void IOPage::onBytesRead(const QByteArray &bytes, const QString &from)
 {
-    m_ioSettings->saveData(bytes, false);
+    m_rxStage->setQueueDepth(--m_pendingRxFrames);
+    xToolsProfilerScope scope(m_rxStage);
     m_rxStatistician->inputBytes(bytes);
     outputText(bytes, from, true);
 }
 
 void IOPage::onBytesWritten(const QByteArray &bytes, const QString &to)
 {
-    m_ioSettings->saveData(bytes, true);
+    m_txStage->setQueueDepth(--m_pendingTxFrames);
+    xToolsProfilerScope scope(m_txStage);
     m_txStatistician->inputBytes(bytes);
     outputText(bytes, to, false);
 }
@@ -376,18 +439,67 @@ void IOPage::open()
     int type = ui->comboBoxCommmunicationTypes->currentData().toInt();
     m_io = IOFactory::singleton().createDevice(type);
     if (m_io) {
+        m_io->setObjectName(m_pageName);
         setUiEnabled(false);
 
         m_rxStatistician->start();
         m_txStatistician->start();
+        m_latencyMeter->start();
+        m_modbusDecoder->start();
 
         connect(m_io, &Communication::opened, this, &IOPage::onOpened);
         connect(m_io, &Communication::closed, this, &IOPage::onClosed);
+
+        // Save the data and measure the latency in the thread of the device, so the timestamp is
+        // taken when the data is read or written, not when the ui thread handles it. The frames
+        // queued for the ui thread are counted here too, they are connected before the ui slots.
+        m_ioSettings->setCommunicationType(type);
+        auto settings = m_ioSettings;
+        auto latencyMeter = m_latencyMeter;
+        auto modbusDecoder = m_modbusDecoder;
+        m_pendingRxFrames = 0;
+        m_pendingTxFrames = 0;
+        connect(
+            m_io,
+            &Communication::bytesRead,
+            m_io,
+            [this, settings, latencyMeter, modbusDecoder](const QByteArray &bytes,
+                                                          const QString &from) {
+                const qint64 timestamp = xToolsCaptureFile::currentTimestamp();
+                latencyMeter->inputRx(bytes, xToolsProfiler::now());
+                modbusDecoder->inputRx(bytes, from, timestamp);
+                settings->saveData(bytes, true, from);
+                this->m_rxStage->addWakeup();
+                this->m_rxStage->setQueueDepth(++this->m_pendingRxFrames);
+            },
+            Qt::DirectConnection);
+        connect(
+            m_io,
+            &Communication::bytesWritten,
+            m_io,
+            [this, settings, latencyMeter, modbusDecoder](const QByteArray &bytes,
+                                                          const QString &to) {
+                const qint64 timestamp = xToolsCaptureFile::currentTimestamp();
+                latencyMeter->inputTx(bytes, xToolsProfiler::now());
+                modbusDecoder->inputTx(bytes, to, timestamp);
+                settings->saveData(bytes, false, to);
+                this->m_txStage->addWakeup();
+                this->m_txStage->setQueueDepth(++this->m_pendingTxFrames);
+            },
+            Qt::DirectConnection);
         connect(m_io, &Communication::bytesWritten, this, &IOPage::onBytesWritten);
         connect(m_io, &Communication::bytesRead, this, &IOPage::onBytesRead);
         connect(m_io, &Communication::errorOccurred, this, &IOPage::onErrorOccurred);
         connect(m_io, &Communication::warningOccurred, this, &::IOPage::onWarningOccurred);
 
+        // The replayed frames are written by the device, they are not delayed by the ui thread.
+        connect(m_replayer,
+                &xTools::Replayer::outputBytes,
+                m_io,
+                &Communication::inputBytes,
+                Qt::DirectConnection);
+        m_replayer->setSink(m_io);
+
         QVariantMap parameters = m_ioUi->save();
         m_ioUi->setupDevice(m_io);
         m_io->load(parameters);
@@ -398,10 +510,16 @@ void IOPage::open()
 
 void IOPage::close()
 {
+    m_replayer->stop();
+    m_replayer->setSink(nullptr);
     m_rxStatistician->exit();
     m_rxStatistician->wait();
     m_txStatistician->exit();
     m_txStatistician->wait();
+    m_latencyMeter->exit();
+    m_latencyMeter->wait();
+    m_modbusDecoder->exit();
+    m_modbusDecoder->wait();
 
     if (m_io) {
         m_io->exit();
@@ -454,6 +572,18 @@ void IOPage::updateLabelInfo()
     QString const crcValue = QString("CRC: 0x%1").arg(QString::fromLatin1(crc.toHex()).toUpper());
     ui->labelCrc->setText(crcValue);
 
+    xToolsDeadlineScheduler::Jitter jitter = m_writeScheduler->jitter();
+    if (jitter.count > 0) {
+        QString jitterInfo = tr("Jitter(p50/p99/max): %1/%2/%3 us, missed: %4")
+                                 .arg(jitter.p50 / 1000)
+                                 .arg(jitter.p99 / 1000)
+                                 .arg(jitter.max / 1000)
+                                 .arg(jitter.missed);
+        ui->comboBoxInputInterval->setToolTip(jitterInfo);
+    } else {
+        ui->comboBoxInputInterval->setToolTip(QString());
+    }
+
     if (!parameters.appendCrc) {
         crcString.clear();
     }
@@ -467,6 +597,24 @@ void IOPage::updateLabelInfo()
     }
 }
 
+void IOPage::updateStorageInfo()
+{
+    SaveThread::Statistics statistics = m_ioSettings->statistics();
+    if (statistics.writtenBytes <= 0) {
+        ui->labelStorage->clear();
+        return;
+    }
+
+    // CPU usage of the compression, it is the time spent on compressing in the interval.
+    qint64 compressionTime = statistics.compressionTime - m_lastCompressionTime;
+    m_lastCompressionTime = statistics.compressionTime;
+    qint64 interval = qint64(m_updateStorageInfoTimer->interval()) * 1000000;
+    double cpu = 100.0 * compressionTime / interval;
+    double ratio = double(statistics.rawBytes) / statistics.writtenBytes;
+    QString info = tr("Ratio: %1 CPU: %2%").arg(ratio, 0, 'f', 2).arg(cpu, 0, 'f', 1);
+    ui->labelStorage->setText(info);
+}
+
 void IOPage::setupMenu(QPushButton *target, QWidget *actionWidget)
 {
     QMenu *menu = new QMenu(target);
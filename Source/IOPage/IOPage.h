@@ -8,12 +8,16 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QButtonGroup>
 #include <QPushButton>
 #include <QTimer>
 #include <QVariantMap>
 #include <QWidget>
 
+#include "xToolsDeadlineScheduler.h"
+#include "xToolsProfiler.h"
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class IOPage;
@@ -23,10 +27,14 @@ QT_END_NAMESPACE
 QT_BEGIN_NAMESPACE
 namespace xTools {
 class Preset;
+class Replayer;
 }
 QT_END_NAMESPACE
 
 class Statistician;
+class LatencyMeter;
+class LoadGenerator;
+class ModbusDecoder;
 class InputSettings;
 class OutputSettings;
 class Communication;
@@ -64,21 +72,38 @@ private:
         const QString cycleInterval{"cycleInterval"};
         const QString inputFormat{"inputFormat"};
         const QString inputSettings{"inputSettings"};
+
+        const QString latencyMeter{"latencyMeter"};
+        const QString loadGenerator{"loadGenerator"};
+        const QString modbusDecoder{"modbusDecoder"};
+        const QString replayer{"replayer"};
     } m_keys;
 
 private:
     Ui::IOPage *ui;
+    QString m_pageName;
     Communication *m_io;
     CommunicationUi *m_ioUi;
     CommunicationSettings *m_ioSettings;
     OutputSettings *m_outputSettings;
     InputSettings *m_inputSettings;
-    QTimer *m_writeTimer;
+    xToolsDeadlineScheduler *m_writeScheduler;
     QTimer *m_updateLabelInfoTimer;
+    QTimer *m_updateStorageInfoTimer;
+    qint64 m_lastCompressionTime{0};
     SyntaxHighlighter *m_highlighter;
     Statistician *m_rxStatistician;
     Statistician *m_txStatistician;
+    LatencyMeter *m_latencyMeter;
+    LoadGenerator *m_loadGenerator;
+    ModbusDecoder *m_modbusDecoder;
+    xToolsProfiler::Stage *m_rxStage;
+    xToolsProfiler::Stage *m_txStage;
+    // Bytes emitted by the device but not handled by the ui thread yet.
+    std::atomic<qint64> m_pendingRxFrames{0};
+    std::atomic<qint64> m_pendingTxFrames{0};
     xTools::Preset *m_preset;
+    xTools::Replayer *m_replayer;
     QButtonGroup m_pageButtonGroup;
     QMap<QAbstractButton *, QWidget *> m_pageContextMap;
 
@@ -111,6 +136,7 @@ private:
     void close();
     void writeBytes();
     void updateLabelInfo();
+    void updateStorageInfo();
     void setupMenu(QPushButton *target, QWidget *actionWidget);
     void setUiEnabled(bool enabled);
     void outputText(const QByteArray &bytes, const QString &flag, bool isRx);
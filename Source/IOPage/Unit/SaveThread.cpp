@@ -9,6 +9,7 @@
 #include "SaveThread.h"
 
 #include <QDateTime>
+#include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QLocale>
@@ -16,6 +17,11 @@
 #include <QTimer>
 
 #include "IO/xIO.h"
+#include "xToolsCaptureFile.h"
+#include "xToolsLogWriter.h"
+#include "xToolsPcapng.h"
+#include "xToolsProfiler.h"
+#include "xToolsSegmentCodec.h"
 
 SaveThread::SaveThread(QObject *parent)
     : QThread(parent)
@@ -27,20 +33,40 @@ SaveThread::~SaveThread()
     wait();
 }
 
-void SaveThread::saveData(const SaveParameters &parameters, const QByteArray &data, bool isRx)
+void SaveThread::saveData(const SaveParameters &parameters,
+                          const QByteArray &data,
+                          bool isRx,
+                          const QString &flag)
 {
     m_ctxListMutex.lock();
     SaveContext ctx;
     ctx.parameters = parameters;
     ctx.data = data;
     ctx.isRx = isRx;
+    ctx.flag = flag;
+    ctx.timestamp = xToolsCaptureFile::currentTimestamp();
     m_ctxList.append(ctx);
+    profilerStage()->setQueueDepth(m_ctxList.size());
     m_ctxListMutex.unlock();
 }
 
-void saveDataToFile(const SaveThread::SaveContext &ctx, QFile *file)
+SaveThread::Statistics SaveThread::statistics() const
 {
-    QDateTime now = QDateTime::currentDateTime();
+    Statistics statistics;
+    statistics.rawBytes = m_rawBytes.load();
+    statistics.writtenBytes = m_writtenBytes.load();
+    statistics.compressionTime = m_compressionTime.load();
+    return statistics;
+}
+
+xToolsProfiler::Stage *SaveThread::profilerStage()
+{
+    return xToolsProfiler::instance()->objectStage(this, m_profilerStage);
+}
+
+QString textLine(const SaveThread::SaveContext &ctx)
+{
+    QDateTime now = QDateTime::fromMSecsSinceEpoch(ctx.timestamp / 1000000);
     QString dateFmt = QLocale().dateFormat();
     QString timeFmt = QLocale().timeFormat(QLocale::ShortFormat);
 
@@ -64,25 +90,91 @@ void saveDataToFile(const SaveThread::SaveContext &ctx, QFile *file)
     static const QRegularExpression reg("[\\s]+");
     line.replace(reg, " ");
     line += text;
-    QTextStream stream(file);
-    stream << line << "\n";
+    line += "\n";
+    return line;
 }
 
-void renameFile(const QString &oldName)
+QString renameFile(const QString &oldName)
 {
-    QFileInfo info(oldName);
     QFile file(oldName);
-
-    QString t = "_" + QString::number(QDateTime::currentMSecsSinceEpoch());
-    QString newName = info.absolutePath() + "/" + info.baseName() + t + "." + info.completeSuffix();
+    qint64 t = QDateTime::currentMSecsSinceEpoch();
+    QString newName = xToolsLogWriter::rotatedFileName(oldName, t);
     if (!file.rename(newName)) {
         qWarning() << "Failed to rename file" << oldName << "to" << newName;
+        return oldName;
+    }
+
+    return newName;
+}
+
+void compressFile(const QString &fileName, SaveThread::Statistics &statistics)
+{
+    // The segment replaces the file, readers detect compressed segments by the magic.
+    QString segmentFileName = fileName + ".tmp";
+    int codec = xToolsSegmentCodec::defaultCodec();
+    qint64 compressionTime = 0;
+    if (!xToolsSegmentCodec::compressFile(fileName,
+                                          segmentFileName,
+                                          codec,
+                                          1024 * 1024,
+                                          &compressionTime)) {
+        qWarning() << "Failed to compress file" << fileName;
+        QFile::remove(segmentFileName);
+        return;
+    }
+
+    statistics.rawBytes += QFileInfo(fileName).size();
+    statistics.writtenBytes += QFileInfo(segmentFileName).size();
+    statistics.compressionTime += compressionTime;
+    if (!QFile::remove(fileName) || !QFile::rename(segmentFileName, fileName)) {
+        qWarning() << "Failed to replace file" << fileName;
+    }
+}
+
+int pcapngLinkType(int communicationType)
+{
+    switch (static_cast<xIO::CommunicationType>(communicationType)) {
+    case xIO::CommunicationType::UdpClient:
+    case xIO::CommunicationType::UdpServer:
+        return xToolsPcapng::LinkTypeUdp;
+    case xIO::CommunicationType::TcpClient:
+    case xIO::CommunicationType::TcpServer:
+        return xToolsPcapng::LinkTypeTcp;
+    case xIO::CommunicationType::WebSocketClient:
+    case xIO::CommunicationType::WebSocketServer:
+        return xToolsPcapng::LinkTypeWebSocket;
+    case xIO::CommunicationType::BleCentral:
+    case xIO::CommunicationType::BlePeripheral:
+        return xToolsPcapng::LinkTypeBle;
+    default:
+        return xToolsPcapng::LinkTypeSerial;
+    }
+}
+
+void saveDataToFile(const SaveThread::SaveContext &ctx, xToolsAbstractCaptureWriter *writer)
+{
+    const QString fileName = ctx.parameters.fileName;
+    if (writer->isOpen() && writer->fileName() != fileName) {
+        writer->close();
+    }
+
+    if (!writer->isOpen()) {
+        if (!writer->open(fileName)) {
+            qWarning() << "Failed to open capture file:" << writer->errorString();
+            return;
+        }
     }
+
+    int direction = ctx.isRx ? xToolsCaptureFile::DirectionRx : xToolsCaptureFile::DirectionTx;
+    writer->append(ctx.timestamp, direction, ctx.flag, ctx.data);
 }
 
-void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList)
+void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList,
+                    xToolsCaptureWriter *captureWriter,
+                    xToolsPcapngWriter *pcapngWriter,
+                    xToolsLogWriter *textWriter,
+                    SaveThread::Statistics &statistics)
 {
-    QFile *file = nullptr;
     for (SaveThread::SaveContext const &ctx : ctxList) {
         if (!ctx.parameters.saveRx && ctx.isRx) {
             continue;
@@ -92,7 +184,7 @@ void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList)
             continue;
         }
 
-        if (!ctx.parameters.saveDate) {
+        if (!ctx.parameters.saveToFile) {
             continue;
         }
 
@@ -101,45 +193,105 @@ void saveDataToFile(const QList<SaveThread::SaveContext> &ctxList)
         }
 
         if (ctx.data.isEmpty()) {
-            return;
+            continue;
         }
 
-        QFileInfo fileInfo(ctx.parameters.fileName);
-        if (fileInfo.exists() && fileInfo.size() >= ctx.parameters.maxKBytes * 1024) {
-            renameFile(ctx.parameters.fileName);
+        if (ctx.parameters.fileType == SaveThread::FileTypeCapture) {
+            saveDataToFile(ctx, captureWriter);
+            continue;
+        } else if (ctx.parameters.fileType == SaveThread::FileTypePcapng) {
+            pcapngWriter->setLinkType(pcapngLinkType(ctx.parameters.communicationType));
+            saveDataToFile(ctx, pcapngWriter);
+            continue;
         }
 
-        if (!file) {
-            file = new QFile(ctx.parameters.fileName);
-            if (!file->open(QIODevice::WriteOnly | QIODevice::Append)) {
-                file->deleteLater();
-                file = nullptr;
-                continue;
-            }
+        // The text file is written, compressed and rotated by the log writer in its own thread.
+        xToolsLogWriter::Parameters parameters = textWriter->parameters();
+        qint64 maxSegmentSize = qint64(ctx.parameters.maxKBytes) * 1024;
+        QString fileName = ctx.parameters.fileName;
+        int codec = xToolsSegmentCodec::CodecNone;
+        if (ctx.parameters.compress) {
+            fileName += ".xtz";
+            codec = xToolsSegmentCodec::defaultCodec();
         }
 
-        saveDataToFile(ctx, file);
+        if (parameters.fileName != fileName || parameters.maxSegmentSize != maxSegmentSize
+            || parameters.codec != codec) {
+            parameters.fileName = fileName;
+            parameters.maxSegmentSize = maxSegmentSize;
+            parameters.codec = codec;
+            textWriter->setParameters(parameters);
+        }
+
+        if (!textWriter->append(textLine(ctx).toUtf8())) {
+            qWarning() << "The text file writer is busy, data is dropped.";
+        }
     }
 
-    if (file) {
-        file->close();
-        file->deleteLater();
-        file = nullptr;
+    // Capture files are kept open between batches, they are rotated when the batch is flushed. The
+    // rotated segments are compressed as a whole, the open segment is always written raw.
+    int maxKBytes = ctxList.isEmpty() ? 0 : ctxList.last().parameters.maxKBytes;
+    bool compress = ctxList.isEmpty() ? false : ctxList.last().parameters.compress;
+    QList<xToolsAbstractCaptureWriter *> writers{captureWriter, pcapngWriter};
+    for (xToolsAbstractCaptureWriter *writer : writers) {
+        if (!writer->isOpen()) {
+            continue;
+        }
+
+        if (!writer->flush()) {
+            qWarning() << "Failed to write capture file:" << writer->errorString();
+        }
+
+        if (maxKBytes > 0 && writer->size() >= qint64(maxKBytes) * 1024) {
+            QString fileName = writer->fileName();
+            writer->close();
+            fileName = renameFile(fileName);
+            if (compress) {
+                compressFile(fileName, statistics);
+            }
+        }
     }
 }
 
 void SaveThread::run()
 {
+    xToolsCaptureWriter captureWriter;
+    xToolsPcapngWriter pcapngWriter;
+    xToolsLogWriter textWriter;
+    textWriter.start();
+    Statistics statistics;
+    auto updateStatistics = [=, &textWriter, &statistics]() {
+        this->m_rawBytes = statistics.rawBytes + textWriter.rawBytes();
+        this->m_writtenBytes = statistics.writtenBytes + textWriter.writtenBytes();
+        this->m_compressionTime = statistics.compressionTime + textWriter.compressionTime();
+    };
+
     QTimer *timer = new QTimer();
     timer->setSingleShot(true);
     timer->setInterval(1000);
-    connect(timer, &QTimer::timeout, timer, [this, timer]() {
+    xToolsProfiler::Stage *stage = profilerStage();
+    qint64 droppedAppends = 0;
+    connect(timer, &QTimer::timeout, timer, [&]() {
         this->m_ctxListMutex.lock();
-        QList<SaveContext> dataList = this->m_ctxList;
-        this->m_ctxList.clear();
+        QList<SaveContext> dataList;
+        dataList.swap(this->m_ctxList);
+        stage->setQueueDepth(0);
         this->m_ctxListMutex.unlock();
 
-        saveDataToFile(dataList);
+        stage->addWakeup();
+        if (!dataList.isEmpty()) {
+            xToolsProfilerScope scope(stage);
+            saveDataToFile(dataList, &captureWriter, &pcapngWriter, &textWriter, statistics);
+        }
+        updateStatistics();
+
+        // Text lines are dropped by the log writer if the disk can't keep up with the data.
+        qint64 dropped = textWriter.droppedAppends();
+        if (dropped != droppedAppends) {
+            stage->addDropped(dropped - droppedAppends);
+            droppedAppends = dropped;
+        }
+
         timer->start();
     });
 
@@ -149,4 +301,14 @@ void SaveThread::run()
     timer->stop();
     timer->deleteLater();
     timer = nullptr;
+
+    m_ctxListMutex.lock();
+    QList<SaveContext> dataList;
+    dataList.swap(m_ctxList);
+    m_ctxListMutex.unlock();
+    saveDataToFile(dataList, &captureWriter, &pcapngWriter, &textWriter, statistics);
+    captureWriter.close();
+    pcapngWriter.close();
+    textWriter.stop();
+    updateStatistics();
 }
@@ -8,14 +8,19 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QMutex>
 #include <QPair>
 #include <QThread>
 
+#include "xToolsProfiler.h"
+
 class SaveThread : public QThread
 {
     Q_OBJECT
 public:
+    enum FileType { FileTypeText, FileTypeCapture, FileTypePcapng };
+
     struct SaveParameters
     {
         bool saveToFile;
@@ -26,7 +31,10 @@ public:
         bool saveTime;
         bool saveMs;
         int format;
+        int fileType;
         int maxKBytes;
+        int communicationType;
+        bool compress;
     };
 
     struct SaveContext
@@ -34,22 +42,42 @@ public:
         SaveParameters parameters;
         QByteArray data;
         bool isRx;
+        QString flag;
+        qint64 timestamp;
+    };
+
+    struct Statistics
+    {
+        qint64 rawBytes{0};
+        qint64 writtenBytes{0};
+        qint64 compressionTime{0}; // ns
     };
 
 public:
     explicit SaveThread(QObject *parent = nullptr);
     ~SaveThread();
 
-    void saveData(const SaveParameters &parameters, const QByteArray &data, bool isRx);
+    void saveData(const SaveParameters &parameters,
+                  const QByteArray &data,
+                  bool isRx,
+                  const QString &flag = QString());
+    /// Bytes of the compressed files, the raw bytes and the written bytes are equal if the files
+    /// are not compressed.
+    Statistics statistics() const;
 
 private:
     QList<SaveContext> m_ctxList;
     QMutex m_ctxListMutex;
     SaveParameters m_parameters;
+    std::atomic<qint64> m_rawBytes{0};
+    std::atomic<qint64> m_writtenBytes{0};
+    std::atomic<qint64> m_compressionTime{0};
+    std::atomic<xToolsProfiler::Stage *> m_profilerStage{nullptr};
 
 protected:
     void run() override;
 
 private:
+    xToolsProfiler::Stage *profilerStage();
     void openSaveFile();
 };
@@ -15,9 +15,11 @@
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QImage>
+#include <QInputDialog>
 #include <QLabel>
 #include <QLayout>
 #include <QMenuBar>
+#include <QMessageBox>
 #include <QPainter>
 #include <QPixmap>
 #include <QScrollBar>
@@ -30,6 +32,8 @@
 #include <QVariant>
 
 #include "xToolsApplication.h"
+#include "xToolsMetricsServer.h"
+#include "xToolsPipelineHealthUi.h"
 #ifdef X_TOOLS_ENABLE_MODULE_ASSISTANTS
 #include "xToolsAssistantFactory.h"
 #endif
@@ -214,6 +218,72 @@ void MainWindow::initOptionMenu()
         bool keep = action->isChecked();
         xToolsSettings::instance()->setValue(m_settingsKey.exitToSystemTray, keep);
     });
+
+    initMetricsMenu();
+}
+
+void MainWindow::initMetricsMenu()
+{
+    auto* server = xToolsMetricsServer::instance();
+    auto* settings = xToolsSettings::instance();
+    QVariant port = settings->value(m_settingsKey.metricsPort);
+    if (!port.isNull()) {
+        server->setPort(port.toInt());
+    }
+
+    auto* metricsMenu = new QMenu(tr("Metrics Endpoint"), this);
+    auto* enableAction = new QAction(this);
+    enableAction->setCheckable(true);
+    metricsMenu->addAction(enableAction);
+    auto updateText = [=]() {
+        QString url = QString("http://127.0.0.1:%1/metrics").arg(server->port());
+        enableAction->setText(tr("Enable") + QString(" (%1)").arg(url));
+    };
+    updateText();
+    m_optionMenu->addMenu(metricsMenu);
+
+    connect(server, &xToolsMetricsServer::errorOccurred, this, [=](const QString& errorString) {
+        enableAction->setChecked(false);
+        settings->setValue(m_settingsKey.metricsEnable, false);
+        QMessageBox::warning(this, tr("Metrics Endpoint"), errorString);
+    });
+    connect(enableAction, &QAction::triggered, this, [=]() {
+        bool enable = enableAction->isChecked();
+        settings->setValue(m_settingsKey.metricsEnable, enable);
+        if (enable) {
+            server->start();
+        } else {
+            server->stop();
+        }
+    });
+
+    metricsMenu->addAction(tr("Port..."), this, [=]() {
+        bool ok = false;
+        int port = QInputDialog::getInt(this,
+                                        tr("Metrics Endpoint"),
+                                        tr("Port"),
+                                        server->port(),
+                                        1,
+                                        65535,
+                                        1,
+                                        &ok);
+        if (!ok) {
+            return;
+        }
+
+        settings->setValue(m_settingsKey.metricsPort, port);
+        server->setPort(port);
+        updateText();
+        if (server->isRunning()) {
+            server->stop();
+            server->start();
+        }
+    });
+
+    if (settings->value(m_settingsKey.metricsEnable).toBool()) {
+        enableAction->setChecked(true);
+        server->start();
+    }
 }
 
 void MainWindow::initViewMenu()
@@ -261,6 +331,15 @@ void MainWindow::initViewMenu()
         a1x1->setChecked(true);
         a1x1->trigger();
     }
+
+    viewMenu->addSeparator();
+    auto* pipelineHealth = new xToolsPipelineHealthUi(this);
+    pipelineHealth->setWindowFlags(Qt::Window);
+    pipelineHealth->hide();
+    viewMenu->addAction(tr("Pipeline Health"), this, [=]() {
+        pipelineHealth->show();
+        pipelineHealth->activateWindow();
+    });
 }
 
 void MainWindow::initLanguageMenu() {}
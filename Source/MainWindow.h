@@ -43,6 +43,8 @@ private:
         const QString isTextBesideIcon{"MainWindow/isTextBesideIcon"};
         const QString pageIndex{"MainWindow/pageIndex"};
         const QString exitToSystemTray{"MainWindow/exitToSystemTray"};
+        const QString metricsEnable{"MainWindow/metricsEnable"};
+        const QString metricsPort{"MainWindow/metricsPort"};
     } m_settingsKey;
 
     QMenu* m_toolMenu;
@@ -57,6 +59,7 @@ private:
     void initFileMenu();
     void initToolMenu();
     void initOptionMenu();
+    void initMetricsMenu();
     void initViewMenu();
     void initLanguageMenu();
     void initHelpMenu();
@@ -0,0 +1,646 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusLoadTester.h"
+
+#include <QJsonArray>
+#include <QModbusClient>
+#include <QModbusReply>
+#include <QTimer>
+
+#include "xToolsModbusTcpPipeline.h"
+#include "xToolsProfiler.h"
+
+static void appendUInt16(QByteArray &bytes, quint16 value)
+{
+    bytes.append(static_cast<char>(value >> 8));
+    bytes.append(static_cast<char>(value & 0xff));
+}
+
+xToolsModbusLoadTester::xToolsModbusLoadTester(QObject *parent)
+    : QObject{parent}
+    , m_timer{new QTimer(this)}
+{
+    // The precise timer fires every millisecond, the number of the requests that are due is
+    // calculated from the elapsed time, so the jitter of the timer does not change the rate.
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(1);
+    connect(m_timer, &QTimer::timeout, this, &xToolsModbusLoadTester::onTimeout);
+}
+
+xToolsModbusLoadTester::~xToolsModbusLoadTester()
+{
+    deleteDevices();
+}
+
+QVariantMap xToolsModbusLoadTester::saveParameters(const Parameters &parameters)
+{
+    QVariantMap mix;
+    for (auto it = parameters.mix.constBegin(); it != parameters.mix.constEnd(); ++it) {
+        mix.insert(QString::number(it.key()), it.value());
+    }
+
+    QVariantMap data;
+    data["deviceType"] = parameters.deviceType;
+    data["address"] = parameters.address;
+    data["port"] = parameters.port;
+    data["connections"] = parameters.connections;
+    data["pipeline"] = parameters.pipeline;
+    data["portName"] = parameters.portName;
+    data["baudRate"] = parameters.baudRate;
+    data["dataBits"] = parameters.dataBits;
+    data["parity"] = parameters.parity;
+    data["stopBits"] = parameters.stopBits;
+    data["serverAddress"] = parameters.serverAddress;
+    data["startAddress"] = parameters.startAddress;
+    data["quantity"] = parameters.quantity;
+    data["mix"] = mix;
+    data["rate"] = parameters.rate;
+    data["maxPending"] = parameters.maxPending;
+    data["timeout"] = parameters.timeout;
+    data["duration"] = parameters.duration;
+    return data;
+}
+
+xToolsModbusLoadTester::Parameters xToolsModbusLoadTester::loadParameters(const QVariantMap &data)
+{
+    Parameters parameters;
+    parameters.deviceType = data.value("deviceType", parameters.deviceType).toInt();
+    parameters.address = data.value("address", parameters.address).toString();
+    parameters.port = data.value("port", parameters.port).toInt();
+    parameters.connections = data.value("connections", parameters.connections).toInt();
+    parameters.pipeline = data.value("pipeline", parameters.pipeline).toBool();
+    parameters.portName = data.value("portName", parameters.portName).toString();
+    parameters.baudRate = data.value("baudRate", parameters.baudRate).toInt();
+    parameters.dataBits = data.value("dataBits", parameters.dataBits).toInt();
+    parameters.parity = data.value("parity", parameters.parity).toInt();
+    parameters.stopBits = data.value("stopBits", parameters.stopBits).toInt();
+    parameters.serverAddress = data.value("serverAddress", parameters.serverAddress).toInt();
+    parameters.startAddress = data.value("startAddress", parameters.startAddress).toInt();
+    parameters.quantity = data.value("quantity", parameters.quantity).toInt();
+    parameters.rate = data.value("rate", parameters.rate).toDouble();
+    parameters.maxPending = data.value("maxPending", parameters.maxPending).toInt();
+    parameters.timeout = data.value("timeout", parameters.timeout).toInt();
+    parameters.duration = data.value("duration", parameters.duration).toInt();
+
+    // The mix is an object of "function code": weight, such as {"3": 8, "16": 2}.
+    if (data.contains("mix")) {
+        const QVariantMap mix = data.value("mix").toMap();
+        parameters.mix.clear();
+        for (auto it = mix.constBegin(); it != mix.constEnd(); ++it) {
+            parameters.mix.insert(it.key().toInt(), it.value().toInt());
+        }
+    }
+
+    return parameters;
+}
+
+bool xToolsModbusLoadTester::start(const Parameters &parameters, QString &errorString)
+{
+    if (m_isRunning || !m_clients.isEmpty() || m_pipeline) {
+        errorString = QString("The load test is running.");
+        return false;
+    }
+
+    xToolsModbusStudio *studio = xToolsModbusStudio::Instance();
+    const bool isTcp = parameters.deviceType == xToolsModbusStudio::ModbusTcpClient;
+    if (!isTcp && parameters.deviceType != xToolsModbusStudio::ModbusRtuSerialClient) {
+        errorString = QString("The device must be a tcp client or a rtu serial client.");
+        return false;
+    }
+
+    if (parameters.pipeline && !isTcp) {
+        errorString = QString("The pipeline is a tcp client.");
+        return false;
+    }
+
+    // The broadcast requests have no response, there is no latency to measure.
+    if (parameters.serverAddress < 1 || parameters.serverAddress > 247) {
+        errorString = QString("The server address must be 1-247.");
+        return false;
+    }
+
+    if (parameters.quantity < 1 || parameters.quantity > 123) {
+        errorString = QString("The quantity must be 1-123.");
+        return false;
+    }
+
+    m_sequence.clear();
+    for (auto it = parameters.mix.constBegin(); it != parameters.mix.constEnd(); ++it) {
+        const int functionCode = it.key();
+        if (functionCode != QModbusPdu::ReadHoldingRegisters
+            && functionCode != QModbusPdu::ReadInputRegisters
+            && functionCode != QModbusPdu::WriteSingleRegister
+            && functionCode != QModbusPdu::WriteMultipleRegisters) {
+            errorString = QString("The function code %1 is not supported.").arg(functionCode);
+            return false;
+        }
+
+        for (int i = 0; i < it.value(); i++) {
+            m_sequence.append(functionCode);
+        }
+    }
+
+    if (m_sequence.isEmpty()) {
+        errorString = QString("The request mix is empty.");
+        return false;
+    }
+
+    // Interleave the function codes, so a mix of 8:2 is not sent as bursts of 8 and 2 requests.
+    QList<int> sequence;
+    QMap<int, int> sent;
+    for (int i = 0; i < m_sequence.size(); i++) {
+        int functionCode = -1;
+        double lag = 0;
+        for (auto it = parameters.mix.constBegin(); it != parameters.mix.constEnd(); ++it) {
+            const double expected = double(i + 1) * it.value() / m_sequence.size();
+            if (it.value() > 0 && expected - sent.value(it.key()) > lag) {
+                lag = expected - sent.value(it.key());
+                functionCode = it.key();
+            }
+        }
+
+        sent[functionCode]++;
+        sequence.append(functionCode);
+    }
+    m_sequence = sequence;
+
+    m_parameters = parameters;
+    m_parameters.connections = isTcp ? qMax(1, parameters.connections) : 1;
+    m_parameters.maxPending = qMax(1, parameters.maxPending);
+    m_statistics = Statistics();
+    m_nextFunction = 0;
+    m_nextClient = 0;
+    m_scheduled = 0;
+    m_isStopping = false;
+
+    // The requests are queued by the pipeline until a connection is connected, the load starts
+    // when the first one is connected.
+    if (m_parameters.pipeline) {
+        m_pipeline = studio->CreateTcpPipeline(m_parameters.address,
+                                               m_parameters.port,
+                                               m_parameters.connections,
+                                               m_parameters.maxPending,
+                                               m_parameters.timeout);
+        connect(m_pipeline, &xToolsModbusTcpPipeline::connected, this, [this]() {
+            onStateChanged(QModbusDevice::ConnectedState);
+        });
+        connect(m_pipeline,
+                &xToolsModbusTcpPipeline::finished,
+                this,
+                &xToolsModbusLoadTester::onPipelineFinished);
+        connect(m_pipeline,
+                &xToolsModbusTcpPipeline::disconnected,
+                this,
+                &xToolsModbusLoadTester::onPipelineDisconnected);
+        connect(m_pipeline,
+                &xToolsModbusTcpPipeline::errorOccurred,
+                this,
+                [this](const QString &errorString) {
+                    if (!m_isRunning && !m_isStopping) {
+                        emit errorOccurred(errorString);
+                    }
+                });
+        m_pipeline->connectDevice();
+        return true;
+    }
+
+    for (int i = 0; i < m_parameters.connections; i++) {
+        QModbusDevice *device = nullptr;
+        if (isTcp) {
+            device = studio->CreateTcpDevice(m_parameters.deviceType,
+                                             m_parameters.address,
+                                             m_parameters.port);
+        } else {
+            device = studio->CreateRtuSerialDevice(m_parameters.deviceType,
+                                                   m_parameters.portName,
+                                                   m_parameters.parity,
+                                                   m_parameters.baudRate,
+                                                   m_parameters.dataBits,
+                                                   m_parameters.stopBits);
+        }
+
+        // The retries would hide the timeouts of the server under test.
+        studio->SetClientDeviceParameters(device, m_parameters.timeout, 0);
+        auto client = qobject_cast<QModbusClient *>(device);
+        m_clients.append(Client{client, 0});
+        connect(client, &QModbusDevice::stateChanged, this, [this](QModbusDevice::State state) {
+            onStateChanged(state);
+        });
+        connect(client, &QModbusDevice::errorOccurred, this, [this, client]() {
+            if (!m_isRunning && !m_isStopping) {
+                emit errorOccurred(client->errorString());
+            }
+        });
+    }
+
+    for (const Client &client : m_clients) {
+        if (!studio->ConnectDeivce(client.device)) {
+            errorString = client.device->errorString();
+            deleteDevices();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void xToolsModbusLoadTester::stop()
+{
+    if (m_isStopping) {
+        return;
+    }
+
+    m_isStopping = true;
+    m_timer->stop();
+    if (m_isRunning) {
+        m_statistics.elapsed = m_elapsedTimer.elapsed();
+    }
+
+    tryFinish();
+}
+
+bool xToolsModbusLoadTester::isRunning() const
+{
+    return m_isRunning;
+}
+
+xToolsModbusLoadTester::Statistics xToolsModbusLoadTester::statistics() const
+{
+    Statistics statistics = m_statistics;
+    if (m_isRunning && !m_isStopping) {
+        statistics.elapsed = m_elapsedTimer.elapsed();
+    }
+
+    return statistics;
+}
+
+QString xToolsModbusLoadTester::summary(const Statistics &statistics)
+{
+    const double seconds = statistics.elapsed / 1000.0;
+    const double rate = seconds > 0 ? statistics.responses / seconds : 0;
+
+    QString text;
+    text += QString("Duration %1 s, %2 requests, %3 responses(%4/s), %5 timeouts, %6 errors, ")
+                .arg(seconds, 0, 'f', 1)
+                .arg(statistics.requests)
+                .arg(statistics.responses)
+                .arg(rate, 0, 'f', 1)
+                .arg(statistics.timeouts)
+                .arg(statistics.errors);
+    text += QString("%1 exceptions, %2 skipped\n")
+                .arg(statistics.exceptions)
+                .arg(statistics.skipped);
+
+    text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+                .arg("FC", 4)
+                .arg("requests", 10)
+                .arg("responses", 10)
+                .arg("timeouts", 10)
+                .arg("errors", 8)
+                .arg("min(us)", 9)
+                .arg("p50", 9)
+                .arg("p99", 9)
+                .arg("p99.9", 9)
+                .arg("max", 9);
+    for (auto it = statistics.functions.constBegin(); it != statistics.functions.constEnd(); ++it) {
+        const FunctionStatistics &function = it.value();
+        const xToolsHdrHistogram &latency = function.latency;
+        text += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+                    .arg(QString("%1").arg(it.key(), 2, 10, QChar('0')), 4)
+                    .arg(function.requests, 10)
+                    .arg(function.responses, 10)
+                    .arg(function.timeouts, 10)
+                    .arg(function.errors, 8)
+                    .arg(latency.min(), 9)
+                    .arg(latency.valueAtPercentile(50), 9)
+                    .arg(latency.valueAtPercentile(99), 9)
+                    .arg(latency.valueAtPercentile(99.9), 9)
+                    .arg(latency.max(), 9);
+        for (auto e = function.exceptions.constBegin(); e != function.exceptions.constEnd(); ++e) {
+            text += QString("     exception 0x%1: %2\n")
+                        .arg(e.key(), 2, 16, QChar('0'))
+                        .arg(e.value());
+        }
+    }
+
+    return text;
+}
+
+QJsonObject xToolsModbusLoadTester::toJson(const Statistics &statistics)
+{
+    QJsonObject functions;
+    for (auto it = statistics.functions.constBegin(); it != statistics.functions.constEnd(); ++it) {
+        const FunctionStatistics &function = it.value();
+        QJsonObject exceptions;
+        for (auto e = function.exceptions.constBegin(); e != function.exceptions.constEnd(); ++e) {
+            exceptions.insert(QString::number(e.key()), e.value());
+        }
+
+        QJsonObject obj;
+        obj.insert("requests", function.requests);
+        obj.insert("responses", function.responses);
+        obj.insert("timeouts", function.timeouts);
+        obj.insert("errors", function.errors);
+        obj.insert("exceptions", exceptions);
+        obj.insert("latency", function.latency.toJson());
+        functions.insert(QString::number(it.key()), obj);
+    }
+
+    const double seconds = statistics.elapsed / 1000.0;
+    QJsonObject obj;
+    obj.insert("elapsed", statistics.elapsed);
+    obj.insert("requests", statistics.requests);
+    obj.insert("responses", statistics.responses);
+    obj.insert("responsesPerSecond", seconds > 0 ? statistics.responses / seconds : 0);
+    obj.insert("timeouts", statistics.timeouts);
+    obj.insert("errors", statistics.errors);
+    obj.insert("exceptions", statistics.exceptions);
+    obj.insert("skipped", statistics.skipped);
+    obj.insert("functions", functions);
+    return obj;
+}
+
+void xToolsModbusLoadTester::onStateChanged(int state)
+{
+    if (m_isRunning || m_isStopping) {
+        // A client that is disconnected while the load is running is not used any more.
+        return;
+    }
+
+    if (state != QModbusDevice::ConnectedState) {
+        return;
+    }
+
+    for (const Client &client : m_clients) {
+        if (client.device->state() != QModbusDevice::ConnectedState) {
+            return;
+        }
+    }
+
+    m_isRunning = true;
+    m_elapsedTimer.start();
+    m_timer->start();
+    emit started();
+}
+
+void xToolsModbusLoadTester::onTimeout()
+{
+    const qint64 elapsed = m_elapsedTimer.nsecsElapsed();
+    if (m_parameters.duration > 0 && elapsed >= m_parameters.duration * 1000000000ll) {
+        stop();
+        return;
+    }
+
+    // Without a target rate, every client keeps its pending requests at the limit.
+    if (m_parameters.rate <= 0) {
+        if (m_pipeline) {
+            while (canSend(0)) {
+                send(0);
+            }
+        }
+
+        for (int i = 0; i < m_clients.size(); i++) {
+            while (canSend(i)) {
+                send(i);
+            }
+        }
+        return;
+    }
+
+    const qint64 due = static_cast<qint64>(elapsed / 1e9 * m_parameters.rate);
+    const qint64 count = due - m_scheduled;
+    for (qint64 i = 0; i < count; i++) {
+        int index = nextClient();
+        if (index == -1) {
+            m_statistics.skipped += count - i;
+            break;
+        }
+
+        send(index);
+    }
+
+    m_scheduled = due;
+}
+
+int xToolsModbusLoadTester::nextClient()
+{
+    // The pipeline balances the requests over the connections itself.
+    if (m_pipeline) {
+        return canSend(0) ? 0 : -1;
+    }
+
+    for (int i = 0; i < m_clients.size(); i++) {
+        int index = m_nextClient;
+        m_nextClient = (m_nextClient + 1) % m_clients.size();
+        if (canSend(index)) {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+bool xToolsModbusLoadTester::canSend(int index) const
+{
+    if (m_pipeline) {
+        const int limit = m_parameters.connections * m_parameters.maxPending;
+        return m_pipeline->isConnected() && m_pipelineRequests.size() < limit;
+    }
+
+    const Client &client = m_clients.at(index);
+    return client.device->state() == QModbusDevice::ConnectedState
+           && client.pending < m_parameters.maxPending;
+}
+
+void xToolsModbusLoadTester::send(int index)
+{
+    const int functionCode = m_sequence.at(m_nextFunction);
+    m_nextFunction = (m_nextFunction + 1) % m_sequence.size();
+
+    FunctionStatistics &function = m_statistics.functions[functionCode];
+    m_statistics.requests++;
+    function.requests++;
+
+    const qint64 sentTime = xToolsProfiler::now();
+    if (m_pipeline) {
+        const quint64 id = m_pipeline->sendRequest(m_parameters.serverAddress,
+                                                   request(functionCode));
+        m_pipelineRequests.insert(id, qMakePair(functionCode, sentTime));
+        return;
+    }
+
+    Client &client = m_clients[index];
+    QModbusReply *reply = client.device->sendRawRequest(request(functionCode),
+                                                        m_parameters.serverAddress);
+    if (!reply) {
+        m_statistics.errors++;
+        function.errors++;
+        return;
+    }
+
+    client.pending++;
+    if (reply->isFinished()) {
+        onReplyFinished(index, functionCode, sentTime, reply);
+    } else {
+        connect(reply, &QModbusReply::finished, this, [=]() {
+            onReplyFinished(index, functionCode, sentTime, reply);
+        });
+    }
+}
+
+void xToolsModbusLoadTester::onReplyFinished(int index,
+                                             int functionCode,
+                                             qint64 sentTime,
+                                             QModbusReply *reply)
+{
+    reply->deleteLater();
+
+    Client &client = m_clients[index];
+    client.pending--;
+
+    // The results of the clients are recorded as the ones of the pipeline.
+    const QModbusResponse response = reply->rawResult();
+    int error = xToolsModbusTcpPipeline::ConnectionError;
+    if (reply->error() == QModbusDevice::NoError) {
+        error = xToolsModbusTcpPipeline::NoError;
+    } else if (reply->error() == QModbusDevice::ProtocolError && response.isException()) {
+        error = xToolsModbusTcpPipeline::ExceptionError;
+    } else if (reply->error() == QModbusDevice::TimeoutError) {
+        error = xToolsModbusTcpPipeline::TimeoutError;
+    }
+    record(functionCode, sentTime, error, response);
+
+    if (m_isStopping) {
+        tryFinish();
+    } else if (m_parameters.rate <= 0 && m_isRunning && canSend(index)) {
+        send(index);
+    }
+}
+
+void xToolsModbusLoadTester::onPipelineFinished(quint64 id,
+                                                int error,
+                                                const QModbusResponse &response)
+{
+    auto it = m_pipelineRequests.find(id);
+    if (it == m_pipelineRequests.end()) {
+        return;
+    }
+
+    const QPair<int, qint64> sent = it.value();
+    m_pipelineRequests.erase(it);
+    record(sent.first, sent.second, error, response);
+
+    if (m_isStopping) {
+        tryFinish();
+    } else if (m_parameters.rate <= 0 && m_isRunning && canSend(0)) {
+        send(0);
+    }
+}
+
+void xToolsModbusLoadTester::onPipelineDisconnected()
+{
+    // The pipeline fails its requests when it is disconnected, the ids that are left would keep
+    // a stopped load from finishing.
+    const QHash<quint64, QPair<int, qint64>> requests = m_pipelineRequests;
+    m_pipelineRequests.clear();
+    for (const QPair<int, qint64> &sent : requests) {
+        const int error = xToolsModbusTcpPipeline::ConnectionError;
+        record(sent.first, sent.second, error, QModbusResponse());
+    }
+
+    if (m_isStopping) {
+        tryFinish();
+    }
+}
+
+void xToolsModbusLoadTester::record(int functionCode,
+                                    qint64 sentTime,
+                                    int error,
+                                    const QModbusResponse &response)
+{
+    FunctionStatistics &function = m_statistics.functions[functionCode];
+    if (error == xToolsModbusTcpPipeline::NoError
+        || error == xToolsModbusTcpPipeline::ExceptionError) {
+        m_statistics.responses++;
+        function.responses++;
+        function.latency.record((xToolsProfiler::now() - sentTime) / 1000);
+        if (error == xToolsModbusTcpPipeline::ExceptionError) {
+            m_statistics.exceptions++;
+            function.exceptions[response.exceptionCode()]++;
+        }
+    } else if (error == xToolsModbusTcpPipeline::TimeoutError) {
+        m_statistics.timeouts++;
+        function.timeouts++;
+    } else {
+        m_statistics.errors++;
+        function.errors++;
+    }
+}
+
+QModbusRequest xToolsModbusLoadTester::request(int functionCode)
+{
+    const quint16 startAddress = m_parameters.startAddress;
+    const quint16 quantity = m_parameters.quantity;
+    switch (functionCode) {
+    case QModbusPdu::ReadHoldingRegisters:
+    case QModbusPdu::ReadInputRegisters:
+        return QModbusRequest(static_cast<QModbusPdu::FunctionCode>(functionCode),
+                              startAddress,
+                              quantity);
+    case QModbusPdu::WriteSingleRegister:
+        return QModbusRequest(QModbusPdu::WriteSingleRegister, startAddress, m_value++);
+    default: {
+        QByteArray data;
+        appendUInt16(data, startAddress);
+        appendUInt16(data, quantity);
+        data.append(static_cast<char>(quantity * 2));
+        for (int i = 0; i < quantity; i++) {
+            appendUInt16(data, m_value++);
+        }
+        return QModbusRequest(QModbusPdu::WriteMultipleRegisters, data);
+    }
+    }
+}
+
+void xToolsModbusLoadTester::tryFinish()
+{
+    for (const Client &client : m_clients) {
+        if (client.pending > 0) {
+            return;
+        }
+    }
+
+    if (!m_pipelineRequests.isEmpty()) {
+        return;
+    }
+
+    deleteDevices();
+    m_isRunning = false;
+    emit finished();
+}
+
+void xToolsModbusLoadTester::deleteDevices()
+{
+    // The devices are deleted later, tryFinish() may be called in a slot of a reply.
+    for (Client &client : m_clients) {
+        client.device->disconnect(this);
+        client.device->disconnectDevice();
+        QModbusDevice *device = client.device;
+        xToolsModbusStudio::Instance()->DeleteModbusDevuce(&device);
+    }
+    m_clients.clear();
+
+    if (m_pipeline) {
+        m_pipeline->disconnect(this);
+        m_pipeline->disconnectDevice();
+        m_pipeline->deleteLater();
+        m_pipeline = nullptr;
+    }
+    m_pipelineRequests.clear();
+}
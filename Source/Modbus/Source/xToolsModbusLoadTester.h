@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QModbusPdu>
+#include <QObject>
+#include <QPair>
+#include <QVariantMap>
+
+#include "xToolsHdrHistogram.h"
+#include "xToolsModbusStudio.h"
+
+class QModbusClient;
+class QModbusReply;
+class QTimer;
+class xToolsModbusTcpPipeline;
+
+/// Drives a server under test with a mix of FC03, FC04, FC06 and FC16 requests at a target rate,
+/// from N tcp clients or one rtu master. The clients are created by xToolsModbusStudio. With the
+/// pipeline option the tcp requests are sent by one xToolsModbusTcpPipeline of N connections
+/// instead, maxPending is the window of every connection then. The load starts when all clients
+/// are connected(the first connection of the pipeline), a request that is due while every client
+/// has its pending requests at the limit is skipped, so the rate never exceeds the target. The
+/// latencies are recorded in us per function code, the exception responses are counted by
+/// exception code.
+///
+/// The tester must be used in the thread it lives in.
+class xToolsModbusLoadTester : public QObject
+{
+    Q_OBJECT
+public:
+    struct Parameters
+    {
+        int deviceType{xToolsModbusStudio::ModbusTcpClient}; // Or ModbusRtuSerialClient.
+        QString address{"127.0.0.1"};
+        int port{502};
+        int connections{1}; // TCP clients, there is one rtu master always.
+        bool pipeline{false}; // TCP only, the requests are not serialized per connection.
+        QString portName;
+        int baudRate{9600};
+        int dataBits{8};
+        int parity{0}; // QSerialPort::Parity
+        int stopBits{1};
+
+        int serverAddress{1};
+        int startAddress{0};
+        int quantity{10};           // Registers of FC03, FC04 and FC16.
+        QMap<int, int> mix{{3, 1}}; // The weights of the function codes.
+        double rate{100};           // Requests per second of all clients, 0 = as fast as possible.
+        int maxPending{1};          // Pending requests per client.
+        int timeout{1000};          // ms
+        int duration{10};           // s, 0 = until stop().
+    };
+
+    struct FunctionStatistics
+    {
+        qint64 requests{0};
+        qint64 responses{0}; // Including the exception responses.
+        qint64 timeouts{0};
+        qint64 errors{0};             // Neither a response nor a timeout.
+        QMap<int, qint64> exceptions; // The key is the exception code.
+        xToolsHdrHistogram latency;   // us, the responses only.
+    };
+
+    struct Statistics
+    {
+        qint64 elapsed{0}; // ms, the time of the load.
+        qint64 requests{0};
+        qint64 responses{0};
+        qint64 timeouts{0};
+        qint64 errors{0};
+        qint64 exceptions{0};
+        qint64 skipped{0}; // Due requests that were not sent.
+        QMap<int, FunctionStatistics> functions;
+    };
+
+public:
+    explicit xToolsModbusLoadTester(QObject *parent = nullptr);
+    ~xToolsModbusLoadTester() override;
+
+    static QVariantMap saveParameters(const Parameters &parameters);
+    static Parameters loadParameters(const QVariantMap &data);
+
+    /// Returns false if the parameters are invalid or a client can not be created.
+    bool start(const Parameters &parameters, QString &errorString);
+    /// Stop sending, finished() is emitted when the pending requests are finished.
+    void stop();
+    bool isRunning() const;
+
+    Statistics statistics() const;
+    /// The human readable summary of the statistics.
+    static QString summary(const Statistics &statistics);
+    static QJsonObject toJson(const Statistics &statistics);
+
+signals:
+    void started();
+    void finished();
+    void errorOccurred(const QString &errorString);
+
+private:
+    struct Client
+    {
+        QModbusClient *device;
+        int pending;
+    };
+
+    Parameters m_parameters;
+    QList<Client> m_clients;
+    xToolsModbusTcpPipeline *m_pipeline{nullptr};
+    QHash<quint64, QPair<int, qint64>> m_pipelineRequests; // id: function code, sent time
+    QList<int> m_sequence; // The function codes of the mix in the order of sending.
+    int m_nextFunction{0};
+    int m_nextClient{0};
+    quint16 m_value{0};
+    qint64 m_scheduled{0};
+    bool m_isRunning{false};
+    bool m_isStopping{false};
+    QElapsedTimer m_elapsedTimer;
+    QTimer *m_timer;
+    Statistics m_statistics;
+
+private:
+    void onStateChanged(int state);
+    void onTimeout();
+    int nextClient();
+    void send(int index);
+    void onReplyFinished(int index, int functionCode, qint64 sentTime, QModbusReply *reply);
+    void onPipelineFinished(quint64 id, int error, const QModbusResponse &response);
+    void onPipelineDisconnected();
+    void record(int functionCode, qint64 sentTime, int error, const QModbusResponse &response);
+    bool canSend(int index) const;
+    void deleteDevices();
+    QModbusRequest request(int functionCode);
+    void tryFinish();
+};
@@ -0,0 +1,343 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusPoller.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QDateTime>
+#include <QModbusReply>
+
+#include "xToolsDeadlineScheduler.h"
+#include "xToolsProfiler.h"
+
+xToolsModbusPoller::xToolsModbusPoller(QObject *parent)
+    : QObject{parent}
+    , m_scheduler{new xToolsDeadlineScheduler(this)}
+{
+    connect(m_scheduler, &xToolsDeadlineScheduler::timeout, this, &xToolsModbusPoller::poll);
+}
+
+xToolsModbusPoller::~xToolsModbusPoller()
+{
+    stop();
+}
+
+void xToolsModbusPoller::setClient(QModbusClient *client)
+{
+    abortPendingRequests();
+    m_client = client;
+}
+
+void xToolsModbusPoller::setTags(const QList<Tag> &tags)
+{
+    bool isRunning = m_isRunning;
+    stop();
+
+    m_tags = tags;
+    m_blocks = groupTags(m_tags, m_maxGap);
+    m_mutex.lock();
+    m_values = QVector<TagValue>(m_tags.size());
+    m_mutex.unlock();
+
+    if (isRunning) {
+        start();
+    }
+}
+
+QList<xToolsModbusPoller::Tag> xToolsModbusPoller::tags() const
+{
+    return m_tags;
+}
+
+QList<xToolsModbusPoller::Block> xToolsModbusPoller::blocks() const
+{
+    return m_blocks;
+}
+
+xToolsModbusPoller::Tag xToolsModbusPoller::loadTag(const QVariantMap &data)
+{
+    Tag tag;
+    tag.name = data.value("name", tag.name).toString();
+    tag.serverAddress = data.value("serverAddress", tag.serverAddress).toInt();
+    tag.table = data.value("table", tag.table).toInt();
+    tag.address = data.value("address", tag.address).toInt();
+    tag.type = data.value("type", tag.type).toInt();
+    tag.period = data.value("period", tag.period).toInt();
+    return tag;
+}
+
+void xToolsModbusPoller::setMaxGap(int maxGap)
+{
+    if (maxGap == m_maxGap) {
+        return;
+    }
+
+    bool isRunning = m_isRunning;
+    stop();
+    m_maxGap = qMax(0, maxGap);
+    m_blocks = groupTags(m_tags, m_maxGap);
+    if (isRunning) {
+        start();
+    }
+}
+
+int xToolsModbusPoller::maxGap() const
+{
+    return m_maxGap;
+}
+
+void xToolsModbusPoller::start()
+{
+    if (m_isRunning) {
+        return;
+    }
+
+    m_isRunning = true;
+    for (int i = 0; i < m_blocks.size(); i++) {
+        m_scheduler->schedule(i, m_blocks.at(i).period * qint64(1000000));
+        // Don't wait a whole period for the first values.
+        poll(i);
+    }
+}
+
+void xToolsModbusPoller::stop()
+{
+    m_scheduler->clear();
+    abortPendingRequests();
+    m_isRunning = false;
+}
+
+bool xToolsModbusPoller::isRunning() const
+{
+    return m_isRunning;
+}
+
+xToolsModbusPoller::TagValue xToolsModbusPoller::tagValue(int index) const
+{
+    m_mutex.lock();
+    TagValue value = m_values.value(index);
+    m_mutex.unlock();
+    return value;
+}
+
+QVector<xToolsModbusPoller::TagValue> xToolsModbusPoller::tagValues() const
+{
+    m_mutex.lock();
+    QVector<TagValue> values = m_values;
+    m_mutex.unlock();
+    return values;
+}
+
+QMap<int, xToolsModbusPoller::ServerStatistics> xToolsModbusPoller::serverStatistics() const
+{
+    m_mutex.lock();
+    QMap<int, ServerStatistics> statistics = m_statistics;
+    m_mutex.unlock();
+    return statistics;
+}
+
+void xToolsModbusPoller::resetStatistics()
+{
+    m_mutex.lock();
+    m_statistics.clear();
+    m_mutex.unlock();
+}
+
+QList<xToolsModbusPoller::Block> xToolsModbusPoller::groupTags(const QList<Tag> &tags, int maxGap)
+{
+    QList<int> indexes;
+    for (int i = 0; i < tags.size(); i++) {
+        const Tag &tag = tags.at(i);
+        if (tag.address >= 0 && tag.address + tagSize(tag) <= 65536 && tag.period > 0) {
+            indexes.append(i);
+        }
+    }
+
+    std::stable_sort(indexes.begin(), indexes.end(), [&tags](int a, int b) {
+        const Tag &x = tags.at(a);
+        const Tag &y = tags.at(b);
+        if (x.serverAddress != y.serverAddress) {
+            return x.serverAddress < y.serverAddress;
+        } else if (x.table != y.table) {
+            return x.table < y.table;
+        } else if (x.period != y.period) {
+            return x.period < y.period;
+        }
+
+        return x.address < y.address;
+    });
+
+    // The tags are sorted by the address, so growing the last block while the request fits is
+    // the fewest blocks.
+    QList<Block> blocks;
+    for (int index : indexes) {
+        const Tag &tag = tags.at(index);
+        const int end = tag.address + tagSize(tag);
+        if (!blocks.isEmpty()) {
+            Block &block = blocks.last();
+            const int blockEnd = block.address + block.count;
+            const int limit = isBitTable(tag.table) ? maxBitsPerRequest : maxRegistersPerRequest;
+            bool isSameKey = block.serverAddress == tag.serverAddress && block.table == tag.table
+                             && block.period == tag.period;
+            if (isSameKey && tag.address <= blockEnd + maxGap && end - block.address <= limit) {
+                block.count = qMax(blockEnd, end) - block.address;
+                block.tags.append(index);
+                continue;
+            }
+        }
+
+        Block block{tag.serverAddress, tag.table, tag.address, end - tag.address, tag.period, {}};
+        block.tags.append(index);
+        blocks.append(block);
+    }
+
+    return blocks;
+}
+
+int xToolsModbusPoller::tagSize(const Tag &tag)
+{
+    if (isBitTable(tag.table)) {
+        return 1;
+    }
+
+    bool isWide = tag.type == TagTypeUInt32 || tag.type == TagTypeInt32 || tag.type == TagTypeFloat;
+    return isWide ? 2 : 1;
+}
+
+bool xToolsModbusPoller::isBitTable(int table)
+{
+    return table == QModbusDataUnit::Coils || table == QModbusDataUnit::DiscreteInputs;
+}
+
+void xToolsModbusPoller::poll(int block)
+{
+    if (!m_client || m_client->state() != QModbusDevice::ConnectedState) {
+        return;
+    }
+
+    const Block &b = m_blocks.at(block);
+    if (m_pendingRequests.contains(block)) {
+        m_mutex.lock();
+        m_statistics[b.serverAddress].skipped++;
+        m_mutex.unlock();
+        return;
+    }
+
+    auto table = static_cast<QModbusDataUnit::RegisterType>(b.table);
+    QModbusReply *reply = m_client->sendReadRequest(QModbusDataUnit(table, b.address, b.count),
+                                                    b.serverAddress);
+    m_mutex.lock();
+    ServerStatistics &statistics = m_statistics[b.serverAddress];
+    statistics.requests++;
+    if (!reply) {
+        statistics.errors++;
+        statistics.lastError = m_client->errorString();
+    }
+    m_mutex.unlock();
+
+    if (!reply) {
+        emit errorOccurred(b.serverAddress, m_client->errorString());
+        return;
+    }
+
+    m_pendingRequests.insert(block, PendingRequest{reply, xToolsProfiler::now()});
+    if (reply->isFinished()) {
+        // Replies of broadcast requests are finished immediately.
+        onReplyFinished(block, reply);
+    } else {
+        connect(reply, &QModbusReply::finished, this, [this, block, reply]() {
+            onReplyFinished(block, reply);
+        });
+    }
+}
+
+void xToolsModbusPoller::onReplyFinished(int block, QModbusReply *reply)
+{
+    reply->deleteLater();
+    auto it = m_pendingRequests.find(block);
+    if (it == m_pendingRequests.end() || it->reply != reply) {
+        return;
+    }
+
+    const double rtt = (xToolsProfiler::now() - it->sentTime) / 1000000.0;
+    m_pendingRequests.erase(it);
+
+    const Block &b = m_blocks.at(block);
+    const bool isOk = reply->error() == QModbusDevice::NoError;
+    const QModbusDataUnit unit = reply->result();
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    m_mutex.lock();
+    ServerStatistics &statistics = m_statistics[b.serverAddress];
+    if (isOk) {
+        statistics.replies++;
+        statistics.lastRtt = rtt;
+        statistics.minRtt = statistics.replies == 1 ? rtt : qMin(statistics.minRtt, rtt);
+        statistics.maxRtt = qMax(statistics.maxRtt, rtt);
+        statistics.meanRtt += (rtt - statistics.meanRtt) / statistics.replies;
+    } else {
+        statistics.errors++;
+        statistics.timeouts += reply->error() == QModbusDevice::TimeoutError ? 1 : 0;
+        statistics.lastError = reply->errorString();
+    }
+
+    for (int index : b.tags) {
+        TagValue &value = m_values[index];
+        if (isOk) {
+            value.value = decodeTag(m_tags.at(index), unit);
+            value.timestamp = timestamp;
+        }
+        value.isValid = isOk && value.value.isValid();
+    }
+    m_mutex.unlock();
+
+    if (isOk) {
+        emit tagsUpdated(b.tags);
+    } else {
+        emit errorOccurred(b.serverAddress, reply->errorString());
+    }
+}
+
+void xToolsModbusPoller::abortPendingRequests()
+{
+    for (const PendingRequest &request : m_pendingRequests) {
+        request.reply->disconnect(this);
+        request.reply->deleteLater();
+    }
+
+    m_pendingRequests.clear();
+}
+
+QVariant xToolsModbusPoller::decodeTag(const Tag &tag, const QModbusDataUnit &unit)
+{
+    const int offset = tag.address - unit.startAddress();
+    if (offset < 0 || offset + tagSize(tag) > int(unit.valueCount())) {
+        return QVariant();
+    }
+
+    const quint16 high = unit.value(offset);
+    if (isBitTable(tag.table) || tag.type == TagTypeBit) {
+        return QVariant(high != 0);
+    } else if (tag.type == TagTypeInt16) {
+        return QVariant(int(qint16(high)));
+    } else if (tag.type == TagTypeUInt16) {
+        return QVariant(uint(high));
+    }
+
+    const quint32 value = (quint32(high) << 16) | unit.value(offset + 1);
+    if (tag.type == TagTypeInt32) {
+        return QVariant(int(qint32(value)));
+    } else if (tag.type == TagTypeFloat) {
+        float cookedValue;
+        std::memcpy(&cookedValue, &value, sizeof(cookedValue));
+        return QVariant(cookedValue);
+    }
+
+    return QVariant(uint(value));
+}
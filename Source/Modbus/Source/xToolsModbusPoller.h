@@ -0,0 +1,148 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QModbusClient>
+#include <QModbusDataUnit>
+#include <QMutex>
+#include <QObject>
+#include <QVariant>
+#include <QVector>
+
+class QModbusReply;
+class xToolsDeadlineScheduler;
+
+/// Polls a list of tags with a modbus client. The tags are grouped into the fewest read requests:
+/// tags of the same server, table and period are merged while the request spans no more than 125
+/// registers or 2000 bits, and the hole between two tags is no longer than the max gap. Every
+/// block is read on its own period, a block is skipped while its previous request is pending.
+///
+/// The poller must be used in the thread of the client, except the values and the statistics
+/// which can be read from any thread.
+class xToolsModbusPoller : public QObject
+{
+    Q_OBJECT
+public:
+    /// 32 bits values are read from two registers, the high word first.
+    enum TagType {
+        TagTypeBit,
+        TagTypeUInt16,
+        TagTypeInt16,
+        TagTypeUInt32,
+        TagTypeInt32,
+        TagTypeFloat
+    };
+    Q_ENUM(TagType)
+
+    static const int maxRegistersPerRequest = 125;
+    static const int maxBitsPerRequest = 2000;
+
+    struct Tag
+    {
+        QString name;
+        int serverAddress{1};
+        int table{QModbusDataUnit::HoldingRegisters};
+        int address{0};
+        int type{TagTypeUInt16}; // Tags of the coils and the discrete inputs are bits always.
+        int period{1000};        // ms
+    };
+
+    struct Block
+    {
+        int serverAddress;
+        int table;
+        int address;
+        int count;
+        int period;
+        QList<int> tags; // The indexes of the tags.
+    };
+
+    struct TagValue
+    {
+        QVariant value;
+        qint64 timestamp{0}; // ms since epoch, when the value is read.
+        bool isValid{false};
+    };
+
+    struct ServerStatistics
+    {
+        qint64 requests{0};
+        qint64 replies{0};
+        qint64 errors{0};   // Including the timeouts.
+        qint64 timeouts{0};
+        qint64 skipped{0};  // Polls skipped because the previous request was pending.
+        double lastRtt{0};  // ms, the round-trip time.
+        double minRtt{0};
+        double maxRtt{0};
+        double meanRtt{0};
+        QString lastError;
+    };
+
+public:
+    explicit xToolsModbusPoller(QObject *parent = nullptr);
+    ~xToolsModbusPoller() override;
+
+    void setClient(QModbusClient *client);
+    /// The values of the tags are reset, the blocks are regrouped.
+    void setTags(const QList<Tag> &tags);
+    QList<Tag> tags() const;
+    QList<Block> blocks() const;
+    /// The keys are the names of the fields of Tag, such as {"name": "t1", "address": 10}.
+    static Tag loadTag(const QVariantMap &data);
+    /// Unused registers(or bits) that may be read to merge two blocks, 0 = contiguous tags only.
+    void setMaxGap(int maxGap);
+    int maxGap() const;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    TagValue tagValue(int index) const;
+    QVector<TagValue> tagValues() const;
+    /// The key is the server address.
+    QMap<int, ServerStatistics> serverStatistics() const;
+    void resetStatistics();
+
+    static QList<Block> groupTags(const QList<Tag> &tags, int maxGap);
+    /// The registers(or bits) of the tag.
+    static int tagSize(const Tag &tag);
+    static bool isBitTable(int table);
+
+signals:
+    /// The values of the tags are updated.
+    void tagsUpdated(const QList<int> &indexes);
+    void errorOccurred(int serverAddress, const QString &errorString);
+
+private:
+    struct PendingRequest
+    {
+        QModbusReply *reply;
+        qint64 sentTime;
+    };
+
+    QModbusClient *m_client{nullptr};
+    xToolsDeadlineScheduler *m_scheduler;
+    QList<Tag> m_tags;
+    QList<Block> m_blocks;
+    QMap<int, PendingRequest> m_pendingRequests; // The key is the index of the block.
+    int m_maxGap{0};
+    bool m_isRunning{false};
+
+    QVector<TagValue> m_values;
+    QMap<int, ServerStatistics> m_statistics;
+    mutable QMutex m_mutex;
+
+private:
+    void poll(int block);
+    void onReplyFinished(int block, QModbusReply *reply);
+    void abortPendingRequests();
+    static QVariant decodeTag(const Tag &tag, const QModbusDataUnit &unit);
+};
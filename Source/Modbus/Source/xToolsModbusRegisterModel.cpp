@@ -0,0 +1,136 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusRegisterModel.h"
+
+#include "xToolsModbusRegisterStore.h"
+
+xToolsModbusRegisterModel::xToolsModbusRegisterModel(xToolsModbusRegisterStore *store,
+                                                     QModbusDataUnit::RegisterType table,
+                                                     QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_store(store)
+    , m_table(table)
+{
+    connect(store,
+            &xToolsModbusRegisterStore::rangeChanged,
+            this,
+            &xToolsModbusRegisterModel::onRangeChanged);
+}
+
+int xToolsModbusRegisterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : xToolsModbusRegisterStore::tableSize;
+}
+
+int xToolsModbusRegisterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 3;
+}
+
+QVariant xToolsModbusRegisterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        if (index.column() == ColumnDescription) {
+            return QVariant();
+        }
+
+        return int(Qt::AlignCenter);
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        return QVariant();
+    }
+
+    int address = index.row();
+    if (index.column() == ColumnAddress) {
+        return QString("%1").arg(QString::number(address), 5, '0');
+    } else if (index.column() == ColumnValue) {
+        quint16 value = m_store->value(m_table, address);
+        return QString("%1").arg(QString::number(value, 16), 4, '0');
+    } else if (index.column() == ColumnDescription) {
+        return m_descriptions.value(address);
+    }
+
+    return QVariant();
+}
+
+bool xToolsModbusRegisterModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::EditRole) {
+        return false;
+    }
+
+    int address = index.row();
+    if (index.column() == ColumnValue) {
+        bool isOk = false;
+        quint16 cookedValue = value.toString().toUShort(&isOk, 16);
+        if (!isOk) {
+            return false;
+        }
+
+        // The view is refreshed by the notification of the store.
+        return m_store->setValue(m_table, address, cookedValue);
+    } else if (index.column() == ColumnDescription) {
+        QString description = value.toString();
+        if (description.isEmpty()) {
+            m_descriptions.remove(address);
+        } else {
+            m_descriptions.insert(address, description);
+        }
+
+        emit dataChanged(index, index);
+        return true;
+    }
+
+    return false;
+}
+
+QVariant xToolsModbusRegisterModel::headerData(int section,
+                                               Qt::Orientation orientation,
+                                               int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    if (section == ColumnAddress) {
+        return tr("Address");
+    } else if (section == ColumnValue) {
+        return tr("Value");
+    } else if (section == ColumnDescription) {
+        return tr("Description");
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags xToolsModbusRegisterModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+    if (index.isValid() && index.column() != ColumnAddress) {
+        flags |= Qt::ItemIsEditable;
+    }
+
+    return flags;
+}
+
+void xToolsModbusRegisterModel::onRangeChanged(QModbusDataUnit::RegisterType table,
+                                               int address,
+                                               int count)
+{
+    if (table != m_table || count <= 0) {
+        return;
+    }
+
+    emit dataChanged(index(address, ColumnValue), index(address + count - 1, ColumnValue));
+}
@@ -0,0 +1,46 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QModbusDataUnit>
+
+class xToolsModbusRegisterStore;
+
+/// A view of one table of a register store. The model holds no values, the rows are read from the
+/// store when they are painted, so only the visible rows cost anything.
+class xToolsModbusRegisterModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column { ColumnAddress, ColumnValue, ColumnDescription };
+
+public:
+    xToolsModbusRegisterModel(xToolsModbusRegisterStore *store,
+                              QModbusDataUnit::RegisterType table,
+                              QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section,
+                        Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+private:
+    xToolsModbusRegisterStore *m_store;
+    QModbusDataUnit::RegisterType m_table;
+    QHash<int, QString> m_descriptions;
+
+private:
+    void onRangeChanged(QModbusDataUnit::RegisterType table, int address, int count);
+};
@@ -0,0 +1,240 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusRegisterStore.h"
+
+#include <QModbusServer>
+#include <QTimer>
+
+xToolsModbusRegisterStore::xToolsModbusRegisterStore(QObject *parent)
+    : QObject(parent)
+    , m_notifyTimer(new QTimer(this))
+{
+    for (int i = 0; i < 4; i++) {
+        m_tables[i].values = QVector<quint16>(tableSize, 0);
+    }
+
+    // The timer is never stopped, the ranges can be written by any thread but the timer can only
+    // be started by the thread of the store.
+    m_notifyTimer->setInterval(40);
+    connect(m_notifyTimer,
+            &QTimer::timeout,
+            this,
+            &xToolsModbusRegisterStore::onNotifyTimerTimeout);
+    m_notifyTimer->start();
+}
+
+xToolsModbusRegisterStore::~xToolsModbusRegisterStore()
+{
+    detachServer();
+}
+
+bool xToolsModbusRegisterStore::setRange(QModbusDataUnit::RegisterType table,
+                                         int address,
+                                         const QVector<quint16> &values)
+{
+    int index = tableIndex(table);
+    if (index < 0 || address < 0 || address + values.count() > tableSize) {
+        return false;
+    }
+
+    if (values.isEmpty()) {
+        return true;
+    }
+
+    bool isBitTable = table == QModbusDataUnit::Coils || table == QModbusDataUnit::DiscreteInputs;
+    m_mutex.lock();
+    // Detached here if a snapshot is alive, the snapshot keeps the old values.
+    quint16 *data = m_tables[index].values.data() + address;
+    for (int i = 0; i < values.count(); i++) {
+        data[i] = isBitTable ? (values.at(i) ? 1 : 0) : values.at(i);
+    }
+    markDirty(index, address, address + values.count());
+    m_mutex.unlock();
+    return true;
+}
+
+QVector<quint16> xToolsModbusRegisterStore::getRange(QModbusDataUnit::RegisterType table,
+                                                     int address,
+                                                     int count) const
+{
+    int index = tableIndex(table);
+    if (index < 0 || address < 0 || count <= 0 || address + count > tableSize) {
+        return QVector<quint16>();
+    }
+
+    m_mutex.lock();
+    QVector<quint16> values = m_tables[index].values.mid(address, count);
+    m_mutex.unlock();
+    return values;
+}
+
+bool xToolsModbusRegisterStore::setValue(QModbusDataUnit::RegisterType table,
+                                         int address,
+                                         quint16 value)
+{
+    return setRange(table, address, QVector<quint16>(1, value));
+}
+
+quint16 xToolsModbusRegisterStore::value(QModbusDataUnit::RegisterType table, int address) const
+{
+    int index = tableIndex(table);
+    if (index < 0 || address < 0 || address >= tableSize) {
+        return 0;
+    }
+
+    m_mutex.lock();
+    quint16 value = m_tables[index].values.at(address);
+    m_mutex.unlock();
+    return value;
+}
+
+QVector<quint16> xToolsModbusRegisterStore::snapshot(QModbusDataUnit::RegisterType table) const
+{
+    int index = tableIndex(table);
+    if (index < 0) {
+        return QVector<quint16>();
+    }
+
+    m_mutex.lock();
+    QVector<quint16> values = m_tables[index].values;
+    m_mutex.unlock();
+    return values;
+}
+
+bool xToolsModbusRegisterStore::attachServer(QModbusServer *server)
+{
+    detachServer();
+    if (!server) {
+        return false;
+    }
+
+    QModbusDataUnitMap map;
+    for (int i = 0; i < 4; i++) {
+        QModbusDataUnit::RegisterType table = tableType(i);
+        map.insert(table, QModbusDataUnit(table, 0, snapshot(table)));
+    }
+
+    server->blockSignals(true);
+    bool isOk = server->setMap(map);
+    server->blockSignals(false);
+    if (!isOk) {
+        return false;
+    }
+
+    m_server = server;
+    connect(server,
+            &QModbusServer::dataWritten,
+            this,
+            &xToolsModbusRegisterStore::onServerDataWritten);
+    return true;
+}
+
+void xToolsModbusRegisterStore::detachServer()
+{
+    if (m_server) {
+        disconnect(m_server, Q_NULLPTR, this, Q_NULLPTR);
+    }
+
+    m_server = Q_NULLPTR;
+}
+
+void xToolsModbusRegisterStore::setNotifyInterval(int interval)
+{
+    m_notifyTimer->setInterval(qMax(1, interval));
+}
+
+int xToolsModbusRegisterStore::notifyInterval() const
+{
+    return m_notifyTimer->interval();
+}
+
+int xToolsModbusRegisterStore::tableIndex(QModbusDataUnit::RegisterType table)
+{
+    switch (table) {
+    case QModbusDataUnit::Coils:
+        return 0;
+    case QModbusDataUnit::DiscreteInputs:
+        return 1;
+    case QModbusDataUnit::InputRegisters:
+        return 2;
+    case QModbusDataUnit::HoldingRegisters:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
+QModbusDataUnit::RegisterType xToolsModbusRegisterStore::tableType(int index)
+{
+    static const QModbusDataUnit::RegisterType types[4] = {QModbusDataUnit::Coils,
+                                                           QModbusDataUnit::DiscreteInputs,
+                                                           QModbusDataUnit::InputRegisters,
+                                                           QModbusDataUnit::HoldingRegisters};
+    return types[index];
+}
+
+void xToolsModbusRegisterStore::markDirty(int index, int begin, int end)
+{
+    Table &table = m_tables[index];
+    if (table.dirtyBegin == table.dirtyEnd) {
+        table.dirtyBegin = begin;
+        table.dirtyEnd = end;
+    } else {
+        table.dirtyBegin = qMin(table.dirtyBegin, begin);
+        table.dirtyEnd = qMax(table.dirtyEnd, end);
+    }
+}
+
+void xToolsModbusRegisterStore::onServerDataWritten(QModbusDataUnit::RegisterType table,
+                                                    int address,
+                                                    int size)
+{
+    if (m_isSyncingServer || !m_server) {
+        return;
+    }
+
+    QModbusDataUnit unit(table, address, size);
+    if (m_server->data(&unit)) {
+        setRange(table, address, unit.values());
+    }
+}
+
+void xToolsModbusRegisterStore::onNotifyTimerTimeout()
+{
+    int begins[4];
+    int ends[4];
+    QVector<quint16> values[4];
+
+    m_mutex.lock();
+    for (int i = 0; i < 4; i++) {
+        Table &table = m_tables[i];
+        begins[i] = table.dirtyBegin;
+        ends[i] = table.dirtyEnd;
+        if (m_server && begins[i] != ends[i]) {
+            values[i] = table.values.mid(begins[i], ends[i] - begins[i]);
+        }
+        table.dirtyBegin = table.dirtyEnd = 0;
+    }
+    m_mutex.unlock();
+
+    for (int i = 0; i < 4; i++) {
+        if (begins[i] == ends[i]) {
+            continue;
+        }
+
+        // The ranges written by the clients are written back too, the values are equal.
+        if (m_server) {
+            m_isSyncingServer = true;
+            m_server->setData(QModbusDataUnit(tableType(i), begins[i], values[i]));
+            m_isSyncingServer = false;
+        }
+
+        emit rangeChanged(tableType(i), begins[i], ends[i] - begins[i]);
+    }
+}
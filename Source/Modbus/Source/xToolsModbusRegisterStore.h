@@ -0,0 +1,83 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QModbusDataUnit>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+class QModbusServer;
+class QTimer;
+
+/// The register map of the server role: the coils, the discrete inputs, the input registers and
+/// the holding registers, every table is 65536 contiguous values. Ranges are read and written in
+/// bulk, a snapshot shares the memory with the store until the store is written(copy on write).
+///
+/// The changes are not notified one by one, the ranges written during a notify interval are merged
+/// and rangeChanged() is emitted once per table and interval, so views cost nothing while the
+/// values are updated at high rates.
+///
+/// An attached server is kept in sync with the store: the writes of the clients are copied into
+/// the store at once, the writes of the store are copied into the server with the notification.
+///
+/// The ranges can be read and written from any thread, the server and the notifications are
+/// handled in the thread of the store.
+class xToolsModbusRegisterStore : public QObject
+{
+    Q_OBJECT
+public:
+    static const int tableSize = 65536;
+
+public:
+    explicit xToolsModbusRegisterStore(QObject *parent = nullptr);
+    ~xToolsModbusRegisterStore() override;
+
+    /// The values of the coils and the discrete inputs are stored as 0 or 1. Returns false if the
+    /// range is out of the table.
+    bool setRange(QModbusDataUnit::RegisterType table, int address, const QVector<quint16> &values);
+    QVector<quint16> getRange(QModbusDataUnit::RegisterType table, int address, int count) const;
+    bool setValue(QModbusDataUnit::RegisterType table, int address, quint16 value);
+    quint16 value(QModbusDataUnit::RegisterType table, int address) const;
+    QVector<quint16> snapshot(QModbusDataUnit::RegisterType table) const;
+
+    /// The map of the server is set to the values of the store.
+    bool attachServer(QModbusServer *server);
+    void detachServer();
+
+    void setNotifyInterval(int interval);
+    int notifyInterval() const;
+
+signals:
+    /// The union of the ranges written since the last notification of the table.
+    void rangeChanged(QModbusDataUnit::RegisterType table, int address, int count);
+
+private:
+    struct Table
+    {
+        QVector<quint16> values;
+        // The dirty range [begin, end) since the last notification, begin == end if it is clean.
+        int dirtyBegin{0};
+        int dirtyEnd{0};
+    };
+
+    Table m_tables[4];
+    mutable QMutex m_mutex;
+    QPointer<QModbusServer> m_server;
+    bool m_isSyncingServer{false};
+    QTimer *m_notifyTimer;
+
+private:
+    static int tableIndex(QModbusDataUnit::RegisterType table);
+    static QModbusDataUnit::RegisterType tableType(int index);
+    void markDirty(int index, int begin, int end);
+    void onServerDataWritten(QModbusDataUnit::RegisterType table, int address, int size);
+    void onNotifyTimerTimeout();
+};
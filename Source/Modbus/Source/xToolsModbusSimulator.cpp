@@ -0,0 +1,772 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusSimulator.h"
+
+#include <algorithm>
+#include <QModbusReply>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "xToolsDeadlineScheduler.h"
+#include "xToolsProfiler.h"
+
+namespace {
+
+void appendUInt16(QByteArray &bytes, quint16 value)
+{
+    bytes.append(static_cast<char>(value >> 8));
+    bytes.append(static_cast<char>(value));
+}
+
+quint16 uint16At(const uchar *data)
+{
+    return quint16((data[0] << 8) | data[1]);
+}
+
+} // namespace
+
+xToolsModbusSimulator::xToolsModbusSimulator(QObject *parent)
+    : QObject{parent}
+    , m_server{new QTcpServer(this)}
+    , m_scheduler{new xToolsDeadlineScheduler(this)}
+{
+    std::fill(m_units, m_units + 256, nullptr);
+    connect(m_server, &QTcpServer::newConnection, this, &xToolsModbusSimulator::onNewConnection);
+    connect(m_scheduler,
+            &xToolsDeadlineScheduler::timeout,
+            this,
+            &xToolsModbusSimulator::onGeneratorTimeout);
+}
+
+xToolsModbusSimulator::~xToolsModbusSimulator()
+{
+    stop();
+    for (Unit *unit : m_units) {
+        delete unit;
+    }
+}
+
+void xToolsModbusSimulator::setParameters(const Parameters &parameters)
+{
+    m_parameters = parameters;
+}
+
+xToolsModbusSimulator::Parameters xToolsModbusSimulator::parameters() const
+{
+    return m_parameters;
+}
+
+void xToolsModbusSimulator::setGatewayClient(QModbusClient *client)
+{
+    m_gatewayClient = client;
+}
+
+bool xToolsModbusSimulator::load(const QVariantMap &data)
+{
+    Parameters parameters;
+    parameters.address = data.value("address", parameters.address).toString();
+    parameters.port = data.value("port", parameters.port).toInt();
+    parameters.mode = data.value("mode", parameters.mode).toInt();
+    parameters.maxQueuedRequests = data.value("maxQueuedRequests", parameters.maxQueuedRequests)
+                                       .toInt();
+    m_parameters = parameters;
+
+    const QVariantList units = data.value("units").toList();
+    for (const QVariant &u : units) {
+        const QVariantMap unit = u.toMap();
+        const int unitId = unit.value("unitId", 1).toInt();
+        if (!addUnit(unitId)) {
+            m_errorString = tr("Invalid unit %1.").arg(unitId);
+            return false;
+        }
+
+        const QVariantList ranges = unit.value("ranges").toList();
+        for (const QVariant &r : ranges) {
+            const QVariantMap range = r.toMap();
+            const int table = range.value("table", QModbusDataUnit::HoldingRegisters).toInt();
+            const int address = range.value("address", 0).toInt();
+            const int count = range.value("count", 1).toInt();
+            if (!addRange(unitId, table, address, count)) {
+                m_errorString = tr("Invalid range %1(%2) of the unit %3.");
+                m_errorString = m_errorString.arg(address).arg(count).arg(unitId);
+                return false;
+            }
+        }
+    }
+
+    const QVariantList generators = data.value("generators").toList();
+    for (const QVariant &g : generators) {
+        const QVariantMap map = g.toMap();
+        Generator generator;
+        generator.unitId = map.value("unitId", generator.unitId).toInt();
+        generator.table = map.value("table", generator.table).toInt();
+        generator.address = map.value("address", generator.address).toInt();
+        generator.type = map.value("type", generator.type).toInt();
+        generator.minimum = map.value("minimum", generator.minimum).toUInt();
+        generator.maximum = map.value("maximum", generator.maximum).toUInt();
+        generator.step = map.value("step", generator.step).toUInt();
+        generator.period = map.value("period", generator.period).toInt();
+        if (addGenerator(generator) == -1) {
+            m_errorString = tr("The registers of the generator %1 of the unit %2 are not mapped.");
+            m_errorString = m_errorString.arg(generator.address).arg(generator.unitId);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool xToolsModbusSimulator::start()
+{
+    stop();
+
+    if (m_parameters.mode == GatewayMode && !m_gatewayClient) {
+        m_errorString = tr("The gateway client is not set.");
+        return false;
+    }
+
+    if (!m_server->listen(QHostAddress(m_parameters.address), m_parameters.port)) {
+        m_errorString = m_server->errorString();
+        return false;
+    }
+
+    if (m_parameters.mode == SimulatorMode) {
+        for (int i = 0; i < m_generators.count(); i++) {
+            const int period = qMax(1, m_generators.at(i).generator.period);
+            m_scheduler->schedule(i, period * qint64(1000000));
+        }
+    }
+
+    m_errorString.clear();
+    return true;
+}
+
+void xToolsModbusSimulator::stop()
+{
+    m_scheduler->clear();
+    m_server->close();
+
+    QList<Connection *> connections = m_connections.values();
+    m_connections.clear();
+    for (Connection *connection : connections) {
+        connection->socket->disconnect(this);
+        connection->socket->abort();
+        connection->socket->deleteLater();
+        delete connection;
+    }
+}
+
+bool xToolsModbusSimulator::isRunning() const
+{
+    return m_server->isListening();
+}
+
+QString xToolsModbusSimulator::errorString() const
+{
+    return m_errorString;
+}
+
+bool xToolsModbusSimulator::addUnit(int unitId)
+{
+    if (unitId < 1 || unitId > 247) {
+        return false;
+    }
+
+    if (!m_units[unitId]) {
+        m_units[unitId] = new Unit;
+    }
+
+    return true;
+}
+
+void xToolsModbusSimulator::removeUnit(int unitId)
+{
+    if (unitId < 1 || unitId > 247) {
+        return;
+    }
+
+    delete m_units[unitId];
+    m_units[unitId] = nullptr;
+}
+
+QList<int> xToolsModbusSimulator::units() const
+{
+    QList<int> ids;
+    for (int i = 1; i <= 247; i++) {
+        if (m_units[i]) {
+            ids.append(i);
+        }
+    }
+
+    return ids;
+}
+
+bool xToolsModbusSimulator::addRange(int unitId, int table, int address, int count)
+{
+    if (unitId < 1 || unitId > 247 || !m_units[unitId] || count < 1 || address < 0
+        || address + count > 65536) {
+        return false;
+    }
+
+    if (table != QModbusDataUnit::Coils && table != QModbusDataUnit::DiscreteInputs
+        && table != QModbusDataUnit::InputRegisters && table != QModbusDataUnit::HoldingRegisters) {
+        return false;
+    }
+
+    // Rebuild the layout with the new range merged, the values of the old ranges are kept.
+    Unit *unit = m_units[unitId];
+    QVector<Segment> segments = unit->segments;
+    segments.append(Segment{table, address, address + count, -1});
+    std::sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b) {
+        return a.table != b.table ? a.table < b.table : a.begin < b.begin;
+    });
+
+    QVector<Segment> merged;
+    for (const Segment &segment : segments) {
+        if (!merged.isEmpty() && merged.last().table == segment.table
+            && segment.begin <= merged.last().end) {
+            merged.last().end = qMax(merged.last().end, segment.end);
+        } else {
+            merged.append(segment);
+        }
+    }
+
+    int size = 0;
+    for (Segment &segment : merged) {
+        segment.offset = size;
+        size += segment.end - segment.begin;
+    }
+
+    QVector<quint16> memory(size, 0);
+    for (const Segment &segment : unit->segments) {
+        for (const Segment &target : merged) {
+            if (target.table == segment.table && target.begin <= segment.begin
+                && segment.end <= target.end) {
+                const quint16 *source = unit->memory.constData() + segment.offset;
+                std::copy(source,
+                          source + (segment.end - segment.begin),
+                          memory.data() + target.offset + (segment.begin - target.begin));
+                break;
+            }
+        }
+    }
+
+    unit->segments = merged;
+    unit->memory = memory;
+    return true;
+}
+
+bool xToolsModbusSimulator::setValues(int unitId,
+                                      int table,
+                                      int address,
+                                      const QVector<quint16> &values)
+{
+    if (unitId < 1 || unitId > 247 || !m_units[unitId] || values.isEmpty()) {
+        return false;
+    }
+
+    quint16 *data = find(m_units[unitId], table, address, values.count());
+    if (!data) {
+        return false;
+    }
+
+    for (int i = 0; i < values.count(); i++) {
+        data[i] = isBitTable(table) ? (values.at(i) ? 1 : 0) : values.at(i);
+    }
+
+    return true;
+}
+
+QVector<quint16> xToolsModbusSimulator::values(int unitId, int table, int address, int count) const
+{
+    if (unitId < 1 || unitId > 247 || !m_units[unitId] || count < 1) {
+        return QVector<quint16>();
+    }
+
+    const Unit *unit = m_units[unitId];
+    const int offset = offsetOf(unit, table, address, count);
+    return offset < 0 ? QVector<quint16>() : unit->memory.mid(offset, count);
+}
+
+int xToolsModbusSimulator::memoryUsage(int unitId) const
+{
+    if (unitId < 1 || unitId > 247 || !m_units[unitId]) {
+        return 0;
+    }
+
+    const Unit *unit = m_units[unitId];
+    return int(sizeof(Unit) + unit->segments.capacity() * sizeof(Segment)
+               + unit->memory.capacity() * sizeof(quint16));
+}
+
+int xToolsModbusSimulator::addGenerator(const Generator &generator)
+{
+    const int count = generator.type == CounterGenerator ? 2 : 1;
+    if (generator.type == CounterGenerator && isBitTable(generator.table)) {
+        return -1;
+    }
+
+    if (values(generator.unitId, generator.table, generator.address, count).isEmpty()) {
+        return -1;
+    }
+
+    const int index = m_generators.count();
+    // Every generator has its own sequence, seeded by the index.
+    m_generators.append(GeneratorContext{generator, quint32(index + 1) * 2654435761u});
+    if (isRunning() && m_parameters.mode == SimulatorMode) {
+        m_scheduler->schedule(index, qMax(1, generator.period) * qint64(1000000));
+    }
+
+    return index;
+}
+
+void xToolsModbusSimulator::clearGenerators()
+{
+    m_scheduler->clear();
+    m_generators.clear();
+}
+
+QList<xToolsModbusSimulator::Generator> xToolsModbusSimulator::generators() const
+{
+    QList<Generator> generators;
+    for (const GeneratorContext &context : m_generators) {
+        generators.append(context.generator);
+    }
+
+    return generators;
+}
+
+xToolsModbusSimulator::Statistics xToolsModbusSimulator::statistics() const
+{
+    return m_statistics;
+}
+
+void xToolsModbusSimulator::resetStatistics()
+{
+    const int queueDepth = m_statistics.queueDepth;
+    m_statistics = Statistics();
+    m_statistics.queueDepth = queueDepth;
+}
+
+QByteArray xToolsModbusSimulator::processRequest(int unitId, const QByteArray &pdu)
+{
+    if (pdu.isEmpty()) {
+        return QByteArray();
+    }
+
+    const int functionCode = quint8(pdu.at(0));
+    if (unitId < 1 || unitId > 247 || !m_units[unitId]) {
+        return exceptionPdu(functionCode, QModbusPdu::GatewayTargetDeviceFailedToRespond);
+    }
+
+    Unit *unit = m_units[unitId];
+    const uchar *data = reinterpret_cast<const uchar *>(pdu.constData());
+    switch (functionCode) {
+    case QModbusPdu::ReadCoils:
+        return readBits(unit, QModbusDataUnit::Coils, data, pdu.size());
+    case QModbusPdu::ReadDiscreteInputs:
+        return readBits(unit, QModbusDataUnit::DiscreteInputs, data, pdu.size());
+    case QModbusPdu::ReadHoldingRegisters:
+        return readRegisters(unit, QModbusDataUnit::HoldingRegisters, data, pdu.size());
+    case QModbusPdu::ReadInputRegisters:
+        return readRegisters(unit, QModbusDataUnit::InputRegisters, data, pdu.size());
+    case QModbusPdu::WriteSingleCoil:
+        return writeSingle(unit, QModbusDataUnit::Coils, data, pdu.size());
+    case QModbusPdu::WriteSingleRegister:
+        return writeSingle(unit, QModbusDataUnit::HoldingRegisters, data, pdu.size());
+    case QModbusPdu::WriteMultipleCoils:
+        return writeMultipleCoils(unit, data, pdu.size());
+    case QModbusPdu::WriteMultipleRegisters:
+        return writeMultipleRegisters(unit, data, pdu.size());
+    default:
+        return exceptionPdu(functionCode, QModbusPdu::IllegalFunction);
+    }
+}
+
+bool xToolsModbusSimulator::isBitTable(int table)
+{
+    return table == QModbusDataUnit::Coils || table == QModbusDataUnit::DiscreteInputs;
+}
+
+QByteArray xToolsModbusSimulator::exceptionPdu(int functionCode, QModbusPdu::ExceptionCode code)
+{
+    QByteArray pdu;
+    pdu.append(static_cast<char>(functionCode | QModbusPdu::ExceptionByte));
+    pdu.append(static_cast<char>(code));
+    return pdu;
+}
+
+int xToolsModbusSimulator::offsetOf(const Unit *unit, int table, int address, int count)
+{
+    // A unit has a few segments, a linear search is faster than a binary one.
+    for (const Segment &segment : unit->segments) {
+        if (segment.table == table && segment.begin <= address && address + count <= segment.end) {
+            return segment.offset + (address - segment.begin);
+        }
+    }
+
+    return -1;
+}
+
+quint16 *xToolsModbusSimulator::find(Unit *unit, int table, int address, int count)
+{
+    const int offset = offsetOf(unit, table, address, count);
+    return offset < 0 ? nullptr : unit->memory.data() + offset;
+}
+
+QByteArray xToolsModbusSimulator::readBits(Unit *unit, int table, const uchar *pdu, int size)
+{
+    if (size != 5) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const int address = uint16At(pdu + 1);
+    const int count = uint16At(pdu + 3);
+    if (count < 1 || count > 2000) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const quint16 *data = find(unit, table, address, count);
+    if (!data) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataAddress);
+    }
+
+    const int byteCount = (count + 7) / 8;
+    QByteArray response(2 + byteCount, '\0');
+    response[0] = static_cast<char>(pdu[0]);
+    response[1] = static_cast<char>(byteCount);
+    char *bits = response.data() + 2;
+    for (int i = 0; i < count; i++) {
+        if (data[i]) {
+            bits[i / 8] = static_cast<char>(bits[i / 8] | (1 << (i % 8)));
+        }
+    }
+
+    return response;
+}
+
+QByteArray xToolsModbusSimulator::readRegisters(Unit *unit, int table, const uchar *pdu, int size)
+{
+    if (size != 5) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const int address = uint16At(pdu + 1);
+    const int count = uint16At(pdu + 3);
+    if (count < 1 || count > 125) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const quint16 *data = find(unit, table, address, count);
+    if (!data) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataAddress);
+    }
+
+    QByteArray response;
+    response.reserve(2 + count * 2);
+    response.append(static_cast<char>(pdu[0]));
+    response.append(static_cast<char>(count * 2));
+    for (int i = 0; i < count; i++) {
+        appendUInt16(response, data[i]);
+    }
+
+    return response;
+}
+
+QByteArray xToolsModbusSimulator::writeSingle(Unit *unit, int table, const uchar *pdu, int size)
+{
+    if (size != 5) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const int address = uint16At(pdu + 1);
+    quint16 value = uint16At(pdu + 3);
+    if (table == QModbusDataUnit::Coils) {
+        if (value != 0xff00 && value != 0x0000) {
+            return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+        }
+        value = value ? 1 : 0;
+    }
+
+    quint16 *data = find(unit, table, address, 1);
+    if (!data) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataAddress);
+    }
+
+    *data = value;
+    return QByteArray(reinterpret_cast<const char *>(pdu), size);
+}
+
+QByteArray xToolsModbusSimulator::writeMultipleCoils(Unit *unit, const uchar *pdu, int size)
+{
+    if (size < 6) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const int address = uint16At(pdu + 1);
+    const int count = uint16At(pdu + 3);
+    const int byteCount = pdu[5];
+    if (count < 1 || count > 1968 || byteCount != (count + 7) / 8 || size != 6 + byteCount) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    quint16 *data = find(unit, QModbusDataUnit::Coils, address, count);
+    if (!data) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataAddress);
+    }
+
+    const uchar *bits = pdu + 6;
+    for (int i = 0; i < count; i++) {
+        data[i] = (bits[i / 8] >> (i % 8)) & 0x01;
+    }
+
+    return QByteArray(reinterpret_cast<const char *>(pdu), 5);
+}
+
+QByteArray xToolsModbusSimulator::writeMultipleRegisters(Unit *unit, const uchar *pdu, int size)
+{
+    if (size < 6) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    const int address = uint16At(pdu + 1);
+    const int count = uint16At(pdu + 3);
+    const int byteCount = pdu[5];
+    if (count < 1 || count > 123 || byteCount != count * 2 || size != 6 + byteCount) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataValue);
+    }
+
+    quint16 *data = find(unit, QModbusDataUnit::HoldingRegisters, address, count);
+    if (!data) {
+        return exceptionPdu(pdu[0], QModbusPdu::IllegalDataAddress);
+    }
+
+    for (int i = 0; i < count; i++) {
+        data[i] = uint16At(pdu + 6 + i * 2);
+    }
+
+    return QByteArray(reinterpret_cast<const char *>(pdu), 5);
+}
+
+void xToolsModbusSimulator::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        auto *connection = new Connection{socket, QByteArray()};
+        m_connections.insert(socket, connection);
+        m_statistics.connections++;
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, connection]() {
+            onReadyRead(connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, connection]() {
+            onDisconnected(connection);
+        });
+    }
+}
+
+void xToolsModbusSimulator::onReadyRead(Connection *connection)
+{
+    connection->buffer.append(connection->socket->readAll());
+
+    const QByteArray &buffer = connection->buffer;
+    const uchar *data = reinterpret_cast<const uchar *>(buffer.constData());
+    int offset = 0;
+    while (buffer.size() - offset >= 8) {
+        const uchar *header = data + offset;
+        const quint16 transactionId = uint16At(header);
+        const quint16 protocolId = uint16At(header + 2);
+        const quint16 length = uint16At(header + 4);
+        if (protocolId != 0 || length < 2 || length > 254) {
+            m_statistics.invalidFrames++;
+            // The connection is deleted by the disconnected signal.
+            connection->socket->abort();
+            return;
+        }
+
+        if (buffer.size() - offset < 6 + length) {
+            break;
+        }
+
+        QByteArray pdu(reinterpret_cast<const char *>(header + 7), length - 1);
+        handleFrame(connection, transactionId, header[6], pdu);
+        offset += 6 + length;
+    }
+
+    connection->buffer.remove(0, offset);
+}
+
+void xToolsModbusSimulator::onDisconnected(Connection *connection)
+{
+    if (m_connections.remove(connection->socket)) {
+        connection->socket->deleteLater();
+        delete connection;
+    }
+}
+
+void xToolsModbusSimulator::handleFrame(Connection *connection,
+                                        quint16 transactionId,
+                                        int unitId,
+                                        QByteArray pdu)
+{
+    m_statistics.requests++;
+    if (m_parameters.mode == GatewayMode) {
+        forward(connection, transactionId, unitId, pdu);
+        return;
+    }
+
+    if (unitId == 0) {
+        // A broadcast is written to all units and not answered.
+        for (int i = 1; i <= 247; i++) {
+            if (m_units[i]) {
+                processRequest(i, pdu);
+            }
+        }
+        return;
+    }
+
+    if (unitId > 247 || !m_units[unitId]) {
+        m_statistics.unknownUnits++;
+    }
+
+    sendResponse(connection->socket, transactionId, unitId, processRequest(unitId, pdu));
+}
+
+void xToolsModbusSimulator::forward(Connection *connection,
+                                    quint16 transactionId,
+                                    int unitId,
+                                    const QByteArray &pdu)
+{
+    const int functionCode = quint8(pdu.at(0));
+    if (!m_gatewayClient || m_gatewayClient->state() != QModbusDevice::ConnectedState) {
+        QByteArray response = exceptionPdu(functionCode, QModbusPdu::GatewayPathUnavailable);
+        sendResponse(connection->socket, transactionId, unitId, response);
+        return;
+    }
+
+    if (m_statistics.queueDepth >= qMax(1, m_parameters.maxQueuedRequests)) {
+        m_statistics.busy++;
+        QByteArray response = exceptionPdu(functionCode, QModbusPdu::ServerDeviceBusy);
+        sendResponse(connection->socket, transactionId, unitId, response);
+        return;
+    }
+
+    QModbusRequest request(static_cast<QModbusPdu::FunctionCode>(functionCode), pdu.mid(1));
+    QModbusReply *reply = m_gatewayClient->sendRawRequest(request, unitId);
+    if (!reply) {
+        QByteArray response = exceptionPdu(functionCode, QModbusPdu::GatewayPathUnavailable);
+        sendResponse(connection->socket, transactionId, unitId, response);
+        return;
+    }
+
+    m_statistics.forwarded++;
+    if (reply->isFinished()) {
+        // A broadcast is finished at once and not answered.
+        reply->deleteLater();
+        return;
+    }
+
+    m_statistics.queueDepth++;
+    m_statistics.maxQueueDepth = qMax(m_statistics.maxQueueDepth, m_statistics.queueDepth);
+
+    // The connection may be closed before the response.
+    QPointer<QTcpSocket> socket = connection->socket;
+    const qint64 sentTime = xToolsProfiler::now();
+    connect(reply, &QModbusReply::finished, this, [=]() {
+        reply->deleteLater();
+        m_statistics.queueDepth--;
+
+        QByteArray response;
+        QModbusResponse result = reply->rawResult();
+        if (reply->error() == QModbusDevice::NoError
+            || (reply->error() == QModbusDevice::ProtocolError && result.isException())) {
+            response.append(static_cast<char>(result.functionCode()));
+            response.append(result.data());
+
+            const double rtt = (xToolsProfiler::now() - sentTime) / 1000000.0;
+            m_statistics.answered++;
+            m_statistics.lastRtt = rtt;
+            m_statistics.maxRtt = qMax(m_statistics.maxRtt, rtt);
+            m_statistics.meanRtt += (rtt - m_statistics.meanRtt) / m_statistics.answered;
+        } else if (reply->error() == QModbusDevice::TimeoutError) {
+            m_statistics.timeouts++;
+            response = exceptionPdu(functionCode, QModbusPdu::GatewayTargetDeviceFailedToRespond);
+        } else {
+            emit errorOccurred(reply->errorString());
+            response = exceptionPdu(functionCode, QModbusPdu::GatewayPathUnavailable);
+        }
+
+        if (socket) {
+            sendResponse(socket, transactionId, unitId, response);
+        }
+    });
+}
+
+void xToolsModbusSimulator::sendResponse(QTcpSocket *socket,
+                                         quint16 transactionId,
+                                         int unitId,
+                                         const QByteArray &pdu)
+{
+    if (pdu.isEmpty()) {
+        return;
+    }
+
+    QByteArray adu;
+    adu.reserve(7 + pdu.size());
+    appendUInt16(adu, transactionId);
+    appendUInt16(adu, 0);
+    appendUInt16(adu, pdu.size() + 1);
+    adu.append(static_cast<char>(unitId));
+    adu.append(pdu);
+    socket->write(adu);
+
+    m_statistics.responses++;
+    if (quint8(pdu.at(0)) & QModbusPdu::ExceptionByte) {
+        m_statistics.exceptions++;
+    }
+}
+
+void xToolsModbusSimulator::onGeneratorTimeout(int index)
+{
+    if (index < 0 || index >= m_generators.count()) {
+        return;
+    }
+
+    GeneratorContext &context = m_generators[index];
+    const Generator &generator = context.generator;
+    const int count = generator.type == CounterGenerator ? 2 : 1;
+    Unit *unit = generator.unitId >= 1 && generator.unitId <= 247 ? m_units[generator.unitId]
+                                                                   : nullptr;
+    quint16 *data = unit ? find(unit, generator.table, generator.address, count) : nullptr;
+    if (!data) {
+        // The unit or the range is removed.
+        return;
+    }
+
+    quint16 value = 0;
+    if (generator.type == RampGenerator) {
+        const int next = data[0] + generator.step;
+        value = next > generator.maximum || next < generator.minimum ? generator.minimum : next;
+    } else if (generator.type == NoiseGenerator) {
+        // xorshift32
+        context.random ^= context.random << 13;
+        context.random ^= context.random >> 17;
+        context.random ^= context.random << 5;
+        const quint32 range = quint32(qMax(0, generator.maximum - generator.minimum)) + 1;
+        value = quint16(generator.minimum + context.random % range);
+    } else if (generator.type == CounterGenerator) {
+        const quint32 counter = ((quint32(data[0]) << 16) | data[1]) + generator.step;
+        data[0] = quint16(counter >> 16);
+        data[1] = quint16(counter);
+        return;
+    }
+
+    data[0] = isBitTable(generator.table) ? (value ? 1 : 0) : value;
+}
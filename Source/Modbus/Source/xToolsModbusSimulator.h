@@ -0,0 +1,197 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QModbusClient>
+#include <QModbusDataUnit>
+#include <QModbusPdu>
+#include <QObject>
+#include <QPointer>
+#include <QVariantMap>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+class xToolsDeadlineScheduler;
+
+/// A modbus tcp server for many units behind one port, the unit id of the MBAP header selects the
+/// unit. A unit maps only the ranges added to it, the ranges of a unit are packed into one block
+/// of memory, so hundreds of units cost no more than the registers they really have. A request
+/// out of the ranges gets the exception "illegal data address", a request to a unit that does not
+/// exist gets "gateway target device failed to respond".
+///
+/// Generators update registers periodically: ramps, noise and 32 bits counters. On the coils and
+/// the discrete inputs a generated value is 1 if it is not 0.
+///
+/// In gateway mode the requests are forwarded to a modbus client, usually the rtu serial client of
+/// xToolsModbusStudio, and the responses are sent back with the transaction ids of the requests.
+/// The forwarded requests are queued by the client, a request that finds the queue full gets
+/// "server device busy".
+///
+/// The simulator must be used in the thread it lives in.
+class xToolsModbusSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode { SimulatorMode, GatewayMode };
+    Q_ENUM(Mode)
+
+    enum GeneratorType { RampGenerator, NoiseGenerator, CounterGenerator };
+    Q_ENUM(GeneratorType)
+
+    struct Parameters
+    {
+        QString address{"0.0.0.0"};
+        quint16 port{502};
+        int mode{SimulatorMode};
+        int maxQueuedRequests{32}; // Gateway mode, forwarded requests waiting for the responses.
+    };
+
+    /// Ramp: the value is increased by the step, and restarts from the minimum after the maximum.
+    /// Noise: a random value in [minimum, maximum].
+    /// Counter: a 32 bits value of two registers(the high word first) increased by the step, the
+/// minimum and the maximum are not used, counters of the coils and the discrete inputs are invalid.
+    struct Generator
+    {
+        int unitId{1};
+        int table{QModbusDataUnit::HoldingRegisters};
+        int address{0};
+        int type{RampGenerator};
+        quint16 minimum{0};
+        quint16 maximum{0xffff};
+        quint16 step{1};
+        int period{1000}; // ms
+    };
+
+    struct Statistics
+    {
+        qint64 connections{0}; // Accepted connections.
+        qint64 requests{0};
+        qint64 responses{0}; // Including the exception responses.
+        qint64 exceptions{0};
+        qint64 invalidFrames{0};
+        qint64 unknownUnits{0};
+        // Gateway mode.
+        qint64 forwarded{0};
+        qint64 answered{0}; // Forwarded requests answered by the units, the exceptions included.
+        qint64 timeouts{0};
+        qint64 busy{0}; // Requests rejected because the queue was full.
+        int queueDepth{0};
+        int maxQueueDepth{0};
+        double lastRtt{0}; // ms, the round-trip time of the forwarded requests.
+        double maxRtt{0};
+        double meanRtt{0};
+    };
+
+public:
+    explicit xToolsModbusSimulator(QObject *parent = nullptr);
+    ~xToolsModbusSimulator() override;
+
+    /// The parameters are applied when the simulator is started.
+    void setParameters(const Parameters &parameters);
+    Parameters parameters() const;
+    /// The client is not owned, it must be connected before the requests are forwarded.
+    void setGatewayClient(QModbusClient *client);
+    /// Load the parameters, the units and the generators, the keys are the names of the fields:
+    /// {"port": 502, "units": [{"unitId": 1, "ranges": [{"table": 4, "address": 0, "count": 10}]}],
+    /// "generators": [{"unitId": 1, "address": 0, "type": 0, "period": 100}]}. The units and the
+    /// generators are added to the ones of the simulator, errorString() tells the invalid one.
+    bool load(const QVariantMap &data);
+
+    bool start();
+    void stop();
+    bool isRunning() const;
+    QString errorString() const;
+
+    /// Unit ids are 1 to 247, 0 is the broadcast address.
+    bool addUnit(int unitId);
+    void removeUnit(int unitId);
+    QList<int> units() const;
+    /// Map [address, address + count) of the table, the new registers are 0. Overlapping and
+    /// adjacent ranges are merged.
+    bool addRange(int unitId, int table, int address, int count);
+    bool setValues(int unitId, int table, int address, const QVector<quint16> &values);
+    /// Empty if the range is not mapped.
+    QVector<quint16> values(int unitId, int table, int address, int count) const;
+    /// The memory of the unit in bytes.
+    int memoryUsage(int unitId) const;
+
+    /// Returns the index of the generator, -1 if the registers are not mapped.
+    int addGenerator(const Generator &generator);
+    void clearGenerators();
+    QList<Generator> generators() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+    /// The response pdu(function code and data) of a request to the unit.
+    QByteArray processRequest(int unitId, const QByteArray &pdu);
+
+signals:
+    void errorOccurred(const QString &errorString);
+
+private:
+    struct Segment
+    {
+        int table;
+        int begin;
+        int end;
+        int offset; // Into the memory of the unit.
+    };
+
+    struct Unit
+    {
+        QVector<Segment> segments; // Sorted by the table and the address.
+        QVector<quint16> memory;
+    };
+
+    struct GeneratorContext
+    {
+        Generator generator;
+        quint32 random;
+    };
+
+    struct Connection
+    {
+        QTcpSocket *socket;
+        QByteArray buffer;
+    };
+
+    Parameters m_parameters;
+    QTcpServer *m_server;
+    QHash<QTcpSocket *, Connection *> m_connections;
+    QPointer<QModbusClient> m_gatewayClient;
+    Unit *m_units[256];
+    QList<GeneratorContext> m_generators;
+    xToolsDeadlineScheduler *m_scheduler;
+    Statistics m_statistics;
+    QString m_errorString;
+
+private:
+    static bool isBitTable(int table);
+    static QByteArray exceptionPdu(int functionCode, QModbusPdu::ExceptionCode code);
+    /// The offset of the registers in the memory of the unit, -1 if they are not mapped.
+    static int offsetOf(const Unit *unit, int table, int address, int count);
+    static quint16 *find(Unit *unit, int table, int address, int count);
+    QByteArray readBits(Unit *unit, int table, const uchar *pdu, int size);
+    QByteArray readRegisters(Unit *unit, int table, const uchar *pdu, int size);
+    QByteArray writeSingle(Unit *unit, int table, const uchar *pdu, int size);
+    QByteArray writeMultipleCoils(Unit *unit, const uchar *pdu, int size);
+    QByteArray writeMultipleRegisters(Unit *unit, const uchar *pdu, int size);
+
+    void onNewConnection();
+    void onReadyRead(Connection *connection);
+    void onDisconnected(Connection *connection);
+    void handleFrame(Connection *connection, quint16 transactionId, int unitId, QByteArray pdu);
+    void forward(Connection *connection, quint16 transactionId, int unitId, const QByteArray &pdu);
+    void sendResponse(QTcpSocket *socket, quint16 transactionId, int unitId, const QByteArray &pdu);
+    void onGeneratorTimeout(int index);
+};
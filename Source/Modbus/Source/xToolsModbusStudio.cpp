@@ -20,6 +20,10 @@
 #include <QModbusRtuSerialServer>
 #endif
 
+#include "xToolsModbusPoller.h"
+#include "xToolsModbusSimulator.h"
+#include "xToolsModbusTcpPipeline.h"
+
 xToolsModbusStudio::xToolsModbusStudio(QObject *parent)
     : QObject(parent)
 {}
@@ -330,6 +334,26 @@ QModbusReply *xToolsModbusStudio::SendWriteRequest(QModbusDevice *modbus_device,
     return Q_NULLPTR;
 }
 
+QModbusReply *xToolsModbusStudio::SendReadRequest(QModbusDevice *modbus_device,
+                                                int register_type,
+                                                int start_address,
+                                                int quantity,
+                                                int server_address)
+{
+    if (modbus_device && IsClientDevice(modbus_device)) {
+        auto cooked_type = QModbusDataUnit::RegisterType(register_type);
+        QModbusDataUnit dataUnit(cooked_type, start_address, quantity);
+        if (dataUnit.isValid()) {
+            auto *client = qobject_cast<QModbusClient *>(modbus_device);
+            return client->sendReadRequest(dataUnit, server_address);
+        } else {
+            qWarning() << "Unvalid data unit!";
+        }
+    }
+
+    return Q_NULLPTR;
+}
+
 QModbusReply *xToolsModbusStudio::SendRawRequest(QModbusDevice *modbus_device,
                                                int server_address,
                                                int function_code,
@@ -344,3 +368,72 @@ QModbusReply *xToolsModbusStudio::SendRawRequest(QModbusDevice *modbus_device,
 
     return Q_NULLPTR;
 }
+
+xToolsModbusTcpPipeline *xToolsModbusStudio::CreateTcpPipeline(
+    const QString &address, int port, int connections, int window, int timeout)
+{
+    xToolsModbusTcpPipeline::Parameters parameters;
+    parameters.address = address;
+    parameters.port = port;
+    parameters.connections = connections;
+    parameters.window = window;
+    parameters.timeout = timeout;
+
+    auto *pipeline = new xToolsModbusTcpPipeline();
+    pipeline->setParameters(parameters);
+    return pipeline;
+}
+
+quint64 xToolsModbusStudio::SendReadRequest(xToolsModbusTcpPipeline *pipeline,
+                                            int register_type,
+                                            int start_address,
+                                            int quantity,
+                                            int server_address)
+{
+    if (pipeline) {
+        auto cooked_type = QModbusDataUnit::RegisterType(register_type);
+        QModbusDataUnit dataUnit(cooked_type, start_address, quantity);
+        return pipeline->sendReadRequest(dataUnit, server_address);
+    }
+
+    return 0;
+}
+
+quint64 xToolsModbusStudio::SendRawRequest(xToolsModbusTcpPipeline *pipeline,
+                                           int server_address,
+                                           int function_code,
+                                           const QByteArray &data)
+{
+    if (pipeline) {
+        auto cooked_function_code = QModbusPdu::FunctionCode(function_code);
+        return pipeline->sendRequest(server_address, QModbusRequest(cooked_function_code, data));
+    }
+
+    return 0;
+}
+
+xToolsModbusPoller *xToolsModbusStudio::CreatePoller(QModbusDevice *modbus_device)
+{
+    if (IsClientDevice(modbus_device)) {
+        auto *poller = new xToolsModbusPoller(modbus_device);
+        poller->setClient(qobject_cast<QModbusClient *>(modbus_device));
+        return poller;
+    }
+
+    return Q_NULLPTR;
+}
+
+xToolsModbusSimulator *xToolsModbusStudio::CreateGateway(QModbusDevice *modbus_device, int port)
+{
+    if (IsClientDevice(modbus_device)) {
+        auto *gateway = new xToolsModbusSimulator(modbus_device);
+        xToolsModbusSimulator::Parameters parameters;
+        parameters.port = port;
+        parameters.mode = xToolsModbusSimulator::GatewayMode;
+        gateway->setParameters(parameters);
+        gateway->setGatewayClient(qobject_cast<QModbusClient *>(modbus_device));
+        return gateway;
+    }
+
+    return Q_NULLPTR;
+}
@@ -13,6 +13,9 @@
 #include <QModbusReply>
 #include <QObject>
 
+class xToolsModbusPoller;
+class xToolsModbusSimulator;
+class xToolsModbusTcpPipeline;
 class xToolsModbusStudio : public QObject
 {
     Q_OBJECT
@@ -72,8 +75,34 @@ public:
                                    QList<quint16> values,
 #endif
                                    int server_address);
+    QModbusReply *SendReadRequest(QModbusDevice *modbus_device,
+                                  int register_type,
+                                  int start_address,
+                                  int quantity,
+                                  int server_address);
     QModbusReply *SendRawRequest(QModbusDevice *modbus_device,
                                  int server_address,
                                  int function_code,
                                  const QByteArray &data);
+
+    /// A tcp client that keeps a window of outstanding requests on every connection, the
+    /// requests of it return the id that is passed to xToolsModbusTcpPipeline::finished(), 0 if
+    /// the request is invalid. The pipeline is not connected, call connectDevice() of it.
+    xToolsModbusTcpPipeline *CreateTcpPipeline(
+        const QString &address, int port, int connections, int window, int timeout);
+    quint64 SendReadRequest(xToolsModbusTcpPipeline *pipeline,
+                            int register_type,
+                            int start_address,
+                            int quantity,
+                            int server_address);
+    quint64 SendRawRequest(xToolsModbusTcpPipeline *pipeline,
+                           int server_address,
+                           int function_code,
+                           const QByteArray &data);
+    /// The poller is a child of the client device, it is null if the device is not a client.
+    xToolsModbusPoller *CreatePoller(QModbusDevice *modbus_device);
+    /// A simulator in gateway mode that forwards the requests of the tcp port to the client
+    /// device(a rtu serial client usually), it is a child of the client device, it is null if the
+    /// device is not a client.
+    xToolsModbusSimulator *CreateGateway(QModbusDevice *modbus_device, int port);
 };
@@ -40,6 +40,8 @@
 #endif
 
 #include "xToolsCompatibility.h"
+#include "xToolsModbusRegisterModel.h"
+#include "xToolsModbusRegisterStore.h"
 #include "xToolsModbusStudio.h"
 #include "xToolsSettings.h"
 
@@ -121,6 +123,7 @@ xToolsModbusStudioUi::xToolsModbusStudioUi(QWidget *parent)
     , ui(new Ui::xToolsModbusStudioUi)
     , m_modbusDevice(Q_NULLPTR)
     , m_registerModel(Q_NULLPTR)
+    , m_registerStore(new xToolsModbusRegisterStore(this))
     , m_keyCtx(new xToolsModbusUiSettingKeys)
 {
     if (!m_settings) {
@@ -277,10 +280,17 @@ void xToolsModbusStudioUi::initComponentRegisterTabWidget()
     QTabWidget *tabWidget = ui->tabWidgetServerRegisters;
     QStringList titles = QStringList() << tr("Coils") << tr("DiscreteInputs")
                                        << tr("InputRegisters") << tr("HoldingRegisters");
-    for (QString &title : titles) {
-        QTableView *tableView = CreateTableView(UINT16_MAX + 1, Q_NULLPTR);
+    QList<QModbusDataUnit::RegisterType> tables;
+    tables << QModbusDataUnit::Coils << QModbusDataUnit::DiscreteInputs
+           << QModbusDataUnit::InputRegisters << QModbusDataUnit::HoldingRegisters;
+    for (int i = 0; i < tables.count(); i++) {
+        QTableView *tableView = new QTableView(this);
+        auto *model = new xToolsModbusRegisterModel(m_registerStore, tables.at(i), tableView);
+        tableView->setModel(model);
+        tableView->setItemDelegateForColumn(0, new ReadOnlyDelegate(tableView));
         tableView->verticalHeader()->hide();
-        tabWidget->addTab(tableView, title);
+        tableView->horizontalHeader()->setStretchLastSection(true);
+        tabWidget->addTab(tableView, titles.at(i));
     }
 }
 
@@ -557,6 +567,7 @@ void xToolsModbusStudioUi::onDeviceTypeChanged()
 
 void xToolsModbusStudioUi::onCloseClicked()
 {
+    m_registerStore->detachServer();
     xToolsModbusStudio::Instance()->DeleteModbusDevuce(&m_modbusDevice);
     updateUiState(false);
 }
@@ -569,17 +580,14 @@ void xToolsModbusStudioUi::onOpenClicked()
     m_modbusDevice = CreateModbusDevice();
 
     if (xToolsModbusStudio::Instance()->IsServerDevice(m_modbusDevice)) {
-        if (!updateServerMap(m_modbusDevice)) {
+        QModbusServer *server = qobject_cast<QModbusServer *>(m_modbusDevice);
+        if (!m_registerStore->attachServer(server)) {
             ui->pushButtonOpen->setEnabled(true);
             qWarning() << "Can not reset server map!";
             return;
         }
 
         updateServerParameters();
-
-        QModbusServer *server = qobject_cast<QModbusServer *>(m_modbusDevice);
-        updateServerRegistersData();
-        connect(server, &QModbusServer::dataWritten, this, &xToolsModbusStudioUi::onDateWritten);
     } else if (xToolsModbusStudio::Instance()->IsClientDevice(m_modbusDevice)) {
         updateClientParameters();
     } else {
@@ -834,67 +842,6 @@ void xToolsModbusStudioUi::onSendClicked()
     m_settings->setValue(m_keyCtx->sendHistoryIndex, index);
 }
 
-void xToolsModbusStudioUi::onDateWritten(QModbusDataUnit::RegisterType table, int address, int size)
-{
-    qInfo() << "Data written:"
-            << "table:" << table << "start address:" << address << "size:" << size;
-    QTableView *tv = getTableView(table);
-    QStandardItemModel *model = qobject_cast<QStandardItemModel *>(tv->model());
-    QModbusServer *server = qobject_cast<QModbusServer *>(m_modbusDevice);
-    QList<quint16> data = xToolsModbusStudio::Instance()->GetServerData(server,
-                                                                        table,
-                                                                        address,
-                                                                        size);
-    size = qMin<int>(data.count(), size);
-    for (int i = 0; i < size; i++) {
-        int row = address + i;
-        int base = 16;
-        int width = base == 2 ? 16 : (base == 10 ? 5 : 4);
-        int value = data.at(i);
-        QString cooked_str = QString::number(value, base);
-        cooked_str = cooked_str.rightJustified(width, '0', true);
-        QStandardItem *item = model->item(row, 1);
-        if (item) {
-            item->setData(cooked_str, Qt::DisplayRole);
-            item->setTextAlignment(Qt::AlignCenter);
-        }
-    }
-
-    tv->viewport()->update();
-}
-
-void xToolsModbusStudioUi::onItemChanged(QStandardItem *item)
-{
-    if (!item) {
-        return;
-    }
-
-    if (item->column() != 1) {
-        return;
-    }
-
-    if (xToolsModbusStudio::Instance()->IsServerDevice(m_modbusDevice)) {
-        int address = item->row();
-        int current_index = ui->tabWidgetServerRegisters->currentIndex();
-        QModbusDataUnit::RegisterType table = QModbusDataUnit::Invalid;
-        if (current_index == 0) {
-            table = QModbusDataUnit::Coils;
-        } else if (current_index == 1) {
-            table = QModbusDataUnit::DiscreteInputs;
-        } else if (current_index == 2) {
-            table = QModbusDataUnit::InputRegisters;
-        } else if (current_index == 3) {
-            table = QModbusDataUnit::HoldingRegisters;
-        } else {
-            Q_ASSERT_X(false, __FUNCTION__, "Unknow table type!");
-            return;
-        }
-
-        quint16 value = item->text().toInt(Q_NULLPTR, 16);
-        xToolsModbusStudio::Instance()->SetServerData(m_modbusDevice, table, address, value);
-    }
-}
-
 QModbusDevice *xToolsModbusStudioUi::CreateModbusDevice()
 {
     QModbusDevice *device = Q_NULLPTR;
@@ -955,8 +902,6 @@ QTableView *xToolsModbusStudioUi::CreateTableView(int rowCount, QTableView *tabl
     }
     model->blockSignals(false);
 
-    connect(model, &QStandardItemModel::itemChanged, this, &xToolsModbusStudioUi::onItemChanged);
-
     return tableView;
 }
 
@@ -1060,57 +1005,6 @@ void xToolsModbusStudioUi::updateServerParameters()
                                                               listen_only_mode);
 }
 
-bool xToolsModbusStudioUi::updateServerMap(QModbusDevice *server)
-{
-    if (server && qobject_cast<QModbusServer *>(server)) {
-        QVector<quint16> values(UINT16_MAX + 1, 0);
-        QModbusDataUnit dataUnit(QModbusDataUnit::Coils, 0, values);
-
-        QModbusDataUnitMap map;
-        map.insert(QModbusDataUnit::Coils, dataUnit);
-        map.insert(QModbusDataUnit::DiscreteInputs, dataUnit);
-        map.insert(QModbusDataUnit::HoldingRegisters, dataUnit);
-        map.insert(QModbusDataUnit::InputRegisters, dataUnit);
-
-        QModbusServer *cooked_server = qobject_cast<QModbusServer *>(server);
-        cooked_server->blockSignals(true);
-        bool is_ok = cooked_server->setMap(map);
-        cooked_server->blockSignals(false);
-        return is_ok;
-    }
-
-    return false;
-}
-
-void xToolsModbusStudioUi::updateServerRegistersData()
-{
-    for (int i = 0; i < 4; i++) {
-        QWidget *widget = ui->tabWidgetServerRegisters->widget(i);
-        QTableView *table_view = qobject_cast<QTableView *>(widget);
-        auto *model = qobject_cast<QStandardItemModel *>(table_view->model());
-        int type = QModbusDataUnit::Invalid;
-        if (i == 0) {
-            type = QModbusDataUnit::Coils;
-        } else if (i == 1) {
-            type = QModbusDataUnit::DiscreteInputs;
-        } else if (i == 2) {
-            type = QModbusDataUnit::InputRegisters;
-        } else if (i == 3) {
-            type = QModbusDataUnit::HoldingRegisters;
-        } else {
-            qWarning() << "Unknown register type.";
-            continue;
-        }
-
-        for (int row = 0; row < model->rowCount(); row++) {
-            QStandardItem *item = model->item(row, 1);
-            quint16 value = item ? item->text().toInt(Q_NULLPTR, 16) : 0;
-            auto table = static_cast<QModbusDataUnit::RegisterType>(type);
-            xToolsModbusStudio::Instance()->SetServerData(m_modbusDevice, table, row, value, false);
-        }
-    }
-}
-
 quint8 xToolsModbusStudioUi::getClientFunctionCode()
 {
     QString txt = ui->comboBoxFunctionCode->currentText();
@@ -1154,25 +1048,6 @@ QByteArray xToolsModbusStudioUi::getClientPdu()
     return data;
 }
 
-QTableView *xToolsModbusStudioUi::getTableView(QModbusDataUnit::RegisterType table)
-{
-    QWidget *tv = Q_NULLPTR;
-    if (table == QModbusDataUnit::Coils) {
-        tv = ui->tabWidgetServerRegisters->widget(0);
-    } else if (table == QModbusDataUnit::DiscreteInputs) {
-        tv = ui->tabWidgetServerRegisters->widget(1);
-    } else if (table == QModbusDataUnit::InputRegisters) {
-        tv = ui->tabWidgetServerRegisters->widget(2);
-    } else if (table == QModbusDataUnit::HoldingRegisters) {
-        tv = ui->tabWidgetServerRegisters->widget(3);
-    } else {
-        tv = ui->tabWidgetServerRegisters->widget(3);
-        qWarning() << "Get table view failed: unknow register type!";
-    }
-
-    return qobject_cast<QTableView *>(tv);
-}
-
 QList<quint16> xToolsModbusStudioUi::getTableValues(QTableView *tableView, int row, int count)
 {
     if (!tableView) {
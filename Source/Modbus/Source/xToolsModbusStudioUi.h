@@ -25,6 +25,7 @@ class xToolsModbusStudioUi;
 }
 
 struct xToolsModbusUiSettingKeys;
+class xToolsModbusRegisterStore;
 class xToolsModbusStudioUi : public QWidget
 {
     Q_OBJECT
@@ -40,6 +41,7 @@ private:
     QModbusDevice *m_modbusDevice{Q_NULLPTR};
     QSettings *m_settings{Q_NULLPTR};
     QStandardItemModel *m_registerModel{Q_NULLPTR};
+    xToolsModbusRegisterStore *m_registerStore{Q_NULLPTR};
     xToolsModbusUiSettingKeys *m_keyCtx;
 
 private:
@@ -100,9 +102,6 @@ private:
     void onWriteClicked();
     void onSendClicked();
 
-    void onDateWritten(QModbusDataUnit::RegisterType table, int address, int size);
-    void onItemChanged(QStandardItem *item);
-
 private:
     QModbusDevice *CreateModbusDevice();
     QTableView *CreateTableView(int rowCount, QTableView *tableView);
@@ -114,13 +113,10 @@ private:
     void updateClientParameters();
     void updateClientTableViewAddress(QTableView *view, int startAddress);
     void updateServerParameters();
-    bool updateServerMap(QModbusDevice *server);
-    void updateServerRegistersData();
 
     quint8 getClientFunctionCode();
     QList<quint16> getClientRegisterValue();
     QByteArray getClientPdu();
-    QTableView *getTableView(QModbusDataUnit::RegisterType table);
     QList<quint16> getTableValues(QTableView *tableView, int row, int count);
 
     void outputModbusReply(QModbusReply *reply, int functionCode);
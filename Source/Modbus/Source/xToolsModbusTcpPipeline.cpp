@@ -0,0 +1,424 @@
+﻿/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#include "xToolsModbusTcpPipeline.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "xToolsProfiler.h"
+
+namespace {
+
+void appendUInt16(QByteArray &bytes, quint16 value)
+{
+    bytes.append(static_cast<char>(value >> 8));
+    bytes.append(static_cast<char>(value));
+}
+
+} // namespace
+
+xToolsModbusTcpPipeline::xToolsModbusTcpPipeline(QObject *parent)
+    : QObject{parent}
+    , m_timeoutTimer{new QTimer(this)}
+{
+    connect(m_timeoutTimer,
+            &QTimer::timeout,
+            this,
+            &xToolsModbusTcpPipeline::onTimeoutTimerTimeout);
+}
+
+xToolsModbusTcpPipeline::~xToolsModbusTcpPipeline()
+{
+    disconnectDevice();
+}
+
+void xToolsModbusTcpPipeline::setParameters(const Parameters &parameters)
+{
+    m_parameters = parameters;
+}
+
+xToolsModbusTcpPipeline::Parameters xToolsModbusTcpPipeline::parameters() const
+{
+    return m_parameters;
+}
+
+void xToolsModbusTcpPipeline::connectDevice()
+{
+    disconnectDevice();
+
+    // The deadlines are checked with a tenth of the timeout, so a request times out late by 10%.
+    m_timeoutTimer->setInterval(qBound(1, m_parameters.timeout / 10, 100));
+    const int count = qBound(1, m_parameters.connections, 64);
+    for (int i = 0; i < count; i++) {
+        auto *connection = new Connection{new QTcpSocket(this), 0, QByteArray(), {}, {}};
+        QTcpSocket *socket = connection->socket;
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::connected, this, [this]() {
+            if (!m_isConnected) {
+                m_isConnected = true;
+                emit connected();
+            }
+            dispatch();
+        });
+        connect(socket, &QTcpSocket::readyRead, this, [this, connection]() {
+            onReadyRead(connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, connection]() {
+            onDisconnected(connection);
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, connection]() {
+            emit errorOccurred(connection->socket->errorString());
+            onDisconnected(connection);
+        });
+
+        m_connections.append(connection);
+        socket->connectToHost(m_parameters.address, m_parameters.port);
+    }
+}
+
+void xToolsModbusTcpPipeline::disconnectDevice()
+{
+    m_timeoutTimer->stop();
+
+    QList<Connection *> connections = m_connections;
+    m_connections.clear();
+    m_nextConnection = 0;
+    for (Connection *connection : connections) {
+        connection->socket->disconnect(this);
+        connection->socket->abort();
+        connection->socket->deleteLater();
+        failOutstanding(connection, ConnectionError);
+        delete connection;
+    }
+
+    failQueue(ConnectionError);
+    if (m_isConnected) {
+        m_isConnected = false;
+        emit disconnected();
+    }
+}
+
+bool xToolsModbusTcpPipeline::isConnected() const
+{
+    for (const Connection *connection : m_connections) {
+        if (connection->socket->state() == QAbstractSocket::ConnectedState) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+quint64 xToolsModbusTcpPipeline::sendRequest(int serverAddress, const QModbusRequest &request)
+{
+    m_queue.push_back(Request{m_nextId++, serverAddress, request});
+    dispatch();
+    return m_nextId - 1;
+}
+
+quint64 xToolsModbusTcpPipeline::sendReadRequest(const QModbusDataUnit &unit, int serverAddress)
+{
+    QModbusPdu::FunctionCode functionCode;
+    int maxCount = 125;
+    if (unit.registerType() == QModbusDataUnit::Coils) {
+        functionCode = QModbusPdu::ReadCoils;
+        maxCount = 2000;
+    } else if (unit.registerType() == QModbusDataUnit::DiscreteInputs) {
+        functionCode = QModbusPdu::ReadDiscreteInputs;
+        maxCount = 2000;
+    } else if (unit.registerType() == QModbusDataUnit::InputRegisters) {
+        functionCode = QModbusPdu::ReadInputRegisters;
+    } else if (unit.registerType() == QModbusDataUnit::HoldingRegisters) {
+        functionCode = QModbusPdu::ReadHoldingRegisters;
+    } else {
+        return 0;
+    }
+
+    const int count = unit.valueCount();
+    if (count < 1 || count > maxCount) {
+        return 0;
+    }
+
+    return sendRequest(serverAddress,
+                       QModbusRequest(functionCode, quint16(unit.startAddress()), quint16(count)));
+}
+
+quint64 xToolsModbusTcpPipeline::sendWriteRequest(const QModbusDataUnit &unit, int serverAddress)
+{
+    const quint16 startAddress = unit.startAddress();
+    const int count = unit.valueCount();
+    if (unit.registerType() == QModbusDataUnit::HoldingRegisters) {
+        if (count == 1) {
+            QModbusRequest request(QModbusPdu::WriteSingleRegister, startAddress, unit.value(0));
+            return sendRequest(serverAddress, request);
+        } else if (count > 1 && count <= 123) {
+            QByteArray data;
+            appendUInt16(data, startAddress);
+            appendUInt16(data, count);
+            data.append(static_cast<char>(count * 2));
+            for (int i = 0; i < count; i++) {
+                appendUInt16(data, unit.value(i));
+            }
+            return sendRequest(serverAddress,
+                               QModbusRequest(QModbusPdu::WriteMultipleRegisters, data));
+        }
+    } else if (unit.registerType() == QModbusDataUnit::Coils) {
+        if (count == 1) {
+            const quint16 value = unit.value(0) ? 0xff00 : 0x0000;
+            QModbusRequest request(QModbusPdu::WriteSingleCoil, startAddress, value);
+            return sendRequest(serverAddress, request);
+        } else if (count > 1 && count <= 1968) {
+            QByteArray data;
+            appendUInt16(data, startAddress);
+            appendUInt16(data, count);
+            data.append(static_cast<char>((count + 7) / 8));
+            QByteArray bits((count + 7) / 8, '\0');
+            for (int i = 0; i < count; i++) {
+                if (unit.value(i)) {
+                    bits[i / 8] = static_cast<char>(bits.at(i / 8) | (1 << (i % 8)));
+                }
+            }
+            data.append(bits);
+            return sendRequest(serverAddress, QModbusRequest(QModbusPdu::WriteMultipleCoils, data));
+        }
+    }
+
+    return 0;
+}
+
+int xToolsModbusTcpPipeline::queuedRequests() const
+{
+    return static_cast<int>(m_queue.size());
+}
+
+int xToolsModbusTcpPipeline::outstandingRequests() const
+{
+    int count = 0;
+    for (const Connection *connection : m_connections) {
+        count += connection->outstanding.size();
+    }
+
+    return count;
+}
+
+xToolsModbusTcpPipeline::Statistics xToolsModbusTcpPipeline::statistics() const
+{
+    return m_statistics;
+}
+
+void xToolsModbusTcpPipeline::resetStatistics()
+{
+    m_statistics = Statistics();
+}
+
+void xToolsModbusTcpPipeline::dispatch()
+{
+    const int window = qMax(1, m_parameters.window);
+    int fullConnections = 0;
+    while (!m_queue.empty() && fullConnections < m_connections.size()) {
+        Connection *connection = m_connections.at(m_nextConnection);
+        m_nextConnection = (m_nextConnection + 1) % m_connections.size();
+        if (connection->socket->state() != QAbstractSocket::ConnectedState
+            || connection->outstanding.size() >= window) {
+            fullConnections++;
+            continue;
+        }
+
+        fullConnections = 0;
+        send(connection, m_queue.front());
+        m_queue.pop_front();
+    }
+}
+
+void xToolsModbusTcpPipeline::send(Connection *connection, const Request &request)
+{
+    quint16 transactionId = connection->transactionId++;
+    while (connection->outstanding.contains(transactionId)) {
+        transactionId = connection->transactionId++;
+    }
+
+    const QByteArray data = request.pdu.data();
+    QByteArray adu;
+    adu.reserve(8 + data.size());
+    appendUInt16(adu, transactionId);
+    appendUInt16(adu, 0);
+    appendUInt16(adu, data.size() + 2);
+    adu.append(static_cast<char>(request.serverAddress));
+    adu.append(static_cast<char>(request.pdu.functionCode()));
+    adu.append(data);
+    connection->socket->write(adu);
+
+    const qint64 deadline = xToolsProfiler::now() + m_parameters.timeout * qint64(1000000);
+    const auto serverAddress = static_cast<quint8>(request.serverAddress);
+    const auto functionCode = static_cast<quint8>(request.pdu.functionCode());
+    connection->outstanding.insert(transactionId,
+                                   Outstanding{request.id, deadline, serverAddress, functionCode});
+    connection->sendingOrder.push_back(qMakePair(transactionId, request.id));
+    m_statistics.requests++;
+    if (!m_timeoutTimer->isActive()) {
+        m_timeoutTimer->start();
+    }
+}
+
+void xToolsModbusTcpPipeline::onReadyRead(Connection *connection)
+{
+    connection->buffer.append(connection->socket->readAll());
+
+    // The signals are emitted after the buffer is consumed, the slots may disconnect the device.
+    struct Result
+    {
+        quint64 id;
+        int error;
+        QModbusResponse response;
+    };
+    QList<Result> results;
+    bool isInvalid = false;
+    const QByteArray &buffer = connection->buffer;
+    const uchar *data = reinterpret_cast<const uchar *>(buffer.constData());
+    int offset = 0;
+    while (buffer.size() - offset >= 8) {
+        const uchar *header = data + offset;
+        const quint16 transactionId = (header[0] << 8) | header[1];
+        const quint16 protocolId = (header[2] << 8) | header[3];
+        const quint16 length = (header[4] << 8) | header[5];
+        if (protocolId != 0 || length < 2 || length > 254) {
+            m_statistics.errors++;
+            isInvalid = true;
+            break;
+        }
+
+        if (buffer.size() - offset < 6 + length) {
+            break;
+        }
+
+        auto it = connection->outstanding.find(transactionId);
+        if (it == connection->outstanding.end()) {
+            m_statistics.lateResponses++;
+        } else if (header[6] != it->serverAddress || (header[7] & 0x7f) != it->functionCode) {
+            // The transaction id is answered by another request, the request is failed.
+            m_statistics.errors++;
+            results.append(Result{it->id, ProtocolError, QModbusResponse()});
+            connection->outstanding.erase(it);
+        } else {
+            auto functionCode = static_cast<QModbusPdu::FunctionCode>(header[7]);
+            QByteArray pdu(reinterpret_cast<const char *>(header + 8), length - 2);
+            QModbusResponse response(functionCode, pdu);
+            m_statistics.responses++;
+            if (response.isException()) {
+                m_statistics.exceptions++;
+                results.append(Result{it->id, ExceptionError, response});
+            } else {
+                results.append(Result{it->id, NoError, response});
+            }
+            connection->outstanding.erase(it);
+        }
+
+        offset += 6 + length;
+    }
+
+    if (isInvalid) {
+        // The outstanding requests are failed by the disconnected signal, the connection may be
+        // deleted by the slots of it.
+        connection->buffer.clear();
+        connection->socket->abort();
+        emit errorOccurred(tr("Invalid MBAP header, the connection is reset."));
+    } else {
+        connection->buffer.remove(0, offset);
+    }
+
+    // The responses parsed before an invalid header are completed too.
+    for (const Result &result : results) {
+        emit finished(result.id, result.error, result.response);
+    }
+
+    dispatch();
+}
+
+void xToolsModbusTcpPipeline::onDisconnected(Connection *connection)
+{
+    if (connection->socket->state() == QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    connection->buffer.clear();
+    failOutstanding(connection, ConnectionError);
+    for (const Connection *cooked : m_connections) {
+        QAbstractSocket::SocketState state = cooked->socket->state();
+        if (state != QAbstractSocket::UnconnectedState) {
+            // Other connections will send the queued requests.
+            dispatch();
+            return;
+        }
+    }
+
+    failQueue(ConnectionError);
+    if (m_isConnected) {
+        m_isConnected = false;
+        emit disconnected();
+    }
+}
+
+void xToolsModbusTcpPipeline::onTimeoutTimerTimeout()
+{
+    const qint64 now = xToolsProfiler::now();
+    QList<quint64> expiredRequests;
+    for (Connection *connection : m_connections) {
+        std::deque<QPair<quint16, quint64>> &order = connection->sendingOrder;
+        while (!order.empty()) {
+            auto it = connection->outstanding.find(order.front().first);
+            // The transaction id may be answered already, or reused by a later request.
+            if (it != connection->outstanding.end() && it->id == order.front().second) {
+                if (it->deadline > now) {
+                    break;
+                }
+
+                expiredRequests.append(it->id);
+                connection->outstanding.erase(it);
+            }
+
+            order.pop_front();
+        }
+    }
+
+    if (outstandingRequests() == 0) {
+        m_timeoutTimer->stop();
+    }
+
+    m_statistics.timeouts += expiredRequests.size();
+    for (quint64 id : expiredRequests) {
+        emit finished(id, TimeoutError, QModbusResponse());
+    }
+
+    dispatch();
+}
+
+void xToolsModbusTcpPipeline::failOutstanding(Connection *connection, int error)
+{
+    QList<quint64> ids;
+    for (const Outstanding &outstanding : connection->outstanding) {
+        ids.append(outstanding.id);
+    }
+
+    connection->outstanding.clear();
+    connection->sendingOrder.clear();
+    m_statistics.errors += ids.size();
+    for (quint64 id : ids) {
+        emit finished(id, error, QModbusResponse());
+    }
+}
+
+void xToolsModbusTcpPipeline::failQueue(int error)
+{
+    std::deque<Request> queue;
+    queue.swap(m_queue);
+    m_statistics.errors += queue.size();
+    for (const Request &request : queue) {
+        emit finished(request.id, error, QModbusResponse());
+    }
+}
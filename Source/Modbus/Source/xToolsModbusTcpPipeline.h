@@ -0,0 +1,130 @@
+/***************************************************************************************************
+ * Copyright 2024 x-tools-author(x-tools@outlook.com). All rights reserved.
+ *
+ * The file is encoded using "utf8 with bom", it is a part of xTools project.
+ *
+ * xTools is licensed according to the terms in the file LICENCE(GPL V3) in the root of the source
+ * code directory.
+ **************************************************************************************************/
+#pragma once
+
+#include <deque>
+#include <QHash>
+#include <QList>
+#include <QModbusDataUnit>
+#include <QModbusPdu>
+#include <QObject>
+#include <QPair>
+
+class QTcpSocket;
+class QTimer;
+
+/// A modbus tcp client that keeps a window of outstanding requests on every connection, instead
+/// of waiting for the response of a request before sending the next one like QModbusTcpClient.
+/// The responses are matched by the transaction id of the MBAP header, so the server may answer
+/// out of order. The requests are queued and sent round robin over parallel connections to the
+/// same server(or gateway) as soon as a window has room, every request times out on its own.
+///
+/// The pipeline must be used in the thread it lives in.
+class xToolsModbusTcpPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    enum Error { NoError, TimeoutError, ConnectionError, ProtocolError, ExceptionError };
+    Q_ENUM(Error)
+
+    struct Parameters
+    {
+        QString address{"127.0.0.1"};
+        quint16 port{502};
+        int connections{1};
+        int window{16};    // Outstanding requests per connection.
+        int timeout{1000}; // ms
+    };
+
+    struct Statistics
+    {
+        qint64 requests{0};  // Sent requests.
+        qint64 responses{0}; // Including the exception responses.
+        qint64 exceptions{0};
+        qint64 timeouts{0};
+        qint64 errors{0};        // Connection and protocol errors.
+        qint64 lateResponses{0}; // Responses that arrived after the timeout.
+    };
+
+public:
+    explicit xToolsModbusTcpPipeline(QObject *parent = nullptr);
+    ~xToolsModbusTcpPipeline() override;
+
+    /// The parameters are applied when the device is connected.
+    void setParameters(const Parameters &parameters);
+    Parameters parameters() const;
+
+    void connectDevice();
+    /// The queued and outstanding requests are finished with ConnectionError.
+    void disconnectDevice();
+    /// Returns true if at least one connection is connected.
+    bool isConnected() const;
+
+    /// Queue a request, the returned id is passed to finished(). The requests wait in the queue
+    /// until a connection is connected. The helpers return 0 if the data unit can not be sent.
+    quint64 sendRequest(int serverAddress, const QModbusRequest &request);
+    quint64 sendReadRequest(const QModbusDataUnit &unit, int serverAddress);
+    /// One register or coil is written with FC06/FC05, more with FC16/FC15.
+    quint64 sendWriteRequest(const QModbusDataUnit &unit, int serverAddress);
+
+    int queuedRequests() const;
+    int outstandingRequests() const;
+    Statistics statistics() const;
+    void resetStatistics();
+
+signals:
+    void connected();
+    void disconnected();
+    void finished(quint64 id, int error, const QModbusResponse &response);
+    void errorOccurred(const QString &errorString);
+
+private:
+    struct Request
+    {
+        quint64 id;
+        int serverAddress;
+        QModbusRequest pdu;
+    };
+
+    struct Outstanding
+    {
+        quint64 id;
+        qint64 deadline;
+        quint8 serverAddress; // The unit id and the function code the response must have.
+        quint8 functionCode;
+    };
+
+    struct Connection
+    {
+        QTcpSocket *socket;
+        quint16 transactionId;
+        QByteArray buffer;
+        QHash<quint16, Outstanding> outstanding;
+        // The transaction ids in the order of sending, the deadlines of them are ascending.
+        std::deque<QPair<quint16, quint64>> sendingOrder;
+    };
+
+    Parameters m_parameters;
+    QList<Connection *> m_connections;
+    std::deque<Request> m_queue;
+    int m_nextConnection{0};
+    quint64 m_nextId{1};
+    bool m_isConnected{false};
+    Statistics m_statistics;
+    QTimer *m_timeoutTimer;
+
+private:
+    void dispatch();
+    void send(Connection *connection, const Request &request);
+    void onReadyRead(Connection *connection);
+    void onDisconnected(Connection *connection);
+    void onTimeoutTimerTimeout();
+    void failOutstanding(Connection *connection, int error);
+    void failQueue(int error);
+};
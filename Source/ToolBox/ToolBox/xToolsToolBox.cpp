@@ -8,7 +8,12 @@
  **************************************************************************************************/
 #include "xToolsToolBox.h"
 
+#include <QAbstractItemModel>
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaProperty>
 
 #include "xToolsToolFactory.h"
 
@@ -87,6 +92,7 @@ void xToolsToolBox::setupCommunicationTool(int type)
         qWarning() << "mComunicationTool is nullptr, type:" << type;
         return;
     }
+    m_communicationType = type;
 
     // clang-format off
     connect(m_comunicator, &xToolsCommunicationTool::bytesRead, m_rxCounter, &xToolsStatisticianTool::inputBytes);
@@ -162,6 +168,87 @@ bool xToolsToolBox::isWorking()
     return m_isWorking;
 }
 
+QVariantMap xToolsToolBox::save()
+{
+    QVariantMap data;
+    if (m_comunicator) {
+        // The parameters of the communication tools are the writable properties of the classes
+        // derived from xToolsBaseTool.
+        QVariantMap communicator;
+        const QMetaObject* metaObject = m_comunicator->metaObject();
+        int offset = xToolsBaseTool::staticMetaObject.propertyCount();
+        for (int i = offset; i < metaObject->propertyCount(); i++) {
+            QMetaProperty property = metaObject->property(i);
+            if (property.isWritable()) {
+                communicator.insert(property.name(), property.read(m_comunicator));
+            }
+        }
+        communicator.insert(m_keys.isEnable, m_comunicator->isEnable());
+
+        data.insert(m_keys.communicationType, m_communicationType);
+        data.insert(m_keys.communicator, communicator);
+    }
+
+    data.insert(m_keys.emitter, saveTableTool(m_emitter));
+    data.insert(m_keys.responser, saveTableTool(m_responser));
+    data.insert(m_keys.prestorer, saveTableTool(m_prestorer));
+    data.insert(m_keys.udpTransmitter, saveTableTool(m_udpTransmitter));
+    data.insert(m_keys.tcpTransmitter, saveTableTool(m_tcpTransmitter));
+    data.insert(m_keys.webSocketTransmitter, saveTableTool(m_webSocketTransmitter));
+#ifdef X_TOOLS_ENABLE_MODULE_SERIALPORT
+    data.insert(m_keys.serialPortTransmitter, saveTableTool(m_serialPortTransmitter));
+#endif
+
+    QVariantMap storer;
+    storer.insert(m_keys.isEnable, m_storer->isEnable());
+    storer.insert(m_keys.saveRx, m_storer->saveRx());
+    storer.insert(m_keys.saveTx, m_storer->saveTx());
+    storer.insert(m_keys.fileName, m_storer->fileName());
+    data.insert(m_keys.storer, storer);
+
+    return data;
+}
+
+void xToolsToolBox::load(const QVariantMap& data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    if (data.contains(m_keys.communicationType)) {
+        setupCommunicationTool(data.value(m_keys.communicationType).toInt());
+    }
+
+    if (m_comunicator) {
+        QVariantMap communicator = data.value(m_keys.communicator).toMap();
+        for (auto it = communicator.constBegin(); it != communicator.constEnd(); ++it) {
+            if (it.key() == m_keys.isEnable) {
+                m_comunicator->setIsEnable(it.value().toBool());
+            } else if (!m_comunicator->setProperty(it.key().toLatin1().constData(), it.value())) {
+                qWarning() << "Unknown parameter of the communication tool:" << it.key();
+            }
+        }
+    }
+
+    loadTableTool(m_emitter, data.value(m_keys.emitter).toMap());
+    loadTableTool(m_responser, data.value(m_keys.responser).toMap());
+    loadTableTool(m_prestorer, data.value(m_keys.prestorer).toMap());
+    loadTableTool(m_udpTransmitter, data.value(m_keys.udpTransmitter).toMap());
+    loadTableTool(m_tcpTransmitter, data.value(m_keys.tcpTransmitter).toMap());
+    loadTableTool(m_webSocketTransmitter, data.value(m_keys.webSocketTransmitter).toMap());
+#ifdef X_TOOLS_ENABLE_MODULE_SERIALPORT
+    loadTableTool(m_serialPortTransmitter, data.value(m_keys.serialPortTransmitter).toMap());
+#endif
+
+    QVariantMap storer = data.value(m_keys.storer).toMap();
+    if (!storer.isEmpty()) {
+        m_storer->setIsEnable(storer.value(m_keys.isEnable).toBool());
+        m_storer->setSaveRx(storer.value(m_keys.saveRx).toBool());
+        m_storer->setSaveTx(storer.value(m_keys.saveTx).toBool());
+        m_storer->setFileName(storer.value(m_keys.fileName).toString());
+    }
+}
+
 xToolsCommunicationTool* xToolsToolBox::getCommunicationTool()
 {
     return m_comunicator;
@@ -305,6 +392,34 @@ QVariant xToolsToolBox::serialPortTransmitter()
 }
 #endif
 
+QVariantMap xToolsToolBox::saveTableTool(xToolsTableModelTool* tool)
+{
+    QVariantMap data;
+    data.insert(m_keys.isEnable, tool->isEnable());
+    data.insert(m_keys.items, tool->itemsContext().toJsonArray().toVariantList());
+    return data;
+}
+
+void xToolsToolBox::loadTableTool(xToolsTableModelTool* tool, const QVariantMap& data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    tool->setIsEnable(data.value(m_keys.isEnable, true).toBool());
+
+    auto model = qobject_cast<QAbstractItemModel*>(tool->tableModel().value<QObject*>());
+    if (model) {
+        model->removeRows(0, model->rowCount());
+    }
+
+    const QVariantList items = data.value(m_keys.items).toList();
+    for (const QVariant& item : items) {
+        QJsonObject obj = QJsonObject::fromVariantMap(item.toMap());
+        tool->addItem(QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact)));
+    }
+}
+
 void xToolsToolBox::onCommunicatorBytesWritten(const QByteArray& bytes, const QString& to)
 {
     Q_UNUSED(bytes)
@@ -60,6 +60,12 @@ public:
     Q_INVOKABLE void send(const QByteArray& bytes);
     bool isWorking();
 
+    /// The configuration of the tool box: the communication type, the writable properties of the
+    /// communication tool, the items of the table tools and the parameters of the storer.
+    QVariantMap save();
+    /// The communication tool is set up with the saved type if the type is in the data.
+    void load(const QVariantMap& data);
+
     xToolsCommunicationTool* getCommunicationTool();
     xToolsEmitterTool* getEmitterTool();
     xToolsResponserTool* getResponserTool();
@@ -104,6 +110,27 @@ private:
     xToolsSerialPortTransmitterTool* m_serialPortTransmitter{nullptr};
 #endif
     bool m_isWorking{false};
+    int m_communicationType{-1};
+
+    struct
+    {
+        const QString communicationType{"communicationType"};
+        const QString communicator{"communicator"};
+        const QString emitter{"emitter"};
+        const QString responser{"responser"};
+        const QString prestorer{"prestorer"};
+        const QString udpTransmitter{"udpTransmitter"};
+        const QString tcpTransmitter{"tcpTransmitter"};
+        const QString webSocketTransmitter{"webSocketTransmitter"};
+        const QString serialPortTransmitter{"serialPortTransmitter"};
+        const QString storer{"storer"};
+
+        const QString isEnable{"isEnable"};
+        const QString items{"items"};
+        const QString saveRx{"saveRx"};
+        const QString saveTx{"saveTx"};
+        const QString fileName{"fileName"};
+    } m_keys;
 
 private:
     QVariant communicator();
@@ -122,6 +149,9 @@ private:
     QVariant serialPortTransmitter();
 #endif
 
+    QVariantMap saveTableTool(xToolsTableModelTool* tool);
+    void loadTableTool(xToolsTableModelTool* tool, const QVariantMap& data);
+
     void onCommunicatorBytesWritten(const QByteArray& bytes, const QString& to);
     void onCommunicatorBytesRead(const QByteArray& bytes, const QString& from);
 };
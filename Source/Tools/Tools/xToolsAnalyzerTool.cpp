@@ -11,11 +11,32 @@
 #include <QDebug>
 
 #include "xToolsCompatibility.h"
+#include "xToolsMetricsServer.h"
 
 xToolsAnalyzerTool::xToolsAnalyzerTool(QObject *parent)
     : xToolsBaseTool{parent}
 {
     m_enable = false;
+
+    m_metricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            xToolsMetricsServer::Labels labels{qMakePair(QString("tool"), profilerStage()->name())};
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_analyzer_frames",
+                                            "Frames matched by the analyzer.",
+                                            labels,
+                                            m_frames);
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_analyzer_overflow_bytes",
+                                            "Bytes flushed because the buffer is full.",
+                                            labels,
+                                            m_overflowBytes);
+        });
+}
+
+xToolsAnalyzerTool::~xToolsAnalyzerTool()
+{
+    xToolsMetricsServer::instance()->removeCollector(m_metricsCollector);
 }
 
 void xToolsAnalyzerTool::setFixed(bool fixed)
@@ -56,6 +77,7 @@ void xToolsAnalyzerTool::inputBytes(const QByteArray &bytes)
     if (isEnable()) {
         m_inputtedBytesMutex.lock();
         m_inputtedBytes.append(bytes);
+        profilerStage()->setQueueDepth(m_inputtedBytes.size());
         m_inputtedBytesMutex.unlock();
     } else {
         emit outputBytes(bytes);
@@ -68,9 +90,15 @@ void xToolsAnalyzerTool::run()
     handleTimer->setInterval(5);
     handleTimer->setSingleShot(true);
     connect(handleTimer, &QTimer::timeout, handleTimer, [=]() {
+        xToolsProfiler::Stage *stage = profilerStage();
+        stage->addWakeup();
         if (m_enable) {
             m_inputtedBytesMutex.lock();
-            analyze();
+            if (!m_inputtedBytes.isEmpty()) {
+                xToolsProfilerScope scope(stage);
+                analyze();
+                stage->setQueueDepth(m_inputtedBytes.size());
+            }
             m_inputtedBytesMutex.unlock();
         }
         handleTimer->start();
@@ -104,6 +132,7 @@ void xToolsAnalyzerTool::analyze()
     if (m_inputtedBytes.length() > ctx.maxTempBytes) {
         QByteArray ba = xToolsByteArrayToHex(m_inputtedBytes, ' ');
         qInfo() << "clear bytes: " + QString::fromLatin1(ba);
+        m_overflowBytes += m_inputtedBytes.length();
         emit outputBytes(m_inputtedBytes);
         m_inputtedBytes.clear();
     }
@@ -122,6 +151,7 @@ void xToolsAnalyzerTool::analyzeFixed()
         QByteArray ba = xToolsByteArrayToHex(frame, ' ');
         QString hex = QString::fromLatin1(ba);
         qInfo() << QString("Analyzer->%1").arg(hex);
+        m_frames++;
         emit outputBytes(frame);
     }
 }
@@ -140,6 +170,7 @@ void xToolsAnalyzerTool::analyzeSeparationMark()
         QString hex = QString::fromLatin1(ba);
         QString msg = QString("Analyzer->%1").arg(hex);
         qInfo() << msg;
+        m_frames++;
         emit outputBytes(m_inputtedBytes);
         m_inputtedBytes.clear();
         return;
@@ -158,5 +189,6 @@ void xToolsAnalyzerTool::analyzeSeparationMark()
     QString hex = QString::fromLatin1(ba);
     QString msg = QString("Analyzer->%1").arg(hex);
     qInfo() << msg;
+    m_frames++;
     emit outputBytes(frame);
 }
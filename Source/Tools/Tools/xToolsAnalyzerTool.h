@@ -8,6 +8,7 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QMutex>
 #include <QTimer>
 #include <QVariant>
@@ -19,6 +20,7 @@ class xToolsAnalyzerTool : public xToolsBaseTool
     Q_OBJECT
 public:
     explicit xToolsAnalyzerTool(QObject *parent = Q_NULLPTR);
+    ~xToolsAnalyzerTool() override;
 
     Q_INVOKABLE void setFixed(bool fixed);
     Q_INVOKABLE void setFrameBytes(int bytes);
@@ -42,6 +44,9 @@ private:
     QByteArray m_inputtedBytes;
     QMutex m_inputtedBytesMutex;
     QVariant m_context;
+    std::atomic<qint64> m_frames{0};
+    std::atomic<qint64> m_overflowBytes{0};
+    int m_metricsCollector;
 
 private:
     void analyze();
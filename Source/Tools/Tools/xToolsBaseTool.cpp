@@ -71,3 +71,8 @@ void xToolsBaseTool::setIsEnable(bool enable)
     m_enable = enable;
     emit isEnableChanged();
 }
+
+xToolsProfiler::Stage *xToolsBaseTool::profilerStage()
+{
+    return xToolsProfiler::instance()->objectStage(this, m_profilerStage);
+}
@@ -13,6 +13,8 @@
 #include <QThread>
 #include <QVariantMap>
 
+#include "xToolsProfiler.h"
+
 class xToolsBaseTool : public QThread
 {
     Q_OBJECT
@@ -34,11 +36,16 @@ public:
     bool isWorking();
     bool isEnable();
     void setIsEnable(bool enable);
+    /// The stage of the pipeline profiler, every instance has its own stage.
+    xToolsProfiler::Stage *profilerStage();
 
 protected:
     std::atomic_bool m_isWorking{false};
     std::atomic_bool m_enable{true};
 
+private:
+    std::atomic<xToolsProfiler::Stage *> m_profilerStage{nullptr};
+
 signals:
     void isWorkingChanged();
     void isEnableChanged();
@@ -14,10 +14,39 @@
 
 #include "xToolsCrcInterface.h"
 #include "xToolsDataStructure.h"
+#include "xToolsMetricsServer.h"
 
 xToolsEmitterTool::xToolsEmitterTool(QObject *parent)
     : xToolsTableModelTool{parent}
-{}
+{
+    mMetricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            xToolsDeadlineScheduler::Jitter jitter = this->jitter();
+            xToolsMetricsServer::Labels labels{qMakePair(QString("tool"), profilerStage()->name())};
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_emitter_missed_deadlines",
+                                            "Deadlines skipped because the emitter was too late.",
+                                            labels,
+                                            jitter.missed);
+
+            const QString quantiles[] = {QString("0.5"), QString("0.99"), QString("0.999")};
+            const qint64 values[] = {jitter.p50, jitter.p99, jitter.p999};
+            for (int i = 0; i < 3; i++) {
+                xToolsMetricsServer::Labels quantileLabels = labels;
+                quantileLabels.append(qMakePair(QString("quantile"), quantiles[i]));
+                xToolsMetricsServer::addGauge(samples,
+                                              "xtools_emitter_jitter_seconds",
+                                              "The lateness of the emitting against the deadlines.",
+                                              quantileLabels,
+                                              values[i] / 1e9);
+            }
+        });
+}
+
+xToolsEmitterTool::~xToolsEmitterTool()
+{
+    xToolsMetricsServer::instance()->removeCollector(mMetricsCollector);
+}
 
 void xToolsEmitterTool::inputBytes(const QByteArray &bytes)
 {
@@ -127,6 +156,7 @@ bool xToolsEmitterTool::setData(const QModelIndex &index, const QVariant &value,
 {
     Q_UNUSED(role);
     int row = index.row();
+    mItemsMutex.lock();
     if (row >= 0 && row < mItems.count()) {
         auto item = mItems.at(row);
         int column = index.column();
@@ -141,7 +171,7 @@ bool xToolsEmitterTool::setData(const QModelIndex &index, const QVariant &value,
             } else if (dataKey == mDataKeys.itemEscapeCharacter) {
                 item.data.itemEscapeCharacter = value.toInt();
             } else if (dataKey == mDataKeys.itemInterval) {
-                item.data.itemInterval = value.toInt();
+                item.data.itemInterval = value.toDouble();
             } else if (dataKey == mDataKeys.itemPrefix) {
                 item.data.itemPrefix = value.toInt();
             } else if (dataKey == mDataKeys.itemSuffix) {
@@ -165,7 +195,9 @@ bool xToolsEmitterTool::setData(const QModelIndex &index, const QVariant &value,
             mItems.replace(row, item);
         }
     }
+    mItemsMutex.unlock();
 
+    emit itemsChanged();
     return true;
 }
 
@@ -175,18 +207,25 @@ bool xToolsEmitterTool::insertRows(int row, int count, const QModelIndex &parent
     Data ctx;
     EmitterItem item;
     item.data = ctx;
-    item.elapsedTime = 0;
+    mItemsMutex.lock();
     for (int i = 0; i < count; i++) {
+        item.id = mNextItemId++;
         mItems.insert(row, item);
     }
+    mItemsMutex.unlock();
 
+    emit itemsChanged();
     return true;
 }
 
 bool xToolsEmitterTool::removeRows(int row, int count, const QModelIndex &parent)
 {
     Q_UNUSED(parent)
+    mItemsMutex.lock();
     mItems.remove(row, count);
+    mItemsMutex.unlock();
+
+    emit itemsChanged();
     return true;
 }
 
@@ -229,36 +268,85 @@ QVariant xToolsEmitterTool::headerData(int section, Qt::Orientation orientation,
     return QVariant("");
 }
 
-void xToolsEmitterTool::run()
+xToolsDeadlineScheduler::Jitter xToolsEmitterTool::jitter()
 {
-    mEmittingTimer = new QTimer();
-    mEmittingTimer->setInterval(mScanInterval);
-    mEmittingTimer->setSingleShot(true);
-    connect(mEmittingTimer, &QTimer::timeout, mEmittingTimer, [=]() { try2emit(); });
-    mEmittingTimer->start();
+    xToolsDeadlineScheduler::Jitter jitter;
+    mSchedulerMutex.lock();
+    if (mScheduler) {
+        jitter = mScheduler->jitter();
+    }
+    mSchedulerMutex.unlock();
+    return jitter;
+}
 
+void xToolsEmitterTool::run()
+{
+    auto *scheduler = new xToolsDeadlineScheduler();
+    connect(scheduler, &xToolsDeadlineScheduler::timeout, scheduler, [this](int id) {
+        try2emit(id);
+    });
+    // The items are changed in the ui thread, the schedule is updated in the thread of the tool.
+    connect(this, &xToolsEmitterTool::itemsChanged, scheduler, [this]() { updateSchedule(); });
+
+    mSchedulerMutex.lock();
+    mScheduler = scheduler;
+    mSchedulerMutex.unlock();
+
+    updateSchedule();
     exec();
 
-    if (mEmittingTimer) {
-        mEmittingTimer->stop();
-        mEmittingTimer->deleteLater();
-        mEmittingTimer = nullptr;
+    mSchedulerMutex.lock();
+    mScheduler = nullptr;
+    mSchedulerMutex.unlock();
+    delete scheduler;
+}
+
+void xToolsEmitterTool::updateSchedule()
+{
+    QHash<int, qint64> intervals;
+    double minInterval = mSpinInterval;
+    mItemsMutex.lock();
+    for (const auto &item : mItems) {
+        if (item.data.itemEnable && item.data.itemInterval > 0) {
+            intervals.insert(item.id, qRound64(item.data.itemInterval * 1000000));
+            minInterval = qMin(minInterval, item.data.itemInterval);
+        }
     }
+    mItemsMutex.unlock();
+
+    const QList<int> ids = mScheduler->ids();
+    for (int id : ids) {
+        if (!intervals.contains(id)) {
+            mScheduler->cancel(id);
+        }
+    }
+
+    for (auto it = intervals.constBegin(); it != intervals.constEnd(); ++it) {
+        mScheduler->schedule(it.key(), it.value());
+    }
+
+    mScheduler->setSpinThreshold(minInterval < mSpinInterval ? mSpinThreshold : 0);
 }
 
-void xToolsEmitterTool::try2emit()
+void xToolsEmitterTool::try2emit(int id)
 {
+    QByteArray bytes;
+    bool emitting = false;
     mItemsMutex.lock();
-    for (auto &item : mItems) {
-        int elapsedTime = item.elapsedTime += mScanInterval;
-        if (elapsedTime > item.data.itemInterval && item.data.itemEnable) {
-            item.elapsedTime = 0;
-            const auto bytes = itemBytes(item.data);
-            emit outputBytes(bytes);
+    for (const auto &item : mItems) {
+        if (item.id == id) {
+            emitting = item.data.itemEnable;
+            if (emitting) {
+                bytes = itemBytes(item.data);
+            }
+            break;
         }
     }
     mItemsMutex.unlock();
-    mEmittingTimer->start();
+
+    if (emitting) {
+        emit outputBytes(bytes);
+    }
 }
 
 QByteArray xToolsEmitterTool::itemBytes(const xToolsEmitterTool::Data &item)
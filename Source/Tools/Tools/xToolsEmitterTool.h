@@ -10,9 +10,9 @@
 
 #include <QAbstractTableModel>
 #include <QMutex>
-#include <QTimer>
 #include <QVariant>
 
+#include "xToolsDeadlineScheduler.h"
 #include "xToolsTableModelTool.h"
 
 class xToolsEmitterTool : public xToolsTableModelTool
@@ -59,7 +59,7 @@ public:
         int itemPrefix;
         QString itemText;
         int itemSuffix;
-        int itemInterval;
+        double itemInterval{1000}; // ms, fractions of a millisecond are allowed.
 
         bool itemCrcEnable;
         bool itemCrcBigEndian;
@@ -71,13 +71,18 @@ public:
     struct EmitterItem
     {
         Data data;
-        int elapsedTime{0};
+        int id{0}; // The id of the item in the scheduler.
     };
 
 public:
     explicit xToolsEmitterTool(QObject *parent = Q_NULLPTR);
+    ~xToolsEmitterTool() override;
     virtual void inputBytes(const QByteArray &bytes) override;
 
+    /// The lateness of the emitting against the deadlines of the items, it is empty if the tool
+    /// is not working.
+    xToolsDeadlineScheduler::Jitter jitter();
+
 public:
     virtual QString cookHeaderString(const QString &str) override;
     virtual QVariant itemContext(int index) final;
@@ -97,6 +102,9 @@ protected:
 
     virtual void run() final;
 
+signals:
+    void itemsChanged();
+
 private:
     QVector<EmitterItem> mItems;
     QMutex mItemsMutex;
@@ -105,11 +113,17 @@ private:
     const int mItemTextColumnIndex{2};
     DataKeys mDataKeys;
     const int mTableColumnCount{13};
-    QTimer *mEmittingTimer;
-    const int mScanInterval{5};
+    int mNextItemId{0};
+    xToolsDeadlineScheduler *mScheduler{nullptr};
+    QMutex mSchedulerMutex;
+    int mMetricsCollector;
+    // Items faster than the interval(ms) are emitted with spinning for sub-millisecond precision.
+    const double mSpinInterval{10};
+    const qint64 mSpinThreshold{1000000};
 
 private:
-    void try2emit();
+    void updateSchedule();
+    void try2emit(int id);
     QByteArray itemBytes(const xToolsEmitterTool::Data &item);
     QVariant columnDisplayRoleData(const EmitterItem &item, int column) const;
 
@@ -8,6 +8,8 @@
  **************************************************************************************************/
 #include "xToolsResponserTool.h"
 
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHeaderView>
 #include <QJsonArray>
@@ -18,10 +20,41 @@
 
 #include "xToolsCrcInterface.h"
 #include "xToolsDataStructure.h"
+#include "xToolsMetricsServer.h"
 
 xToolsResponserTool::xToolsResponserTool(QObject *parent)
     : xToolsTableModelTool{parent}
-{}
+{
+    m_metricsCollector = xToolsMetricsServer::instance()->addCollector(
+        [this](QList<xToolsMetricsServer::Sample> &samples) {
+            xToolsMetricsServer::Labels labels{qMakePair(QString("tool"), profilerStage()->name())};
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_responser_input_frames",
+                                            "Frames checked by the responser.",
+                                            labels,
+                                            m_inputFrames);
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_responser_matched_frames",
+                                            "Frames that matched at least one item.",
+                                            labels,
+                                            m_matchedFrames);
+            xToolsMetricsServer::addCounter(samples,
+                                            "xtools_responser_responses",
+                                            "Responses scheduled by the responser.",
+                                            labels,
+                                            m_responses);
+            xToolsMetricsServer::addGauge(samples,
+                                          "xtools_responser_pending_responses",
+                                          "Delayed responses that have not been output yet.",
+                                          labels,
+                                          m_pendingResponses);
+        });
+}
+
+xToolsResponserTool::~xToolsResponserTool()
+{
+    xToolsMetricsServer::instance()->removeCollector(m_metricsCollector);
+}
 
 int xToolsResponserTool::rowCount(const QModelIndex &parent) const
 {
@@ -58,65 +91,132 @@ bool xToolsResponserTool::setData(const QModelIndex &index, const QVariant &valu
         int column = index.column();
         if (column >= 0 && column < headers().count()) {
             auto dataKey = headers().at(column);
+            bool referenceChanged = false;
+            bool responseChanged = false;
+            bool programChanged = false;
             if (dataKey == m_dataKeys.itemEnable) {
                 item.data.itemEnable = value.toBool();
             } else if (dataKey == m_dataKeys.itemDescription) {
                 item.data.itemDescription = value.toString();
             } else if (dataKey == m_dataKeys.itemOption) {
                 item.data.itemOption = value.toInt();
+                programChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceTextFormat) {
                 item.data.itemReferenceTextFormat = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceEscapeCharacter) {
                 item.data.itemReferenceEscapeCharacter = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferencePrefix) {
                 item.data.itemReferencePrefix = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceSuffix) {
                 item.data.itemReferenceSuffix = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceCrcEnable) {
                 item.data.itemReferenceCrcEnable = value.toBool();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceCrcBigEndian) {
                 item.data.itemReferenceCrcBigEndian = value.toBool();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceCrcAlgorithm) {
                 item.data.itemReferenceCrcAlgorithm = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceCrcStartIndex) {
                 item.data.itemReferenceCrcStartIndex = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceCrcEndIndex) {
                 item.data.itemReferenceCrcEndIndex = value.toInt();
+                referenceChanged = true;
             } else if (dataKey == m_dataKeys.itemReferenceText) {
                 item.data.itemReferenceText = value.toString();
+                referenceChanged = true;
+                programChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseTextFormat) {
                 item.data.itemResponseTextFormat = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseEscapeCharacter) {
                 item.data.itemResponseEscapeCharacter = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponsePrefix) {
                 item.data.itemResponsePrefix = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseSuffix) {
                 item.data.itemResponseSuffix = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseCrcEnable) {
                 item.data.itemResponseCrcEnable = value.toBool();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseCrcBigEndian) {
                 item.data.itemResponseCrcBigEndian = value.toBool();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseCrcAlgorithm) {
                 item.data.itemResponseCrcAlgorithm = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseCrcStartIndex) {
                 item.data.itemResponseCrcStartIndex = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseCrcEndIndex) {
                 item.data.itemResponseCrcEndIndex = value.toInt();
+                responseChanged = true;
             } else if (dataKey == m_dataKeys.itemResponseDelay) {
                 item.data.itemResponseDelay = value.toInt();
             } else if (dataKey == m_dataKeys.itemResponseText) {
                 item.data.itemResponseText = value.toString();
+                responseChanged = true;
+                programChanged = true;
             } else {
                 // Nothing to do yet.
             }
 
+            // The item is cooked and compiled at once by afterItemChanged() when it is added.
+            if (!m_isAddingItem) {
+                if (referenceChanged) {
+                    item.referenceBytes = referenceBytes(item.data);
+                }
+                if (responseChanged) {
+                    item.responseBytes = responseBytes(item.data);
+                }
+                if (programChanged) {
+                    compileProgram(item);
+                }
+            }
+
+            m_itemsMutex.lock();
             m_iItems.replace(row, item);
+            m_itemsMutex.unlock();
         }
     }
 
     return true;
 }
 
+void xToolsResponserTool::afterItemChanged(int index)
+{
+    if (index < 0 || index >= m_iItems.count()) {
+        return;
+    }
+
+    ResponserData item = m_iItems.at(index);
+    item.referenceBytes = referenceBytes(item.data);
+    item.responseBytes = responseBytes(item.data);
+    compileProgram(item);
+
+    m_itemsMutex.lock();
+    m_iItems.replace(index, item);
+    m_itemsMutex.unlock();
+}
+
+void xToolsResponserTool::compileProgram(ResponserData &item)
+{
+    // The errors of the rule are reported by the editor.
+    if (item.data.itemOption == xToolsDataStructure::ResponseOptionInputMatchRule) {
+        item.program.compile(item.data.itemReferenceText, item.data.itemResponseText);
+    } else {
+        item.program = xToolsRuleProgram();
+    }
+}
+
 bool xToolsResponserTool::insertRows(int row, int count, const QModelIndex &parent)
 {
     Q_UNUSED(parent);
@@ -439,23 +539,48 @@ void xToolsResponserTool::inputBytes(const QByteArray &bytes)
 {
     m_inputBytesListMutex.lock();
     m_inputBytesList.append(bytes);
+    profilerStage()->setQueueDepth(m_inputBytesList.size());
     m_inputBytesListMutex.unlock();
 }
 
+qint64 xToolsResponserTool::pendingResponses() const
+{
+    return m_pendingResponses;
+}
+
 void xToolsResponserTool::run()
 {
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    m_delayedResponses.reset(0);
+
     QTimer *outputTimer = new QTimer();
+    outputTimer->setTimerType(Qt::PreciseTimer);
     outputTimer->setInterval(5);
     outputTimer->setSingleShot(true);
 
-    connect(outputTimer, &QTimer::timeout, outputTimer, [=]() {
+    connect(outputTimer, &QTimer::timeout, outputTimer, [=, &elapsedTimer]() {
+        xToolsProfiler::Stage *stage = profilerStage();
+        stage->addWakeup();
+        QList<QByteArray> responses;
+        m_delayedResponses.advance(elapsedTimer.elapsed(), responses);
+
         m_inputBytesListMutex.lock();
         while (!m_inputBytesList.isEmpty()) {
+            xToolsProfilerScope scope(stage);
             auto bytes = m_inputBytesList.takeFirst();
-            try2output(bytes, outputTimer);
+            try2output(bytes, responses);
         }
+        stage->setQueueDepth(0);
         m_inputBytesListMutex.unlock();
-        outputTimer->start();
+
+        m_pendingResponses = m_delayedResponses.size();
+        for (const auto &response : responses) {
+            emit outputBytes(response);
+        }
+
+        // The wheel is advanced every tick while there are delayed responses.
+        outputTimer->start(m_delayedResponses.isEmpty() ? 5 : 1);
     });
 
     outputTimer->start();
@@ -465,11 +590,14 @@ void xToolsResponserTool::run()
     m_inputBytesList.clear();
     m_inputBytesListMutex.unlock();
 
+    m_delayedResponses.reset(0);
+    m_pendingResponses = 0;
+
     outputTimer->deleteLater();
     outputTimer = nullptr;
 }
 
-void xToolsResponserTool::try2output(const QByteArray &bytes, QObject *receiver)
+void xToolsResponserTool::try2output(const QByteArray &bytes, QList<QByteArray> &responses)
 {
     m_itemsMutex.lock();
     auto items = m_iItems;
@@ -480,14 +608,17 @@ void xToolsResponserTool::try2output(const QByteArray &bytes, QObject *receiver)
     int contain = xToolsDataStructure::ResponseOptionInputContainReference;
     int discontain = xToolsDataStructure::ResponseOptionInputDiscontainReference;
     int eaual = xToolsDataStructure::ResponseOptionInputEqualReference;
+    int rule = xToolsDataStructure::ResponseOptionInputMatchRule;
 
+    m_inputFrames++;
+    bool matched = false;
     for (const auto &item : items) {
         if (!item.data.itemEnable) {
             continue;
         }
 
-        auto refBytes = referenceBytes(item.data);
-        auto resBytes = responseBytes(item.data);
+        const QByteArray &refBytes = item.referenceBytes;
+        QByteArray resBytes = item.responseBytes;
 #if 0
         qDebug() << QString::fromLatin1(ctx.bytes.toHex())
                  << QString::fromLatin1(refBytes.toHex())
@@ -505,15 +636,28 @@ void xToolsResponserTool::try2output(const QByteArray &bytes, QObject *receiver)
             enableResponse = (!bytes.contains(refBytes));
         } else if (item.data.itemOption == eaual) {
             enableResponse = (bytes == refBytes);
+        } else if (item.data.itemOption == rule) {
+            resBytes.clear();
+            enableResponse = item.program.match(bytes, m_ruleContext)
+                             && item.program.response(bytes, m_ruleContext, resBytes);
         }
 
         if (!enableResponse) {
             continue;
         }
 
-        QTimer::singleShot(item.data.itemResponseDelay, receiver, [=]() {
-            emit outputBytes(responseBytes(item.data));
-        });
+        matched = true;
+        m_responses++;
+
+        if (item.data.itemResponseDelay > 0) {
+            m_delayedResponses.add(item.data.itemResponseDelay, resBytes);
+        } else {
+            responses.append(resBytes);
+        }
+    }
+
+    if (matched) {
+        m_matchedFrames++;
     }
 }
 
@@ -8,11 +8,14 @@
  **************************************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <QAbstractTableModel>
 #include <QMutex>
 #include <QVariant>
 
+#include "xToolsRuleProgram.h"
 #include "xToolsTableModelTool.h"
+#include "xToolsTimerWheel.h"
 
 #define SAK_STR_PROPERTY(name) Q_PROPERTY(QString name READ name CONSTANT)
 
@@ -84,6 +87,11 @@ public:
     {
         ResponserItem data;
         int elapsedTime{0};
+        // Cooked when the item is changed, the matching and the responses share them.
+        QByteArray referenceBytes;
+        QByteArray responseBytes;
+        // The reference text is the rule and the response text is the template.
+        xToolsRuleProgram program;
     };
 
     struct ResponserItemKeys
@@ -116,9 +124,12 @@ public:
 
 public:
     explicit xToolsResponserTool(QObject *parent = nullptr);
+    ~xToolsResponserTool() override;
     Q_INVOKABLE QVariant itemContext(int index) override;
     QString cookHeaderString(const QString &str) override;
     void inputBytes(const QByteArray &bytes) override;
+    /// Delayed responses that have not been output yet.
+    qint64 pendingResponses() const;
 
 protected:
     void run() override;
@@ -132,6 +143,7 @@ protected:
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     // clang-format on
+    void afterItemChanged(int index) override;
 
 private:
     QVector<QByteArray> m_inputBytesList;
@@ -144,12 +156,21 @@ private:
     const int m_itemTextColumnIndex{2};
     struct ResponserItemKeys m_dataKeys;
     const int m_tableColumnCount{24};
+    std::atomic<qint64> m_inputFrames{0};
+    std::atomic<qint64> m_matchedFrames{0};
+    std::atomic<qint64> m_responses{0};
+    std::atomic<qint64> m_pendingResponses{0};
+    int m_metricsCollector;
+    // Only accessed by the thread of the tool, a tick is a millisecond.
+    xToolsTimerWheel m_delayedResponses;
+    xToolsRuleProgram::Context m_ruleContext;
 
 private:
     QVariant columnDisplayRoleData(const ResponserData &item, int column) const;
     QByteArray referenceBytes(const ResponserItem &item) const;
     QByteArray responseBytes(const ResponserItem &item) const;
-    void try2output(const QByteArray &bytes, QObject *receiver);
+    void compileProgram(ResponserData &item);
+    void try2output(const QByteArray &bytes, QList<QByteArray> &responses);
 
 private:
     QString itemEnable();
@@ -12,6 +12,7 @@
 #include <QTimer>
 
 #include "xToolsBaseTool.h"
+#include "xToolsCaptureStorer.h"
 
 class xToolsStorerTool : public xToolsBaseTool
 {
@@ -50,9 +51,5 @@ private:
     } m_parameters;
     QMutex m_parametersMutex;
 
-    QList<QByteArray> m_inputBytesList;
-    QMutex m_inputBytesListMutex;
-
-private:
-    void write2file();
+    xToolsCaptureStorer m_storer;
 };
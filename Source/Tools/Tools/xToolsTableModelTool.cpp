@@ -80,9 +80,11 @@ void xToolsTableModelTool::addItem(const QString &jsonCtx, int index)
         index = m_tableModel->rowCount() - 1;
     }
 
+    m_isAddingItem = true;
     for (int i = 0; i < headers().count(); i++) {
         if (i >= columnCount()) {
             qWarning() << "Invalid column index!";
+            m_isAddingItem = false;
             return;
         }
 
@@ -91,6 +93,9 @@ void xToolsTableModelTool::addItem(const QString &jsonCtx, int index)
         m_tableModel->setData(modelIndex, jsonObj.value(key), Qt::EditRole);
         qInfo() << qPrintable(QString("set %1 as").arg(key)) << jsonObj.value(key);
     }
+
+    m_isAddingItem = false;
+    afterItemChanged(index);
 }
 
 QVariant xToolsTableModelTool::itemsContext()
@@ -36,9 +36,13 @@ protected:
     virtual bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) = 0;
     virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const = 0;
     // clang-format on
+    /// Called when every column of the item has been set by addItem().
+    virtual void afterItemChanged(int index) { Q_UNUSED(index); }
 
 protected:
     xToolsTableModel *m_tableModel;
+    // True while addItem() is setting the columns of an item, see afterItemChanged().
+    bool m_isAddingItem{false};
 
 private:
     // clang-format off
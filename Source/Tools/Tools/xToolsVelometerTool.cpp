@@ -17,36 +17,19 @@ xToolsVelometerTool::xToolsVelometerTool(QObject *parent)
 void xToolsVelometerTool::inputBytes(const QByteArray &bytes)
 {
     if (isRunning()) {
-        mInputBytesContextListMutex.lock();
-        mInputBytesContextList.append(bytes);
-        mInputBytesContextListMutex.unlock();
+        mRateMeter.add(bytes.length());
     }
 }
 
 void xToolsVelometerTool::run()
 {
+    mRateMeter.reset();
     QTimer *timer = new QTimer();
     timer->setInterval(1000);
     timer->setSingleShot(true);
     connect(timer, &QTimer::timeout, timer, [=]() {
-        this->mInputBytesContextListMutex.lock();
-        auto list = this->mInputBytesContextList;
-        this->mInputBytesContextList.clear();
-        this->mInputBytesContextListMutex.unlock();
-
-        int v = 0;
-        for (auto &bytes : list) {
-            v += bytes.length();
-        }
-
-        QString cookedVelocity;
-        if (v < 1024) {
-            cookedVelocity = QString("%1Bytes/s").arg(v);
-        } else if (v < 1024 * 1024) {
-            cookedVelocity = QString("%1KB/s").arg(v / 1024);
-        } else {
-            cookedVelocity = QString("%1MB/s").arg(v / (1024 * 1024));
-        }
+        double v = this->mRateMeter.rate(xToolsRateMeter::Window1s).bytesPerSecond;
+        QString cookedVelocity = xToolsRateMeter::speedString(v);
 
         this->mVelocityMutex.lock();
         this->mVelocity = cookedVelocity;
@@ -67,6 +50,6 @@ QString xToolsVelometerTool::velocity()
 {
     mVelocityMutex.lock();
     QString v = mVelocity;
-    mVelocityMutex.lock();
+    mVelocityMutex.unlock();
     return v;
 }
@@ -9,7 +9,7 @@
 #pragma once
 
 #include "xToolsBaseTool.h"
-#include <QList>
+#include "xToolsRateMeter.h"
 #include <QMutex>
 
 class xToolsVelometerTool : public xToolsBaseTool
@@ -25,8 +25,7 @@ protected:
     void run() override;
 
 private:
-    QList<QByteArray> mInputBytesContextList;
-    QMutex mInputBytesContextListMutex;
+    xToolsRateMeter mRateMeter;
     QString mVelocity;
     QMutex mVelocityMutex;
 
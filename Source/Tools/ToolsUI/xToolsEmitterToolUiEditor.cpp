@@ -36,7 +36,7 @@ QJsonObject xToolsEmitterToolUiEditor::parameters()
     int escape = ui->comboBoxEscaoe->currentData().toInt();
     int prefix = ui->comboBoxPrefix->currentData().toInt();
     int suffix = ui->comboBoxSufix->currentData().toInt();
-    int interval = ui->spinBoxInterval->value();
+    double interval = ui->spinBoxInterval->value();
     bool crcEnable = ui->checkBoxCrcEnable->isChecked();
     bool crcBigEndian = ui->checkBoxBigEndian->isChecked();
     int algotirhm = ui->comboBoxAlgorithm->currentData().toInt();
@@ -71,7 +71,7 @@ void xToolsEmitterToolUiEditor::setParameters(const QJsonObject &params)
     int escape = params.value(keys.itemEscapeCharacter).toInt();
     int prefix = params.value(keys.itemPrefix).toInt();
     int suffix = params.value(keys.itemSuffix).toInt();
-    int interval = params.value(keys.itemInterval).toInt();
+    double interval = params.value(keys.itemInterval).toDouble();
     bool crcEnable = params.value(keys.itemCrcEnable).toBool();
     bool crcBigEndian = params.value(keys.itemCrcBigEndian).toBool();
     int algotirhm = params.value(keys.itemCrcAlgorithm).toInt();
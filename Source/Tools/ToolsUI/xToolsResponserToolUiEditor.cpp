@@ -9,7 +9,11 @@
 #include "xToolsResponserToolUiEditor.h"
 #include "ui_xToolsResponserToolUiEditor.h"
 
+#include <QMessageBox>
+
+#include "xToolsDataStructure.h"
 #include "xToolsResponserTool.h"
+#include "xToolsRuleProgram.h"
 
 xToolsResponserToolUiEditor::xToolsResponserToolUiEditor(QWidget *parent)
     : QDialog{parent}
@@ -19,7 +23,10 @@ xToolsResponserToolUiEditor::xToolsResponserToolUiEditor(QWidget *parent)
     setModal(true);
     setWindowTitle(tr("Responser Item Editor"));
 
-    connect(ui->pushButtonOk, &QPushButton::clicked, this, &xToolsResponserToolUiEditor::accept);
+    connect(ui->pushButtonOk,
+            &QPushButton::clicked,
+            this,
+            &xToolsResponserToolUiEditor::onPushButtonOkClicked);
     connect(ui->pushButtonCancel, &QPushButton::clicked, this, &xToolsResponserToolUiEditor::reject);
 }
 
@@ -146,3 +153,17 @@ void xToolsResponserToolUiEditor::setParameters(const QJsonObject &params)
     ui->spinBoxResDelay->setValue(resDelay);
     ui->lineEditResData->setText(resData);
 }
+
+void xToolsResponserToolUiEditor::onPushButtonOkClicked()
+{
+    int option = ui->comboBoxOption->currentData().toInt();
+    if (option == xToolsDataStructure::ResponseOptionInputMatchRule) {
+        xToolsRuleProgram program;
+        if (!program.compile(ui->lineEditRefData->text(), ui->lineEditResData->text())) {
+            QMessageBox::warning(this, tr("Invalid Rule"), program.errorString());
+            return;
+        }
+    }
+
+    accept();
+}
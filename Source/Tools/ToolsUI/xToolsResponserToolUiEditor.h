@@ -25,6 +25,9 @@ public:
     Q_INVOKABLE QJsonObject parameters();
     Q_INVOKABLE void setParameters(const QJsonObject &params);
 
+private:
+    void onPushButtonOkClicked();
+
 private:
     Ui::xToolsResponserToolUiEditor *ui{nullptr};
 };
@@ -73,7 +73,7 @@ void xToolsStorerToolUi::onPushButtonSelectFileClicked()
     auto str = QFileDialog::getSaveFileName(Q_NULLPTR,
                                             tr("Save file"),
                                             ".",
-                                            tr("txt (*.txt);;All (*)"));
+                                            tr("xTools capture (*.xcap);;PCAPNG (*.pcapng);;All (*)"));
     if (!str.isEmpty()) {
         ui->lineEditStorerPath->setText(str);
     }